@@ -0,0 +1,141 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+#include "usteps.h"
+
+// ============================================================================
+// УГОЛ ВЫХОДНОГО ВАЛА ↔ МИКРОШАГИ - ТОЧНАЯ РАЦИОНАЛЬНАЯ АРИФМЕТИКА (ЧИСТАЯ ЛОГИКА)
+// ============================================================================
+// Микрошагов на оборот вала = steps_per_rev · usteps_per_step · gear_ratio = num / den.
+// gear_ratio (float в настройках) приводится к дроби с небольшим знаменателем (0.333333 → 1/3).
+// Угол - целые миллиградусы. Остаток деления переносится в следующий ход (AngleCarry),
+// поэтому сумма выданных микрошагов всегда равна точному пересчёту суммы углов -
+// 16 ходов по 22.5° дают ровно оборот, сколько бы их ни было. Без Arduino - проверяется на хосте.
+
+#define ANGLE_MDEG_PER_REV 360000LL
+#define ANGLE_GEAR_MAX_DEN 1000
+
+struct AngleUnits {
+    int64_t num;            // Микрошагов на оборот вала = num / den
+    int64_t den;
+};
+
+// Остаток в единицах 1/(360000·den) микрошага, всегда в [0, scale)
+struct AngleCarry {
+    int64_t rem;
+};
+
+// Дробь для gear_ratio: подходящие дроби цепной дроби, пока погрешность больше точности float
+inline bool angle_ratio_to_fraction(double x, int64_t max_den, int64_t *num, int64_t *den) {
+    if (!(x > 0) || x > 1.0e6) return false;
+    int64_t p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+    double r = x;
+    for (int i = 0; i < 32; i++) {
+        double a = floor(r);
+        int64_t p2 = (int64_t)a * p1 + p0;
+        int64_t q2 = (int64_t)a * q1 + q0;
+        if (q2 > max_den) break;
+        p0 = p1; q0 = q1; p1 = p2; q1 = q2;
+        if (fabs((double)p1 / q1 - x) <= x * 1.0e-6) break;
+        double frac = r - a;
+        if (frac < 1.0e-12) break;
+        r = 1.0 / frac;
+    }
+    if (q1 == 0 || p1 == 0) return false;
+    *num = p1;
+    *den = q1;
+    return true;
+}
+
+inline bool angle_units_make(uint32_t steps_per_rev, uint32_t usteps_per_step, float gear_ratio, AngleUnits &u) {
+    int64_t gnum, gden;
+    if (steps_per_rev == 0 || usteps_per_step == 0) return false;
+    if (!angle_ratio_to_fraction(gear_ratio, ANGLE_GEAR_MAX_DEN, &gnum, &gden)) return false;
+    u.num = (int64_t)steps_per_rev * usteps_per_step * gnum;
+    u.den = gden;
+    return true;
+}
+
+inline bool angle_units_equal(const AngleUnits &a, const AngleUnits &b) {
+    return a.num == b.num && a.den == b.den;
+}
+
+inline int64_t angle_scale(const AngleUnits &u) {
+    return ANGLE_MDEG_PER_REV * u.den;
+}
+
+inline int64_t angle_floor_div(int64_t a, int64_t b) {
+    int64_t q = a / b;
+    if ((a % b) != 0 && ((a < 0) != (b < 0))) q--;
+    return q;
+}
+
+// Половина шкалы - выдаётся ближайший микрошаг к точному углу
+inline void angle_carry_reset(const AngleUnits &u, AngleCarry &c) {
+    c.rem = angle_scale(u) / 2;
+}
+
+// Угол, при котором num·mdeg ещё не выходит за ход одной команды (и за int64)
+inline bool angle_mdeg_fits(const AngleUnits &u, int64_t mdeg) {
+    int64_t limit = USTEPS_MAX_MOVE * angle_scale(u) / u.num;
+    return mdeg >= -limit && mdeg <= limit;
+}
+
+// Относительный поворот на mdeg: микрошаги хода, остаток - в carry
+inline bool angle_move_relative(const AngleUnits &u, AngleCarry &c, int64_t mdeg, int32_t *usteps) {
+    if (!angle_mdeg_fits(u, mdeg)) return false;
+    const int64_t scale = angle_scale(u);
+    int64_t total = mdeg * u.num + c.rem;
+    int64_t q = angle_floor_div(total, scale);
+    if (!usteps_move_valid(q)) return false;
+    c.rem = total - q * scale;
+    *usteps = (int32_t)q;
+    return true;
+}
+
+// Абсолютный угол от начала координат (XACTUAL = 0 ↔ 0°). carry ставится так, что следующие
+// относительные ходы продолжают точно от mdeg, а не от округлённой позиции
+inline bool angle_target_absolute(const AngleUnits &u, AngleCarry &c, int64_t mdeg, int32_t *target) {
+    if (!angle_mdeg_fits(u, mdeg)) return false;
+    const int64_t scale = angle_scale(u);
+    int64_t total = mdeg * u.num + scale / 2;
+    int64_t q = angle_floor_div(total, scale);
+    if (q < INT32_MIN || q > INT32_MAX) return false;
+    c.rem = total - q * scale;
+    *target = (int32_t)q;
+    return true;
+}
+
+// Угол вала для позиции в микрошагах (для отображения)
+inline double angle_from_usteps_deg(const AngleUnits &u, int64_t usteps) {
+    return (double)usteps * 360.0 * (double)u.den / (double)u.num;
+}
+
+// Десятичный угол ("-22.5", "90", "0.0625") → миллиградусы без float, 4-й знак округляется
+inline bool angle_parse_mdeg(const char *s, int64_t *mdeg) {
+    if (!s) return false;
+    while (*s == ' ') s++;
+    bool neg = false;
+    if (*s == '+' || *s == '-') neg = (*s++ == '-');
+    int64_t value = 0;
+    int digits = 0, frac = 0;
+    bool round_up = false;
+    for (; *s >= '0' && *s <= '9'; s++, digits++) {
+        if (value > 1000000000000LL) return false;
+        value = value * 10 + (*s - '0');
+    }
+    if (*s == '.') {
+        s++;
+        for (; *s >= '0' && *s <= '9'; s++, digits++) {
+            if (frac < 3) value = value * 10 + (*s - '0');
+            else if (frac == 3) round_up = *s >= '5';
+            frac++;
+        }
+    }
+    while (*s == ' ') s++;
+    if (!digits || *s) return false;
+    for (; frac < 3; frac++) value *= 10;
+    if (round_up) value++;
+    *mdeg = neg ? -value : value;
+    return true;
+}
@@ -47,6 +47,12 @@ struct MotorPreset {
     uint16_t acceleration;      // Ускорение (шаг/с²)
     uint16_t deceleration;      // Замедление (шаг/с²)
     uint16_t steps_per_rev;     // Шагов на оборот
+    // Шеститочечная рампа (см. MotorSettings)
+    uint32_t vstart;
+    uint16_t a1;
+    uint32_t v1;
+    uint16_t d1;
+    uint32_t vstop;
 };
 
 // Пресеты для разных типов двигателей
@@ -62,7 +68,8 @@ const MotorPreset NEMA_PRESETS[] = {
         300,        // 300 шаг/с (медленнее для малых моторов)
         400,        // 400 шаг/с²
         400,        // 400 шаг/с²
-        200         // 200 шагов/оборот (БЕЗ микрошагов!)
+        200,        // 200 шагов/оборот (БЕЗ микрошагов!)
+        0, 400, 0, 400, 1   // Рампа: одна фаза (малый момент - без рывка на старте)
     },
     
     // NEMA 14 - средний двигатель
@@ -75,7 +82,8 @@ const MotorPreset NEMA_PRESETS[] = {
         350,        // 350 шаг/с
         450,        // 450 шаг/с²
         450,        // 450 шаг/с²
-        200         // 200 шагов/оборот (БЕЗ микрошагов!)
+        200,        // 200 шагов/оборот (БЕЗ микрошагов!)
+        10, 700, 100, 700, 10   // Рампа: старт с 10 шаг/с, до 100 шаг/с - ускорение x1.5
     },
     
     // NEMA 17 - популярный, универсальный
@@ -88,7 +96,8 @@ const MotorPreset NEMA_PRESETS[] = {
         400,        // 400 шаг/с (как в тесте!)
         500,        // 500 шаг/с² (как в тесте!)
         500,        // 500 шаг/с²
-        200         // 200 шагов/оборот (БЕЗ микрошагов!)
+        200,        // 200 шагов/оборот (БЕЗ микрошагов!)
+        10, 800, 120, 800, 10   // Рампа: старт с 10 шаг/с, до 120 шаг/с - ускорение x1.6
     },
     
     // NEMA 23 - большой ток, высокий момент
@@ -101,7 +110,8 @@ const MotorPreset NEMA_PRESETS[] = {
         600,        // 600 шаг/с
         500,        // 500 шаг/с²
         500,        // 500 шаг/с²
-        200         // 200 шагов/оборот (БЕЗ микрошагов!)
+        200,        // 200 шагов/оборот (БЕЗ микрошагов!)
+        5, 600, 150, 600, 5     // Рампа: большой ротор - мягкий старт, до 150 шаг/с - ускорение x1.2
     }
 };
 
@@ -4,6 +4,7 @@
 // ⚠️ КРИТИЧЕСКИ ВАЖНО: R_SENSE должен соответствовать физическому резистору на плате!
 // Для TMC5160 Pro V1.5 (BigTreeTech/Watterott) = 0.033 Ом (согласно даташиту!)
 #define TMC5160_RSENSE 0.033f  // Sense resistor value (DO NOT CHANGE unless hardware is different!)
+#define TMC5160_FCLK 12000000  // Внутренний генератор TMC5160 (CLK пин не подключен)
 
 // --- Режимы работы TMC5160 ---
 enum MotorControlMode {
@@ -20,7 +21,13 @@ enum MotorControlMode {
 #define DEFAULT_CURRENT_MA 800
 #define DEFAULT_MICROSTEPS 16
 #define DEFAULT_HOLD_MULTIPLIER 0.5f
+// Шеститочечная рампа: по умолчанию как раньше - одна фаза AMAX/DMAX (V1 = 0)
+#define DEFAULT_VSTART 0
+#define DEFAULT_V1 0
+#define DEFAULT_VSTOP 1
 #define DEFAULT_CONTROL_MODE MODE_MOTION_CONTROLLER
+// TCOOLTHRS: StallGuard работает при TSTEP <= порога. 0xFFFFF - на любой скорости
+#define TCOOLTHRS_ALWAYS 0xFFFFF
 #define EEPROM_SIZE 512
 #define MAX_PROFILES 5
 #define PROFILE_SIZE 100
@@ -43,10 +50,25 @@ struct MotorSettings {
     uint8_t control_mode;       // Режим управления (MotorControlMode)
     float gear_ratio;           // Передаточное число (например: 3.0 = 1:3, 0.333 = 3:1)
     int8_t stallguard_threshold; // Порог StallGuard (-64 до 63, 0 = выкл)
+    uint32_t spi_clock_hz;      // Частота SPI после калибровки (0 = не калибровалась)
+    // Шеститочечная рампа (VMAX/AMAX/DMAX = max_speed/acceleration/deceleration)
+    uint32_t vstart;            // Стартовая скорость (steps/s)
+    uint16_t a1;                // Ускорение до V1 (steps/s²)
+    uint32_t v1;                // Скорость смены A1→AMAX и DMAX→D1 (steps/s, 0 = одна фаза)
+    uint16_t d1;                // Замедление ниже V1 (steps/s²)
+    uint32_t vstop;             // Скорость остановки (steps/s, >= vstart)
+    uint32_t stallguard_tcoolthrs; // TCOOLTHRS из свипа SGT (TCOOLTHRS_ALWAYS - не настраивался)
     uint32_t checksum;          // Для проверки валидности данных
 };
 
 // --- Wi-Fi ---
 #define WIFI_AP_SSID "Krya"
 #define WIFI_AP_PASSWORD "12345678"
-#define WIFI_AP_IP "192.168.4.1"
\ No newline at end of file
+#define WIFI_AP_IP "192.168.4.1"
+// --- Лог в Serial ---
+// Уровень на этапе компиляции: вызовы LOG_*() выше него не компилируются вовсе, аргументы не
+// вычисляются (serial_log.h). 1 - ошибки, 2 - +предупреждения, 3 - +информация, 4 - +отладка.
+// Переопределяется из platformio.ini: build_flags = -DLOG_LEVEL=2
+#ifndef LOG_LEVEL
+#define LOG_LEVEL 3
+#endif
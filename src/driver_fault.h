@@ -0,0 +1,101 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+
+// ============================================================================
+// ОШИБКИ ДРАЙВЕРА TMC5160 - РАЗБОР DRV_STATUS/GSTAT И РЕШЕНИЕ (ЧИСТАЯ ЛОГИКА)
+// ============================================================================
+// Вызывается обработчиком фронта DIAG0 (fault_monitor.cpp). Без Arduino/SPI - проверяется
+// на хосте подстановкой значений регистров.
+
+// Биты регистров (даташит TMC5160, DRV_STATUS 0x6F и GSTAT 0x01)
+#define DRV_STATUS_S2VSA (1UL << 12)
+#define DRV_STATUS_S2VSB (1UL << 13)
+#define DRV_STATUS_OT    (1UL << 25)
+#define DRV_STATUS_OTPW  (1UL << 26)
+#define DRV_STATUS_S2GA  (1UL << 27)
+#define DRV_STATUS_S2GB  (1UL << 28)
+#define GSTAT_RESET      (1UL << 0)
+#define GSTAT_DRV_ERR    (1UL << 1)
+#define GSTAT_UV_CP      (1UL << 2)
+
+enum DriverFaultFlag : uint16_t {
+    FAULT_S2GA    = 1 << 0,     // Замыкание на землю, фаза A
+    FAULT_S2GB    = 1 << 1,
+    FAULT_S2VSA   = 1 << 2,     // Замыкание на питание, фаза A
+    FAULT_S2VSB   = 1 << 3,
+    FAULT_OT      = 1 << 4,     // Перегрев (драйвер уже выключил мост)
+    FAULT_OTPW    = 1 << 5,     // Предупреждение о перегреве
+    FAULT_UV_CP   = 1 << 6,     // Просадка charge pump
+    FAULT_DRV_ERR = 1 << 7,     // Драйвер отключён по ошибке (защёлкнуто до сброса GSTAT)
+    FAULT_RESET   = 1 << 8,     // Драйвер сбросился (регистры по умолчанию)
+};
+
+#define FAULT_CRITICAL_MASK (FAULT_S2GA | FAULT_S2GB | FAULT_S2VSA | FAULT_S2VSB | FAULT_OT | FAULT_UV_CP | FAULT_DRV_ERR)
+
+enum FaultAction : uint8_t {
+    FAULT_ACT_NONE = 0,         // Фронт DIAG0 от StallGuard - не ошибка
+    FAULT_ACT_WARN,             // Только запись в журнал (предупреждение о перегреве)
+    FAULT_ACT_DISABLE,          // Снять EN и остановить движение
+};
+
+static inline uint16_t driver_fault_decode(uint32_t drv_status, uint32_t gstat) {
+    uint16_t f = 0;
+    if (drv_status & DRV_STATUS_S2GA) f |= FAULT_S2GA;
+    if (drv_status & DRV_STATUS_S2GB) f |= FAULT_S2GB;
+    if (drv_status & DRV_STATUS_S2VSA) f |= FAULT_S2VSA;
+    if (drv_status & DRV_STATUS_S2VSB) f |= FAULT_S2VSB;
+    if (drv_status & DRV_STATUS_OT) f |= FAULT_OT;
+    if (drv_status & DRV_STATUS_OTPW) f |= FAULT_OTPW;
+    if (gstat & GSTAT_UV_CP) f |= FAULT_UV_CP;
+    if (gstat & GSTAT_DRV_ERR) f |= FAULT_DRV_ERR;
+    if (gstat & GSTAT_RESET) f |= FAULT_RESET;
+    return f;
+}
+
+// hard_disabled - ISR уже снял EN (StallGuard на DIAG0 не выведен, любой фронт - ошибка).
+// Такой фронт без флагов всё равно остаётся отключением: неизвестная причина безопаснее стоянки
+static inline FaultAction driver_fault_action(uint16_t flags, bool hard_disabled) {
+    if (flags & FAULT_CRITICAL_MASK) return FAULT_ACT_DISABLE;
+    if (hard_disabled) return FAULT_ACT_DISABLE;
+    if (flags & (FAULT_OTPW | FAULT_RESET)) return FAULT_ACT_WARN;
+    return FAULT_ACT_NONE;
+}
+
+// Можно ли снова включить мотор: активных критических флагов нет
+static inline bool driver_fault_cleared(uint32_t drv_status, uint32_t gstat) {
+    return (driver_fault_decode(drv_status, gstat) & FAULT_CRITICAL_MASK) == 0;
+}
+
+static inline const char* driver_fault_name(uint16_t flag) {
+    switch (flag) {
+        case FAULT_S2GA: return "s2ga";
+        case FAULT_S2GB: return "s2gb";
+        case FAULT_S2VSA: return "s2vsa";
+        case FAULT_S2VSB: return "s2vsb";
+        case FAULT_OT: return "ot";
+        case FAULT_OTPW: return "otpw";
+        case FAULT_UV_CP: return "uv_cp";
+        case FAULT_DRV_ERR: return "drv_err";
+        case FAULT_RESET: return "reset";
+        default: return "unknown";
+    }
+}
+
+// Флаги через запятую ("s2ga,drv_err"), без флагов - "none". Возвращает длину
+static inline int driver_fault_describe(uint16_t flags, char *buf, size_t size) {
+    if (!size) return 0;
+    buf[0] = '\0';
+    int len = 0;
+    for (uint16_t bit = 1; bit && bit <= FAULT_RESET; bit <<= 1) {
+        if (!(flags & bit)) continue;
+        int n = snprintf(buf + len, size - len, "%s%s", len ? "," : "", driver_fault_name(bit));
+        if (n < 0 || (size_t)(len + n) >= size) {
+            buf[len] = '\0';
+            break;
+        }
+        len += n;
+    }
+    if (!flags) len = snprintf(buf, size, "none");
+    return len;
+}
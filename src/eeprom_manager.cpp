@@ -1,7 +1,23 @@
 #include "eeprom_manager.h"
 #include "tmc.h"
+#include "serial_log.h"
 
 MotorSettings currentSettings;
+static portMUX_TYPE settings_mux = portMUX_INITIALIZER_UNLOCKED;
+
+MotorSettings get_settings_snapshot() {
+    MotorSettings copy;
+    portENTER_CRITICAL(&settings_mux);
+    copy = currentSettings;
+    portEXIT_CRITICAL(&settings_mux);
+    return copy;
+}
+
+void publish_settings(const MotorSettings& settings) {
+    portENTER_CRITICAL(&settings_mux);
+    currentSettings = settings;
+    portEXIT_CRITICAL(&settings_mux);
+}
 
 // Простая функция для вычисления checksum
 uint32_t calculateChecksum(const MotorSettings& settings) {
@@ -14,6 +30,9 @@ uint32_t calculateChecksum(const MotorSettings& settings) {
     sum += settings.steps_per_rev;
     sum += (uint32_t)(settings.hold_multiplier * 1000); // float -> int для checksum
     sum += settings.control_mode;
+    sum += settings.spi_clock_hz;
+    sum += settings.vstart + settings.a1 + settings.v1 + settings.d1 + settings.vstop;
+    sum += settings.stallguard_tcoolthrs;
     return sum;
 }
 
@@ -62,6 +81,13 @@ void initMotorSettingsFromEEPROM() {
         currentSettings.control_mode = DEFAULT_CONTROL_MODE;
         currentSettings.gear_ratio = 1.0f;             // По умолчанию 1:1 (прямая передача)
         currentSettings.stallguard_threshold = 0;      // StallGuard выключен по умолчанию
+        currentSettings.stallguard_tcoolthrs = TCOOLTHRS_ALWAYS;
+        currentSettings.spi_clock_hz = 0;              // SPI будет откалиброван при первом запуске
+        currentSettings.vstart = DEFAULT_VSTART;
+        currentSettings.a1 = DEFAULT_ACCEL;
+        currentSettings.v1 = DEFAULT_V1;               // Одна фаза AMAX/DMAX, как раньше
+        currentSettings.d1 = DEFAULT_DECEL;
+        currentSettings.vstop = DEFAULT_VSTOP;
 
         // Сохраняем значения по умолчанию
         saveMotorSettings(currentSettings);
@@ -72,13 +98,18 @@ void initMotorSettingsFromEEPROM() {
 }
 
 void printMotorSettings() {
-    add_log("⚙️ Current motor settings:");
-    add_log("  Current: " + String(currentSettings.current_mA) + " mA");
-    add_log("  Hold multiplier: " + String(currentSettings.hold_multiplier, 2));
-    add_log("  Microsteps: " + String(currentSettings.microsteps));
-    add_log("  Steps per rev: " + String(currentSettings.steps_per_rev));
-    add_log("  Max speed: " + String(currentSettings.max_speed) + " steps/s");
-    add_log("  Acceleration: " + String(currentSettings.acceleration) + " steps/s²");
-    add_log("  Deceleration: " + String(currentSettings.deceleration) + " steps/s²");
-    add_log("  Control mode: " + String(currentSettings.control_mode == MODE_MOTION_CONTROLLER ? "Motion Controller" : "STEP/DIR"));
+    LOG_INFOF("⚙️ Current motor settings:");
+    LOG_INFOF("  Current: %u mA", currentSettings.current_mA);
+    LOG_INFOF("  Hold multiplier: %.2f", currentSettings.hold_multiplier);
+    LOG_INFOF("  Microsteps: %u", currentSettings.microsteps);
+    LOG_INFOF("  Steps per rev: %u", currentSettings.steps_per_rev);
+    LOG_INFOF("  Max speed: %lu steps/s", (unsigned long)currentSettings.max_speed);
+    LOG_INFOF("  Acceleration: %u steps/s²", currentSettings.acceleration);
+    LOG_INFOF("  Deceleration: %u steps/s²", currentSettings.deceleration);
+    LOG_INFOF("  Ramp: VSTART=%lu A1=%u V1=%lu D1=%u VSTOP=%lu", (unsigned long)currentSettings.vstart,
+              currentSettings.a1, (unsigned long)currentSettings.v1, currentSettings.d1,
+              (unsigned long)currentSettings.vstop);
+    if (currentSettings.spi_clock_hz) LOG_INFOF("  SPI clock: %lu Hz", (unsigned long)currentSettings.spi_clock_hz);
+    else LOG_INFOF("  SPI clock: not calibrated");
+    LOG_INFOF("  Control mode: %s", currentSettings.control_mode == MODE_MOTION_CONTROLLER ? "Motion Controller" : "STEP/DIR");
 }
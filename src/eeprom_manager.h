@@ -13,6 +13,12 @@ bool loadMotorSettings(MotorSettings& settings);
 void initMotorSettingsFromEEPROM();
 void printMotorSettings();
 
+// currentSettings меняет только задача движения - через publish_settings(), под спинлоком.
+// Остальные задачи (AsyncTCP, телеметрия) берут согласованную копию get_settings_snapshot():
+// прямое чтение полей может попасть на середину записи и смешать старые и новые значения
+MotorSettings get_settings_snapshot();
+void publish_settings(const MotorSettings& settings);
+
 extern MotorSettings currentSettings;
 
 
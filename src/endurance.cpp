@@ -0,0 +1,278 @@
+#include "endurance.h"
+#include "tmc.h"
+#include "eeprom_manager.h"
+#include "motion_task.h"
+#include "move_events.h"
+#include "move_segments.h"
+#include "fault_monitor.h"
+
+// Объявление функции для веб-логов (определена в web_server.cpp)
+extern void add_log_to_web(String message);
+
+enum EndurancePhase : uint8_t {
+    ENDURANCE_IDLE = 0,
+    ENDURANCE_MOVE,         // Ход идёт, ждём события завершения
+    ENDURANCE_DWELL         // Пауза после хода
+};
+
+// Параметры пишет AsyncTCP (только когда тест не идёт), статус читает AsyncTCP - под спинлоком
+static portMUX_TYPE endurance_mux = portMUX_INITIALIZER_UNLOCKED;
+static EnduranceConfig endurance_config = endurance_default_config();
+static EnduranceStatus endurance_status = {};
+
+// Исполнение - только задача движения
+static EnduranceConfig active = {};
+static EndurancePhase phase = ENDURANCE_IDLE;
+static uint8_t leg = 0;                     // 0 - туда, 1 - обратно
+static uint32_t start_ms = 0;
+static uint32_t cycle_start_ms = 0;
+static uint32_t phase_start_ms = 0;
+static int32_t reference = 0;
+static bool ramp_overridden = false;
+
+// Выборки текущего цикла
+static uint8_t cycle_peak_cs = 0;
+static uint16_t cycle_stall_samples = 0;
+static uint32_t cycle_diag_base = 0;
+static bool last_stall = false;
+static uint32_t last_snapshot_ms = 0;
+
+EnduranceConfig endurance_default_config() {
+    EnduranceConfig c = {};
+    c.pattern = ENDURANCE_BACK_AND_FORTH;
+    c.distance_usteps = ENDURANCE_DEFAULT_STEPS * (int32_t)get_usteps_per_step();
+    c.dwell_ms = ENDURANCE_DEFAULT_DWELL_MS;
+    c.max_failures = ENDURANCE_DEFAULT_MAX_FAILURES;
+    c.move_timeout_ms = ENDURANCE_DEFAULT_MOVE_TIMEOUT_MS;
+    return c;
+}
+
+const char* endurance_pattern_name(EndurancePattern pattern) {
+    return pattern == ENDURANCE_ROTATE ? "rotate" : "back_and_forth";
+}
+
+bool endurance_configure(const EnduranceConfig &config) {
+    if (is_endurance_active()) return false;
+    portENTER_CRITICAL(&endurance_mux);
+    endurance_config = config;
+    portEXIT_CRITICAL(&endurance_mux);
+    return true;
+}
+
+bool is_endurance_active() {
+    return phase != ENDURANCE_IDLE;
+}
+
+EnduranceStatus get_endurance_status() {
+    portENTER_CRITICAL(&endurance_mux);
+    EnduranceStatus s = endurance_status;
+    portEXIT_CRITICAL(&endurance_mux);
+    if (s.running) s.elapsed_ms = millis() - start_ms;
+    return s;
+}
+
+// Пик тока и StallGuard - из снимка движения (задача обновляет его раз в MOTION_POLL_PERIOD_MS)
+static void endurance_sample() {
+    MotionSnapshot snap = get_motion_snapshot(MOTION_POLL_PERIOD_MS);
+    if (!snap.valid || snap.timestamp_ms == last_snapshot_ms) return;
+    last_snapshot_ms = snap.timestamp_ms;
+
+    TMC5160_Reg::DRV_STATUS_Register drv = {0};
+    drv.value = snap.drv_status;
+    if (drv.stst) {
+        last_stall = false;
+        return;
+    }
+    if (drv.cs_actual > cycle_peak_cs) cycle_peak_cs = drv.cs_actual;
+    if (drv.stallGuard && !last_stall) cycle_stall_samples++;
+    last_stall = drv.stallGuard;
+}
+
+static void endurance_move(int32_t usteps) {
+    move_relative_usteps(usteps, MODE_MOTION_CONTROLLER);
+    phase = ENDURANCE_MOVE;
+    phase_start_ms = millis();
+}
+
+static void endurance_begin_cycle(uint32_t now) {
+    leg = 0;
+    cycle_start_ms = now;
+    cycle_peak_cs = 0;
+    cycle_stall_samples = 0;
+    cycle_diag_base = get_fault_monitor_stats().stall_edges;
+    last_stall = false;
+    endurance_move(active.distance_usteps);
+}
+
+static void endurance_report(const EnduranceStatus &s) {
+    const EnduranceStats &st = s.stats;
+    add_log_to_web("────────────────────────────────────────────────────────────────");
+    String stop_msg = "[STOP] Тест мотора остановлен (" + String(s.stop_reason) + ") | Время: " +
+                      String(s.elapsed_ms / 1000.0, 1) + "с | Циклов: " + String(st.cycles);
+    add_log("🛑 " + stop_msg);
+    add_log_to_web(stop_msg);
+
+    add_log_to_web("[STATS] ════════════════════════════════════════════");
+    add_log_to_web("[STATS] Время теста: " + String(s.elapsed_ms / 1000.0, 1) + " секунд");
+    add_log_to_web("[STATS] Выполнено циклов: " + String(st.cycles));
+    add_log_to_web("[STATS] Неудачных циклов: " + String(st.failed_cycles));
+    if (st.cycles > 0) {
+        add_log_to_web("[STATS] Время цикла: среднее " + String(st.cycle_ms.mean, 1) + "мс, σ " +
+                       String(running_stats_stddev(st.cycle_ms), 1) + "мс, мин " + String(st.cycle_ms.min, 0) +
+                       "мс, макс " + String(st.cycle_ms.max, 0) + "мс");
+        add_log_to_web("[STATS] Ошибка позиции: средняя " + String(st.error_usteps.mean, 1) + " мкшаг, σ " +
+                       String(running_stats_stddev(st.error_usteps), 1) + ", макс |ошибка| " +
+                       String(st.max_abs_error) + " мкшаг");
+        add_log_to_web("[STATS] Пик CS_ACTUAL: макс " + String(st.peak_cs_max) + "/31, средний за цикл " +
+                       String(st.peak_cs.mean, 1));
+        add_log_to_web("[STATS] Срабатываний StallGuard: " + String(st.stalls_total) + " (циклов: " +
+                       String(st.stall_cycles) + ")");
+    } else {
+        add_log_to_web("[STATS] Нет завершённых циклов для статистики");
+    }
+    add_log_to_web("[STATS] ════════════════════════════════════════════");
+}
+
+// stop_motion - прервать текущий ход (тест остановился сам, посреди хода)
+static void endurance_finish(const char *reason, bool stop_motion) {
+    phase = ENDURANCE_IDLE;
+    if (stop_motion && tmc_initialized && move_in_flight()) {
+        move_events_abort();
+        motor.stop();
+    }
+    if (ramp_overridden && tmc_initialized) apply_ramp_profile(get_ramp_profile(currentSettings));
+    ramp_overridden = false;
+
+    portENTER_CRITICAL(&endurance_mux);
+    endurance_status.running = false;
+    endurance_status.stop_reason = reason;
+    endurance_status.elapsed_ms = millis() - start_ms;
+    EnduranceStatus s = endurance_status;
+    portEXIT_CRITICAL(&endurance_mux);
+    endurance_report(s);
+}
+
+static void endurance_cycle_done(uint32_t now) {
+    if (active.pattern == ENDURANCE_ROTATE) reference = usteps_add(reference, active.distance_usteps);
+
+    EnduranceCycleSample sample;
+    sample.duration_ms = now - cycle_start_ms;
+    sample.position_error = usteps_diff(read_position_usteps(), reference);
+    sample.peak_cs = cycle_peak_cs;
+    uint32_t diag_stalls = get_fault_monitor_stats().stall_edges - cycle_diag_base;
+    // Одно и то же срабатывание видно и в DRV_STATUS, и на DIAG0 - берём больший счёт
+    sample.stalls = diag_stalls > cycle_stall_samples ? (uint16_t)constrain(diag_stalls, (uint32_t)0, (uint32_t)0xFFFF)
+                                                      : cycle_stall_samples;
+
+    portENTER_CRITICAL(&endurance_mux);
+    endurance_stats_add(endurance_status.stats, sample, active.tolerance_usteps);
+    endurance_status.reference = reference;
+    EnduranceStats st = endurance_status.stats;
+    portEXIT_CRITICAL(&endurance_mux);
+
+    if (active.max_failures && st.consecutive_failures >= active.max_failures) {
+        add_log_to_web("[FAIL] " + String(st.consecutive_failures) + " неудачных циклов подряд (ошибка " +
+                       String(sample.position_error) + " мкшаг, StallGuard " + String(sample.stalls) + ")");
+        endurance_finish("too many failed cycles", false);
+        return;
+    }
+    if (active.max_cycles && st.cycles >= active.max_cycles) {
+        add_log_to_web("[CYCLES] Тест мотора завершен по количеству циклов (" + String(st.cycles) + ")");
+        endurance_finish("cycle limit", false);
+        return;
+    }
+    // Лимит времени - на границе цикла: мотор останавливается в опорной позиции
+    if (active.max_time_ms && now - start_ms >= active.max_time_ms) {
+        add_log_to_web("[TIME] Тест мотора завершен по времени (" + String(active.max_time_ms / 1000.0, 1) +
+                       "с, циклов: " + String(st.cycles) + ")");
+        endurance_finish("time limit", false);
+        return;
+    }
+    endurance_begin_cycle(now);
+}
+
+void endurance_start() {
+    if (is_endurance_active()) endurance_abort("restarted");
+
+    portENTER_CRITICAL(&endurance_mux);
+    EnduranceConfig config = endurance_config;
+    portEXIT_CRITICAL(&endurance_mux);
+
+    if (!tmc_initialized || !motor_enabled || currentSettings.control_mode != MODE_MOTION_CONTROLLER) {
+        add_log_to_web("❌ Cannot start endurance test - motor not ready or not in Motion Controller mode");
+        return;
+    }
+    active = config;
+    if (active.max_speed || active.acceleration || active.deceleration) {
+        MoveSegment seg = {0, active.max_speed, active.acceleration, active.deceleration};
+        if (!apply_ramp_profile(move_segment_ramp(get_ramp_profile(currentSettings), seg))) {
+            add_log_to_web("❌ Endurance test: ramp rejected");
+            return;
+        }
+        ramp_overridden = true;
+    }
+
+    uint32_t now = millis();
+    reference = read_position_usteps();
+    start_ms = now;
+    portENTER_CRITICAL(&endurance_mux);
+    endurance_status.running = true;
+    endurance_status.stop_reason = nullptr;
+    endurance_status.elapsed_ms = 0;
+    endurance_status.reference = reference;
+    endurance_status.config = active;
+    endurance_stats_reset(endurance_status.stats);
+    portEXIT_CRITICAL(&endurance_mux);
+
+    String pattern_str = active.pattern == ENDURANCE_ROTATE ? "→" : "⇄";
+    String log_msg = "[TEST] Тест мотора запущен: " + pattern_str + " " +
+                     String(steps_from_usteps(active.distance_usteps)) + " шагов | Пауза: " + String(active.dwell_ms) + "ms";
+    if (active.max_cycles > 0) log_msg += " | Циклов: " + String(active.max_cycles);
+    if (active.max_time_ms > 0) log_msg += " | Время: " + String(active.max_time_ms / 1000) + "с";
+    add_log("🧪 " + log_msg);
+    add_log_to_web(log_msg);
+    add_log_to_web("────────────────────────────────────────────────────────────────");
+
+    endurance_begin_cycle(now);
+}
+
+void endurance_tick() {
+    if (phase == ENDURANCE_IDLE) return;
+    if (!tmc_initialized || !motor_enabled) {
+        endurance_abort("motor not ready");
+        return;
+    }
+
+    uint32_t now = millis();
+    endurance_sample();
+
+    switch (phase) {
+        case ENDURANCE_MOVE:
+            if (move_in_flight()) {
+                if (now - phase_start_ms >= active.move_timeout_ms) endurance_finish("move timeout", true);
+                return;
+            }
+            phase = ENDURANCE_DWELL;
+            phase_start_ms = now;
+            return;
+
+        case ENDURANCE_DWELL:
+            if (now - phase_start_ms < active.dwell_ms) return;
+            if (active.pattern == ENDURANCE_BACK_AND_FORTH && leg == 0) {
+                leg = 1;
+                endurance_move(-active.distance_usteps);
+                return;
+            }
+            endurance_cycle_done(now);
+            return;
+
+        default:
+            return;
+    }
+}
+
+void endurance_abort(const char *reason) {
+    if (!is_endurance_active()) return;
+    // Движение останавливает вызывающий (стоп, хоминг, новая команда) - здесь рампа и итог
+    endurance_finish(reason, false);
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <Arduino.h>
+#include "endurance_stats.h"
+
+// ============================================================================
+// ТЕСТ МОТОРА НА РЕСУРС (аналог теста соленоида)
+// ============================================================================
+// Задача движения гоняет мотор туда-обратно или в одну сторону N циклов или T секунд.
+// За цикл: длительность, срабатывания StallGuard (DRV_STATUS.stallGuard из снимка движения
+// и фронты DIAG0), пик CS_ACTUAL и ошибка XACTUAL против опорной позиции в конце цикла.
+// Статистика накапливается без хранения выборок (endurance_stats.h), итог - в лог строками
+// [STATS], как у соленоида. Только MODE_MOTION_CONTROLLER.
+
+#define ENDURANCE_DEFAULT_STEPS 1000
+#define ENDURANCE_DEFAULT_DWELL_MS 100
+#define ENDURANCE_DEFAULT_MAX_FAILURES 5
+#define ENDURANCE_DEFAULT_MOVE_TIMEOUT_MS 30000
+
+enum EndurancePattern : uint8_t {
+    ENDURANCE_BACK_AND_FORTH = 0,   // +distance, -distance: опора - стартовая позиция
+    ENDURANCE_ROTATE                // +distance за цикл: опора сдвигается на distance
+};
+
+struct EnduranceConfig {
+    EndurancePattern pattern;
+    int32_t distance_usteps;        // Ход за цикл (знак - направление)
+    uint32_t dwell_ms;              // Пауза после каждого хода
+    uint32_t max_cycles;            // 0 = бесконечно
+    uint32_t max_time_ms;           // 0 = бесконечно
+    uint32_t tolerance_usteps;      // Допуск ошибки позиции в конце цикла
+    uint8_t max_failures;           // Подряд неудачных циклов до остановки (0 = не останавливать)
+    uint32_t move_timeout_ms;
+    uint32_t max_speed;             // Рампа теста, 0 - из настроек
+    uint32_t acceleration;
+    uint32_t deceleration;
+};
+
+struct EnduranceStatus {
+    bool running;
+    const char *stop_reason;
+    uint32_t elapsed_ms;
+    int32_t reference;              // Текущая опорная позиция (микрошаги)
+    EnduranceConfig config;
+    EnduranceStats stats;
+};
+
+EnduranceConfig endurance_default_config();
+const char* endurance_pattern_name(EndurancePattern pattern);
+// Новые параметры (из AsyncTCP). false - тест идёт, менять нельзя
+bool endurance_configure(const EnduranceConfig &config);
+
+// Задача движения: старт, отмена и обслуживание (каждую итерацию)
+void endurance_start();
+void endurance_tick();
+void endurance_abort(const char *reason);
+
+bool is_endurance_active();
+EnduranceStatus get_endurance_status();
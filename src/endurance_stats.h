@@ -0,0 +1,101 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+// ============================================================================
+// СТАТИСТИКА ТЕСТА МОТОРА НА РЕСУРС (ЧИСТАЯ ЛОГИКА)
+// ============================================================================
+// Накопление без хранения выборок: среднее и дисперсия по Уэлфорду (устойчиво на миллионах
+// циклов, в отличие от суммы квадратов), min/max. Одна выборка каждой метрики на цикл -
+// double на ESP32 программный, но это раз в сотни миллисекунд. Проверяется на хосте.
+
+struct RunningStats {
+    uint32_t count;
+    double mean;
+    double m2;              // Сумма квадратов отклонений от текущего среднего
+    double min;
+    double max;
+};
+
+inline void running_stats_reset(RunningStats &s) {
+    s.count = 0;
+    s.mean = 0;
+    s.m2 = 0;
+    s.min = 0;
+    s.max = 0;
+}
+
+inline void running_stats_add(RunningStats &s, double x) {
+    s.count++;
+    double delta = x - s.mean;
+    s.mean += delta / s.count;
+    s.m2 += delta * (x - s.mean);
+    if (s.count == 1 || x < s.min) s.min = x;
+    if (s.count == 1 || x > s.max) s.max = x;
+}
+
+// Выборочная дисперсия (n - 1), 0 при одной выборке
+inline double running_stats_variance(const RunningStats &s) {
+    return s.count > 1 ? s.m2 / (s.count - 1) : 0;
+}
+
+inline double running_stats_stddev(const RunningStats &s) {
+    return sqrt(running_stats_variance(s));
+}
+
+// Итог одного цикла теста
+struct EnduranceCycleSample {
+    uint32_t duration_ms;
+    int32_t position_error;     // XACTUAL - опорная позиция в конце цикла (микрошаги)
+    uint8_t peak_cs;            // Максимум CS_ACTUAL за цикл (0..31)
+    uint16_t stalls;            // Срабатываний StallGuard за цикл
+};
+
+struct EnduranceStats {
+    uint32_t cycles;
+    uint32_t failed_cycles;         // Со срабатыванием StallGuard или ошибкой больше допуска
+    uint32_t consecutive_failures;
+    uint32_t stalls_total;
+    uint32_t stall_cycles;          // Циклов хотя бы с одним срабатыванием
+    uint32_t max_abs_error;
+    uint8_t peak_cs_max;
+    RunningStats cycle_ms;
+    RunningStats error_usteps;
+    RunningStats peak_cs;
+};
+
+inline void endurance_stats_reset(EnduranceStats &s) {
+    s.cycles = 0;
+    s.failed_cycles = 0;
+    s.consecutive_failures = 0;
+    s.stalls_total = 0;
+    s.stall_cycles = 0;
+    s.max_abs_error = 0;
+    s.peak_cs_max = 0;
+    running_stats_reset(s.cycle_ms);
+    running_stats_reset(s.error_usteps);
+    running_stats_reset(s.peak_cs);
+}
+
+// Учесть цикл. tolerance - допустимая |ошибка позиции|. Возвращает true, если цикл неудачный
+inline bool endurance_stats_add(EnduranceStats &s, const EnduranceCycleSample &c, uint32_t tolerance) {
+    uint32_t abs_error = c.position_error < 0 ? 0u - (uint32_t)c.position_error : (uint32_t)c.position_error;
+    bool failed = c.stalls > 0 || abs_error > tolerance;
+
+    s.cycles++;
+    running_stats_add(s.cycle_ms, c.duration_ms);
+    running_stats_add(s.error_usteps, c.position_error);
+    running_stats_add(s.peak_cs, c.peak_cs);
+    if (abs_error > s.max_abs_error) s.max_abs_error = abs_error;
+    if (c.peak_cs > s.peak_cs_max) s.peak_cs_max = c.peak_cs;
+    s.stalls_total += c.stalls;
+    if (c.stalls) s.stall_cycles++;
+
+    if (failed) {
+        s.failed_cycles++;
+        s.consecutive_failures++;
+    } else {
+        s.consecutive_failures = 0;
+    }
+    return failed;
+}
@@ -0,0 +1,219 @@
+#include "fault_monitor.h"
+#include "tmc.h"
+#include "pins.h"
+
+// Объявление функции для веб-логов (определена в web_server.cpp)
+extern void add_log_to_web(String message);
+// Событие для клиентов /api/events (определена в web_server.cpp)
+extern void publish_fault_event(const FaultLogEntry &entry);
+
+#define GCONF_DIAG0_ERROR (1UL << 5)
+#define GCONF_DIAG0_PUSHPULL (1UL << 12)
+
+static TaskHandle_t fault_task_handle = nullptr;
+
+// Пишет ISR
+static volatile uint32_t fault_isr_us = 0;
+static volatile uint32_t fault_diag_edges = 0;
+static volatile bool fault_hard_disabled = false;
+static volatile uint32_t fault_hard_latency_us = 0;
+static volatile bool fault_stall_routed = false;
+
+// Пишет задача ошибок, читают задача движения и AsyncTCP
+static volatile bool fault_stop_pending = false;
+static FaultMonitorStats fault_stats = {};
+static FaultLogEntry fault_log[FAULT_LOG_SIZE];
+static uint32_t fault_log_total = 0;
+static portMUX_TYPE fault_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void IRAM_ATTR diag0_isr() {
+    uint32_t now = micros();
+    fault_isr_us = now;
+    fault_diag_edges++;
+    stallguard_triggered = true;
+
+    // Stall на DIAG0 не выведен - это ошибка драйвера: EN без ожидания SPI и планировщика
+    if (!fault_stall_routed && motor_enabled) {
+        digitalWrite(EN_PIN, HIGH);
+        fault_hard_disabled = true;
+        fault_hard_latency_us = micros() - now;
+    }
+
+    BaseType_t woken = pdFALSE;
+    if (fault_task_handle) vTaskNotifyGiveFromISR(fault_task_handle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void fault_record(const FaultLogEntry &entry) {
+    portENTER_CRITICAL(&fault_mux);
+    fault_log[fault_log_total % FAULT_LOG_SIZE] = entry;
+    fault_log_total++;
+    portEXIT_CRITICAL(&fault_mux);
+}
+
+static void fault_handle_edge() {
+    uint32_t isr_us = fault_isr_us;
+    bool hard = fault_hard_disabled;
+
+    motor.lockBus();
+    uint32_t drv_status = motor.readRegisterDirect(TMC5160_Reg::DRV_STATUS);
+    uint32_t gstat = motor.readRegisterDirect(TMC5160_Reg::GSTAT);
+    motor.unlockBus();
+
+    uint16_t flags = driver_fault_decode(drv_status, gstat);
+    FaultAction action = driver_fault_action(flags, hard);
+
+    if (action == FAULT_ACT_NONE) {
+        portENTER_CRITICAL(&fault_mux);
+        fault_stats.stall_edges++;
+        portEXIT_CRITICAL(&fault_mux);
+        return;
+    }
+
+    FaultLogEntry entry = {};
+    entry.timestamp_ms = millis();
+    entry.flags = flags;
+    entry.action = action;
+    entry.hard_disable = hard;
+    entry.drv_status = drv_status;
+    entry.gstat = gstat;
+
+    if (action == FAULT_ACT_DISABLE) {
+        if (!hard) digitalWrite(EN_PIN, HIGH);
+        uint32_t soft_latency = micros() - isr_us;
+        entry.latency_us = hard ? fault_hard_latency_us : soft_latency;
+        motor_enabled = false;
+        fault_stop_pending = true;
+    }
+
+    portENTER_CRITICAL(&fault_mux);
+    entry.seq = fault_log_total + 1;
+    if (action == FAULT_ACT_DISABLE) {
+        fault_stats.faults++;
+        fault_stats.latched = true;
+        fault_stats.latched_flags = flags;
+        if (hard) {
+            fault_stats.hard_latency_last_us = entry.latency_us;
+            if (entry.latency_us > fault_stats.hard_latency_max_us) fault_stats.hard_latency_max_us = entry.latency_us;
+        } else {
+            fault_stats.soft_latency_last_us = entry.latency_us;
+            if (entry.latency_us > fault_stats.soft_latency_max_us) fault_stats.soft_latency_max_us = entry.latency_us;
+        }
+    } else {
+        fault_stats.warnings++;
+    }
+    portEXIT_CRITICAL(&fault_mux);
+    fault_record(entry);
+
+    char names[64];
+    driver_fault_describe(flags, names, sizeof(names));
+    if (action == FAULT_ACT_DISABLE) {
+        add_log_to_web("🚨 Driver fault (" + String(names) + ") - motor disabled in " + String(entry.latency_us) +
+                       " µs" + (hard ? " (ISR)" : ""));
+    } else {
+        add_log_to_web("⚠️ Driver warning: " + String(names));
+    }
+    publish_fault_event(entry);
+}
+
+static void fault_task(void *arg) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (!tmc_initialized) {
+            fault_hard_disabled = false;
+            continue;
+        }
+        fault_handle_edge();
+    }
+}
+
+void init_fault_monitor() {
+    if (fault_task_handle) return;
+
+    xTaskCreatePinnedToCore(fault_task, "fault", FAULT_TASK_STACK, nullptr,
+                            FAULT_TASK_PRIORITY, &fault_task_handle, FAULT_TASK_CORE);
+
+    pinMode(DIAG_PIN, INPUT_PULLDOWN);
+    attachInterrupt(digitalPinToInterrupt(DIAG_PIN), diag0_isr, RISING);
+    add_log("✅ Driver fault monitor on DIAG0 (GPIO" + String(DIAG_PIN) + ")");
+}
+
+void fault_monitor_configure() {
+    motor.lockBus();
+    uint32_t gconf = motor.readRegister(TMC5160_Reg::GCONF);
+    gconf |= GCONF_DIAG0_ERROR | GCONF_DIAG0_PUSHPULL;
+    motor.writeRegister(TMC5160_Reg::GCONF, gconf);
+    motor.unlockBus();
+}
+
+void fault_monitor_set_stall_routed(bool routed) {
+    fault_stall_routed = routed;
+}
+
+bool fault_monitor_take_stop() {
+    if (!fault_stop_pending) return false;
+    fault_stop_pending = false;
+    return true;
+}
+
+bool fault_monitor_rearm() {
+    if (!tmc_initialized) return false;
+
+    // drv_err/uv_cp защёлкнуты до записи 1 в GSTAT (reset не трогаем - его ловит run_motor)
+    motor.lockBus();
+    motor.writeRegister(TMC5160_Reg::GSTAT, GSTAT_DRV_ERR | GSTAT_UV_CP);
+    uint32_t drv_status = motor.readRegisterDirect(TMC5160_Reg::DRV_STATUS);
+    uint32_t gstat = motor.readRegisterDirect(TMC5160_Reg::GSTAT);
+    motor.unlockBus();
+
+    if (!driver_fault_cleared(drv_status, gstat)) {
+        char names[64];
+        driver_fault_describe(driver_fault_decode(drv_status, gstat), names, sizeof(names));
+        add_log_to_web("❌ Driver fault still active (" + String(names) + ") - motor stays disabled");
+        return false;
+    }
+
+    fault_hard_disabled = false;
+    portENTER_CRITICAL(&fault_mux);
+    fault_stats.latched = false;
+    fault_stats.latched_flags = 0;
+    portEXIT_CRITICAL(&fault_mux);
+    return true;
+}
+
+bool is_fault_latched() {
+    return fault_stats.latched;
+}
+
+FaultMonitorStats get_fault_monitor_stats() {
+    portENTER_CRITICAL(&fault_mux);
+    FaultMonitorStats s = fault_stats;
+    portEXIT_CRITICAL(&fault_mux);
+    s.diag_edges = fault_diag_edges;
+    s.stall_routed = fault_stall_routed;
+    return s;
+}
+
+uint8_t get_fault_log(FaultLogEntry *out, uint8_t max_entries) {
+    portENTER_CRITICAL(&fault_mux);
+    uint32_t count = fault_log_total < FAULT_LOG_SIZE ? fault_log_total : FAULT_LOG_SIZE;
+    if (count > max_entries) count = max_entries;
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = fault_log[(fault_log_total - count + i) % FAULT_LOG_SIZE];
+    }
+    portEXIT_CRITICAL(&fault_mux);
+    return (uint8_t)count;
+}
+
+void clear_fault_log() {
+    portENTER_CRITICAL(&fault_mux);
+    fault_log_total = 0;
+    fault_stats.stall_edges = 0;
+    fault_stats.faults = 0;
+    fault_stats.warnings = 0;
+    fault_stats.hard_latency_last_us = 0;
+    fault_stats.hard_latency_max_us = 0;
+    fault_stats.soft_latency_last_us = 0;
+    fault_stats.soft_latency_max_us = 0;
+    portEXIT_CRITICAL(&fault_mux);
+}
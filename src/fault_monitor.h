@@ -0,0 +1,63 @@
+#pragma once
+#include <Arduino.h>
+#include "driver_fault.h"
+
+// ============================================================================
+// ОШИБКИ ДРАЙВЕРА ПО DIAG0 (ПРЕРЫВАНИЕ ВМЕСТО ОПРОСА РЕГИСТРОВ)
+// ============================================================================
+// GCONF.diag0_error выводит ошибки драйвера на DIAG0 (тот же вывод, что и StallGuard,
+// push-pull активный HIGH). Предупреждение о перегреве (otpw) не выводится - оно не повод
+// снимать EN в ISR, в журнал попадает вместе с ближайшим фронтом. diag0_isr():
+//  - StallGuard на DIAG0 не выведен - любой фронт это ошибка, EN снимается прямо в ISR;
+//  - выведен (хоминг, порог в настройках) - будит задачу ошибок, она читает DRV_STATUS/GSTAT
+//    и решает (driver_fault.h): stall - пропуск, ошибка - снять EN.
+// Задача движения останавливает рампу/хоминг/свип по fault_monitor_take_stop().
+
+#define FAULT_LOG_SIZE 16
+#define FAULT_TASK_CORE 1
+#define FAULT_TASK_PRIORITY 4       // Выше задачи движения (3)
+#define FAULT_TASK_STACK 4096
+
+struct FaultLogEntry {
+    uint32_t seq;
+    uint32_t timestamp_ms;
+    uint16_t flags;                 // DriverFaultFlag
+    FaultAction action;
+    bool hard_disable;              // EN снят в ISR
+    uint32_t drv_status;
+    uint32_t gstat;
+    uint32_t latency_us;            // Фронт DIAG0 → EN снят (для WARN - 0)
+};
+
+struct FaultMonitorStats {
+    uint32_t diag_edges;            // Все фронты DIAG0
+    uint32_t stall_edges;           // Из них StallGuard (без ошибок)
+    uint32_t faults;                // Отключений
+    uint32_t warnings;
+    bool latched;                   // Мотор отключён по ошибке, ждёт включения
+    uint16_t latched_flags;
+    bool stall_routed;              // StallGuard выведен на DIAG0 - решает задача, не ISR
+    uint32_t hard_latency_last_us;  // ISR: фронт → EN
+    uint32_t hard_latency_max_us;
+    uint32_t soft_latency_last_us;  // Задача: фронт → чтение регистров → EN
+    uint32_t soft_latency_max_us;
+};
+
+// Прерывание и задача (после setup_tmc5160)
+void init_fault_monitor();
+// GCONF: ошибки драйвера на DIAG0, push-pull активный HIGH (из setup_tmc5160)
+void fault_monitor_configure();
+// StallGuard выведен на DIAG0 (GCONF.diag0_stall) - из setup_stallguard
+void fault_monitor_set_stall_routed(bool routed);
+void IRAM_ATTR diag0_isr();
+
+// Задача движения: true один раз после отключения по ошибке - остановить всё движение
+bool fault_monitor_take_stop();
+// Перед включением мотора: сброс GSTAT.drv_err/uv_cp, false - ошибка ещё активна
+bool fault_monitor_rearm();
+
+bool is_fault_latched();
+FaultMonitorStats get_fault_monitor_stats();
+// Журнал от старых к новым, возвращает число записей
+uint8_t get_fault_log(FaultLogEntry *out, uint8_t max_entries);
+void clear_fault_log();
@@ -0,0 +1,114 @@
+#include "health_monitor.h"
+#include "tmc.h"
+#include "homing.h"
+#include "sg_tuning.h"
+
+// Объявление функции для веб-логов (определена в web_server.cpp)
+extern void add_log_to_web(String message);
+
+// Пишет задача движения, читает AsyncTCP (копия под спинлоком)
+static DeratePolicy derate_policy = derate_default_policy();
+static bool derating_enabled = true;
+static HealthStatus health = {};
+static bool health_started = false;
+static volatile bool health_reapply_pending = false;
+static uint32_t health_last_sample_ms = 0;
+static portMUX_TYPE health_mux = portMUX_INITIALIZER_UNLOCKED;
+
+uint8_t get_derate_percent() {
+    return health_started ? health.percent : 100;
+}
+
+HealthStatus get_health_status() {
+    portENTER_CRITICAL(&health_mux);
+    HealthStatus s = health;
+    portEXIT_CRITICAL(&health_mux);
+    s.derating_enabled = derating_enabled;
+    s.percent = get_derate_percent();
+    s.requested_mA = get_requested_motor_current();
+    s.effective_mA = derate_current(s.requested_mA, s.percent);
+    return s;
+}
+
+DeratePolicy get_derate_policy() {
+    portENTER_CRITICAL(&health_mux);
+    DeratePolicy p = derate_policy;
+    portEXIT_CRITICAL(&health_mux);
+    return p;
+}
+
+void set_derate_policy(const DeratePolicy &policy, bool enabled) {
+    portENTER_CRITICAL(&health_mux);
+    derate_policy = policy;
+    derating_enabled = enabled;
+    portEXIT_CRITICAL(&health_mux);
+    // Задача движения пересчитает ток на следующем опросе
+    health_reapply_pending = true;
+}
+
+void reset_health_stats() {
+    portENTER_CRITICAL(&health_mux);
+    uint8_t percent = health.percent;
+    derate_reset(health.derate, millis());
+    // Текущее снижение остаётся - сбрасываются только счётчики
+    health.derate.percent = percent;
+    health.derate.min_reached = percent;
+    health.samples = 0;
+    health.cs_min = 31;
+    health.cs_max = 0;
+    portEXIT_CRITICAL(&health_mux);
+}
+
+void health_monitor_tick() {
+    if (!tmc_initialized) return;
+
+    uint32_t now = millis();
+    if (!health_started) {
+        derate_reset(health.derate, now);
+        health.percent = 100;
+        health.cs_min = 31;
+        health_started = true;
+    }
+    if (now - health_last_sample_ms < DERATE_SAMPLE_PERIOD_MS) return;
+    health_last_sample_ms = now;
+
+    TMC5160_Reg::DRV_STATUS_Register drv = {0};
+    drv.value = motor.readRegisterDirect(TMC5160_Reg::DRV_STATUS);
+
+    portENTER_CRITICAL(&health_mux);
+    health.samples++;
+    health.otpw = drv.otpw;
+    health.ot = drv.ot;
+    if (!drv.stst) {
+        health.cs_actual = drv.cs_actual;
+        if (drv.cs_actual < health.cs_min) health.cs_min = drv.cs_actual;
+        if (drv.cs_actual > health.cs_max) health.cs_max = drv.cs_actual;
+    }
+    uint8_t old_percent = health.percent;
+    DerateDecision decision = DERATE_NONE;
+    if (derating_enabled) {
+        decision = derate_update(health.derate, derate_policy, drv.otpw, drv.ot, now);
+        health.percent = health.derate.percent;
+    } else {
+        // Без снижения - только учёт otpw
+        derate_update(health.derate, derate_policy, drv.otpw, false, now);
+        health.derate.percent = 100;
+        health.percent = 100;
+    }
+    uint8_t percent = health.percent;
+    portEXIT_CRITICAL(&health_mux);
+
+    if (decision != DERATE_NONE || percent != old_percent) {
+        uint16_t requested = get_requested_motor_current();
+        add_log_to_web(String(decision == DERATE_STEP_UP || percent > old_percent ? "🌡️ Driver cooled" : "🌡️ Driver hot (otpw)") +
+                       " - current " + String(percent) + "% (" + String(derate_current(requested, percent)) +
+                       " of " + String(requested) + " mA)");
+        health_reapply_pending = true;
+    }
+
+    // Хоминг и свип SGT задают ток сами и восстанавливают его через set_motor_current()
+    if (health_reapply_pending && !is_homing_active() && !is_sg_tune_active()) {
+        health_reapply_pending = false;
+        reapply_motor_current();
+    }
+}
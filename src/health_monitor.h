@@ -0,0 +1,35 @@
+#pragma once
+#include <Arduino.h>
+#include "thermal_derating.h"
+
+// ============================================================================
+// ФОНОВЫЙ КОНТРОЛЬ ДРАЙВЕРА И ТЕПЛОВОЕ СНИЖЕНИЕ ТОКА
+// ============================================================================
+// Задача движения раз в DERATE_SAMPLE_PERIOD_MS читает DRV_STATUS (otpw, ot, CS_ACTUAL) и
+// ведёт политику thermal_derating.h. Снижение применяется через set_motor_current(): ток
+// настроек/команды остаётся "заказанным", в чип пишется его доля get_derate_percent().
+// Во время хоминга и свипа SGT ток не меняется - применится после них.
+
+struct HealthStatus {
+    bool derating_enabled;
+    uint32_t samples;
+    bool otpw;
+    bool ot;
+    uint8_t cs_actual;          // Последний CS_ACTUAL (0..31)
+    uint8_t cs_min;
+    uint8_t cs_max;
+    uint8_t percent;            // Текущая доля тока
+    uint16_t requested_mA;      // Ток настроек/команды
+    uint16_t effective_mA;      // Записанный в чип
+    DerateState derate;         // События и время на сниженном токе
+};
+
+// Задача движения: каждую итерацию (опрос по своему периоду)
+void health_monitor_tick();
+
+uint8_t get_derate_percent();
+HealthStatus get_health_status();
+DeratePolicy get_derate_policy();
+// Из AsyncTCP. Выключение - ток сразу возвращается к 100%
+void set_derate_policy(const DeratePolicy &policy, bool enabled);
+void reset_health_stats();
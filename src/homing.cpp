@@ -0,0 +1,231 @@
+#include "homing.h"
+#include "tmc.h"
+#include "eeprom_manager.h"
+#include "move_events.h"
+
+// Объявление функции для веб-логов (определена в web_server.cpp)
+extern void add_log_to_web(String message);
+
+#define SW_MODE_SG_STOP (1UL << 10)
+
+// Автомат и статистика: пишет задача движения, читает AsyncTCP (копия под спинлоком)
+static HomingMachine homing_machine = {};
+static HomingConfig homing_config = homing_default_config();
+static HomingStatus homing_status = {};
+static portMUX_TYPE homing_mux = portMUX_INITIALIZER_UNLOCKED;
+
+HomingConfig homing_default_config() {
+    HomingConfig c;
+    c.phases[HOMING_PHASE_FAST].speed = HOMING_DEFAULT_FAST_SPEED;
+    c.phases[HOMING_PHASE_FAST].current_mA = HOMING_DEFAULT_FAST_CURRENT;
+    c.phases[HOMING_PHASE_FAST].sgt = HOMING_DEFAULT_FAST_SGT;
+    c.phases[HOMING_PHASE_BACKOFF].speed = HOMING_DEFAULT_BACKOFF_SPEED;
+    c.phases[HOMING_PHASE_BACKOFF].current_mA = HOMING_DEFAULT_BACKOFF_CURRENT;
+    c.phases[HOMING_PHASE_BACKOFF].sgt = 0;
+    c.phases[HOMING_PHASE_SLOW].speed = HOMING_DEFAULT_SLOW_SPEED;
+    c.phases[HOMING_PHASE_SLOW].current_mA = HOMING_DEFAULT_SLOW_CURRENT;
+    c.phases[HOMING_PHASE_SLOW].sgt = HOMING_DEFAULT_SLOW_SGT;
+    c.direction = HOMING_DEFAULT_DIRECTION;
+    c.backoff_steps = HOMING_DEFAULT_BACKOFF_STEPS;
+    c.timeout_ms = HOMING_DEFAULT_TIMEOUT_MS;
+    return c;
+}
+
+HomingConfig get_homing_config() {
+    portENTER_CRITICAL(&homing_mux);
+    HomingConfig c = homing_config;
+    portEXIT_CRITICAL(&homing_mux);
+    return c;
+}
+
+bool homing_configure(const HomingConfig &config) {
+    if (is_homing_active()) return false;
+    portENTER_CRITICAL(&homing_mux);
+    homing_config = config;
+    portEXIT_CRITICAL(&homing_mux);
+    return true;
+}
+
+bool is_homing_active() {
+    return homing_active(homing_machine);
+}
+
+HomingStatus get_homing_status() {
+    portENTER_CRITICAL(&homing_mux);
+    HomingStatus s = homing_status;
+    portEXIT_CRITICAL(&homing_mux);
+    return s;
+}
+
+void homing_invalidate_origin() {
+    portENTER_CRITICAL(&homing_mux);
+    homing_status.origin_valid = false;
+    portEXIT_CRITICAL(&homing_mux);
+}
+
+static void homing_publish_state() {
+    portENTER_CRITICAL(&homing_mux);
+    homing_status.state = homing_machine.state;
+    homing_status.error = homing_machine.error;
+    homing_status.fast_latch = homing_machine.fast_latch;
+    homing_status.slow_latch = homing_machine.slow_latch;
+    portEXIT_CRITICAL(&homing_mux);
+}
+
+// Остановка по StallGuard (SW_MODE.sg_stop). Событие event_stop_sg сбрасывается записью 1 -
+// пока оно стоит, чип держит мотор остановленным
+static void homing_set_stall_stop(bool enable) {
+    motor.lockBus();
+    uint32_t sw_mode = motor.readRegister(TMC5160_Reg::SW_MODE);
+    sw_mode = enable ? (sw_mode | SW_MODE_SG_STOP) : (sw_mode & ~SW_MODE_SG_STOP);
+    motor.writeRegister(TMC5160_Reg::SW_MODE, sw_mode);
+    motor.writeRegister(TMC5160_Reg::RAMP_STAT, motor.readRegisterDirect(TMC5160_Reg::RAMP_STAT));
+    motor.unlockBus();
+    stallguard_triggered = false;
+}
+
+// Снять остановку по упору. Сначала мотор стоит в позиционировании на месте (VMAX = 0,
+// XTARGET = XACTUAL, RAMPMODE = 0), потом снимается sg_stop: иначе с VMAX режима скорости
+// чип сразу снова давит в упор. Рампа из настроек возвращается уже после снятия
+static void homing_release_stall() {
+    motor.lockBus();
+    uint32_t xactual = motor.readRegisterDirect(TMC5160_Reg::XACTUAL);
+    motor.writeRegister(TMC5160_Reg::VMAX, 0);
+    motor.writeRegister(TMC5160_Reg::XTARGET, xactual);
+    motor.writeRegister(TMC5160_Reg::RAMPMODE, 0);
+    motor.unlockBus();
+    homing_set_stall_stop(false);
+    leave_jog_mode();
+}
+
+// Ток и порог StallGuard после хоминга - из настроек
+static void homing_restore_settings() {
+    homing_set_stall_stop(false);
+    set_motor_current(currentSettings.current_mA, currentSettings.hold_multiplier);
+    setup_stallguard(currentSettings.stallguard_threshold, currentSettings.stallguard_tcoolthrs);
+}
+
+static void homing_finish(bool ok) {
+    homing_restore_settings();
+
+    portENTER_CRITICAL(&homing_mux);
+    homing_status.last_duration_ms = homing_machine.duration_ms;
+    if (ok) {
+        homing_status.successes++;
+        // Прошлый ноль не сбрасывался - точка упора в его системе и есть ошибка повторяемости
+        if (homing_status.origin_valid) homing_repeatability_add(homing_status.repeat, homing_machine.slow_latch);
+        homing_status.origin_valid = true;
+    } else {
+        homing_status.failures++;
+    }
+    portEXIT_CRITICAL(&homing_mux);
+    homing_publish_state();
+
+    if (ok) {
+        add_log_to_web("🏠 Homing done in " + String(homing_machine.duration_ms) + " ms (stall at " +
+                       String(homing_machine.slow_latch) + " µsteps)");
+    } else {
+        add_log_to_web("❌ Homing failed: " + String(homing_machine.error ? homing_machine.error : "aborted"));
+    }
+}
+
+// Начало координат в точке упора: XACTUAL -= latch (по модулю 2^32, см. usteps.h)
+static void homing_set_origin(int32_t latch) {
+    set_position_usteps(usteps_diff(read_position_usteps(), latch));
+}
+
+static void homing_execute(const HomingCommand &cmd) {
+    const HomingPhaseConfig &phase = homing_machine.config.phases[cmd.phase];
+
+    switch (cmd.action) {
+        case HOMING_ACT_APPROACH:
+            homing_set_stall_stop(false);
+            set_motor_current(phase.current_mA, currentSettings.hold_multiplier);
+            setup_stallguard(phase.sgt);
+            set_jog_speed(cmd.velocity);
+            break;
+
+        case HOMING_ACT_ARM_STALL:
+            homing_set_stall_stop(true);
+            break;
+
+        case HOMING_ACT_MOVE: {
+            // Мотор стоит на упоре (sg_stop) - снимаем событие и отъезжаем позиционированием
+            homing_release_stall();
+            set_motor_current(phase.current_mA, currentSettings.hold_multiplier);
+            RampProfile ramp = get_ramp_profile(currentSettings);
+            ramp.vmax = phase.speed;
+            if (ramp.vstart > ramp.vmax) ramp.vstart = ramp.vmax;
+            if (ramp.v1 > ramp.vmax) ramp.v1 = 0;
+            if (ramp.vstop < ramp.vstart) ramp.vstop = ramp.vstart;
+            apply_ramp_profile(ramp);
+            move_motor_steps(cmd.steps, MODE_MOTION_CONTROLLER);
+            break;
+        }
+
+        case HOMING_ACT_SET_ORIGIN:
+            homing_release_stall();
+            homing_set_origin(cmd.latch);
+            apply_ramp_profile(get_ramp_profile(currentSettings));
+            homing_finish(true);
+            return;
+
+        case HOMING_ACT_ABORT:
+            homing_release_stall();
+            homing_finish(false);
+            return;
+
+        default:
+            return;
+    }
+    homing_publish_state();
+}
+
+void homing_start() {
+    if (is_homing_active()) return;
+
+    if (!tmc_initialized || !motor_enabled) {
+        add_log_to_web("❌ Homing: motor is not enabled");
+        return;
+    }
+    if (currentSettings.control_mode != MODE_MOTION_CONTROLLER) {
+        add_log_to_web("❌ Homing requires SPI motion controller mode");
+        return;
+    }
+
+    portENTER_CRITICAL(&homing_mux);
+    homing_status.runs++;
+    portEXIT_CRITICAL(&homing_mux);
+
+    add_log_to_web("🏠 Homing started");
+    homing_execute(homing_begin(homing_machine, get_homing_config(), millis()));
+}
+
+void homing_abort(const char *reason) {
+    if (!is_homing_active()) return;
+    homing_execute(homing_fail(homing_machine, millis(), reason));
+}
+
+void homing_tick() {
+    if (!is_homing_active()) return;
+
+    if (!tmc_initialized || !motor_enabled) {
+        homing_abort("motor disabled during homing");
+        return;
+    }
+
+    HomingInputs in;
+    in.now_ms = millis();
+
+    TMC5160_Reg::RAMP_STAT_Register ramp = {0};
+    ramp.value = motor.readRegisterDirect(TMC5160_Reg::RAMP_STAT);
+    in.velocity_reached = ramp.velocity_reached;
+    // Фронт DIAG0 (ISR) или событие остановки по StallGuard в самом чипе
+    in.stall = stallguard_triggered || ramp.event_stop_sg;
+    stallguard_triggered = false;
+
+    in.move_done = !move_in_flight();
+    in.xactual = (int32_t)motor.readRegisterDirect(TMC5160_Reg::XACTUAL);
+
+    homing_execute(homing_update(homing_machine, in));
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <Arduino.h>
+#include "homing_machine.h"
+
+// ============================================================================
+// SENSORLESS HOMING НА TMC5160 (StallGuard2 + sg_stop)
+// ============================================================================
+// Автомат из homing_machine.h, исполняемый задачей движения: подходы - режим скорости
+// (RAMPMODE 1/2), остановка на упоре - аппаратно по StallGuard (SW_MODE.sg_stop),
+// фронт ловит diag0_isr() (fault_monitor.h). Только режим MODE_MOTION_CONTROLLER.
+
+// Параметры по умолчанию (шаги/с, мА, SGT)
+#define HOMING_DEFAULT_DIRECTION -1
+#define HOMING_DEFAULT_FAST_SPEED 800
+#define HOMING_DEFAULT_FAST_CURRENT 600
+#define HOMING_DEFAULT_FAST_SGT 8
+#define HOMING_DEFAULT_BACKOFF_SPEED 400
+#define HOMING_DEFAULT_BACKOFF_CURRENT 800
+#define HOMING_DEFAULT_BACKOFF_STEPS 100
+#define HOMING_DEFAULT_SLOW_SPEED 200
+#define HOMING_DEFAULT_SLOW_CURRENT 500
+#define HOMING_DEFAULT_SLOW_SGT 6
+#define HOMING_DEFAULT_TIMEOUT_MS 20000
+
+struct HomingStatus {
+    HomingState state;
+    const char *error;
+    uint32_t runs;
+    uint32_t successes;
+    uint32_t failures;
+    uint32_t last_duration_ms;
+    int32_t fast_latch;             // XACTUAL на упоре (микрошаги, до установки нуля)
+    int32_t slow_latch;
+    bool origin_valid;              // Ноль задан хомингом и с тех пор не сбрасывался
+    HomingRepeatability repeat;     // slow_latch в системе прошлого хоминга (идеал - 0)
+};
+
+HomingConfig homing_default_config();
+HomingConfig get_homing_config();
+// Новые параметры (из AsyncTCP). false - хоминг идёт, менять нельзя
+bool homing_configure(const HomingConfig &config);
+
+// Задача движения: старт, отмена и обслуживание (каждую итерацию)
+void homing_start();
+void homing_abort(const char *reason);
+void homing_tick();
+
+bool is_homing_active();
+HomingStatus get_homing_status();
+// Позиция сброшена не хомингом - следующий хоминг не даёт выборку повторяемости
+void homing_invalidate_origin();
@@ -0,0 +1,217 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================================
+// SENSORLESS HOMING - КОНЕЧНЫЙ АВТОМАТ (ЧИСТАЯ ЛОГИКА)
+// ============================================================================
+// Фазы: быстрый подход до упора → отъезд → медленный подход. На фронте StallGuard
+// фиксируется XACTUAL; точка остановки медленного подхода становится началом координат.
+// Автомат не знает про железо: получает входы (время, RAMP_STAT, сработку StallGuard,
+// XACTUAL) и выдаёт команды. На чипе их исполняет homing.cpp, на хосте - модель упора
+// в test/test_homing_machine (тот же код автомата, упор и StallGuard симулируются).
+
+enum HomingState : uint8_t {
+    HOMING_IDLE = 0,
+    HOMING_FAST_APPROACH,
+    HOMING_BACKOFF,
+    HOMING_SLOW_APPROACH,
+    HOMING_DONE,
+    HOMING_FAILED
+};
+
+enum HomingPhaseId : uint8_t {
+    HOMING_PHASE_FAST = 0,
+    HOMING_PHASE_BACKOFF,
+    HOMING_PHASE_SLOW,
+    HOMING_PHASE_COUNT
+};
+
+struct HomingPhaseConfig {
+    uint32_t speed;         // Шаги/с
+    uint16_t current_mA;
+    int8_t sgt;             // Порог StallGuard (-64..63), для отъезда не используется
+};
+
+struct HomingConfig {
+    HomingPhaseConfig phases[HOMING_PHASE_COUNT];
+    int8_t direction;       // +1 / -1 - в сторону упора
+    uint32_t backoff_steps;
+    uint32_t timeout_ms;    // На каждую фазу
+};
+
+enum HomingAction : uint8_t {
+    HOMING_ACT_NONE = 0,
+    HOMING_ACT_APPROACH,    // Вращение со скоростью velocity, StallGuard ещё не взведён
+    HOMING_ACT_ARM_STALL,   // Скорость набрана - взвести остановку по StallGuard
+    HOMING_ACT_MOVE,        // Относительное движение на steps (отъезд)
+    HOMING_ACT_SET_ORIGIN,  // Начало координат в точке latch (XACTUAL)
+    HOMING_ACT_ABORT        // Остановить мотор (таймаут/отмена)
+};
+
+struct HomingCommand {
+    HomingAction action;
+    uint8_t phase;          // HomingPhaseId - скорость/ток/SGT для команды
+    int32_t velocity;       // Шаги/с со знаком (APPROACH)
+    int32_t steps;          // MOVE
+    int32_t latch;          // SET_ORIGIN
+};
+
+struct HomingInputs {
+    uint32_t now_ms;
+    bool velocity_reached;  // RAMP_STAT.velocity_reached
+    bool stall;             // Фронт StallGuard с прошлого вызова
+    bool move_done;         // Отъезд завершён
+    int32_t xactual;
+};
+
+struct HomingMachine {
+    HomingConfig config;
+    HomingState state;
+    bool armed;             // StallGuard взведён (до набора скорости сработки игнорируются)
+    uint32_t start_ms;
+    uint32_t phase_start_ms;
+    int32_t fast_latch;     // XACTUAL на упоре: быстрый и медленный подход
+    int32_t slow_latch;
+    uint32_t duration_ms;
+    const char *error;
+};
+
+inline const char* homing_state_name(HomingState state) {
+    switch (state) {
+        case HOMING_IDLE: return "idle";
+        case HOMING_FAST_APPROACH: return "fast_approach";
+        case HOMING_BACKOFF: return "backoff";
+        case HOMING_SLOW_APPROACH: return "slow_approach";
+        case HOMING_DONE: return "done";
+        case HOMING_FAILED: return "failed";
+        default: return "unknown";
+    }
+}
+
+inline bool homing_active(const HomingMachine &m) {
+    return m.state == HOMING_FAST_APPROACH || m.state == HOMING_BACKOFF || m.state == HOMING_SLOW_APPROACH;
+}
+
+// nullptr - корректна, иначе текст ошибки
+inline const char* homing_config_validate(const HomingConfig &c) {
+    if (c.direction != 1 && c.direction != -1) return "direction must be 1 or -1";
+    for (uint8_t i = 0; i < HOMING_PHASE_COUNT; i++) {
+        if (c.phases[i].speed == 0) return "phase speed must be > 0";
+        if (c.phases[i].sgt < -64 || c.phases[i].sgt > 63) return "sgt must be -64..63";
+    }
+    if (c.phases[HOMING_PHASE_SLOW].speed > c.phases[HOMING_PHASE_FAST].speed) {
+        return "slow approach must not be faster than fast approach";
+    }
+    if (c.backoff_steps == 0) return "backoff_steps must be > 0";
+    if (c.timeout_ms == 0) return "timeout_ms must be > 0";
+    return nullptr;
+}
+
+inline HomingCommand homing_command(HomingAction action, uint8_t phase) {
+    HomingCommand cmd = {};
+    cmd.action = action;
+    cmd.phase = phase;
+    return cmd;
+}
+
+inline HomingCommand homing_approach(HomingMachine &m, HomingState state, uint8_t phase, uint32_t now_ms) {
+    m.state = state;
+    m.armed = false;
+    m.phase_start_ms = now_ms;
+    HomingCommand cmd = homing_command(HOMING_ACT_APPROACH, phase);
+    cmd.velocity = m.config.direction * (int32_t)m.config.phases[phase].speed;
+    return cmd;
+}
+
+inline HomingCommand homing_begin(HomingMachine &m, const HomingConfig &config, uint32_t now_ms) {
+    m.config = config;
+    m.start_ms = now_ms;
+    m.fast_latch = 0;
+    m.slow_latch = 0;
+    m.duration_ms = 0;
+    m.error = nullptr;
+    return homing_approach(m, HOMING_FAST_APPROACH, HOMING_PHASE_FAST, now_ms);
+}
+
+inline HomingCommand homing_fail(HomingMachine &m, uint32_t now_ms, const char *error) {
+    m.state = HOMING_FAILED;
+    m.armed = false;
+    m.error = error;
+    m.duration_ms = now_ms - m.start_ms;
+    return homing_command(HOMING_ACT_ABORT, HOMING_PHASE_FAST);
+}
+
+// Один шаг автомата (вызывать периодически, пока homing_active)
+inline HomingCommand homing_update(HomingMachine &m, const HomingInputs &in) {
+    switch (m.state) {
+        case HOMING_FAST_APPROACH:
+        case HOMING_SLOW_APPROACH: {
+            bool fast = m.state == HOMING_FAST_APPROACH;
+            if (m.armed && in.stall) {
+                m.armed = false;
+                if (fast) {
+                    m.fast_latch = in.xactual;
+                    m.state = HOMING_BACKOFF;
+                    m.phase_start_ms = in.now_ms;
+                    HomingCommand cmd = homing_command(HOMING_ACT_MOVE, HOMING_PHASE_BACKOFF);
+                    cmd.steps = -m.config.direction * (int32_t)m.config.backoff_steps;
+                    return cmd;
+                }
+                m.slow_latch = in.xactual;
+                m.state = HOMING_DONE;
+                m.duration_ms = in.now_ms - m.start_ms;
+                HomingCommand cmd = homing_command(HOMING_ACT_SET_ORIGIN, HOMING_PHASE_SLOW);
+                cmd.latch = m.slow_latch;
+                return cmd;
+            }
+            // Во время разгона StallGuard ненадёжен - взводим только на заданной скорости
+            if (!m.armed && in.velocity_reached) {
+                m.armed = true;
+                return homing_command(HOMING_ACT_ARM_STALL, fast ? HOMING_PHASE_FAST : HOMING_PHASE_SLOW);
+            }
+            if (in.now_ms - m.phase_start_ms >= m.config.timeout_ms) {
+                return homing_fail(m, in.now_ms, fast ? "fast approach: no stall before timeout" :
+                                                        "slow approach: no stall before timeout");
+            }
+            return homing_command(HOMING_ACT_NONE, 0);
+        }
+
+        case HOMING_BACKOFF:
+            if (in.move_done) return homing_approach(m, HOMING_SLOW_APPROACH, HOMING_PHASE_SLOW, in.now_ms);
+            if (in.now_ms - m.phase_start_ms >= m.config.timeout_ms) {
+                return homing_fail(m, in.now_ms, "backoff: move did not finish");
+            }
+            return homing_command(HOMING_ACT_NONE, 0);
+
+        default:
+            return homing_command(HOMING_ACT_NONE, 0);
+    }
+}
+
+// ===== ПОВТОРЯЕМОСТЬ =====
+// Разброс точки упора (в микрошагах) между последовательными хомингами
+
+struct HomingRepeatability {
+    uint32_t samples;
+    int32_t min;
+    int32_t max;
+    int64_t sum;
+};
+
+inline void homing_repeatability_reset(HomingRepeatability &r) {
+    r.samples = 0;
+    r.min = 0;
+    r.max = 0;
+    r.sum = 0;
+}
+
+inline void homing_repeatability_add(HomingRepeatability &r, int32_t value) {
+    if (r.samples == 0 || value < r.min) r.min = value;
+    if (r.samples == 0 || value > r.max) r.max = value;
+    r.sum += value;
+    r.samples++;
+}
+
+inline uint32_t homing_repeatability_spread(const HomingRepeatability &r) {
+    return r.samples ? (uint32_t)(r.max - r.min) : 0;
+}
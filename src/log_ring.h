@@ -0,0 +1,367 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+
+// ============================================================================
+// ЛОГ ДЛЯ ВЕБ-ИНТЕРФЕЙСА - КОЛЬЦО ДВОИЧНЫХ ЗАПИСЕЙ (ЧИСТАЯ ЛОГИКА)
+// ============================================================================
+// Запись - заголовок 8 байт (время, уровень, метка, id сообщения, длина) и полезная нагрузка:
+// текст как есть или до 4 аргументов int32 для сообщений с id (LogMsgId). Ведущий смайлик
+// или "[МЕТКА] " превращается в LogTag при записи; время, метки и смайлики внутри текста
+// переводятся в текст только при чтении (log_render). Кольцо - массив фиксированного размера:
+// ни одной аллокации на запись, старые записи вытесняются целиком. Номера записей (seq)
+// сквозные - клиенты читают с курсора.
+
+#define LOG_RING_BYTES 12288
+#define LOG_RECORD_HEADER 8
+#define LOG_PAYLOAD_MAX 255
+#define LOG_EVENT_ARGS 4
+#define LOG_RENDER_MAX 320              // Строка после рендера (с временем и метками)
+
+enum LogLevel : uint8_t {
+    LOG_LEVEL_ERROR = 1,
+    LOG_LEVEL_WARN  = 2,
+    LOG_LEVEL_INFO  = 3,
+    LOG_LEVEL_DEBUG = 4
+};
+
+enum LogTag : uint8_t {
+    LOG_TAG_NONE = 0,
+    LOG_TAG_OK,
+    LOG_TAG_ERROR,
+    LOG_TAG_WARN,
+    LOG_TAG_MOVE,
+    LOG_TAG_SWITCH,
+    LOG_TAG_CONFIG,
+    LOG_TAG_ENABLE,
+    LOG_TAG_DISABLE,
+    LOG_TAG_INFO,
+    LOG_TAG_CENTER,
+    LOG_TAG_STOP,
+    LOG_TAG_SAVE,
+    LOG_TAG_SETTINGS,
+    LOG_TAG_TEST,
+    LOG_TAG_TIME,
+    LOG_TAG_CYCLES,
+    LOG_TAG_CLEAR,
+    LOG_TAG_STATS,
+    LOG_TAG_FAIL,
+    LOG_TAG_COUNT
+};
+
+// Сообщения с аргументами: текст собирается только при чтении (горячие пути)
+enum LogMsgId : uint8_t {
+    LOG_MSG_TEXT = 0,               // Нагрузка - текст
+    LOG_MSG_SOLENOID_SWITCH,        // позиция (0 - A, 1 - B), попытка, из
+    LOG_MSG_SOLENOID_OK,            // позиция, датчик, мс
+    LOG_MSG_SOLENOID_FAIL,          // позиция, датчик, попытка, из
+    LOG_MSG_COUNT,
+    LOG_MSG_WRAP = 0xFF             // Служебная: дальше до конца массива пусто, запись с начала
+};
+
+inline const char* log_tag_text(LogTag tag) {
+    static const char *const names[LOG_TAG_COUNT] = {
+        "", "[OK]", "[ERROR]", "[WARN]", "[MOVE]", "[SWITCH]", "[CONFIG]", "[ENABLE]", "[DISABLE]",
+        "[INFO]", "[CENTER]", "[STOP]", "[SAVE]", "[SETTINGS]", "[TEST]", "[TIME]", "[CYCLES]",
+        "[CLEAR]", "[STATS]", "[FAIL]"
+    };
+    return tag < LOG_TAG_COUNT ? names[tag] : "";
+}
+
+struct LogEmoji {
+    const char *utf8;
+    LogTag tag;
+};
+
+// Смайлики, которые в тексте лога заменяются метками (как раньше replace_emojis)
+inline const LogEmoji* log_emoji_table(size_t &count) {
+    static const LogEmoji table[] = {
+        {"✅", LOG_TAG_OK}, {"❌", LOG_TAG_ERROR}, {"⚠️", LOG_TAG_WARN}, {"🚀", LOG_TAG_MOVE},
+        {"🔄", LOG_TAG_SWITCH}, {"🔧", LOG_TAG_CONFIG}, {"🔋", LOG_TAG_ENABLE}, {"🔌", LOG_TAG_DISABLE},
+        {"📊", LOG_TAG_INFO}, {"🎯", LOG_TAG_CENTER}, {"🚨", LOG_TAG_STOP}, {"💾", LOG_TAG_SAVE},
+        {"⚙️", LOG_TAG_SETTINGS}, {"⏹️", LOG_TAG_STOP}, {"🧪", LOG_TAG_TEST}, {"🛑", LOG_TAG_STOP},
+        {"⏱️", LOG_TAG_TIME}, {"🔢", LOG_TAG_CYCLES}, {"🧹", LOG_TAG_CLEAR}
+    };
+    count = sizeof(table) / sizeof(table[0]);
+    return table;
+}
+
+// Смайлик из таблицы в начале s (длина len) - его метка, matched - сколько байт он занимает
+inline LogTag log_emoji_at(const char *s, size_t len, size_t &matched) {
+    if (len == 0 || (uint8_t)s[0] < 0xE2) return LOG_TAG_NONE;
+    size_t count;
+    const LogEmoji *table = log_emoji_table(count);
+    for (size_t i = 0; i < count; i++) {
+        size_t n = strlen(table[i].utf8);
+        if (n <= len && memcmp(s, table[i].utf8, n) == 0) {
+            matched = n;
+            return table[i].tag;
+        }
+    }
+    return LOG_TAG_NONE;
+}
+
+inline LogLevel log_tag_level(LogTag tag) {
+    if (tag == LOG_TAG_ERROR || tag == LOG_TAG_FAIL || tag == LOG_TAG_STOP) return LOG_LEVEL_ERROR;
+    if (tag == LOG_TAG_WARN) return LOG_LEVEL_WARN;
+    return LOG_LEVEL_INFO;
+}
+
+// Ведущий смайлик или "[МЕТКА]" (и пробел за ними) → метка; text/len сдвигаются за префикс
+inline LogTag log_classify(const char *&text, size_t &len) {
+    size_t matched = 0;
+    LogTag tag = log_emoji_at(text, len, matched);
+    if (tag == LOG_TAG_NONE && len > 2 && text[0] == '[') {
+        for (uint8_t t = 1; t < LOG_TAG_COUNT; t++) {
+            const char *name = log_tag_text((LogTag)t);
+            size_t n = strlen(name);
+            if (n <= len && memcmp(text, name, n) == 0) {
+                tag = (LogTag)t;
+                matched = n;
+                break;
+            }
+        }
+    }
+    if (tag == LOG_TAG_NONE) return tag;
+    text += matched;
+    len -= matched;
+    if (len > 0 && text[0] == ' ') {
+        text++;
+        len--;
+    }
+    return tag;
+}
+
+// Обрезка по границе символа UTF-8 (не посреди многобайтовой последовательности)
+inline size_t log_utf8_clip(const char *s, size_t len, size_t max) {
+    if (len <= max) return len;
+    while (max > 0 && ((uint8_t)s[max] & 0xC0) == 0x80) max--;
+    return max;
+}
+
+// То же для текста, уже обрезанного без оглядки на UTF-8 (vsnprintf): хвост - оборванный
+// символ, если его ведущий байт обещает больше байт, чем осталось
+inline size_t log_utf8_trim(const char *s, size_t len) {
+    size_t lead = len;
+    while (lead > 0 && ((uint8_t)s[lead - 1] & 0xC0) == 0x80) lead--;
+    if (lead == 0) return len;
+    uint8_t b = (uint8_t)s[lead - 1];
+    size_t need = b >= 0xF0 ? 4 : b >= 0xE0 ? 3 : b >= 0xC0 ? 2 : 1;
+    return lead - 1 + need > len ? lead - 1 : len;
+}
+
+struct LogRecord {
+    uint32_t seq;
+    uint32_t timestamp_ms;
+    LogLevel level;
+    LogTag tag;
+    LogMsgId msg_id;
+    uint8_t len;
+    uint8_t payload[LOG_PAYLOAD_MAX];
+};
+
+struct LogRing {
+    uint8_t data[LOG_RING_BYTES];
+    uint16_t head;                  // Смещение самой старой записи
+    uint16_t tail;                  // Смещение следующей записи
+    uint16_t count;
+    uint32_t first_seq;             // Номер самой старой записи
+    uint32_t next_seq;              // Номер следующей записи
+    uint32_t evicted;               // Вытеснено записей за всё время
+};
+
+inline void log_ring_init(LogRing &r) {
+    r.head = r.tail = r.count = 0;
+    r.first_seq = r.next_seq = 0;
+    r.evicted = 0;
+}
+
+// Очистка - номера продолжаются (курсоры клиентов остаются упорядоченными)
+inline void log_ring_clear(LogRing &r) {
+    r.head = r.tail = r.count = 0;
+    r.first_seq = r.next_seq;
+}
+
+inline uint16_t log_ring_bytes_used(const LogRing &r) {
+    if (r.count == 0) return 0;
+    if (r.tail > r.head) return r.tail - r.head;
+    return LOG_RING_BYTES - r.head + r.tail;    // С учётом хвоста до конца массива
+}
+
+// Смещение записи с учётом перехода на начало массива
+inline uint16_t log_ring_align(const LogRing &r, uint16_t offset) {
+    if (LOG_RING_BYTES - offset < LOG_RECORD_HEADER) return 0;
+    if (r.data[offset + 6] == LOG_MSG_WRAP) return 0;
+    return offset;
+}
+
+inline uint16_t log_ring_record_size(const LogRing &r, uint16_t offset) {
+    return LOG_RECORD_HEADER + r.data[offset + 7];
+}
+
+inline void log_ring_evict(LogRing &r) {
+    uint16_t at = log_ring_align(r, r.head);
+    r.head = at + log_ring_record_size(r, at);
+    r.count--;
+    r.first_seq++;
+    r.evicted++;
+    if (r.count == 0) r.head = r.tail = 0;
+    else r.head = log_ring_align(r, r.head);
+}
+
+// Возвращает номер записи. Длинная нагрузка обрезается до LOG_PAYLOAD_MAX
+inline uint32_t log_ring_push(LogRing &r, uint32_t timestamp_ms, LogLevel level, LogTag tag, LogMsgId msg_id,
+                              const void *payload, size_t len) {
+    if (len > LOG_PAYLOAD_MAX) len = LOG_PAYLOAD_MAX;
+    uint16_t need = LOG_RECORD_HEADER + len;
+
+    uint16_t at;
+    for (;;) {
+        if (r.count == 0) r.head = r.tail = 0;
+        bool wraps = LOG_RING_BYTES - r.tail < need;
+        at = wraps ? 0 : r.tail;
+        bool fits;
+        if (r.count == 0) fits = true;
+        else if (r.tail > r.head) fits = !wraps || need <= r.head;     // Живые записи [head, tail)
+        else fits = !wraps && r.tail + need <= r.head;                  // Живые записи с переходом
+        if (fits) break;
+        log_ring_evict(r);
+    }
+    // Хвост до конца массива пропускается: метка перехода, если влезает заголовок
+    if (at != r.tail && LOG_RING_BYTES - r.tail >= LOG_RECORD_HEADER) r.data[r.tail + 6] = LOG_MSG_WRAP;
+
+    uint8_t *p = r.data + at;
+    p[0] = (uint8_t)timestamp_ms;
+    p[1] = (uint8_t)(timestamp_ms >> 8);
+    p[2] = (uint8_t)(timestamp_ms >> 16);
+    p[3] = (uint8_t)(timestamp_ms >> 24);
+    p[4] = level;
+    p[5] = tag;
+    p[6] = msg_id;
+    p[7] = (uint8_t)len;
+    memcpy(p + LOG_RECORD_HEADER, payload, len);
+
+    r.tail = at + need;
+    r.count++;
+    return r.next_seq++;
+}
+
+inline void log_ring_read_at(const LogRing &r, uint16_t offset, uint32_t seq, LogRecord &rec) {
+    const uint8_t *p = r.data + offset;
+    rec.seq = seq;
+    rec.timestamp_ms = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    rec.level = (LogLevel)p[4];
+    rec.tag = (LogTag)p[5];
+    rec.msg_id = (LogMsgId)p[6];
+    rec.len = p[7];
+    memcpy(rec.payload, p + LOG_RECORD_HEADER, rec.len);
+}
+
+// Курсор чтения: смещение записи seq. Живая запись не двигается, пока не вытеснена -
+// между чтениями курсор действителен, если seq >= first_seq
+struct LogCursor {
+    uint32_t seq;
+    uint16_t offset;
+};
+
+// Курсор на запись seq (или на самую старую, если seq уже вытеснена). false - seq вытеснена
+// или впереди next_seq (лог очищен, прибор перезапущен): курсор тогда на самой старой
+inline bool log_ring_seek(const LogRing &r, uint32_t seq, LogCursor &c) {
+    bool valid = seq >= r.first_seq && seq <= r.next_seq;
+    c.seq = r.first_seq;
+    c.offset = r.head;
+    if (!valid) return false;
+    while (c.seq < seq) {
+        uint16_t at = log_ring_align(r, c.offset);
+        c.offset = at + log_ring_record_size(r, at);
+        c.seq++;
+    }
+    return true;
+}
+
+// Следующая запись по курсору. false - записей больше нет или запись курсора вытеснена
+inline bool log_ring_next(const LogRing &r, LogCursor &c, LogRecord &rec) {
+    if (c.seq < r.first_seq || c.seq >= r.next_seq) return false;
+    uint16_t at = log_ring_align(r, c.offset);
+    log_ring_read_at(r, at, c.seq, rec);
+    c.offset = at + LOG_RECORD_HEADER + rec.len;
+    c.seq++;
+    return true;
+}
+
+inline int32_t log_event_arg(const LogRecord &rec, uint8_t i) {
+    int32_t v = 0;
+    if ((size_t)(i + 1) * sizeof(int32_t) <= rec.len) memcpy(&v, rec.payload + i * sizeof(int32_t), sizeof(v));
+    return v;
+}
+
+inline const char* log_solenoid_position(int32_t pos) {
+    return pos ? "B (-90°)" : "A (+90°)";
+}
+
+// Метка сообщения с id (для записи)
+inline LogTag log_event_tag(LogMsgId id) {
+    switch (id) {
+        case LOG_MSG_SOLENOID_SWITCH: return LOG_TAG_SWITCH;
+        case LOG_MSG_SOLENOID_OK: return LOG_TAG_OK;
+        case LOG_MSG_SOLENOID_FAIL: return LOG_TAG_ERROR;
+        default: return LOG_TAG_NONE;
+    }
+}
+
+// Текст сообщения без времени и метки
+inline int log_render_message(const LogRecord &rec, char *out, size_t size) {
+    switch (rec.msg_id) {
+        case LOG_MSG_SOLENOID_SWITCH:
+            return snprintf(out, size, "%s | Попытка %ld/%ld", log_solenoid_position(log_event_arg(rec, 0)),
+                            (long)log_event_arg(rec, 1), (long)log_event_arg(rec, 2));
+        case LOG_MSG_SOLENOID_OK:
+            return snprintf(out, size, "%s → H%ld сработал за %ldмс", log_solenoid_position(log_event_arg(rec, 0)),
+                            (long)log_event_arg(rec, 1), (long)log_event_arg(rec, 2));
+        case LOG_MSG_SOLENOID_FAIL:
+            return snprintf(out, size, "%s → H%ld НЕ сработал | Попытка %ld/%ld", log_solenoid_position(log_event_arg(rec, 0)),
+                            (long)log_event_arg(rec, 1), (long)log_event_arg(rec, 2), (long)log_event_arg(rec, 3));
+        default:
+            break;
+    }
+    size_t n = rec.len < size - 1 ? rec.len : size - 1;
+    memcpy(out, rec.payload, n);
+    out[n] = '\0';
+    return (int)n;
+}
+
+// Строка лога как раньше: "[MM:SS.mmm] [МЕТКА] текст\n", смайлики из таблицы - метками.
+// out - не меньше LOG_RENDER_MAX байт. Возвращает длину
+inline size_t log_render(const LogRecord &rec, char *out) {
+    uint32_t ms = rec.timestamp_ms;
+    int n = snprintf(out, LOG_RENDER_MAX, "[%02lu:%02lu.%03lu] ", (unsigned long)(ms / 60000),
+                     (unsigned long)(ms / 1000 % 60), (unsigned long)(ms % 1000));
+    size_t o = n;
+    const char *tag = log_tag_text(rec.tag);
+    if (*tag) o += snprintf(out + o, LOG_RENDER_MAX - o, "%s ", tag);
+
+    char message[LOG_RENDER_MAX];
+    int len = log_render_message(rec, message, sizeof(message));
+    if (len < 0) len = 0;
+    if ((size_t)len >= sizeof(message)) len = sizeof(message) - 1;
+
+    for (size_t i = 0; i < (size_t)len && o < LOG_RENDER_MAX - 2;) {
+        size_t matched = 0;
+        LogTag t = log_emoji_at(message + i, len - i, matched);
+        if (t != LOG_TAG_NONE) {
+            const char *text = log_tag_text(t);
+            size_t tl = strlen(text);
+            if (o + tl >= LOG_RENDER_MAX - 2) break;
+            memcpy(out + o, text, tl);
+            o += tl;
+            i += matched;
+        } else {
+            out[o++] = message[i++];
+        }
+    }
+    out[o++] = '\n';
+    out[o] = '\0';
+    return o;
+}
@@ -9,6 +9,11 @@
 #include <EEPROM.h>
 #include "solenoid.h"
 #include "hall_sensors.h"
+#include "motion_task.h"
+#include "step_pulse.h"
+#include "fault_monitor.h"
+#include "telemetry.h"
+#include "serial_log.h"
 
 // SPI Motion Controller - никаких extern переменных!
 void handleClient(); // Объявление функции из web_server.cpp
@@ -33,6 +38,7 @@ void init_wifi_ap() {
 
 void setup() {
     Serial.begin(115200);
+    init_serial_log();  // add_log() до этого копится в очереди, лишнее отбрасывается
     Serial.println("=== ESP32 STARTING ===");
 
     // СНАЧАЛА WiFi - чтобы точка доступа поднялась быстро
@@ -68,6 +74,7 @@ void setup() {
     pinMode(DIR_PIN, OUTPUT);
     digitalWrite(STEP_PIN, LOW);
     digitalWrite(DIR_PIN, LOW);
+    init_step_pulse_engine();  // STEP отдаётся периферии RMT
 
     // === ИНИЦИАЛИЗАЦИЯ СОЛЕНОИДА ===
     Serial.println("Initializing solenoid (L298N)...");
@@ -94,15 +101,22 @@ void setup() {
         Serial.println(currentSettings.control_mode == MODE_MOTION_CONTROLLER ? "Motion Controller" : "STEP/DIR");
     }
 
-    // TMC5160 готов к работе через веб-интерфейс
+    // Ошибки драйвера (КЗ, перегрев) - по прерыванию DIAG0, мотор отключается без опроса
+    if (tmc_initialized) init_fault_monitor();
+
+    // TMC5160 готов к работе через веб-интерфейс.
+    // С этого момента команды мотору выполняет только задача движения (core 1)
+    init_motion_task();
+
+    // Push-телеметрия подписчикам SSE (core 0) - снимок движения уже обновляет задача движения
+    init_telemetry();
 
     Serial.println("=== SYSTEM READY ===");
     Serial.println("Connect to WiFi 'Krya' and go to 192.168.4.1");
 }
 
 void loop() {
-    // Мониторинг TMC5160
-    run_motor();
+    // Мониторинг TMC5160 (run_motor) - в задаче движения, см. motion_task.cpp
 
     // Проверка состояния соленоида (завершение импульса)
     is_solenoid_switching();
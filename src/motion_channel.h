@@ -0,0 +1,128 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include "spsc_queue.h"
+
+// ============================================================================
+// КАНАЛ КОМАНД ЗАДАЧИ ДВИЖЕНИЯ: ОЧЕРЕДЬ + СЛОТ JOG + МЕТРИКИ
+// ============================================================================
+// Без Arduino/FreeRTOS зависимостей - собирается и на хосте (std::thread).
+// Производитель - одна задача (AsyncTCP): push(), request_jog().
+// Потребитель - задача движения: drain(), take_jog(), note_jog_applied().
+// stats() - из любой задачи. Время в мкс передаёт вызывающий (micros() на ESP32).
+// Cmd должен иметь поле uint32_t enqueue_us - его заполняет push().
+
+// Метрики очереди и задержки "постановка в очередь → выполнение"
+struct MotionChannelStats {
+    uint16_t queue_depth;
+    uint16_t queue_depth_max;
+    uint32_t enqueued;
+    uint32_t dropped;           // Очередь была полна
+    uint32_t executed;
+    uint32_t latency_last_us;
+    uint32_t latency_max_us;
+    uint32_t latency_avg_us;
+    uint32_t jog_requests;      // Запросов скорости jog
+    uint32_t jog_applied;       // Из них применено (остальные перекрыты более свежими)
+};
+
+template <typename Cmd, uint16_t N>
+class MotionChannel {
+public:
+    // Производитель. cancel_jog - ещё не применённая скорость jog сбрасывается: скорость,
+    // заданная ДО остановки/движения, не должна примениться после них. false - очередь полна
+    bool push(Cmd cmd, uint32_t now_us, bool cancel_jog) {
+        cmd.enqueue_us = now_us;
+        if (cancel_jog) _jog_pending.store(false, std::memory_order_release);
+
+        if (!_queue.push(cmd)) {
+            bump(_dropped);
+            return false;
+        }
+        bump(_enqueued);
+        uint16_t depth = _queue.size();
+        if (depth > _depth_max.load(std::memory_order_relaxed)) _depth_max.store(depth, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Производитель: "последний побеждает", не отказывает. Сначала скорость, затем флаг
+    void request_jog(int32_t speed) {
+        _jog_speed.store(speed, std::memory_order_relaxed);
+        _jog_pending.store(true, std::memory_order_release);
+        bump(_jog_requests);
+    }
+
+    // Потребитель: выполнить все команды в порядке постановки. dispatch(cmd) возвращает true,
+    // если задержка команды идёт в статистику (быстрые команды, не переинициализация)
+    template <typename Dispatch, typename Clock>
+    uint16_t drain(Dispatch dispatch, Clock now_us) {
+        Cmd cmd;
+        uint16_t count = 0;
+        while (_queue.pop(cmd)) {
+            bool realtime = dispatch(cmd);
+            bump(_executed);
+            count++;
+            if (!realtime) continue;
+
+            uint32_t latency = now_us() - cmd.enqueue_us;
+            _latency_last_us.store(latency, std::memory_order_relaxed);
+            if (latency > _latency_max_us.load(std::memory_order_relaxed)) {
+                _latency_max_us.store(latency, std::memory_order_relaxed);
+            }
+            _latency_total_us += latency;
+            _latency_samples++;
+            _latency_avg_us.store((uint32_t)(_latency_total_us / _latency_samples), std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+    // Потребитель: сначала снимаем флаг, затем читаем скорость - обновление не теряется
+    // (новая запись после снятия флага снова его поставит)
+    bool take_jog(int32_t &speed) {
+        if (!_jog_pending.exchange(false, std::memory_order_acq_rel)) return false;
+        speed = _jog_speed.load(std::memory_order_relaxed);
+        return true;
+    }
+
+    void note_jog_applied() { bump(_jog_applied); }
+
+    MotionChannelStats stats() const {
+        MotionChannelStats s;
+        s.queue_depth = _queue.size();
+        s.queue_depth_max = _depth_max.load(std::memory_order_relaxed);
+        s.enqueued = _enqueued.load(std::memory_order_relaxed);
+        s.dropped = _dropped.load(std::memory_order_relaxed);
+        s.executed = _executed.load(std::memory_order_relaxed);
+        s.latency_last_us = _latency_last_us.load(std::memory_order_relaxed);
+        s.latency_max_us = _latency_max_us.load(std::memory_order_relaxed);
+        s.latency_avg_us = _latency_avg_us.load(std::memory_order_relaxed);
+        s.jog_requests = _jog_requests.load(std::memory_order_relaxed);
+        s.jog_applied = _jog_applied.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    // Каждый счётчик пишет только одна задача - чтение-запись без атомарного RMW
+    static void bump(std::atomic<uint32_t> &counter) {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    SpscQueue<Cmd, N> _queue;
+
+    // Производитель
+    std::atomic<uint16_t> _depth_max{0};
+    std::atomic<uint32_t> _enqueued{0};
+    std::atomic<uint32_t> _dropped{0};
+    std::atomic<uint32_t> _jog_requests{0};
+    std::atomic<int32_t> _jog_speed{0};
+    std::atomic<bool> _jog_pending{false};
+
+    // Потребитель
+    std::atomic<uint32_t> _executed{0};
+    std::atomic<uint32_t> _latency_last_us{0};
+    std::atomic<uint32_t> _latency_max_us{0};
+    std::atomic<uint32_t> _latency_avg_us{0};
+    std::atomic<uint32_t> _jog_applied{0};
+    uint64_t _latency_total_us = 0;
+    uint32_t _latency_samples = 0;
+};
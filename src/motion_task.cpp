@@ -0,0 +1,367 @@
+#include "motion_task.h"
+#include "tmc.h"
+#include "eeprom_manager.h"
+#include "step_pulse.h"
+#include "move_events.h"
+#include "homing.h"
+#include "sg_tuning.h"
+#include "fault_monitor.h"
+#include "health_monitor.h"
+#include "move_queue.h"
+#include "serial_log.h"
+#include "sequence.h"
+#include "endurance.h"
+
+// Объявление функции для веб-логов (определена в web_server.cpp)
+extern void add_log_to_web(String message);
+
+// Очередь команд и слот скорости jog: производитель - AsyncTCP, потребитель - задача движения.
+// Jog - мимо очереди, "последний побеждает": слайдер шлёт 20+ запросов/с, промежуточные не нужны
+static MotionChannel<MotionCommand, MOTION_QUEUE_SIZE> motion_channel;
+static TaskHandle_t motion_task_handle = nullptr;
+
+// motion_call(): один вызов за раз (AsyncTCP - единственный производитель). Флаг снимает
+// задача движения после fn - до этого ctx ещё используется, даже если обработчик не дождался
+static volatile bool motion_call_busy = false;
+static SemaphoreHandle_t motion_call_done = nullptr;
+
+static uint32_t motion_now_us() {
+    return micros();
+}
+
+const char* motion_command_name(MotionCommandType type) {
+    switch (type) {
+        case MOTION_CMD_MOVE: return "move";
+        case MOTION_CMD_MOVE_TO: return "move_to";
+        case MOTION_CMD_MOVE_ANGLE: return "move_angle";
+        case MOTION_CMD_MOVE_TO_ANGLE: return "move_to_angle";
+        case MOTION_CMD_STOP: return "stop";
+        case MOTION_CMD_EMERGENCY_STOP: return "emergency_stop";
+        case MOTION_CMD_ENABLE: return "enable";
+        case MOTION_CMD_DISABLE: return "disable";
+        case MOTION_CMD_RESET_POSITION: return "reset_position";
+        case MOTION_CMD_SET_CURRENT: return "set_current";
+        case MOTION_CMD_APPLY_SETTINGS: return "apply_settings";
+        case MOTION_CMD_CALIBRATE_SPI: return "calibrate_spi";
+        case MOTION_CMD_RUN_SEQUENCE: return "run_sequence";
+        case MOTION_CMD_STOP_SEQUENCE: return "stop_sequence";
+        case MOTION_CMD_ENDURANCE: return "endurance";
+        case MOTION_CMD_STOP_ENDURANCE: return "stop_endurance";
+        case MOTION_CMD_HOME: return "home";
+        case MOTION_CMD_SG_TUNE: return "sg_tune";
+        case MOTION_CMD_CALL: return "call";
+        default: return "unknown";
+    }
+}
+
+bool motion_enqueue(MotionCommand cmd) {
+    bool cancel_jog = cmd.type == MOTION_CMD_MOVE || cmd.type == MOTION_CMD_MOVE_TO ||
+                      cmd.type == MOTION_CMD_MOVE_ANGLE || cmd.type == MOTION_CMD_MOVE_TO_ANGLE ||
+                      cmd.type == MOTION_CMD_STOP || cmd.type == MOTION_CMD_EMERGENCY_STOP ||
+                      cmd.type == MOTION_CMD_DISABLE;
+
+    if (!motion_channel.push(cmd, micros(), cancel_jog)) {
+        LOG_WARNF("⚠️ Motion queue full, dropped: %s", motion_command_name(cmd.type));
+        return false;
+    }
+
+    if (motion_task_handle) xTaskNotifyGive(motion_task_handle);
+    return true;
+}
+
+void motion_request_jog(int32_t speed) {
+    motion_channel.request_jog(speed);
+    if (motion_task_handle) xTaskNotifyGive(motion_task_handle);
+}
+
+bool motion_call_pending() {
+    return motion_call_busy;
+}
+
+bool motion_call(MotionCallFn fn, void *ctx, uint32_t timeout_ms) {
+    if (!motion_task_handle || motion_call_busy) return false;
+
+    // Отдача от вызова, которого прошлый обработчик не дождался
+    xSemaphoreTake(motion_call_done, 0);
+
+    MotionCommand cmd = {};
+    cmd.type = MOTION_CMD_CALL;
+    cmd.call_fn = fn;
+    cmd.call_ctx = ctx;
+    motion_call_busy = true;
+    if (!motion_enqueue(cmd)) {
+        motion_call_busy = false;
+        return false;
+    }
+    return xSemaphoreTake(motion_call_done, pdMS_TO_TICKS(timeout_ms)) == pdTRUE;
+}
+
+// Перед любым ходом: прервать хоминг/свип/jog и, если заданы, записать VMAX/AMAX/DMAX команды.
+// false - рампа не записалась, ход не начинаем
+static bool motion_prepare_move(const MotionCommand &cmd) {
+    homing_abort("interrupted by move");
+    sg_tune_abort("interrupted by move");
+    move_queue_abort("interrupted by move");
+    sequence_abort("interrupted by move");
+    endurance_abort("interrupted by move");
+    leave_jog_mode();
+    if (cmd.max_speed > 0 && tmc_initialized) {
+        // Вся рампа перед движением одной группой (VSTART/A1/V1/D1/VSTOP - из настроек)
+        RampProfile ramp = get_ramp_profile(currentSettings);
+        ramp.vmax = cmd.max_speed;
+        ramp.amax = cmd.acceleration;
+        ramp.dmax = cmd.deceleration;
+        if (!apply_ramp_profile(ramp)) return false;
+        LOG_INFOF("⚙️ Ramp updated: VMAX=%lu, AMAX=%u, DMAX=%u", (unsigned long)cmd.max_speed,
+                  cmd.acceleration, cmd.deceleration);
+    }
+    return true;
+}
+
+// Выполнение одной команды. Возвращает true, если это "быстрая" команда,
+// для которой задержка до записи в SPI входит в статистику
+static bool motion_dispatch(const MotionCommand &cmd) {
+    switch (cmd.type) {
+        case MOTION_CMD_MOVE:
+            if (!motion_prepare_move(cmd)) return true;
+            move_relative_usteps(cmd.usteps, (MotorControlMode)currentSettings.control_mode);
+            return true;
+
+        case MOTION_CMD_MOVE_TO:
+            if (!motion_prepare_move(cmd)) return true;
+            move_absolute_usteps(cmd.usteps);
+            return true;
+
+        case MOTION_CMD_MOVE_ANGLE:
+            if (!motion_prepare_move(cmd)) return true;
+            move_angle_mdeg(cmd.angle_mdeg, (MotorControlMode)currentSettings.control_mode);
+            return true;
+
+        case MOTION_CMD_MOVE_TO_ANGLE:
+            if (!motion_prepare_move(cmd)) return true;
+            move_to_angle_mdeg(cmd.angle_mdeg);
+            return true;
+
+        case MOTION_CMD_STOP:
+            homing_abort("stopped");
+            sg_tune_abort("stopped");
+            move_queue_abort("stopped");
+            sequence_abort("stopped");
+            endurance_abort("stopped");
+            step_pulse_abort();
+            move_events_abort();
+            // В режиме скорости - плавное торможение с AMAX, update_jog() вернёт позиционирование
+            if (is_jog_active()) set_jog_speed(0);
+            if (tmc_initialized) motor.stop();
+            return true;
+
+        case MOTION_CMD_EMERGENCY_STOP:
+            // EN уже снят обработчиком HTTP (без SPI), здесь останавливаем генератор рампы
+            digitalWrite(EN_PIN, HIGH);
+            motor_enabled = false;
+            homing_abort("emergency stop");
+            sg_tune_abort("emergency stop");
+            move_queue_abort("emergency stop");
+            sequence_abort("emergency stop");
+            endurance_abort("emergency stop");
+            step_pulse_abort();
+            move_events_abort();
+            if (tmc_initialized) motor.stop();
+            leave_jog_mode();
+            return true;
+
+        case MOTION_CMD_ENABLE:
+            enable_motor();
+            return true;
+
+        case MOTION_CMD_DISABLE:
+            homing_abort("motor disabled");
+            sg_tune_abort("motor disabled");
+            move_queue_abort("motor disabled");
+            sequence_abort("motor disabled");
+            endurance_abort("motor disabled");
+            move_events_abort();
+            leave_jog_mode();
+            disable_motor();
+            return true;
+
+        case MOTION_CMD_RESET_POSITION:
+            // Цели очереди - абсолютные, после смены начала координат они неверны
+            move_queue_abort("position reset");
+            sequence_abort("position reset");
+            endurance_abort("position reset");
+            set_position_usteps(0);
+            homing_invalidate_origin();
+            return true;
+
+        case MOTION_CMD_SET_CURRENT:
+            set_motor_current(cmd.current_mA, cmd.hold_multiplier);
+            return true;
+
+        case MOTION_CMD_APPLY_SETTINGS: {
+            homing_abort("settings changed");
+            sg_tune_abort("settings changed");
+            move_queue_abort("settings changed");
+            sequence_abort("settings changed");
+            endurance_abort("settings changed");
+            // currentSettings обновляем ДО setup - он берёт оттуда частоту SPI.
+            // Под спинлоком: AsyncTCP в это время может снимать копию настроек
+            publish_settings(cmd.settings);
+            // Обычно - только отличающиеся регистры, без переинициализации и потери позиции
+            bool ok = apply_settings_diff(currentSettings);
+            if (!ok) {
+                uint32_t start_us = micros();
+                ok = setup_tmc5160(currentSettings.current_mA, currentSettings.hold_multiplier,
+                                   currentSettings.microsteps, currentSettings.max_speed,
+                                   currentSettings.acceleration, currentSettings.deceleration);
+                note_full_config_apply(micros() - start_us);
+            }
+            if (ok) init_fault_monitor();
+            if (ok && saveMotorSettings(currentSettings)) {
+                add_log_to_web("💾 Preset settings saved to EEPROM");
+            } else if (!ok) {
+                add_log_to_web("❌ Failed to apply settings");
+            }
+            return false;
+        }
+
+        case MOTION_CMD_CALIBRATE_SPI: {
+            uint32_t hz = calibrate_spi_clock();
+            add_log_to_web(hz ? "🔧 SPI clock calibrated: " + String(hz) + " Hz" : String("❌ SPI calibration failed"));
+            return false;
+        }
+
+        case MOTION_CMD_RUN_SEQUENCE:
+            homing_abort("interrupted by sequence");
+            sg_tune_abort("interrupted by sequence");
+            move_queue_abort("interrupted by sequence");
+            endurance_abort("interrupted by sequence");
+            leave_jog_mode();
+            sequence_start();
+            return true;
+
+        case MOTION_CMD_STOP_SEQUENCE:
+            if (is_sequence_active()) {
+                sequence_abort("stopped");
+                step_pulse_abort();
+                move_events_abort();
+                if (tmc_initialized) motor.stop();
+            }
+            return true;
+
+        case MOTION_CMD_ENDURANCE:
+            homing_abort("interrupted by endurance test");
+            sg_tune_abort("interrupted by endurance test");
+            move_queue_abort("interrupted by endurance test");
+            sequence_abort("interrupted by endurance test");
+            leave_jog_mode();
+            endurance_start();
+            return true;
+
+        case MOTION_CMD_STOP_ENDURANCE:
+            if (is_endurance_active()) {
+                endurance_abort("stopped");
+                move_events_abort();
+                if (tmc_initialized) motor.stop();
+            }
+            return true;
+
+        case MOTION_CMD_HOME:
+            sg_tune_abort("interrupted by homing");
+            move_queue_abort("interrupted by homing");
+            sequence_abort("interrupted by homing");
+            endurance_abort("interrupted by homing");
+            homing_start();
+            return true;
+
+        case MOTION_CMD_SG_TUNE:
+            homing_abort("interrupted by SGT sweep");
+            move_queue_abort("interrupted by SGT sweep");
+            sequence_abort("interrupted by SGT sweep");
+            endurance_abort("interrupted by SGT sweep");
+            sg_tune_start();
+            return true;
+
+        case MOTION_CMD_CALL:
+            cmd.call_fn(cmd.call_ctx);
+            // Сначала отдача, потом флаг: следующий motion_call() снимет отдачу, если её не дождались
+            xSemaphoreGive(motion_call_done);
+            motion_call_busy = false;
+            return false;
+
+        default:
+            return false;
+    }
+}
+
+static void motion_task(void *arg) {
+    uint32_t last_poll_ms = 0;
+
+    for (;;) {
+        // Просыпаемся по команде (xTaskNotifyGive) или раз в тик для обслуживания
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1));
+
+        // EN уже снят обработчиком DIAG0 - останавливаем генератор рампы и всё, что движет мотор
+        if (fault_monitor_take_stop()) {
+            homing_abort("driver fault");
+            sg_tune_abort("driver fault");
+            move_queue_abort("driver fault");
+            sequence_abort("driver fault");
+            endurance_abort("driver fault");
+            step_pulse_abort();
+            move_events_abort();
+            leave_jog_mode();
+            if (tmc_initialized) motor.stop();
+            disable_motor();
+        }
+
+        motion_channel.drain(motion_dispatch, motion_now_us);
+
+        int32_t jog_speed;
+        if (motion_channel.take_jog(jog_speed)) {
+            // Хоминг, свип SGT, очередь сегментов и программы сами управляют движением - слайдер не вмешивается
+            if (!is_homing_active() && !is_sg_tune_active() && !is_move_queue_active() && !is_sequence_active() &&
+                !is_endurance_active()) {
+                set_jog_speed(jog_speed);
+                motion_channel.note_jog_applied();
+            }
+        }
+
+        // Завершение движения - сразу после команд, до остального обслуживания
+        move_events_poll();
+        // Следующий сегмент очереди - в той же итерации, где обнаружено достижение цели
+        move_queue_tick();
+        homing_tick();
+        sg_tune_tick();
+
+        run_motor();
+        health_monitor_tick();
+        update_jog();
+        sequence_tick();
+        endurance_tick();
+
+        // Снимок движения для остальных задач (статус, тест соленоида)
+        if (tmc_initialized && (millis() - last_poll_ms) >= MOTION_POLL_PERIOD_MS) {
+            MotionSnapshot snap;
+            read_motion_snapshot(snap);
+            last_poll_ms = millis();
+        }
+    }
+}
+
+void init_motion_task() {
+    if (motion_task_handle) return;
+
+    motion_call_done = xSemaphoreCreateBinary();
+    xTaskCreatePinnedToCore(motion_task, "motion", MOTION_TASK_STACK, nullptr,
+                            MOTION_TASK_PRIORITY, &motion_task_handle, MOTION_TASK_CORE);
+    add_log("✅ Motion task started (core " + String(MOTION_TASK_CORE) + ", queue " + String(MOTION_QUEUE_SIZE) + ")");
+}
+
+bool is_motion_task_running() {
+    return motion_task_handle != nullptr;
+}
+
+MotionTaskStats get_motion_task_stats() {
+    return motion_channel.stats();
+}
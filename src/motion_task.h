@@ -0,0 +1,85 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "motion_channel.h"
+
+// ============================================================================
+// ЗАДАЧА ДВИЖЕНИЯ (FreeRTOS) - ЕДИНСТВЕННЫЙ ВЛАДЕЛЕЦ motor_ptr ДЛЯ КОМАНД
+// ============================================================================
+// HTTP-обработчики (задача AsyncTCP - единственный производитель) только кладут
+// команды в SPSC очередь и сразу отвечают. Задача движения разбирает очередь,
+// пишет в TMC5160 и обслуживает run_motor()/sequence_tick().
+
+#define MOTION_QUEUE_SIZE 16        // Степень двойки
+#define MOTION_TASK_CORE 1          // APP CPU (WiFi/LwIP работают на PRO CPU)
+#define MOTION_TASK_PRIORITY 3      // Выше loop() (1)
+#define MOTION_TASK_STACK 6144
+#define MOTION_POLL_PERIOD_MS 20    // Период обновления снимка движения для остальных задач
+
+enum MotionCommandType : uint8_t {
+    MOTION_CMD_MOVE = 0,              // usteps - относительно (+ max_speed/acceleration/deceleration, если max_speed не 0)
+    MOTION_CMD_STOP,
+    MOTION_CMD_EMERGENCY_STOP,
+    MOTION_CMD_ENABLE,
+    MOTION_CMD_DISABLE,
+    MOTION_CMD_RESET_POSITION,
+    MOTION_CMD_SET_CURRENT,           // current_mA, hold_multiplier
+    MOTION_CMD_APPLY_SETTINGS,        // settings: полная переинициализация + сохранение в EEPROM
+    MOTION_CMD_CALIBRATE_SPI,
+    MOTION_CMD_RUN_SEQUENCE,          // Программа, подготовленная sequence_set_pending()
+    MOTION_CMD_STOP_SEQUENCE,
+    MOTION_CMD_ENDURANCE,             // Тест на ресурс с параметрами из endurance_configure()
+    MOTION_CMD_STOP_ENDURANCE,
+    MOTION_CMD_HOME,                  // Sensorless homing с параметрами из homing_configure()
+    MOTION_CMD_SG_TUNE,               // Свип SGT по полосам скорости с параметрами из sg_tune_configure()
+    MOTION_CMD_MOVE_TO,               // usteps - абсолютная позиция (только MODE_MOTION_CONTROLLER)
+    MOTION_CMD_MOVE_ANGLE,            // angle_mdeg - поворот вала относительно (+ рампа, как MOVE)
+    MOTION_CMD_MOVE_TO_ANGLE,         // angle_mdeg - угол от начала координат (только MODE_MOTION_CONTROLLER)
+    MOTION_CMD_CALL,                  // call_fn(call_ctx) - чтения с чипа для AsyncTCP, см. motion_call()
+    MOTION_CMD_COUNT
+};
+
+typedef void (*MotionCallFn)(void *ctx);
+
+struct MotionCommand {
+    MotionCommandType type;
+    int32_t usteps;         // Микрошаги TMC5160 (шаг = get_usteps_per_step())
+    int64_t angle_mdeg;     // Угол выходного вала, миллиградусы
+    uint32_t max_speed;
+    uint16_t acceleration;
+    uint16_t deceleration;
+    uint16_t current_mA;
+    float hold_multiplier;
+    MotorSettings settings;
+    MotionCallFn call_fn;
+    void *call_ctx;
+    uint32_t enqueue_us;    // Заполняется motion_enqueue()
+};
+
+// Метрики очереди и задержки "постановка в очередь → запись в SPI" (motion_channel.h)
+typedef MotionChannelStats MotionTaskStats;
+
+// Время ожидания motion_call() для обычных диагностических чтений
+#define MOTION_CALL_TIMEOUT_MS 500
+
+// Запуск задачи (после setup_tmc5160)
+void init_motion_task();
+bool is_motion_task_running();
+
+// Поставить команду (только из задачи AsyncTCP!). false - очередь полна
+bool motion_enqueue(MotionCommand cmd);
+
+// Новая скорость jog (шаги/с со знаком, 0 - плавная остановка). Мимо очереди, не отказывает:
+// если задача ещё не применила прошлое значение, оно заменяется новым
+void motion_request_jog(int32_t speed);
+
+// Выполнить fn(ctx) в задаче движения и дождаться (только из задачи AsyncTCP!): так
+// обработчики диагностики читают регистры, не обращаясь к SPI из сетевой задачи.
+// ctx должен быть static - при таймауте вызов всё равно выполнится, но позже.
+// false - задача не запущена, предыдущий вызов ещё не выполнен, очередь полна или таймаут
+bool motion_call(MotionCallFn fn, void *ctx, uint32_t timeout_ms = MOTION_CALL_TIMEOUT_MS);
+// Предыдущий вызов ещё не выполнен - его static ctx заполнять нельзя
+bool motion_call_pending();
+
+MotionTaskStats get_motion_task_stats();
+const char* motion_command_name(MotionCommandType type);
@@ -0,0 +1,159 @@
+#include "move_events.h"
+#include "tmc.h"
+#include "step_pulse.h"
+
+// Отправка события клиентам (определена в web_server.cpp)
+extern void publish_move_event(const MoveDoneEvent &event);
+
+// Текущее движение - только задача движения
+static bool move_active = false;
+static bool move_aborted = false;
+static bool move_stalled = false;
+static bool move_vzero_seen = false;    // Рампа стоит не у цели с move_vzero_since_ms
+static uint32_t move_vzero_since_ms = 0;
+static MotorControlMode move_mode = MODE_MOTION_CONTROLLER;
+static uint32_t move_start_ms = 0;
+static uint32_t last_done_us = 0;
+static bool last_done_valid = false;
+
+// Кольцо событий и статистика: пишет задача движения, читает AsyncTCP - под спинлоком
+static MoveDoneEvent move_ring[MOVE_EVENT_RING_SIZE];
+static uint32_t move_seq = 0;
+static MoveEventStats move_stats = {};
+static uint64_t dead_time_total_ms = 0;
+static portMUX_TYPE move_events_mux = portMUX_INITIALIZER_UNLOCKED;
+
+void move_events_begin(MotorControlMode mode) {
+    uint32_t now_us = micros();
+
+    portENTER_CRITICAL(&move_events_mux);
+    move_stats.started++;
+    // Мёртвое время: от обнаружения завершения прошлого движения до старта этого
+    if (!move_active && last_done_valid) {
+        uint32_t dead_ms = (now_us - last_done_us) / 1000;
+        if (dead_ms <= MOVE_DEAD_TIME_MAX_MS) {
+            move_stats.dead_time_last_ms = dead_ms;
+            if (dead_ms > move_stats.dead_time_max_ms) move_stats.dead_time_max_ms = dead_ms;
+            dead_time_total_ms += dead_ms;
+            move_stats.dead_time_samples++;
+            move_stats.dead_time_avg_ms = (uint32_t)(dead_time_total_ms / move_stats.dead_time_samples);
+        }
+    }
+    portEXIT_CRITICAL(&move_events_mux);
+
+    // Новое движение поверх текущего (смена цели) - одно событие на оба
+    if (!move_active) move_start_ms = millis();
+    move_active = true;
+    move_aborted = false;
+    move_stalled = false;
+    move_vzero_seen = false;
+    move_mode = mode;
+    last_done_valid = false;
+}
+
+void move_events_abort() {
+    if (move_active) move_aborted = true;
+}
+
+static bool move_finished() {
+    if (move_mode == MODE_STEP_DIR) {
+        return !step_pulse_busy();
+    }
+
+    if (!tmc_initialized || !motor_enabled) return true;
+
+    // Одно чтение RAMP_STAT: position_reached - XACTUAL == XTARGET, vzero - рампа стоит.
+    // Флаги событий (event_*) не используем - их чтение не мешает остальным.
+    TMC5160_Reg::RAMP_STAT_Register ramp = {0};
+    ramp.value = motor.readRegisterDirect(TMC5160_Reg::RAMP_STAT);
+    if (!ramp.vzero) {
+        move_vzero_seen = false;
+        return false;
+    }
+    if (ramp.position_reached || move_aborted) return true;
+
+    // Стоим не у цели: рампа ещё не тронулась или уже не поедет (VMAX = 0, цель снята)
+    uint32_t now = millis();
+    if (!move_vzero_seen) {
+        move_vzero_seen = true;
+        move_vzero_since_ms = now;
+        return false;
+    }
+    if (now - move_vzero_since_ms < MOVE_STALL_TIMEOUT_MS) return false;
+    move_aborted = true;
+    move_stalled = true;
+    return true;
+}
+
+void move_events_poll() {
+    if (!move_active) return;
+
+    move_stats.polls++;
+    if (!move_finished()) return;
+
+    MoveDoneEvent event;
+    event.timestamp_ms = millis();
+    event.xactual = tmc_initialized ? (int32_t)motor.readRegisterDirect(TMC5160_Reg::XACTUAL) : 0;
+    event.duration_ms = event.timestamp_ms - move_start_ms;
+    event.mode = move_mode;
+    event.aborted = move_aborted;
+    event.stalled = move_stalled;
+
+    move_active = false;
+    last_done_us = micros();
+    last_done_valid = true;
+
+    portENTER_CRITICAL(&move_events_mux);
+    event.seq = ++move_seq;
+    move_ring[event.seq % MOVE_EVENT_RING_SIZE] = event;
+    move_stats.completed++;
+    if (move_stalled) move_stats.stalled++;
+    portEXIT_CRITICAL(&move_events_mux);
+
+    publish_move_event(event);
+}
+
+bool move_in_flight() {
+    return move_active;
+}
+
+uint32_t move_events_last_seq() {
+    return move_seq;
+}
+
+bool move_events_get_last(MoveDoneEvent &event) {
+    portENTER_CRITICAL(&move_events_mux);
+    bool ok = move_seq > 0;
+    if (ok) event = move_ring[move_seq % MOVE_EVENT_RING_SIZE];
+    portEXIT_CRITICAL(&move_events_mux);
+    return ok;
+}
+
+uint8_t move_events_since(uint32_t since, MoveDoneEvent *events, uint8_t max_events) {
+    uint8_t n = 0;
+    portENTER_CRITICAL(&move_events_mux);
+    uint32_t first = since + 1;
+    // Старше кольца - только то, что сохранилось
+    if (move_seq >= MOVE_EVENT_RING_SIZE && first <= move_seq - MOVE_EVENT_RING_SIZE) {
+        first = move_seq - MOVE_EVENT_RING_SIZE + 1;
+    }
+    for (uint32_t seq = first; seq <= move_seq && n < max_events; seq++) {
+        events[n++] = move_ring[seq % MOVE_EVENT_RING_SIZE];
+    }
+    portEXIT_CRITICAL(&move_events_mux);
+    return n;
+}
+
+MoveEventStats get_move_event_stats() {
+    portENTER_CRITICAL(&move_events_mux);
+    MoveEventStats stats = move_stats;
+    portEXIT_CRITICAL(&move_events_mux);
+    return stats;
+}
+
+void reset_move_event_stats() {
+    portENTER_CRITICAL(&move_events_mux);
+    move_stats = {};
+    dead_time_total_ms = 0;
+    portEXIT_CRITICAL(&move_events_mux);
+}
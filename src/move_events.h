@@ -0,0 +1,54 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================================================
+// СОБЫТИЯ ЗАВЕРШЕНИЯ ДВИЖЕНИЯ
+// ============================================================================
+// Задача движения каждую 1 мс проверяет RAMP_STAT (position_reached + vzero) для SPI
+// режима или окончание передачи RMT для STEP/DIR. Завершение - событие с номером,
+// временем и итоговым XACTUAL: кольцо для опроса + push клиентам (SSE /api/events).
+// Заодно меряется "мёртвое время" - пауза от завершения движения до старта следующего.
+// Рампа стоит (vzero) не у цели дольше MOVE_STALL_TIMEOUT_MS - движение закрывается событием
+// со stalled = true, а не висит "в пути" (например, VMAX = 0 после остановки).
+
+#define MOVE_EVENT_RING_SIZE 16          // Последних событий в памяти
+#define MOVE_DEAD_TIME_MAX_MS 5000       // Паузы длиннее - простой, а не мёртвое время
+#define MOVE_STALL_TIMEOUT_MS 500        // Рампа стоит не у цели - движение не идёт
+
+struct MoveDoneEvent {
+    uint32_t seq;           // 1, 2, 3... (0 - событий ещё не было)
+    uint32_t timestamp_ms;  // millis() обнаружения
+    int32_t xactual;        // Итоговая позиция (микрошаги)
+    uint32_t duration_ms;   // От старта движения до обнаружения завершения
+    uint8_t mode;           // MotorControlMode движения
+    bool aborted;           // Завершено остановкой, а не достижением цели
+    bool stalled;           // Рампа встала не у цели (MOVE_STALL_TIMEOUT_MS), aborted тоже true
+};
+
+struct MoveEventStats {
+    uint32_t started;
+    uint32_t completed;
+    uint32_t polls;                 // Проверок RAMP_STAT
+    uint32_t stalled;               // Закрыто по MOVE_STALL_TIMEOUT_MS
+    uint32_t dead_time_last_ms;
+    uint32_t dead_time_avg_ms;
+    uint32_t dead_time_max_ms;
+    uint32_t dead_time_samples;
+};
+
+// Вызывает move_motor_steps() после успешного старта движения
+void move_events_begin(MotorControlMode mode);
+// Остановка/аварийный стоп: движение завершится событием с aborted = true
+void move_events_abort();
+// Проверка завершения (задача движения, каждую итерацию)
+void move_events_poll();
+
+bool move_in_flight();
+uint32_t move_events_last_seq();
+bool move_events_get_last(MoveDoneEvent &event);
+// События с seq > since (по возрастанию), не больше max_events. Возвращает число
+uint8_t move_events_since(uint32_t since, MoveDoneEvent *events, uint8_t max_events);
+
+MoveEventStats get_move_event_stats();
+void reset_move_event_stats();
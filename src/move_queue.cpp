@@ -0,0 +1,163 @@
+#include "move_queue.h"
+#include "spsc_queue.h"
+#include "tmc.h"
+#include "move_events.h"
+#include "homing.h"
+#include "sg_tuning.h"
+#include "sequence.h"
+#include "endurance.h"
+#include "eeprom_manager.h"
+
+// Объявление функции для веб-логов (определена в web_server.cpp)
+extern void add_log_to_web(String message);
+
+static SpscQueue<MoveSegment, MOVE_QUEUE_SIZE> move_segments_buf;
+
+// Состояние исполнения - только задача движения
+static bool queue_active = false;
+static bool next_ready = false;
+static int32_t next_target = 0;
+static RampRegisters next_regs = {};
+static volatile int32_t current_target = 0;
+static uint32_t queue_started_ms = 0;
+static uint32_t run_executed = 0;
+
+static volatile uint32_t stat_enqueued = 0;     // Пишет AsyncTCP
+static volatile uint32_t stat_rejected = 0;
+static MoveQueueStatus stats = {};              // Остальное пишет задача движения
+static uint64_t handoff_total_us = 0;
+static uint32_t handoff_samples = 0;
+
+bool move_queue_push(const MoveSegment *segments, uint16_t count) {
+    if (count > move_queue_free()) {
+        stat_rejected++;
+        return false;
+    }
+    // Потребитель только освобождает место - проверенного хватит на все сегменты
+    for (uint16_t i = 0; i < count; i++) move_segments_buf.push(segments[i]);
+    stat_enqueued += count;
+    return true;
+}
+
+uint16_t move_queue_free() {
+    return move_segments_buf.capacity() - move_segments_buf.size();
+}
+
+// Следующий сегмент - из буфера сразу в регистры, пока едет текущий
+static void prepare_next() {
+    MoveSegment seg;
+    next_ready = move_segments_buf.pop(seg);
+    if (!next_ready) return;
+
+    RampProfile ramp = move_segment_ramp(get_ramp_profile(currentSettings), seg);
+    ramp_profile_to_registers(ramp, TMC5160_FCLK, TMC_LIB_USTEPS_PER_STEP, next_regs);
+    next_target = seg.target;
+}
+
+static bool can_start() {
+    return tmc_initialized && motor_enabled && currentSettings.control_mode == MODE_MOTION_CONTROLLER &&
+           !move_in_flight() && !is_homing_active() && !is_sg_tune_active() && !is_jog_active() &&
+           !is_sequence_active() && !is_endurance_active();
+}
+
+static void finish_queue() {
+    queue_active = false;
+    stats.active = false;
+    // Рампа сегментов не должна остаться следующим командам
+    apply_ramp_profile(get_ramp_profile(currentSettings));
+    add_log_to_web("✅ Move queue done: " + String(run_executed) + " segments in " +
+                   String(millis() - queue_started_ms) + " ms");
+}
+
+void move_queue_tick() {
+    uint32_t detected_us = micros();
+    bool handoff = false;
+
+    if (!queue_active) {
+        if (move_segments_buf.size() == 0 || !can_start()) return;
+        queue_active = true;
+        stats.active = true;
+        queue_started_ms = millis();
+        run_executed = 0;
+        leave_jog_mode();
+        add_log("▶️ Move queue started: " + String(move_segments_buf.size()) + " segments");
+    } else {
+        if (move_in_flight()) return;
+        stats.completed++;
+        handoff = true;
+    }
+
+    // Сегменты могли прийти уже после того, как буфер опустел
+    if (!next_ready) prepare_next();
+    if (!next_ready) {
+        finish_queue();
+        return;
+    }
+    if (!tmc_initialized || !motor_enabled) {
+        move_queue_abort("motor not ready");
+        return;
+    }
+
+    stats.regs_written_last = load_motion_segment(next_regs, next_target);
+    move_events_begin(MODE_MOTION_CONTROLLER);
+    current_target = next_target;
+    stats.executed++;
+    run_executed++;
+
+    if (handoff) {
+        uint32_t us = micros() - detected_us;
+        stats.handoff_last_us = us;
+        if (us > stats.handoff_max_us) stats.handoff_max_us = us;
+        handoff_total_us += us;
+        handoff_samples++;
+    }
+
+    next_ready = false;
+    prepare_next();
+}
+
+void move_queue_abort(const char *reason) {
+    uint32_t dropped = next_ready ? 1 : 0;
+    MoveSegment seg;
+    while (move_segments_buf.pop(seg)) dropped++;
+    next_ready = false;
+    if (!queue_active && !dropped) return;
+
+    bool was_active = queue_active;
+    queue_active = false;
+    stats.active = false;
+    stats.aborted += dropped;
+    stats.last_abort_reason = reason;
+    if (was_active && tmc_initialized) apply_ramp_profile(get_ramp_profile(currentSettings));
+    add_log_to_web("⏹️ Move queue aborted (" + String(reason) + "), " + String(dropped) + " segments dropped");
+}
+
+bool is_move_queue_active() {
+    return queue_active;
+}
+
+MoveQueueStatus get_move_queue_status() {
+    MoveQueueStatus s = stats;
+    s.depth = move_segments_buf.size();
+    s.capacity = MOVE_QUEUE_SIZE;
+    s.next_ready = next_ready;
+    s.current_target = current_target;
+    s.enqueued = stat_enqueued;
+    s.rejected = stat_rejected;
+    s.handoff_avg_us = handoff_samples ? (uint32_t)(handoff_total_us / handoff_samples) : 0;
+    return s;
+}
+
+void reset_move_queue_stats() {
+    stats.executed = 0;
+    stats.completed = 0;
+    stats.aborted = 0;
+    stats.regs_written_last = 0;
+    stats.handoff_last_us = 0;
+    stats.handoff_max_us = 0;
+    stats.last_abort_reason = nullptr;
+    handoff_total_us = 0;
+    handoff_samples = 0;
+    stat_enqueued = 0;
+    stat_rejected = 0;
+}
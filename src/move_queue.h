@@ -0,0 +1,46 @@
+#pragma once
+#include <Arduino.h>
+#include "move_segments.h"
+
+// ============================================================================
+// ОЧЕРЕДЬ АБСОЛЮТНЫХ ЦЕЛЕЙ С ПОДГРУЗКОЙ СЛЕДУЮЩЕГО СЕГМЕНТА
+// ============================================================================
+// HTTP (задача AsyncTCP - единственный производитель) кладёт сегменты в SPSC буфер,
+// задача движения их исполняет: пока едет текущий сегмент, следующий уже вынут и пересчитан
+// в регистры рампы. Как только move_events_poll() фиксирует position_reached, в той же
+// итерации пишутся отличающиеся регистры рампы и XTARGET - пауза между сегментами =
+// период задачи (1 мс) + несколько датаграмм SPI. Только MODE_MOTION_CONTROLLER.
+// Любая другая команда движения, стоп, отключение, хоминг, смена настроек - очередь сбрасывается.
+
+#define MOVE_QUEUE_SIZE 64          // Степень двойки (SpscQueue)
+
+struct MoveQueueStatus {
+    bool active;                    // Сегменты исполняются
+    uint16_t depth;                 // Ждут в буфере (без загруженного и подготовленного)
+    uint16_t capacity;
+    bool next_ready;                // Следующий сегмент уже пересчитан
+    int32_t current_target;
+    uint32_t enqueued;
+    uint32_t executed;              // Загружено в чип
+    uint32_t completed;             // Доехали до цели
+    uint32_t aborted;               // Сегментов сброшено при отмене
+    uint32_t rejected;              // Отказов HTTP (нет места)
+    uint32_t regs_written_last;     // Датаграмм на последнюю подгрузку (рампа + XTARGET)
+    uint32_t handoff_last_us;       // Цель достигнута (обнаружено) → новый XTARGET записан
+    uint32_t handoff_max_us;
+    uint32_t handoff_avg_us;
+    const char *last_abort_reason;
+};
+
+// Только из задачи AsyncTCP: все сегменты или ни одного. false - не хватает места
+bool move_queue_push(const MoveSegment *segments, uint16_t count);
+uint16_t move_queue_free();
+
+// Задача движения: после move_events_poll()
+void move_queue_tick();
+// Задача движения: остановить исполнение и выбросить сегменты
+void move_queue_abort(const char *reason);
+bool is_move_queue_active();
+
+MoveQueueStatus get_move_queue_status();
+void reset_move_queue_stats();
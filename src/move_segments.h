@@ -0,0 +1,96 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include "ramp_profile.h"
+
+// ============================================================================
+// СЕГМЕНТЫ ОЧЕРЕДИ ДВИЖЕНИЯ - ФОРМАТ И РАЗБОР (ЧИСТАЯ ЛОГИКА)
+// ============================================================================
+// Сегмент - абсолютная цель и своя рампа: "target[:vmax[:amax[:dmax]]]", сегменты через ';'
+// или перевод строки. Пример: "51200:2000:1500;0:800;25600". vmax/amax/dmax в шагах/с и
+// шагах/с², пропущенные или 0 - из настроек. Без Arduino - проверяется на хосте.
+
+struct MoveSegment {
+    int32_t target;         // Абсолютная позиция, микрошаги
+    uint32_t vmax;          // 0 - max_speed из настроек
+    uint32_t amax;          // 0 - acceleration из настроек
+    uint32_t dmax;          // 0 - deceleration из настроек
+};
+
+struct MoveSegmentsParse {
+    uint16_t count;
+    uint16_t error_at;      // Номер сегмента с ошибкой (с 0)
+    const char *error;      // nullptr - разбор успешен
+};
+
+// usteps_per_unit - 1 для целей в микрошагах, get_usteps_per_step() для целей в шагах
+inline MoveSegmentsParse move_segments_parse(const char *text, uint32_t usteps_per_unit,
+                                             MoveSegment *out, uint16_t max_segments) {
+    MoveSegmentsParse r = {0, 0, nullptr};
+    const char *p = text;
+    while (p && *p) {
+        while (*p == ' ' || *p == ';' || *p == '\n' || *p == '\r') p++;
+        if (!*p) break;
+        r.error_at = r.count;
+        if (r.count >= max_segments) {
+            r.error = "too many segments";
+            return r;
+        }
+
+        int64_t fields[4] = {0, 0, 0, 0};
+        uint8_t n = 0;
+        for (;;) {
+            char *end;
+            long long v = strtoll(p, &end, 10);
+            if (end == p) {
+                r.error = "expected number";
+                return r;
+            }
+            fields[n++] = v;
+            p = end;
+            if (*p != ':') break;
+            if (n >= 4) {
+                r.error = "too many fields";
+                return r;
+            }
+            p++;
+        }
+        while (*p == ' ') p++;
+        if (*p && *p != ';' && *p != '\n' && *p != '\r') {
+            r.error = "unexpected character";
+            return r;
+        }
+
+        int64_t target = fields[0] >= INT32_MIN && fields[0] <= INT32_MAX ? fields[0] * (int64_t)usteps_per_unit : INT64_MAX;
+        if (target < INT32_MIN || target > INT32_MAX) {
+            r.error = "target out of int32 range";
+            return r;
+        }
+        for (uint8_t i = 1; i < 4; i++) {
+            if (fields[i] < 0 || fields[i] > 0xFFFFFFLL) {
+                r.error = "speed/acceleration out of range";
+                return r;
+            }
+        }
+        MoveSegment &s = out[r.count++];
+        s.target = (int32_t)target;
+        s.vmax = (uint32_t)fields[1];
+        s.amax = (uint32_t)fields[2];
+        s.dmax = (uint32_t)fields[3];
+    }
+    if (!r.count && !r.error) r.error = "no segments";
+    return r;
+}
+
+// Рампа сегмента поверх рампы настроек. Медленный сегмент ниже VSTART/V1 - как у хоминга,
+// точки рампы прижимаются к vmax
+inline RampProfile move_segment_ramp(const RampProfile &base, const MoveSegment &seg) {
+    RampProfile ramp = base;
+    if (seg.vmax) ramp.vmax = seg.vmax;
+    if (seg.amax) ramp.amax = seg.amax;
+    if (seg.dmax) ramp.dmax = seg.dmax;
+    if (ramp.vstart > ramp.vmax) ramp.vstart = ramp.vmax;
+    if (ramp.v1 > ramp.vmax) ramp.v1 = 0;
+    if (ramp.vstop < ramp.vstart) ramp.vstop = ramp.vstart;
+    return ramp;
+}
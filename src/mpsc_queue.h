@@ -0,0 +1,86 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// ============================================================================
+// ОГРАНИЧЕННАЯ LOCK-FREE ОЧЕРЕДЬ: МНОГО ПРОИЗВОДИТЕЛЕЙ / ОДИН ПОТРЕБИТЕЛЬ
+// ============================================================================
+// Без Arduino/FreeRTOS зависимостей - собирается и на хосте (std::thread).
+// push() - из любых задач одновременно, pop() - только одна задача. У каждой ячейки свой
+// номер: производитель занимает ячейку CAS-ом по индексу записи и публикует её номером,
+// потребитель берёт только опубликованные. Заполнена - push() сразу возвращает false, ни
+// ожидания, ни блокировок. N - степень двойки, индексы uint16_t переполняются свободно.
+
+template <typename T, uint16_t N>
+class MpscQueue {
+    static_assert(N > 1 && (N & (N - 1)) == 0, "MpscQueue size must be a power of two");
+    static_assert(N <= 16384, "MpscQueue size must fit int16_t index differences");
+
+public:
+    MpscQueue() {
+        for (uint16_t i = 0; i < N; i++) _cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // Производитель: fill(T&) заполняет ячейку на месте (без копии через стек).
+    // false - очередь заполнена, fill не вызывается
+    template <typename F>
+    bool push_with(F fill) {
+        uint16_t pos = _enqueue.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell &cell = _cells[pos & (N - 1)];
+            uint16_t seq = cell.seq.load(std::memory_order_acquire);
+            int16_t diff = (int16_t)(seq - pos);
+            if (diff == 0) {
+                if (_enqueue.compare_exchange_weak(pos, (uint16_t)(pos + 1), std::memory_order_relaxed)) {
+                    fill(cell.data);
+                    cell.seq.store((uint16_t)(pos + 1), std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _enqueue.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool push(const T &item) {
+        return push_with([&item](T &slot) { slot = item; });
+    }
+
+    // Потребитель: use(const T&) читает ячейку на месте. false - пусто (или следующая
+    // ячейка ещё заполняется - порядок сохраняется)
+    template <typename F>
+    bool pop_with(F use) {
+        uint16_t pos = _dequeue.load(std::memory_order_relaxed);
+        Cell &cell = _cells[pos & (N - 1)];
+        uint16_t seq = cell.seq.load(std::memory_order_acquire);
+        if ((int16_t)(seq - (uint16_t)(pos + 1)) < 0) return false;
+
+        use(cell.data);
+        cell.seq.store((uint16_t)(pos + N), std::memory_order_release);
+        _dequeue.store((uint16_t)(pos + 1), std::memory_order_relaxed);
+        return true;
+    }
+
+    bool pop(T &item) {
+        return pop_with([&item](const T &slot) { item = slot; });
+    }
+
+    // Текущая глубина (приблизительная)
+    uint16_t size() const {
+        return (uint16_t)(_enqueue.load(std::memory_order_acquire) - _dequeue.load(std::memory_order_relaxed));
+    }
+
+    static constexpr uint16_t capacity() { return N; }
+
+private:
+    struct Cell {
+        std::atomic<uint16_t> seq;
+        T data;
+    };
+
+    Cell _cells[N];
+    std::atomic<uint16_t> _enqueue{0};
+    std::atomic<uint16_t> _dequeue{0};  // Пишет только потребитель
+};
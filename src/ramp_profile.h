@@ -0,0 +1,166 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+// ============================================================================
+// ШЕСТИТОЧЕЧНАЯ РАМПА TMC5160 (VSTART, A1, V1, AMAX, VMAX, DMAX, D1, VSTOP)
+// ============================================================================
+// Разгон: скачок до VSTART → A1 до V1 → AMAX до VMAX.
+// Торможение: DMAX до V1 → D1 до VSTOP → остановка. V1 = 0 - только AMAX/DMAX.
+// Чистая логика без Arduino - калькулятор времени работает и на хосте.
+
+// Масштаб библиотеки tommag: её float API считает шаг = 256 микрошагов
+#define TMC_LIB_USTEPS_PER_STEP 256
+
+// Разрядность регистров рампы (даташит §6.3)
+#define RAMP_REG_VSTART_MAX 0x3FFFF
+#define RAMP_REG_VSTOP_MAX  0x3FFFF
+#define RAMP_REG_V1_MAX     0xFFFFF
+#define RAMP_REG_VMAX_MAX   0x7FFE00
+#define RAMP_REG_ACC_MAX    0xFFFF
+
+// Параметры рампы в шагах/с и шагах/с² (как max_speed/acceleration в MotorSettings)
+struct RampProfile {
+    uint32_t vstart;
+    uint32_t a1;
+    uint32_t v1;
+    uint32_t amax;
+    uint32_t vmax;
+    uint32_t dmax;
+    uint32_t d1;
+    uint32_t vstop;
+};
+
+// Те же параметры в единицах регистров TMC5160
+struct RampRegisters {
+    uint32_t vstart;
+    uint32_t a1;
+    uint32_t v1;
+    uint32_t amax;
+    uint32_t vmax;
+    uint32_t dmax;
+    uint32_t d1;
+    uint32_t vstop;
+};
+
+// Проверка профиля: nullptr - корректен, иначе текст ошибки
+inline const char* ramp_profile_validate(const RampProfile &p) {
+    if (p.vmax == 0) return "vmax must be > 0";
+    if (p.amax == 0 || p.dmax == 0) return "amax and dmax must be > 0";
+    if (p.vstart > p.vmax) return "vstart must be <= vmax";
+    if (p.vstop < p.vstart) return "vstop must be >= vstart";
+    if (p.v1 > p.vmax) return "v1 must be <= vmax";
+    if (p.v1 > 0 && (p.a1 == 0 || p.d1 == 0)) return "a1 and d1 must be > 0 when v1 is used";
+    return nullptr;
+}
+
+inline uint32_t ramp_clamp_reg(double value, uint32_t max_value) {
+    if (value <= 0) return 0;
+    if (value >= max_value) return max_value;
+    return (uint32_t)(value + 0.5);
+}
+
+// Пересчёт в регистры (даташит §12): v[Гц] = VMAX * fCLK / 2^24, a[Гц/с] = AMAX * fCLK² / 2^41
+inline void ramp_profile_to_registers(const RampProfile &p, uint32_t fclk, uint32_t usteps_per_step, RampRegisters &r) {
+    const double v_scale = (double)usteps_per_step * 16777216.0 / fclk;
+    const double a_scale = (double)usteps_per_step * 2199023255552.0 / ((double)fclk * fclk);
+
+    r.vstart = ramp_clamp_reg(p.vstart * v_scale, RAMP_REG_VSTART_MAX);
+    r.v1 = ramp_clamp_reg(p.v1 * v_scale, RAMP_REG_V1_MAX);
+    r.vmax = ramp_clamp_reg(p.vmax * v_scale, RAMP_REG_VMAX_MAX);
+    r.vstop = ramp_clamp_reg(p.vstop * v_scale, RAMP_REG_VSTOP_MAX);
+    r.a1 = ramp_clamp_reg(p.a1 * a_scale, RAMP_REG_ACC_MAX);
+    r.amax = ramp_clamp_reg(p.amax * a_scale, RAMP_REG_ACC_MAX);
+    r.dmax = ramp_clamp_reg(p.dmax * a_scale, RAMP_REG_ACC_MAX);
+    r.d1 = ramp_clamp_reg(p.d1 * a_scale, RAMP_REG_ACC_MAX);
+
+    // Ограничения режима позиционирования: VSTOP >= VSTART и не 0, D1 и DMAX не 0 (даже при V1 = 0)
+    if (r.vstop < r.vstart) r.vstop = r.vstart;
+    if (r.vstop == 0) r.vstop = 1;
+    if (r.d1 == 0) r.d1 = 1;
+    if (r.dmax == 0) r.dmax = 1;
+    if (r.amax == 0) r.amax = 1;
+}
+
+// ===== КАЛЬКУЛЯТОР ВРЕМЕНИ ДВИЖЕНИЯ =====
+
+// Путь и время одной фазы от v0 до v1 с ускорением a (v1 >= v0)
+inline void ramp_phase(float v0, float v1, float a, float *dist, float *time) {
+    if (v1 <= v0 || a <= 0) {
+        *dist = 0;
+        *time = 0;
+        return;
+    }
+    *time = (v1 - v0) / a;
+    *dist = (v1 * v1 - v0 * v0) / (2.0f * a);
+}
+
+// Разгон от VSTART до vp (путь и время); торможение от vp до VSTOP
+inline void ramp_accel_to(const RampProfile &p, float vp, float *dist, float *time) {
+    float d1 = 0, t1 = 0, d2 = 0, t2 = 0;
+    float vstart = p.vstart < vp ? (float)p.vstart : vp;
+    if (p.v1 > 0 && p.v1 > vstart) {
+        float split = p.v1 < vp ? (float)p.v1 : vp;
+        ramp_phase(vstart, split, (float)p.a1, &d1, &t1);
+        ramp_phase(split, vp, (float)p.amax, &d2, &t2);
+    } else {
+        ramp_phase(vstart, vp, (float)p.amax, &d2, &t2);
+    }
+    *dist = d1 + d2;
+    *time = t1 + t2;
+}
+
+inline void ramp_decel_from(const RampProfile &p, float vp, float *dist, float *time) {
+    float d1 = 0, t1 = 0, d2 = 0, t2 = 0;
+    float vstop = p.vstop < vp ? (float)p.vstop : vp;
+    if (p.v1 > 0 && p.v1 > vstop) {
+        float split = p.v1 < vp ? (float)p.v1 : vp;
+        ramp_phase(split, vp, (float)p.dmax, &d2, &t2);
+        ramp_phase(vstop, split, (float)p.d1, &d1, &t1);
+    } else {
+        ramp_phase(vstop, vp, (float)p.dmax, &d2, &t2);
+    }
+    *dist = d1 + d2;
+    *time = t1 + t2;
+}
+
+// Время движения на distance шагов из покоя в покой (мс). Короткие ходы не достигают VMAX -
+// пиковая скорость ищется бисекцией так, чтобы разгон + торможение уложились в путь.
+inline float estimate_move_time_ms(const RampProfile &p, uint32_t distance) {
+    if (distance == 0 || p.vmax == 0 || p.amax == 0 || p.dmax == 0) return 0;
+
+    float dist = (float)distance;
+    float da, ta, dd, td;
+    ramp_accel_to(p, (float)p.vmax, &da, &ta);
+    ramp_decel_from(p, (float)p.vmax, &dd, &td);
+    if (da + dd <= dist) {
+        return (ta + td + (dist - da - dd) / p.vmax) * 1000.0f;
+    }
+
+    float lo = 0, hi = (float)p.vmax;
+    for (int i = 0; i < 40; i++) {
+        float mid = 0.5f * (lo + hi);
+        ramp_accel_to(p, mid, &da, &ta);
+        ramp_decel_from(p, mid, &dd, &td);
+        if (da + dd > dist) hi = mid;
+        else lo = mid;
+    }
+    ramp_accel_to(p, lo, &da, &ta);
+    ramp_decel_from(p, lo, &dd, &td);
+    // Остаток пути (доли шага из-за бисекции и скачков VSTART/VSTOP) - на пиковой скорости
+    float rest = dist - da - dd;
+    float t = ta + td + (lo > 0 && rest > 0 ? rest / lo : 0);
+    return t * 1000.0f;
+}
+
+// ===== РЕЖИМ СКОРОСТИ (RAMPMODE 1/2) =====
+
+// Скорость шагов/с → регистр VMAX (та же шкала, что в ramp_profile_to_registers)
+inline uint32_t ramp_speed_to_vmax(uint32_t speed, uint32_t fclk, uint32_t usteps_per_step) {
+    return ramp_clamp_reg(speed * ((double)usteps_per_step * 16777216.0 / fclk), RAMP_REG_VMAX_MAX);
+}
+
+// VACTUAL (24 бита со знаком, уже расширен) → шаги/с
+inline float ramp_vactual_to_speed(int32_t vactual, uint32_t fclk, uint32_t usteps_per_step) {
+    return (float)((double)vactual * fclk / 16777216.0 / usteps_per_step);
+}
@@ -0,0 +1,267 @@
+#include "sequence.h"
+#include "tmc.h"
+#include "eeprom_manager.h"
+#include "move_events.h"
+#include "move_segments.h"
+#include "step_pulse.h"
+#include "fault_monitor.h"
+#include <LittleFS.h>
+
+// Объявление функции для веб-логов (определена в web_server.cpp)
+extern void add_log_to_web(String message);
+
+// Бывший update_center_sequence(): ±1000 шагов с паузой после каждого завершения
+static const char CENTER_SEQUENCE_SOURCE[] =
+    "# Вправо, влево, возврат в центр\n"
+    "move 1000\n"
+    "wait_done\n"
+    "wait 250\n"
+    "move -1000\n"
+    "wait_done\n"
+    "wait 250\n"
+    "move 1000\n"
+    "wait_done\n";
+
+// Ожидающая запуска программа: пишет AsyncTCP, забирает задача движения - копия под спинлоком
+static portMUX_TYPE sequence_mux = portMUX_INITIALIZER_UNLOCKED;
+static SeqProgram pending_program;
+static char pending_name[SEQUENCE_NAME_MAX + 1] = "";
+static bool pending_ready = false;
+
+// Исполнение - только задача движения
+static SeqProgram active_program;
+static SeqVm vm = {};
+static bool seq_active = false;
+static bool current_overridden = false;
+static bool ramp_overridden = false;
+static uint32_t started_ms = 0;
+static SequenceStatus status = {};
+
+bool sequence_name_valid(const String &name) {
+    if (name.isEmpty() || name.length() > SEQUENCE_NAME_MAX) return false;
+    for (size_t i = 0; i < name.length(); i++) {
+        char c = name[i];
+        if (!isalnum((unsigned char)c) && c != '_' && c != '-') return false;
+    }
+    return true;
+}
+
+String sequence_path(const String &name) {
+    return "/seq_" + name + ".txt";
+}
+
+bool sequence_load_source(const String &name, String &source) {
+    File file = LittleFS.open(sequence_path(name), "r");
+    if (file) {
+        source = file.readString();
+        file.close();
+        return true;
+    }
+    if (name == SEQUENCE_BUILTIN_CENTER) {
+        source = CENTER_SEQUENCE_SOURCE;
+        return true;
+    }
+    return false;
+}
+
+bool sequence_save_source(const String &name, const String &source) {
+    File file = LittleFS.open(sequence_path(name), "w");
+    if (!file) return false;
+    size_t written = file.print(source);
+    file.close();
+    return written == source.length();
+}
+
+bool sequence_remove(const String &name) {
+    return LittleFS.remove(sequence_path(name));
+}
+
+uint8_t sequence_list(String *names, uint8_t max_names) {
+    uint8_t count = 0;
+    bool center_file = false;
+    File root = LittleFS.open("/");
+    for (File file = root.openNextFile(); file && count < max_names; file = root.openNextFile()) {
+        // Старое ядро отдаёт полный путь, новое - имя файла
+        String fname = file.name();
+        if (fname.startsWith("/")) fname = fname.substring(1);
+        if (!fname.startsWith("seq_") || !fname.endsWith(".txt")) continue;
+        names[count] = fname.substring(4, fname.length() - 4);
+        if (names[count] == SEQUENCE_BUILTIN_CENTER) center_file = true;
+        count++;
+    }
+    if (!center_file && count < max_names) names[count++] = SEQUENCE_BUILTIN_CENTER;
+    return count;
+}
+
+const char* sequence_validate(const SeqProgram &program, uint16_t *op_index) {
+    // Проверка идёт в AsyncTCP - поля из одной версии настроек
+    MotorSettings settings = get_settings_snapshot();
+    RampProfile base = get_ramp_profile(settings);
+    uint16_t index = 0;
+    for (uint16_t pc = 0; pc < program.length; pc += 1 + SEQ_OP_ARGS[program.code[pc]], index++) {
+        const uint32_t *a = &program.code[pc + 1];
+        *op_index = index;
+        if (program.code[pc] == SEQ_OP_CURRENT && !validate_current(a[0])) return "invalid current";
+        if (program.code[pc] == SEQ_OP_MOVE_TO && settings.control_mode != MODE_MOTION_CONTROLLER) {
+            return "move_to needs Motion Controller mode";
+        }
+        if (program.code[pc] == SEQ_OP_RAMP) {
+            MoveSegment seg = {0, a[0], a[1], a[2]};
+            if ((seg.vmax && !validate_speed(seg.vmax)) || seg.amax > 0xFFFF || seg.dmax > 0xFFFF ||
+                (seg.amax && !validate_acceleration(seg.amax)) || (seg.dmax && !validate_acceleration(seg.dmax))) {
+                return "invalid speed/acceleration";
+            }
+            const char *error = ramp_profile_validate(move_segment_ramp(base, seg));
+            if (error) return error;
+        }
+    }
+    return nullptr;
+}
+
+void sequence_set_pending(const String &name, const SeqProgram &program) {
+    portENTER_CRITICAL(&sequence_mux);
+    memcpy(&pending_program, &program, seq_program_bytes(program));
+    strlcpy(pending_name, name.c_str(), sizeof(pending_name));
+    pending_ready = true;
+    portEXIT_CRITICAL(&sequence_mux);
+}
+
+// Вернуть ток и рампу настроек, остановить движение, если программа прервана посреди хода
+static void sequence_finish(bool stop_motion) {
+    seq_active = false;
+    status.active = false;
+    status.state = vm.state;
+    status.pc = vm.pc;
+    status.ops_executed = vm.ops_executed;
+    status.actions = vm.actions;
+    status.elapsed_ms = millis() - started_ms;
+    status.error = vm.error;
+
+    if (stop_motion && tmc_initialized && move_in_flight()) {
+        step_pulse_abort();
+        move_events_abort();
+        motor.stop();
+    }
+    if (tmc_initialized && current_overridden) set_motor_current(currentSettings.current_mA, currentSettings.hold_multiplier);
+    if (tmc_initialized && ramp_overridden) apply_ramp_profile(get_ramp_profile(currentSettings));
+    current_overridden = false;
+    ramp_overridden = false;
+
+    if (vm.state == SEQ_DONE) {
+        add_log_to_web("✅ Sequence '" + String(status.name) + "' done: " + String(vm.actions) + " actions in " +
+                       String(status.elapsed_ms) + " ms");
+    } else {
+        add_log_to_web("⏹️ Sequence '" + String(status.name) + "' stopped at pc " + String(vm.pc) + ": " +
+                       String(vm.error ? vm.error : "unknown"));
+    }
+}
+
+bool sequence_start() {
+    if (seq_active) sequence_abort("restarted");
+
+    portENTER_CRITICAL(&sequence_mux);
+    bool ready = pending_ready;
+    if (ready) {
+        memcpy(&active_program, &pending_program, seq_program_bytes(pending_program));
+        strlcpy(status.name, pending_name, sizeof(status.name));
+        pending_ready = false;
+    }
+    portEXIT_CRITICAL(&sequence_mux);
+
+    if (!ready) {
+        add_log_to_web("❌ Sequence: nothing to run");
+        return false;
+    }
+    if (!tmc_initialized || !motor_enabled) {
+        add_log_to_web("❌ Cannot start sequence - motor not ready");
+        return false;
+    }
+
+    seq_start(vm);
+    seq_active = true;
+    started_ms = millis();
+    status.active = true;
+    status.state = SEQ_RUNNING;
+    status.code_words = active_program.length;
+    status.error = nullptr;
+    status.runs++;
+    add_log("▶️ Sequence '" + String(status.name) + "' started: " + String(active_program.ops) + " ops, " +
+            String(seq_program_bytes(active_program)) + " bytes");
+    return true;
+}
+
+// Действие программы на драйвере. nullptr - выполнено
+static const char* sequence_execute(const SeqAction &act) {
+    MotorControlMode mode = (MotorControlMode)currentSettings.control_mode;
+    switch (act.type) {
+        case SEQ_ACT_MOVE:
+            move_relative_usteps(act.arg[0], mode);
+            return nullptr;
+
+        case SEQ_ACT_MOVE_TO:
+            return move_absolute_usteps(act.arg[0]) ? nullptr : "move_to failed";
+
+        case SEQ_ACT_ANGLE:
+            return move_angle_mdeg(act.arg[0], mode) ? nullptr : "angle move failed";
+
+        case SEQ_ACT_CURRENT:
+            set_motor_current((uint16_t)act.arg[0], currentSettings.hold_multiplier);
+            current_overridden = true;
+            return nullptr;
+
+        case SEQ_ACT_RAMP: {
+            MoveSegment seg = {0, (uint32_t)act.arg[0], (uint32_t)act.arg[1], (uint32_t)act.arg[2]};
+            ramp_overridden = true;
+            return apply_ramp_profile(move_segment_ramp(get_ramp_profile(currentSettings), seg)) ? nullptr : "ramp rejected";
+        }
+
+        default:
+            return nullptr;
+    }
+}
+
+void sequence_tick() {
+    if (!seq_active) return;
+    if (!tmc_initialized || !motor_enabled) {
+        sequence_abort("motor not ready");
+        return;
+    }
+
+    // wait_stall считает фронты DIAG0 от StallGuard - stall должен быть выведен на DIAG0 (setup_stallguard)
+    for (uint8_t i = 0; i < SEQUENCE_ACTIONS_PER_TICK; i++) {
+        SeqInputs in = {(uint32_t)millis(), !move_in_flight(), get_fault_monitor_stats().stall_edges};
+        SeqAction act = seq_step(vm, active_program, in);
+        if (vm.state != SEQ_RUNNING) {
+            sequence_finish(vm.state == SEQ_FAILED);
+            return;
+        }
+        if (act.type == SEQ_ACT_NONE) break;
+
+        const char *error = sequence_execute(act);
+        if (error) {
+            seq_fail(vm, error);
+            sequence_finish(true);
+            return;
+        }
+    }
+    status.pc = vm.pc;
+    status.ops_executed = vm.ops_executed;
+    status.actions = vm.actions;
+}
+
+void sequence_abort(const char *reason) {
+    if (!seq_active) return;
+    // Движение останавливает вызывающий (стоп, хоминг, новая команда) - здесь только ток и рампа
+    seq_fail(vm, reason);
+    sequence_finish(false);
+}
+
+bool is_sequence_active() {
+    return seq_active;
+}
+
+SequenceStatus get_sequence_status() {
+    SequenceStatus s = status;
+    if (s.active) s.elapsed_ms = millis() - started_ms;
+    return s;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <Arduino.h>
+#include "sequence_vm.h"
+
+// ============================================================================
+// ПРОГРАММЫ ДВИЖЕНИЯ НА LittleFS
+// ============================================================================
+// Текст программы (формат - sequence_vm.h) хранится в /seq_<имя>.txt. HTTP-обработчик читает
+// его, компилирует в байткод, проверяет ток и рампы и отдаёт готовую программу задаче
+// движения. Та забирает её командой MOTION_CMD_RUN_SEQUENCE и исполняет в sequence_tick()
+// без ожиданий внутри задачи. Встроенная "center" (вправо - влево - в центр, бывшая жёсткая
+// последовательность) есть и без файла, файл с тем же именем её заменяет.
+// Ток и рампа из программы действуют до её конца, затем возвращаются значения настроек.
+
+#define SEQUENCE_NAME_MAX 24
+#define SEQUENCE_SOURCE_MAX 4096
+#define SEQUENCE_LIST_MAX 32
+#define SEQUENCE_ACTIONS_PER_TICK 8     // Действий за итерацию задачи (ток + рампа + ход - сразу)
+#define SEQUENCE_BUILTIN_CENTER "center"
+
+struct SequenceStatus {
+    bool active;
+    char name[SEQUENCE_NAME_MAX + 1];
+    SeqState state;
+    uint16_t pc;
+    uint16_t code_words;
+    uint32_t ops_executed;
+    uint32_t actions;
+    uint32_t runs;
+    uint32_t elapsed_ms;
+    const char *error;              // Причина ошибки или отмены последнего запуска
+};
+
+bool sequence_name_valid(const String &name);
+String sequence_path(const String &name);
+
+// Только задача AsyncTCP: текст программы (файл или встроенная), сохранение, список имён
+bool sequence_load_source(const String &name, String &source);
+bool sequence_save_source(const String &name, const String &source);
+bool sequence_remove(const String &name);
+uint8_t sequence_list(String *names, uint8_t max_names);
+// Ток и рампы программы допустимы для драйвера. nullptr - да, иначе ошибка и номер операции
+const char* sequence_validate(const SeqProgram &program, uint16_t *op_index);
+// Скомпилированная программа ждёт MOTION_CMD_RUN_SEQUENCE (прошлая неначатая заменяется)
+void sequence_set_pending(const String &name, const SeqProgram &program);
+
+// Задача движения
+bool sequence_start();
+void sequence_tick();
+void sequence_abort(const char *reason);
+bool is_sequence_active();
+
+SequenceStatus get_sequence_status();
@@ -0,0 +1,335 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "usteps.h"
+#include "angle_units.h"
+
+// ============================================================================
+// ПРОГРАММЫ ДВИЖЕНИЯ - КОМПИЛЯТОР В БАЙТКОД И НЕБЛОКИРУЮЩИЙ ИНТЕРПРЕТАТОР (ЧИСТАЯ ЛОГИКА)
+// ============================================================================
+// Текст - команда на строку, '#' - комментарий до конца строки:
+//   move <шаги>              относительный ход (move_us <микрошаги>)
+//   move_to <шаги>           абсолютная позиция (move_to_us <микрошаги>)
+//   angle <градусы>          поворот выходного вала (angle_units.h)
+//   wait <мс>
+//   wait_done [таймаут_мс]   ждать события завершения движения
+//   wait_stall [таймаут_мс]  ждать срабатывания StallGuard
+//   loop <N> ... end         повтор N раз (0 - бесконечно), вложенность до SEQ_MAX_LOOP_DEPTH
+//   current <мА>             ток для следующих ходов
+//   ramp <vmax> [amax] [dmax]  рампа следующих ходов (0 или пропуск - из настроек)
+// Байткод - плоский массив uint32_t: слово операции и следом её аргументы. Интерпретатор сам
+// не ждёт: seq_step() проходит управляющие операции и возвращает первое действие для железа
+// (ход, ток, рампа) или SEQ_ACT_NONE, если стоит на ожидании. Проверяется на хосте.
+
+#define SEQ_MAX_CODE_WORDS 512
+#define SEQ_MAX_LOOP_DEPTH 4
+#define SEQ_MAX_OPS_PER_STEP 64     // За вызов seq_step() - не даёт зависнуть на пустом цикле
+#define SEQ_MAX_LINE 96
+
+enum SeqOpcode : uint8_t {
+    SEQ_OP_HALT = 0,
+    SEQ_OP_MOVE,            // usteps
+    SEQ_OP_MOVE_TO,         // usteps
+    SEQ_OP_ANGLE,           // mdeg
+    SEQ_OP_WAIT,            // ms
+    SEQ_OP_WAIT_DONE,       // timeout_ms (0 - без таймаута)
+    SEQ_OP_WAIT_STALL,      // timeout_ms
+    SEQ_OP_LOOP,            // count (0 - бесконечно)
+    SEQ_OP_END,
+    SEQ_OP_CURRENT,         // mA
+    SEQ_OP_RAMP,            // vmax, amax, dmax
+    SEQ_OP_COUNT
+};
+
+static const uint8_t SEQ_OP_ARGS[SEQ_OP_COUNT] = {0, 1, 1, 1, 1, 1, 1, 1, 0, 1, 3};
+
+struct SeqProgram {
+    uint16_t length;        // Слов байткода, с завершающим HALT
+    uint16_t ops;           // Операций
+    uint32_t code[SEQ_MAX_CODE_WORDS];
+};
+
+// Занятая программой память: заголовок и слова байткода (остаток массива не используется)
+static inline size_t seq_program_bytes(const SeqProgram &p) {
+    return offsetof(SeqProgram, code) + p.length * sizeof(p.code[0]);
+}
+
+struct SeqCompileResult {
+    const char *error;      // nullptr - успешно
+    uint16_t line;          // Строка ошибки (с 1)
+};
+
+// ===== КОМПИЛЯТОР =====
+
+static inline bool seq_parse_int(const char *tok, int64_t min_value, int64_t max_value, int64_t *out) {
+    char *end;
+    long long v = strtoll(tok, &end, 10);
+    if (end == tok || *end) return false;
+    if (v < min_value || v > max_value) return false;
+    *out = v;
+    return true;
+}
+
+static inline bool seq_emit(SeqProgram &p, uint32_t word) {
+    if (p.length >= SEQ_MAX_CODE_WORDS) return false;
+    p.code[p.length++] = word;
+    return true;
+}
+
+// usteps_per_step - шкала шагов в move/move_to (get_usteps_per_step())
+static inline SeqCompileResult seq_compile(const char *text, uint32_t usteps_per_step, SeqProgram &p) {
+    SeqCompileResult r = {nullptr, 0};
+    p.length = 0;
+    p.ops = 0;
+    uint16_t loop_pc[SEQ_MAX_LOOP_DEPTH];
+    uint16_t loop_line[SEQ_MAX_LOOP_DEPTH];
+    uint8_t depth = 0;
+
+    const char *s = text ? text : "";
+    while (*s || r.line == 0) {
+        r.line++;
+        // Строка без комментария
+        char line[SEQ_MAX_LINE];
+        size_t n = 0;
+        bool comment = false;
+        for (; *s && *s != '\n'; s++) {
+            if (*s == '#') comment = true;
+            if (comment || *s == '\r') continue;
+            if (n + 1 >= sizeof(line)) { r.error = "line too long"; return r; }
+            line[n++] = *s;
+        }
+        line[n] = '\0';
+        if (*s == '\n') s++;
+
+        char *tok[5];
+        uint8_t count = 0;
+        for (char *t = strtok(line, " \t"); t && count < 5; t = strtok(nullptr, " \t")) tok[count++] = t;
+        if (count == 0) {
+            if (!*s) break;
+            continue;
+        }
+        if (count == 5) { r.error = "too many arguments"; return r; }
+
+        const char *cmd = tok[0];
+        uint8_t args = count - 1;
+        int64_t v[3] = {0, 0, 0};
+        uint8_t op;
+        bool ok = true;
+
+        if (!strcmp(cmd, "move") || !strcmp(cmd, "move_to") || !strcmp(cmd, "move_us") || !strcmp(cmd, "move_to_us")) {
+            bool us = strstr(cmd, "_us") != nullptr;
+            op = !strncmp(cmd, "move_to", 7) ? SEQ_OP_MOVE_TO : SEQ_OP_MOVE;
+            int32_t usteps = 0;
+            ok = args == 1 && seq_parse_int(tok[1], INT32_MIN, INT32_MAX, &v[0]);
+            if (ok && us) ok = op == SEQ_OP_MOVE_TO || usteps_move_valid(v[0]);
+            else if (ok) {
+                ok = usteps_from_steps(v[0], usteps_per_step, &usteps);
+                v[0] = usteps;
+            }
+            if (!ok) { r.error = "expected position in int32 µstep range"; return r; }
+        } else if (!strcmp(cmd, "angle")) {
+            op = SEQ_OP_ANGLE;
+            ok = args == 1 && angle_parse_mdeg(tok[1], &v[0]) && v[0] >= INT32_MIN && v[0] <= INT32_MAX;
+            if (!ok) { r.error = "expected angle in degrees"; return r; }
+        } else if (!strcmp(cmd, "wait")) {
+            op = SEQ_OP_WAIT;
+            ok = args == 1 && seq_parse_int(tok[1], 0, 86400000, &v[0]);
+            if (!ok) { r.error = "expected wait time in ms"; return r; }
+        } else if (!strcmp(cmd, "wait_done") || !strcmp(cmd, "wait_stall")) {
+            op = !strcmp(cmd, "wait_done") ? SEQ_OP_WAIT_DONE : SEQ_OP_WAIT_STALL;
+            ok = args <= 1 && (args == 0 || seq_parse_int(tok[1], 0, 86400000, &v[0]));
+            if (!ok) { r.error = "expected optional timeout in ms"; return r; }
+        } else if (!strcmp(cmd, "loop")) {
+            op = SEQ_OP_LOOP;
+            ok = args == 1 && seq_parse_int(tok[1], 0, 0xFFFFFFFFLL, &v[0]);
+            if (!ok) { r.error = "expected loop count"; return r; }
+            if (depth >= SEQ_MAX_LOOP_DEPTH) { r.error = "loops nested too deep"; return r; }
+        } else if (!strcmp(cmd, "end")) {
+            op = SEQ_OP_END;
+            if (args) { r.error = "end takes no arguments"; return r; }
+            if (!depth) { r.error = "end without loop"; return r; }
+            // Тело цикла без единой операции - бесконечный пустой проход
+            if (loop_pc[depth - 1] + 1 + SEQ_OP_ARGS[SEQ_OP_LOOP] == p.length) { r.error = "empty loop"; return r; }
+            depth--;
+        } else if (!strcmp(cmd, "current")) {
+            op = SEQ_OP_CURRENT;
+            ok = args == 1 && seq_parse_int(tok[1], 1, 65535, &v[0]);
+            if (!ok) { r.error = "expected current in mA"; return r; }
+        } else if (!strcmp(cmd, "ramp")) {
+            op = SEQ_OP_RAMP;
+            ok = args >= 1 && args <= 3;
+            for (uint8_t i = 0; ok && i < args; i++) ok = seq_parse_int(tok[i + 1], 0, 0xFFFFFF, &v[i]);
+            if (!ok) { r.error = "expected ramp <vmax> [amax] [dmax]"; return r; }
+        } else {
+            r.error = "unknown command";
+            return r;
+        }
+
+        if (op == SEQ_OP_LOOP) {
+            loop_pc[depth] = p.length;
+            loop_line[depth++] = r.line;
+        }
+        ok = seq_emit(p, op);
+        for (uint8_t i = 0; ok && i < SEQ_OP_ARGS[op]; i++) ok = seq_emit(p, (uint32_t)v[i]);
+        if (!ok) { r.error = "program too long"; return r; }
+        p.ops++;
+        if (!*s) break;
+    }
+
+    if (depth) {
+        r.error = "loop without end";
+        r.line = loop_line[depth - 1];
+        return r;
+    }
+    if (!seq_emit(p, SEQ_OP_HALT)) { r.error = "program too long"; return r; }
+    r.line = 0;
+    return r;
+}
+
+// ===== ИНТЕРПРЕТАТОР =====
+
+enum SeqState : uint8_t {
+    SEQ_IDLE = 0,
+    SEQ_RUNNING,
+    SEQ_DONE,
+    SEQ_FAILED
+};
+
+enum SeqActionType : uint8_t {
+    SEQ_ACT_NONE = 0,
+    SEQ_ACT_MOVE,           // arg[0] - микрошаги относительно
+    SEQ_ACT_MOVE_TO,        // arg[0] - микрошаги абсолютно
+    SEQ_ACT_ANGLE,          // arg[0] - миллиградусы
+    SEQ_ACT_CURRENT,        // arg[0] - мА
+    SEQ_ACT_RAMP            // arg[0..2] - vmax, amax, dmax (0 - из настроек)
+};
+
+struct SeqAction {
+    SeqActionType type;
+    int32_t arg[3];
+};
+
+struct SeqLoopFrame {
+    uint16_t body_pc;
+    uint32_t remaining;     // 0 - бесконечный цикл
+};
+
+struct SeqInputs {
+    uint32_t now_ms;
+    bool move_done;         // Движение не идёт (событие завершения уже было)
+    uint32_t stall_count;   // Счётчик срабатываний StallGuard
+};
+
+struct SeqVm {
+    SeqState state;
+    uint16_t pc;
+    uint8_t depth;
+    SeqLoopFrame loops[SEQ_MAX_LOOP_DEPTH];
+    uint8_t waiting;        // SeqOpcode текущего ожидания, 0 - не ждёт
+    uint32_t wait_start_ms;
+    uint32_t wait_ms;       // WAIT - длительность, WAIT_DONE/WAIT_STALL - таймаут
+    uint32_t stall_base;
+    uint32_t ops_executed;
+    uint32_t actions;
+    const char *error;
+};
+
+static inline const char* seq_state_name(SeqState state) {
+    switch (state) {
+        case SEQ_RUNNING: return "running";
+        case SEQ_DONE: return "done";
+        case SEQ_FAILED: return "failed";
+        default: return "idle";
+    }
+}
+
+static inline void seq_start(SeqVm &vm) {
+    memset(&vm, 0, sizeof(vm));
+    vm.state = SEQ_RUNNING;
+}
+
+static inline void seq_fail(SeqVm &vm, const char *error) {
+    vm.state = SEQ_FAILED;
+    vm.error = error;
+    vm.waiting = 0;
+}
+
+static inline SeqAction seq_action(SeqActionType type, const uint32_t *a, uint8_t count) {
+    SeqAction act = {type, {0, 0, 0}};
+    for (uint8_t i = 0; i < count; i++) act.arg[i] = (int32_t)a[i];
+    return act;
+}
+
+static inline SeqAction seq_step(SeqVm &vm, const SeqProgram &p, const SeqInputs &in) {
+    SeqAction none = {SEQ_ACT_NONE, {0, 0, 0}};
+    if (vm.state != SEQ_RUNNING) return none;
+
+    if (vm.waiting) {
+        uint32_t elapsed = in.now_ms - vm.wait_start_ms;
+        bool done = vm.waiting == SEQ_OP_WAIT ? elapsed >= vm.wait_ms
+                  : vm.waiting == SEQ_OP_WAIT_DONE ? in.move_done
+                  : in.stall_count != vm.stall_base;
+        if (!done) {
+            if (vm.waiting != SEQ_OP_WAIT && vm.wait_ms && elapsed >= vm.wait_ms) {
+                seq_fail(vm, vm.waiting == SEQ_OP_WAIT_DONE ? "wait_done timeout" : "wait_stall timeout");
+            }
+            return none;
+        }
+        vm.waiting = 0;
+    }
+
+    for (uint16_t n = 0; n < SEQ_MAX_OPS_PER_STEP; n++) {
+        if (vm.pc >= p.length) {
+            seq_fail(vm, "pc out of range");
+            return none;
+        }
+        uint8_t op = (uint8_t)p.code[vm.pc];
+        if (op >= SEQ_OP_COUNT || vm.pc + 1u + SEQ_OP_ARGS[op] > p.length) {
+            seq_fail(vm, "bad opcode");
+            return none;
+        }
+        const uint32_t *a = &p.code[vm.pc + 1];
+        vm.pc += 1 + SEQ_OP_ARGS[op];
+        vm.ops_executed++;
+
+        switch (op) {
+            case SEQ_OP_HALT:
+                vm.pc -= 1;
+                vm.state = SEQ_DONE;
+                return none;
+
+            case SEQ_OP_MOVE: vm.actions++; return seq_action(SEQ_ACT_MOVE, a, 1);
+            case SEQ_OP_MOVE_TO: vm.actions++; return seq_action(SEQ_ACT_MOVE_TO, a, 1);
+            case SEQ_OP_ANGLE: vm.actions++; return seq_action(SEQ_ACT_ANGLE, a, 1);
+            case SEQ_OP_CURRENT: vm.actions++; return seq_action(SEQ_ACT_CURRENT, a, 1);
+            case SEQ_OP_RAMP: vm.actions++; return seq_action(SEQ_ACT_RAMP, a, 3);
+
+            case SEQ_OP_WAIT:
+            case SEQ_OP_WAIT_DONE:
+            case SEQ_OP_WAIT_STALL:
+                if (op == SEQ_OP_WAIT && a[0] == 0) break;
+                if (op == SEQ_OP_WAIT_DONE && in.move_done) break;
+                vm.waiting = op;
+                vm.wait_start_ms = in.now_ms;
+                vm.wait_ms = a[0];
+                vm.stall_base = in.stall_count;
+                return none;
+
+            case SEQ_OP_LOOP:
+                vm.loops[vm.depth].body_pc = vm.pc;
+                vm.loops[vm.depth].remaining = a[0];
+                vm.depth++;
+                break;
+
+            case SEQ_OP_END: {
+                SeqLoopFrame &f = vm.loops[vm.depth - 1];
+                if (f.remaining == 0 || --f.remaining > 0) vm.pc = f.body_pc;
+                else vm.depth--;
+                break;
+            }
+        }
+    }
+    return none;
+}
@@ -0,0 +1,127 @@
+#include "serial_log.h"
+#include "mpsc_queue.h"
+#include "log_ring.h"
+#include <atomic>
+#include <stdarg.h>
+
+struct SerialLogLine {
+    uint16_t len;
+    char text[SERIAL_LOG_LINE_MAX + 1];     // +1 - завершающий ноль vsnprintf, в Serial не уходит
+};
+
+static MpscQueue<SerialLogLine, SERIAL_LOG_QUEUE_SIZE> serial_log_queue;
+static TaskHandle_t serial_log_task_handle = nullptr;
+
+// Пишут производители из любых задач - только атомарные счётчики, без критических секций
+static std::atomic<uint32_t> written{0};
+static std::atomic<uint32_t> dropped{0};
+static std::atomic<uint32_t> truncated{0};
+static std::atomic<uint16_t> max_queued{0};
+static std::atomic<uint32_t> producer_last_us{0};
+static std::atomic<uint32_t> producer_total_us{0};
+static std::atomic<uint32_t> producer_max_us{0};
+
+template <typename V>
+static void atomic_max(std::atomic<V> &target, V value) {
+    V current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+static bool serial_log_account(uint32_t start_us, bool queued, bool was_truncated) {
+    if (!queued) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    uint32_t elapsed_us = micros() - start_us;
+    written.fetch_add(1, std::memory_order_relaxed);
+    if (was_truncated) truncated.fetch_add(1, std::memory_order_relaxed);
+    atomic_max(max_queued, serial_log_queue.size());
+    producer_last_us.store(elapsed_us, std::memory_order_relaxed);
+    producer_total_us.fetch_add(elapsed_us, std::memory_order_relaxed);
+    atomic_max(producer_max_us, elapsed_us);
+    return true;
+}
+
+bool serial_log_write(const char *text, size_t len) {
+    uint32_t start_us = micros();
+    size_t n = log_utf8_clip(text, len, SERIAL_LOG_LINE_MAX);
+    bool queued = serial_log_queue.push_with([text, n](SerialLogLine &line) {
+        memcpy(line.text, text, n);
+        line.len = n;
+    });
+    return serial_log_account(start_us, queued, n < len);
+}
+
+// vsnprintf пишет прямо в занятую ячейку: ни String, ни буфера на стеке вызывающего.
+// Потребитель ждёт эту ячейку, пока она форматируется, - порядок строк не меняется
+bool serial_log_printf(const char *format, ...) {
+    uint32_t start_us = micros();
+    va_list args;
+    va_start(args, format);
+    bool was_truncated = false;
+    bool queued = serial_log_queue.push_with([format, &args, &was_truncated](SerialLogLine &line) {
+        int full = vsnprintf(line.text, sizeof(line.text), format, args);
+        size_t n = full < 0 ? 0 : (size_t)full;
+        if (n > SERIAL_LOG_LINE_MAX) {
+            n = log_utf8_trim(line.text, SERIAL_LOG_LINE_MAX);
+            was_truncated = true;
+        }
+        line.len = n;
+    });
+    va_end(args);
+    return serial_log_account(start_us, queued, was_truncated);
+}
+
+// Единственный потребитель. Serial.write() ждёт UART здесь, а не в задаче движения
+static void serial_log_task(void *) {
+    uint32_t reported_dropped = 0;
+    for (;;) {
+        bool printed = false;
+        while (serial_log_queue.pop_with([](const SerialLogLine &line) {
+            Serial.write((const uint8_t *)line.text, line.len);
+            Serial.write((const uint8_t *)"\r\n", 2);
+        })) {
+            printed = true;
+        }
+
+        uint32_t lost = dropped.load(std::memory_order_relaxed);
+        if (lost < reported_dropped) reported_dropped = 0;  // Статистику сбросили
+        if (lost != reported_dropped) {
+            Serial.printf("⚠️ Serial log: %lu lines dropped (queue full)\r\n", (unsigned long)(lost - reported_dropped));
+            reported_dropped = lost;
+        }
+
+        if (!printed) vTaskDelay(pdMS_TO_TICKS(SERIAL_LOG_IDLE_MS));
+    }
+}
+
+void init_serial_log() {
+    if (serial_log_task_handle) return;
+    xTaskCreatePinnedToCore(serial_log_task, "serial_log", SERIAL_LOG_TASK_STACK, nullptr,
+                            SERIAL_LOG_TASK_PRIORITY, &serial_log_task_handle, SERIAL_LOG_TASK_CORE);
+}
+
+SerialLogStats get_serial_log_stats() {
+    SerialLogStats s = {};
+    s.written = written.load(std::memory_order_relaxed);
+    s.dropped = dropped.load(std::memory_order_relaxed);
+    s.truncated = truncated.load(std::memory_order_relaxed);
+    s.queued = serial_log_queue.size();
+    s.max_queued = max_queued.load(std::memory_order_relaxed);
+    s.producer_last_us = producer_last_us.load(std::memory_order_relaxed);
+    s.producer_avg_us = s.written ? (float)producer_total_us.load(std::memory_order_relaxed) / s.written : 0;
+    s.producer_max_us = producer_max_us.load(std::memory_order_relaxed);
+    return s;
+}
+
+void reset_serial_log_stats() {
+    written = 0;
+    dropped = 0;
+    truncated = 0;
+    max_queued = 0;
+    producer_last_us = 0;
+    producer_total_us = 0;
+    producer_max_us = 0;
+}
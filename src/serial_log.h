@@ -0,0 +1,79 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// ============================================================================
+// АСИНХРОННЫЙ ЛОГ В SERIAL
+// ============================================================================
+// add_log() и LOG_*() только копируют строку в ячейку lock-free очереди (mpsc_queue.h) - без
+// ожидания UART (~87 мкс на символ при 115200) и без мьютекса, из любой задачи. Выводит их
+// своя низкоприоритетная задача на PRO CPU. Очередь заполнена - строка отбрасывается и
+// учитывается, задача вывода потом сообщает, сколько строк потеряно. Длиннее
+// SERIAL_LOG_LINE_MAX - обрезается по границе символа UTF-8.
+// Уровень LOG_LEVEL (config.h) - на этапе компиляции: отключённый LOG_DEBUG(...) не оставляет
+// в прошивке ни вызова, ни сборки String из аргументов.
+// LOG_*F(format, ...) - printf-форма для горячих путей: vsnprintf форматирует прямо в ячейку
+// очереди, без String и без кучи. Аргументы - как у printf: int32_t/uint32_t через (long) и
+// (unsigned long) с %ld/%lu.
+
+#define SERIAL_LOG_QUEUE_SIZE 32        // Степень двойки
+#define SERIAL_LOG_LINE_MAX 190         // Байт текста в ячейке (ячейка - 194 байта)
+#define SERIAL_LOG_IDLE_MS 10           // Опрос пустой очереди
+#define SERIAL_LOG_TASK_CORE 0
+#define SERIAL_LOG_TASK_PRIORITY 1
+#define SERIAL_LOG_TASK_STACK 3072
+
+struct SerialLogStats {
+    uint32_t written;                   // Строк поставлено в очередь
+    uint32_t dropped;                   // Очередь была заполнена
+    uint32_t truncated;                 // Обрезано до SERIAL_LOG_LINE_MAX
+    uint16_t queued;                    // Сейчас в очереди
+    uint16_t max_queued;
+    uint32_t producer_last_us;          // Стоимость add_log() для вызывающей задачи
+    float producer_avg_us;
+    uint32_t producer_max_us;
+};
+
+void init_serial_log();
+
+// Производитель: из любой задачи, не блокирует. false - строка отброшена
+bool serial_log_write(const char *text, size_t len);
+bool serial_log_printf(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+SerialLogStats get_serial_log_stats();
+void reset_serial_log_stats();
+
+// Определена в tmc.cpp - строка уходит в serial_log_write()
+void add_log(String message);
+
+#if LOG_LEVEL >= 1
+#define LOG_ERROR(msg) add_log(msg)
+#define LOG_ERRORF(...) serial_log_printf(__VA_ARGS__)
+#else
+#define LOG_ERROR(msg) do { } while (0)
+#define LOG_ERRORF(...) do { } while (0)
+#endif
+
+#if LOG_LEVEL >= 2
+#define LOG_WARN(msg) add_log(msg)
+#define LOG_WARNF(...) serial_log_printf(__VA_ARGS__)
+#else
+#define LOG_WARN(msg) do { } while (0)
+#define LOG_WARNF(...) do { } while (0)
+#endif
+
+#if LOG_LEVEL >= 3
+#define LOG_INFO(msg) add_log(msg)
+#define LOG_INFOF(...) serial_log_printf(__VA_ARGS__)
+#else
+#define LOG_INFO(msg) do { } while (0)
+#define LOG_INFOF(...) do { } while (0)
+#endif
+
+#if LOG_LEVEL >= 4
+#define LOG_DEBUG(msg) add_log(msg)
+#define LOG_DEBUGF(...) serial_log_printf(__VA_ARGS__)
+#else
+#define LOG_DEBUG(msg) do { } while (0)
+#define LOG_DEBUGF(...) do { } while (0)
+#endif
@@ -0,0 +1,200 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+
+// ============================================================================
+// СТАТИСТИКА STALLGUARD2 (SG_RESULT / CS_ACTUAL) И ВЫБОР SGT - ЧИСТАЯ ЛОГИКА
+// ============================================================================
+// Выборки DRV_STATUS группируются по (полоса скорости, SGT). Для каждой точки - среднее,
+// σ (Уэлфорд), минимум и "пол шума" mean - SG_NOISE_SIGMA·σ. Рекомендуемый SGT полосы -
+// самый чувствительный (наименьший), при котором SG_RESULT на свободном ходу не опускается
+// к нулю (stall = SG_RESULT 0). Один и тот же код считает на чипе (sg_tuning.cpp) и на
+// хосте по записанному CSV (/api/sg_tune/samples.csv), строки - sg_csv_parse_line().
+
+#define SG_MAX_BANDS 6              // Полос скорости
+#define SG_MAX_SWEEP_POINTS 16      // Значений SGT в одной полосе
+#define SG_NOISE_SIGMA 4.0f         // Пол шума = mean - 4σ
+#define SG_FLOOR_MARGIN 50.0f       // Пол шума свободного хода должен быть выше (из 1023)
+#define SG_MIN_SAMPLES 32           // Меньше - точка не оценивается
+#define SG_MAX_NOISE_RATIO 0.25f    // σ/mean выше - в этой полосе StallGuard ненадёжен
+#define SG_TCOOLTHRS_MARGIN_DIV 8   // TCOOLTHRS = TSTEP полосы + 1/8 (включение чуть ниже скорости)
+
+// Упакованная выборка (4 байта): SG_RESULT 0..9, CS_ACTUAL 10..14, stst 15, SGT+64 16..22, полоса 24..27
+static inline uint32_t sg_sample_pack(uint16_t sg_result, uint8_t cs_actual, bool stst, int8_t sgt, uint8_t band) {
+    return (sg_result & 0x3FF) | ((uint32_t)(cs_actual & 0x1F) << 10) | ((uint32_t)(stst ? 1 : 0) << 15) |
+           ((uint32_t)((sgt + 64) & 0x7F) << 16) | ((uint32_t)(band & 0x0F) << 24);
+}
+static inline uint16_t sg_sample_result(uint32_t s) { return s & 0x3FF; }
+static inline uint8_t sg_sample_cs(uint32_t s) { return (s >> 10) & 0x1F; }
+static inline bool sg_sample_stst(uint32_t s) { return (s >> 15) & 1; }
+static inline int8_t sg_sample_sgt(uint32_t s) { return (int8_t)(((s >> 16) & 0x7F) - 64); }
+static inline uint8_t sg_sample_band(uint32_t s) { return (s >> 24) & 0x0F; }
+
+struct SgStats {
+    uint32_t n;
+    uint32_t standstill;    // Выборки в покое - SG_RESULT недостоверен, не учитываются
+    float mean;
+    float m2;
+    uint16_t min;
+    uint16_t max;
+    float cs_mean;
+};
+
+static inline void sg_stats_reset(SgStats &s) {
+    s.n = 0;
+    s.standstill = 0;
+    s.mean = 0;
+    s.m2 = 0;
+    s.min = 0x3FF;
+    s.max = 0;
+    s.cs_mean = 0;
+}
+
+static inline void sg_stats_add(SgStats &s, uint16_t sg_result, uint8_t cs_actual, bool stst) {
+    if (stst) {
+        s.standstill++;
+        return;
+    }
+    s.n++;
+    float delta = sg_result - s.mean;
+    s.mean += delta / s.n;
+    s.m2 += delta * (sg_result - s.mean);
+    s.cs_mean += (cs_actual - s.cs_mean) / s.n;
+    if (sg_result < s.min) s.min = sg_result;
+    if (sg_result > s.max) s.max = sg_result;
+}
+
+static inline float sg_stats_std(const SgStats &s) {
+    return s.n > 1 ? sqrtf(s.m2 / (s.n - 1)) : 0.0f;
+}
+
+static inline float sg_stats_floor(const SgStats &s) {
+    return s.mean - SG_NOISE_SIGMA * sg_stats_std(s);
+}
+
+// Точка безопасна: достаточно выборок, пол шума и минимум выше запаса - ложных stall не будет
+static inline bool sg_point_safe(const SgStats &s) {
+    return s.n >= SG_MIN_SAMPLES && sg_stats_floor(s) >= SG_FLOOR_MARGIN && s.min > 0;
+}
+
+struct SgSweepPoint {
+    int8_t sgt;
+    SgStats stats;
+};
+
+struct SgBandResult {
+    uint32_t speed;             // Шаги/с
+    uint32_t tstep;             // TSTEP на этой скорости (1/fCLK между 1/256 микрошагами)
+    uint8_t points;
+    SgSweepPoint sweep[SG_MAX_SWEEP_POINTS];
+    bool usable;
+    int8_t sgt_recommended;
+    float noise;                // σ/mean в рекомендованной точке
+    float floor;
+    uint32_t tcoolthrs;
+};
+
+static inline void sg_band_reset(SgBandResult &b, uint32_t speed) {
+    b.speed = speed;
+    b.tstep = 0;
+    b.points = 0;
+    b.usable = false;
+    b.sgt_recommended = 0;
+    b.noise = 0;
+    b.floor = 0;
+    b.tcoolthrs = 0;
+}
+
+// Точка свипа для SGT (создаётся при первой выборке). nullptr - свип переполнен
+static inline SgSweepPoint* sg_band_point(SgBandResult &b, int8_t sgt) {
+    for (uint8_t i = 0; i < b.points; i++) {
+        if (b.sweep[i].sgt == sgt) return &b.sweep[i];
+    }
+    if (b.points >= SG_MAX_SWEEP_POINTS) return nullptr;
+    SgSweepPoint &p = b.sweep[b.points++];
+    p.sgt = sgt;
+    sg_stats_reset(p.stats);
+    return &p;
+}
+
+// Рекомендация полосы: наименьший безопасный SGT
+static inline void sg_band_recommend(SgBandResult &b) {
+    b.usable = false;
+    const SgSweepPoint *best = nullptr;
+    for (uint8_t i = 0; i < b.points; i++) {
+        const SgSweepPoint &p = b.sweep[i];
+        if (!sg_point_safe(p.stats)) continue;
+        if (!best || p.sgt < best->sgt) best = &p;
+    }
+    if (!best) return;
+
+    b.sgt_recommended = best->sgt;
+    b.floor = sg_stats_floor(best->stats);
+    b.noise = best->stats.mean > 0 ? sg_stats_std(best->stats) / best->stats.mean : 1.0f;
+    b.usable = b.noise <= SG_MAX_NOISE_RATIO;
+    b.tcoolthrs = b.tstep + b.tstep / SG_TCOOLTHRS_MARGIN_DIV;
+}
+
+// Итог по всем полосам: SGT, безопасный во всех пригодных полосах (наибольший из рекомендованных),
+// TCOOLTHRS - по самой медленной пригодной полосе. false - пригодных полос нет
+static inline bool sg_tune_summary(const SgBandResult *bands, uint8_t count, int8_t *sgt, uint32_t *tcoolthrs) {
+    bool found = false;
+    for (uint8_t i = 0; i < count; i++) {
+        if (!bands[i].usable) continue;
+        if (!found || bands[i].sgt_recommended > *sgt) *sgt = bands[i].sgt_recommended;
+        if (!found || bands[i].tcoolthrs > *tcoolthrs) *tcoolthrs = bands[i].tcoolthrs;
+        found = true;
+    }
+    return found;
+}
+
+// ===== ФАЙЛ ВЫБОРОК (CSV) =====
+// Строка: band,speed,tstep,sgt,sg_result,cs_actual,stst
+
+struct SgCsvRow {
+    uint8_t band;
+    uint32_t speed;
+    uint32_t tstep;
+    int8_t sgt;
+    uint16_t sg_result;
+    uint8_t cs_actual;
+    bool stst;
+};
+
+#define SG_CSV_HEADER "band,speed,tstep,sgt,sg_result,cs_actual,stst"
+
+static inline int sg_csv_format_row(char *buf, size_t size, const SgCsvRow &r) {
+    return snprintf(buf, size, "%u,%lu,%lu,%d,%u,%u,%u\n", (unsigned)r.band, (unsigned long)r.speed,
+                    (unsigned long)r.tstep, (int)r.sgt, (unsigned)r.sg_result, (unsigned)r.cs_actual, r.stst ? 1u : 0u);
+}
+
+// false - заголовок, пустая или битая строка
+static inline bool sg_csv_parse_line(const char *line, SgCsvRow &r) {
+    unsigned band, sg, cs, stst;
+    unsigned long speed, tstep;
+    int sgt;
+    if (sscanf(line, "%u,%lu,%lu,%d,%u,%u,%u", &band, &speed, &tstep, &sgt, &sg, &cs, &stst) != 7) return false;
+    if (band >= SG_MAX_BANDS || sgt < -64 || sgt > 63 || sg > 1023 || cs > 31) return false;
+    r.band = band;
+    r.speed = speed;
+    r.tstep = tstep;
+    r.sgt = sgt;
+    r.sg_result = sg;
+    r.cs_actual = cs;
+    r.stst = stst != 0;
+    return true;
+}
+
+// Добавить выборку в результаты (bands - массив SG_MAX_BANDS, band_count растёт по мере появления полос)
+static inline bool sg_accumulate(SgBandResult *bands, uint8_t *band_count, const SgCsvRow &r) {
+    if (r.band >= SG_MAX_BANDS) return false;
+    while (*band_count <= r.band) sg_band_reset(bands[(*band_count)++], 0);
+    SgBandResult &b = bands[r.band];
+    b.speed = r.speed;
+    if (r.tstep) b.tstep = r.tstep;
+    SgSweepPoint *p = sg_band_point(b, r.sgt);
+    if (!p) return false;
+    sg_stats_add(p->stats, r.sg_result, r.cs_actual, r.stst);
+    return true;
+}
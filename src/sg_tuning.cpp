@@ -0,0 +1,340 @@
+#include "sg_tuning.h"
+#include "tmc.h"
+#include "eeprom_manager.h"
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+
+// Объявление функции для веб-логов (определена в web_server.cpp)
+extern void add_log_to_web(String message);
+
+enum SgTunePhase : uint8_t {
+    SG_PHASE_IDLE = 0,
+    SG_PHASE_SPIN_UP,       // Выход на скорость полосы
+    SG_PHASE_SETTLE,        // Пауза после скорости / смены SGT
+};
+
+// Параметры: sg_request пишет AsyncTCP (только когда не идёт), sg_active - копия на время измерения
+static SgTuneRequest sg_request = {};
+static SgTuneRequest sg_active = {};
+static SgTunePhase sg_phase = SG_PHASE_IDLE;
+static uint32_t sg_phase_start_ms = 0;
+static uint32_t sg_start_ms = 0;
+static uint8_t sg_band_index = 0;
+static uint8_t sg_point_index = 0;
+static uint32_t sg_saved_tcoolthrs = 0;
+
+// Результаты и кольцо выборок - пишет задача движения, читаются только после окончания
+static SgBandResult sg_bands[SG_MAX_BANDS];
+static uint8_t sg_band_count = 0;
+static uint32_t sg_ring[SG_RING_SIZE];
+static uint32_t sg_ring_total = 0;
+
+static SgTuneStatus sg_status = {};
+static portMUX_TYPE sg_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static uint8_t sg_sweep_count(const SgTuneRequest &r) {
+    return (uint8_t)((r.sgt_max - r.sgt_min) / r.sgt_step + 1);
+}
+
+static int8_t sg_sweep_value(const SgTuneRequest &r, uint8_t index) {
+    return (int8_t)(r.sgt_min + index * r.sgt_step);
+}
+
+bool sg_tune_configure(const SgTuneRequest &request, const char **error) {
+    *error = nullptr;
+    if (is_sg_tune_active()) *error = "SGT sweep already running";
+    else if (request.bands == 0 || request.bands > SG_MAX_BANDS) *error = "bands must be 1..6";
+    else if (request.sgt_min < -64 || request.sgt_max > 63 || request.sgt_min > request.sgt_max) *error = "sgt range must be within -64..63";
+    else if (request.sgt_step == 0) *error = "sgt_step must be > 0";
+    else if ((request.sgt_max - request.sgt_min) / request.sgt_step + 1 > SG_MAX_SWEEP_POINTS) *error = "too many SGT points (max 16)";
+    else if (request.samples < SG_MIN_SAMPLES || request.samples > SG_TUNE_MAX_SAMPLES) *error = "samples must be 32..2048";
+    for (uint8_t i = 0; !*error && i < request.bands; i++) {
+        if (request.speeds[i] == 0 || request.speeds[i] > MAX_SPEED_STEPS) *error = "band speed out of range";
+    }
+    if (*error) return false;
+
+    sg_request = request;
+    return true;
+}
+
+bool is_sg_tune_active() {
+    return sg_phase != SG_PHASE_IDLE;
+}
+
+SgTuneStatus get_sg_tune_status() {
+    portENTER_CRITICAL(&sg_mux);
+    SgTuneStatus s = sg_status;
+    portEXIT_CRITICAL(&sg_mux);
+    return s;
+}
+
+uint8_t get_sg_tune_bands(const SgBandResult **bands) {
+    *bands = sg_bands;
+    return is_sg_tune_active() ? 0 : sg_band_count;
+}
+
+uint32_t sg_ring_count() {
+    if (is_sg_tune_active()) return 0;
+    return sg_ring_total < SG_RING_SIZE ? sg_ring_total : SG_RING_SIZE;
+}
+
+uint32_t sg_ring_get(uint32_t index) {
+    uint32_t oldest = sg_ring_total > SG_RING_SIZE ? sg_ring_total % SG_RING_SIZE : 0;
+    return sg_ring[(oldest + index) % SG_RING_SIZE];
+}
+
+String sg_tune_preset_path(int preset_id) {
+    return preset_id < 0 ? String("/sg_tune_custom.json") : "/sg_tune_" + String(preset_id) + ".json";
+}
+
+// SGT в COOLCONF (биты 16..22), sfilt = 0 - нефильтрованный SG_RESULT, обновляется каждый полный шаг
+static void sg_write_sgt(int8_t sgt) {
+    motor.lockBus();
+    uint32_t coolconf = motor.readRegister(TMC5160_Reg::COOLCONF);
+    coolconf &= ~((0x7FUL << 16) | (1UL << 24));
+    coolconf |= ((uint32_t)(sgt & 0x7F) << 16);
+    motor.writeRegister(TMC5160_Reg::COOLCONF, coolconf);
+    motor.unlockBus();
+}
+
+static void sg_restore_driver() {
+    if (is_jog_active()) set_jog_speed(0);
+    sg_write_sgt(currentSettings.stallguard_threshold);
+    motor.writeRegister(TMC5160_Reg::TCOOLTHRS, sg_saved_tcoolthrs);
+}
+
+static void sg_set_status_point() {
+    portENTER_CRITICAL(&sg_mux);
+    sg_status.band = sg_band_index;
+    sg_status.sgt = sg_sweep_value(sg_active, sg_point_index);
+    portEXIT_CRITICAL(&sg_mux);
+}
+
+static void sg_begin_band() {
+    sg_write_sgt(sg_sweep_value(sg_active, sg_point_index));
+    set_jog_speed((int32_t)sg_active.speeds[sg_band_index]);
+    sg_phase = SG_PHASE_SPIN_UP;
+    sg_phase_start_ms = millis();
+    sg_set_status_point();
+}
+
+void sg_tune_results_json(JsonObject obj) {
+    JsonArray bands = obj["bands"].to<JsonArray>();
+    for (uint8_t i = 0; i < sg_band_count; i++) {
+        const SgBandResult &b = sg_bands[i];
+        JsonObject band = bands.add<JsonObject>();
+        band["speed"] = b.speed;
+        band["tstep"] = b.tstep;
+        band["usable"] = b.usable;
+        band["sgt"] = b.sgt_recommended;
+        band["noise"] = b.noise;
+        band["floor"] = b.floor;
+        band["tcoolthrs"] = b.tcoolthrs;
+        JsonArray sweep = band["sweep"].to<JsonArray>();
+        for (uint8_t j = 0; j < b.points; j++) {
+            const SgStats &s = b.sweep[j].stats;
+            JsonObject point = sweep.add<JsonObject>();
+            point["sgt"] = b.sweep[j].sgt;
+            point["n"] = s.n;
+            point["standstill"] = s.standstill;
+            point["mean"] = s.mean;
+            point["std"] = sg_stats_std(s);
+            point["min"] = s.min;
+            point["max"] = s.max;
+            point["cs_mean"] = s.cs_mean;
+            point["safe"] = sg_point_safe(s);
+        }
+    }
+}
+
+static void sg_save_results(const SgTuneStatus &status) {
+    JsonDocument doc;
+    doc["preset_id"] = status.preset_id;
+    doc["recommended"] = status.recommended;
+    doc["sgt"] = status.sgt_recommended;
+    doc["tcoolthrs"] = status.tcoolthrs_recommended;
+    doc["sample_rate_hz"] = status.sample_rate_hz;
+    sg_tune_results_json(doc.as<JsonObject>());
+
+    File file = LittleFS.open(sg_tune_preset_path(status.preset_id), "w");
+    if (!file) {
+        add_log_to_web("❌ SGT sweep: cannot write " + sg_tune_preset_path(status.preset_id));
+        return;
+    }
+    serializeJson(doc, file);
+    file.close();
+}
+
+bool sg_tune_load_preset(int preset_id, int8_t *sgt, uint32_t *tcoolthrs) {
+    File file = LittleFS.open(sg_tune_preset_path(preset_id), "r");
+    if (!file) return false;
+
+    JsonDocument doc;
+    DeserializationError err = deserializeJson(doc, file);
+    file.close();
+    if (err || !doc["recommended"].as<bool>()) return false;
+
+    *sgt = doc["sgt"].as<int8_t>();
+    *tcoolthrs = doc["tcoolthrs"].as<uint32_t>();
+    return true;
+}
+
+static void sg_finish() {
+    sg_phase = SG_PHASE_IDLE;
+    sg_restore_driver();
+
+    for (uint8_t i = 0; i < sg_band_count; i++) sg_band_recommend(sg_bands[i]);
+    int8_t sgt = 0;
+    uint32_t tcoolthrs = 0;
+    bool found = sg_tune_summary(sg_bands, sg_band_count, &sgt, &tcoolthrs);
+
+    portENTER_CRITICAL(&sg_mux);
+    sg_status.running = false;
+    sg_status.done = true;
+    sg_status.recommended = found;
+    sg_status.sgt_recommended = sgt;
+    sg_status.tcoolthrs_recommended = tcoolthrs;
+    sg_status.duration_ms = millis() - sg_start_ms;
+    SgTuneStatus status = sg_status;
+    portEXIT_CRITICAL(&sg_mux);
+
+    sg_save_results(status);
+
+    if (!found) {
+        add_log_to_web("⚠️ SGT sweep: no band with a safe SGT - widen the range or raise the speeds");
+        return;
+    }
+    add_log_to_web("📈 SGT sweep: SGT=" + String(sgt) + ", TCOOLTHRS=" + String(tcoolthrs) +
+                   " (" + String(status.sample_rate_hz) + " samples/s)");
+
+    // Порог и TCOOLTHRS в настройках - измеренные на этом моторе: StallGuard включается с
+    // найденной скорости и после применения настроек, и после хоминга
+    if (currentSettings.stallguard_threshold != sgt || currentSettings.stallguard_tcoolthrs != tcoolthrs) {
+        MotorSettings updated = currentSettings;
+        updated.stallguard_threshold = sgt;
+        updated.stallguard_tcoolthrs = tcoolthrs;
+        publish_settings(updated);
+        saveMotorSettings(updated);
+    }
+    setup_stallguard(sgt, tcoolthrs);
+}
+
+// Непрерывная пачка чтений DRV_STATUS - частота ограничена только SPI
+static void sg_capture() {
+    const uint8_t band = sg_band_index;
+    const int8_t sgt = sg_sweep_value(sg_active, sg_point_index);
+
+    SgCsvRow row;
+    row.band = band;
+    row.speed = sg_active.speeds[band];
+    row.tstep = motor.readRegisterDirect(TMC5160_Reg::TSTEP) & 0xFFFFF;
+    row.sgt = sgt;
+
+    uint32_t start_us = micros();
+    for (uint16_t i = 0; i < sg_active.samples; i++) {
+        TMC5160_Reg::DRV_STATUS_Register drv = {0};
+        drv.value = motor.readRegisterDirect(TMC5160_Reg::DRV_STATUS);
+        row.sg_result = drv.sg_result;
+        row.cs_actual = drv.cs_actual;
+        row.stst = drv.stst;
+        sg_accumulate(sg_bands, &sg_band_count, row);
+        sg_ring[sg_ring_total++ % SG_RING_SIZE] = sg_sample_pack(row.sg_result, row.cs_actual, row.stst, sgt, band);
+    }
+    uint32_t elapsed_us = micros() - start_us;
+
+    portENTER_CRITICAL(&sg_mux);
+    sg_status.samples_total += sg_active.samples;
+    if (elapsed_us) sg_status.sample_rate_hz = (uint32_t)((uint64_t)sg_active.samples * 1000000 / elapsed_us);
+    portEXIT_CRITICAL(&sg_mux);
+}
+
+void sg_tune_start() {
+    if (is_sg_tune_active()) return;
+
+    if (!tmc_initialized || !motor_enabled) {
+        add_log_to_web("❌ SGT sweep: motor is not enabled");
+        return;
+    }
+    if (currentSettings.control_mode != MODE_MOTION_CONTROLLER) {
+        add_log_to_web("❌ SGT sweep requires SPI motion controller mode");
+        return;
+    }
+
+    sg_active = sg_request;
+    sg_band_count = sg_active.bands;
+    for (uint8_t i = 0; i < sg_band_count; i++) sg_band_reset(sg_bands[i], sg_active.speeds[i]);
+    sg_ring_total = 0;
+    sg_band_index = 0;
+    sg_point_index = 0;
+    sg_start_ms = millis();
+
+    portENTER_CRITICAL(&sg_mux);
+    sg_status = {};
+    sg_status.running = true;
+    sg_status.preset_id = sg_active.preset_id;
+    portEXIT_CRITICAL(&sg_mux);
+
+    // StallGuard (SG_RESULT) на всех скоростях свипа
+    sg_saved_tcoolthrs = motor.readRegister(TMC5160_Reg::TCOOLTHRS);
+    motor.writeRegister(TMC5160_Reg::TCOOLTHRS, 0xFFFFF);
+
+    add_log_to_web("📈 SGT sweep started: " + String(sg_active.bands) + " bands x " +
+                   String(sg_sweep_count(sg_active)) + " SGT values");
+    sg_begin_band();
+}
+
+void sg_tune_abort(const char *reason) {
+    if (!is_sg_tune_active()) return;
+    sg_phase = SG_PHASE_IDLE;
+    sg_restore_driver();
+
+    portENTER_CRITICAL(&sg_mux);
+    sg_status.running = false;
+    sg_status.error = reason;
+    sg_status.duration_ms = millis() - sg_start_ms;
+    portEXIT_CRITICAL(&sg_mux);
+    add_log_to_web("❌ SGT sweep aborted: " + String(reason));
+}
+
+void sg_tune_tick() {
+    if (!is_sg_tune_active()) return;
+
+    if (!tmc_initialized || !motor_enabled) {
+        sg_tune_abort("motor disabled");
+        return;
+    }
+
+    uint32_t now = millis();
+    switch (sg_phase) {
+        case SG_PHASE_SPIN_UP: {
+            TMC5160_Reg::RAMP_STAT_Register ramp = {0};
+            ramp.value = motor.readRegisterDirect(TMC5160_Reg::RAMP_STAT);
+            if (ramp.velocity_reached) {
+                sg_phase = SG_PHASE_SETTLE;
+                sg_phase_start_ms = now;
+            } else if (now - sg_phase_start_ms >= SG_TUNE_TIMEOUT_MS) {
+                sg_tune_abort("band speed not reached");
+            }
+            break;
+        }
+
+        case SG_PHASE_SETTLE:
+            if (now - sg_phase_start_ms < SG_TUNE_SETTLE_MS) break;
+            sg_capture();
+
+            if (++sg_point_index < sg_sweep_count(sg_active)) {
+                sg_write_sgt(sg_sweep_value(sg_active, sg_point_index));
+                sg_phase_start_ms = millis();
+                sg_set_status_point();
+            } else if (++sg_band_index < sg_active.bands) {
+                sg_point_index = 0;
+                sg_begin_band();
+            } else {
+                sg_finish();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
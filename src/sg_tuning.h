@@ -0,0 +1,66 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "sg_stats.h"
+
+// ============================================================================
+// ХАРАКТЕРИЗАЦИЯ STALLGUARD: СВИП SGT ПО ПОЛОСАМ СКОРОСТИ
+// ============================================================================
+// Задача движения вращает мотор (режим скорости) на каждой скорости полосы и для каждого
+// SGT свипа снимает DRV_STATUS (SG_RESULT, CS_ACTUAL) подряд - так часто, как позволяет
+// SPI - в кольцо RAM. Статистика и рекомендации - sg_stats.h. Итог сохраняется на LittleFS
+// рядом с пресетом (/sg_tune_<preset>.json) и подставляется при применении пресета.
+
+#define SG_RING_SIZE 4096               // Последних выборок для выгрузки CSV (16 KB)
+#define SG_TUNE_DEFAULT_SAMPLES 512     // Выборок на точку (SGT) - непрерывная пачка
+#define SG_TUNE_MAX_SAMPLES 2048
+#define SG_TUNE_SETTLE_MS 100           // После выхода на скорость / смены SGT
+#define SG_TUNE_TIMEOUT_MS 10000        // Выход на скорость полосы
+#define SG_TUNE_CUSTOM_PRESET -1        // Результат не для пресета
+
+struct SgTuneRequest {
+    int8_t preset_id;                   // Индекс NEMA_PRESETS или SG_TUNE_CUSTOM_PRESET
+    uint8_t bands;
+    uint32_t speeds[SG_MAX_BANDS];      // Шаги/с
+    int8_t sgt_min;
+    int8_t sgt_max;
+    uint8_t sgt_step;
+    uint16_t samples;
+};
+
+struct SgTuneStatus {
+    bool running;
+    bool done;
+    const char *error;
+    int8_t preset_id;
+    uint8_t band;                       // Текущая полоса / точка
+    int8_t sgt;
+    uint32_t samples_total;
+    uint32_t sample_rate_hz;            // Фактическая частота опроса DRV_STATUS
+    bool recommended;                   // Итог найден (есть пригодные полосы)
+    int8_t sgt_recommended;
+    uint32_t tcoolthrs_recommended;
+    uint32_t duration_ms;
+};
+
+// Параметры (из AsyncTCP). false - идёт измерение или запрос некорректен
+bool sg_tune_configure(const SgTuneRequest &request, const char **error);
+
+// Задача движения
+void sg_tune_start();
+void sg_tune_abort(const char *reason);
+void sg_tune_tick();
+
+bool is_sg_tune_active();
+SgTuneStatus get_sg_tune_status();
+// Результаты полос последнего измерения (только когда не идёт). Возвращает число полос
+uint8_t get_sg_tune_bands(const SgBandResult **bands);
+// Выборки из кольца от старых к новым (только когда не идёт)
+uint32_t sg_ring_count();
+uint32_t sg_ring_get(uint32_t index);
+// Полосы и точки свипа последнего измерения в obj["bands"] (ответ API и файл пресета)
+void sg_tune_results_json(JsonObject obj);
+
+// Сохранённый итог для пресета: false - пресет не измерялся
+bool sg_tune_load_preset(int preset_id, int8_t *sgt, uint32_t *tcoolthrs);
+String sg_tune_preset_path(int preset_id);
@@ -2,10 +2,13 @@
 #include "pins.h"
 #include "hall_sensors.h"
 #include "tmc.h"
+#include "log_ring.h"
+#include "serial_log.h"
 #include <Arduino.h>
 
-// Объявление функции для веб-логов (определена в web_server.cpp)
+// Объявление функций для веб-логов (определены в web_server.cpp)
 extern void add_log_to_web(String message);
+extern void add_log_event(LogMsgId id, int32_t a0 = 0, int32_t a1 = 0, int32_t a2 = 0, int32_t a3 = 0);
 
 // Текущее состояние соленоида
 String solenoid_current_state = "unknown";
@@ -327,6 +330,12 @@ bool is_solenoid_testing() {
 }
 
 // Функция для вызова в loop() - обрабатывает автоматический тест
+// Позиция текущего переключения для записей лога: 0 - A, 1 - B
+static int32_t solenoid_test_position_code() {
+    if (solenoid_test_direction == 2) return solenoid_test_current_state ? 1 : 0;
+    return solenoid_test_direction == 0 ? 0 : 1;
+}
+
 void solenoid_test_loop() {
     if (!solenoid_test_running) return;
     
@@ -355,13 +364,10 @@ void solenoid_test_loop() {
     extern bool motor_enabled;
     extern bool tmc_initialized;
     if (tmc_initialized && motor_enabled) {
-        extern TMC5160_SPI *motor_ptr;
-        if (motor_ptr) {
-            int32_t vactual = (int32_t)(*motor_ptr).readRegister(TMC5160_Reg::VACTUAL);
-            if (abs(vactual) > 10) {
-                // Мотор движется - пропускаем этот цикл
-                return;
-            }
+        const MotionSnapshot &snap = get_motion_snapshot(motor.getShadowMaxAge());
+        if (abs(snap.vactual) > 10) {
+            // Мотор движется - пропускаем этот цикл
+            return;
         }
     }
     
@@ -372,7 +378,7 @@ void solenoid_test_loop() {
             // Определяем направление для текущего переключения
             uint8_t current_direction;
             uint8_t expected_sensor;
-            String pos_name;
+            const char *pos_name;
             
             if (solenoid_test_direction == 2) {
                 // Оба по очереди: A → датчик 1, B → датчик 2
@@ -399,9 +405,9 @@ void solenoid_test_loop() {
             solenoid_test_stabilization_start = 0;
             
             // Формат вариант 2 без "Переключение в"
-            String switch_msg = "[SWITCH] " + pos_name + " | Попытка " + String(solenoid_test_attempt + 1) + "/" + String(solenoid_test_max_attempts);
-            add_log("🔄 " + switch_msg);
-            add_log_to_web(switch_msg);
+            LOG_INFOF("🔄 [SWITCH] %s | Попытка %d/%d", pos_name, solenoid_test_attempt + 1, solenoid_test_max_attempts);
+            // В веб-лог - записью с аргументами, текст соберётся при чтении
+            add_log_event(LOG_MSG_SOLENOID_SWITCH, current_direction, solenoid_test_attempt + 1, solenoid_test_max_attempts);
             solenoid_test_total_switches++; // Увеличиваем счетчик переключений
         }
     } else if (solenoid_test_state == 1) {
@@ -435,15 +441,13 @@ void solenoid_test_loop() {
         if (sensor_state) {
             // Датчик сработал!
             unsigned long sensor_time = millis() - solenoid_test_sensor_check_start;
-            String pos_name = (solenoid_test_direction == 2) ? 
+            const char *pos_name = (solenoid_test_direction == 2) ?
                 (solenoid_test_current_state ? "B (-90°)" : "A (+90°)") :
                 (solenoid_test_direction == 0 ? "A (+90°)" : "B (-90°)");
-            String sensor_name = "H" + String(expected_sensor);
             
             // Формат вариант 2
-            String success_msg = "[OK] " + pos_name + " → " + sensor_name + " сработал за " + String(sensor_time) + "мс";
-            add_log("✅ " + success_msg);
-            add_log_to_web(success_msg);
+            LOG_INFOF("✅ [OK] %s → H%d сработал за %luмс", pos_name, expected_sensor, sensor_time);
+            add_log_event(LOG_MSG_SOLENOID_OK, solenoid_test_position_code(), expected_sensor, sensor_time);
             
             // Собираем статистику
             solenoid_test_successful_switches++;
@@ -519,15 +523,15 @@ void solenoid_test_loop() {
             if ((millis() - solenoid_test_sensor_check_start) >= 500) {
                 // Таймаут - датчик не сработал
                 solenoid_test_attempt++;
-                String pos_name = (solenoid_test_direction == 2) ? 
+                const char *pos_name = (solenoid_test_direction == 2) ?
                     (solenoid_test_current_state ? "B (-90°)" : "A (+90°)") :
                     (solenoid_test_direction == 0 ? "A (+90°)" : "B (-90°)");
-                String sensor_name = "H" + String(expected_sensor);
                 
                 // Формат вариант 2
-                String fail_msg = "[ERROR] " + pos_name + " → " + sensor_name + " НЕ сработал | Попытка " + String(solenoid_test_attempt) + "/" + String(solenoid_test_max_attempts);
-                add_log("❌ " + fail_msg);
-                add_log_to_web(fail_msg);
+                LOG_ERRORF("❌ [ERROR] %s → H%d НЕ сработал | Попытка %d/%d", pos_name, expected_sensor,
+                           solenoid_test_attempt, solenoid_test_max_attempts);
+                add_log_event(LOG_MSG_SOLENOID_FAIL, solenoid_test_position_code(), expected_sensor,
+                              solenoid_test_attempt, solenoid_test_max_attempts);
                 
                 if (solenoid_test_attempt >= solenoid_test_max_attempts) {
                     // Все попытки исчерпаны - увеличиваем счетчик последовательных неудач для текущей позиции
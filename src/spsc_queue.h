@@ -0,0 +1,51 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// ============================================================================
+// ОГРАНИЧЕННАЯ LOCK-FREE ОЧЕРЕДЬ: ОДИН ПРОИЗВОДИТЕЛЬ / ОДИН ПОТРЕБИТЕЛЬ
+// ============================================================================
+// Без Arduino/FreeRTOS зависимостей - собирается и на хосте (std::thread).
+// push() вызывает только одна задача, pop() - только одна (другая) задача.
+// N - степень двойки; индексы свободно переполняются (uint16_t), поэтому N <= 32768.
+
+template <typename T, uint16_t N>
+class SpscQueue {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+    static_assert(N <= 32768, "SpscQueue size must fit uint16_t index arithmetic");
+
+public:
+    // Производитель: false если очередь заполнена
+    bool push(const T &item) {
+        uint16_t head = _head.load(std::memory_order_relaxed);
+        uint16_t tail = _tail.load(std::memory_order_acquire);
+        if ((uint16_t)(head - tail) >= N) return false;
+
+        _buf[head & (N - 1)] = item;
+        _head.store((uint16_t)(head + 1), std::memory_order_release);
+        return true;
+    }
+
+    // Потребитель: false если очередь пуста
+    bool pop(T &item) {
+        uint16_t tail = _tail.load(std::memory_order_relaxed);
+        uint16_t head = _head.load(std::memory_order_acquire);
+        if (head == tail) return false;
+
+        item = _buf[tail & (N - 1)];
+        _tail.store((uint16_t)(tail + 1), std::memory_order_release);
+        return true;
+    }
+
+    // Текущая глубина (приблизительная, если читать из третьей задачи)
+    uint16_t size() const {
+        return (uint16_t)(_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire));
+    }
+
+    static constexpr uint16_t capacity() { return N; }
+
+private:
+    T _buf[N];
+    std::atomic<uint16_t> _head{0};
+    std::atomic<uint16_t> _tail{0};
+};
@@ -0,0 +1,258 @@
+#pragma once
+#include <stdint.h>
+#include <math.h>
+#include "step_stream.h"
+
+// ============================================================================
+// ПЛАНИРОВЩИК ИНТЕРВАЛОВ ШАГОВ: ТРАПЕЦИЯ / S-КРИВАЯ (ЦЕЛОЧИСЛЕННЫЙ, O(1) НА ШАГ)
+// ============================================================================
+// Рекуррентная формула Austin ("Generate stepper-motor speed profiles in real time"):
+//   разгон:     c[n] = c[n-1] - 2*c[n-1] / (4n + 1)
+//   торможение: та же рампа в обратную сторону, c = c + 2c / (4n - 1)
+// Ограничение рывка - ускорение растёт по шагам: вес шага w[n] = min(n, J),
+// тогда c[n] = c[n-1] - 2*c[n-1]*w[n] / (4*S[n] + w[n]), S[n] = сумма весов
+// (при J = 0 все веса 1 и формула совпадает с Austin).
+// Интервал хранится в Q24.8 тиках RMT (STEP_RMT_TICK_HZ). Корень - только при планировании.
+// Остаток деления переносится в следующий шаг - иначе на длинных рампах приращение
+// округляется в 0 и разгон "застревает" ниже заданной скорости.
+
+// constexpr с циклами требует C++14; на gnu++11 функции остаются обычными inline
+#if __cplusplus >= 201402L
+#define STEP_PLANNER_CONSTEXPR constexpr
+#else
+#define STEP_PLANNER_CONSTEXPR inline
+#endif
+
+#define STEP_PLANNER_Q 8                    // Дробных бит интервала
+#define STEP_PLANNER_C0_CORR_Q8 173         // 0.676 * 256 - поправка первого интервала (Austin)
+#define STEP_PLANNER_MAX_JERK_STEPS 10000
+
+enum StepPlannerPhase : uint8_t {
+    STEP_PHASE_ACCEL = 0,
+    STEP_PHASE_CRUISE,
+    STEP_PHASE_DECEL,
+    STEP_PHASE_DONE
+};
+
+struct StepPlanner {
+    uint32_t total_steps;
+    uint32_t index;           // Выдано шагов
+    uint32_t accel_steps;
+    uint32_t decel_steps;
+    uint32_t c_q8;            // Интервал следующего шага
+    uint32_t cmin_q8;         // Интервал крейсерской скорости
+    uint32_t jerk_steps;      // 0 - трапеция
+    uint32_t n;               // Позиция в рампе (разгон - растёт, торможение - убывает)
+    uint64_t sum_w;           // S[n]
+    uint32_t rest;            // Остаток деления (переносится в следующий шаг, как у Eiling)
+    uint8_t phase;
+};
+
+STEP_PLANNER_CONSTEXPR uint64_t step_isqrt64(uint64_t x) {
+    uint64_t result = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > x) bit >>= 2;
+    while (bit != 0) {
+        if (x >= result + bit) {
+            x -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+// Вес шага n рампы (n >= 1)
+STEP_PLANNER_CONSTEXPR uint32_t step_planner_weight(uint32_t n, uint32_t jerk_steps) {
+    return jerk_steps == 0 ? 1 : (n < jerk_steps ? n : jerk_steps);
+}
+
+// Сумма весов первых n шагов рампы
+STEP_PLANNER_CONSTEXPR uint64_t step_planner_weight_sum(uint32_t n, uint32_t jerk_steps) {
+    if (jerk_steps == 0) return n;
+    if (n <= jerk_steps) return (uint64_t)n * (n + 1) / 2;
+    return (uint64_t)jerk_steps * (jerk_steps + 1) / 2 + (uint64_t)(n - jerk_steps) * jerk_steps;
+}
+
+// Шагов рампы до скорости v (шаги/с) при ускорении a (шаги/с²):
+// v² = 2 * a * S[n] / W, W = max(J, 1) - полный вес
+STEP_PLANNER_CONSTEXPR uint32_t step_planner_ramp_steps(uint32_t v, uint32_t a, uint32_t jerk_steps) {
+    uint64_t w_full = jerk_steps == 0 ? 1 : jerk_steps;
+    uint64_t target = ((uint64_t)v * v * w_full + 2ULL * a - 1) / (2ULL * a);   // S[n] >= target
+    if (jerk_steps == 0) return (uint32_t)target;
+
+    uint64_t s_jerk = step_planner_weight_sum(jerk_steps, jerk_steps);
+    if (target <= s_jerk) {
+        // n(n+1)/2 >= target
+        uint64_t n = step_isqrt64(2 * target);
+        while (n * (n + 1) / 2 < target) n++;
+        return (uint32_t)n;
+    }
+    return (uint32_t)(jerk_steps + (target - s_jerk + jerk_steps - 1) / jerk_steps);
+}
+
+// Инициализация: total шагов, max_hz, accel/decel (шаги/с²), jerk_steps (0 - трапеция)
+STEP_PLANNER_CONSTEXPR void step_planner_init(StepPlanner &p, uint32_t total_steps, uint32_t max_hz,
+                                              uint32_t accel, uint32_t decel, uint32_t jerk_steps) {
+    if (max_hz == 0) max_hz = 1;
+    if (max_hz > STEP_RMT_TICK_HZ / STEP_MIN_INTERVAL_TICKS) max_hz = STEP_RMT_TICK_HZ / STEP_MIN_INTERVAL_TICKS;
+    if (accel == 0) accel = 1;
+    if (decel == 0) decel = 1;
+    if (jerk_steps > STEP_PLANNER_MAX_JERK_STEPS) jerk_steps = STEP_PLANNER_MAX_JERK_STEPS;
+
+    p.total_steps = total_steps;
+    p.index = 0;
+    p.jerk_steps = jerk_steps;
+    p.n = 0;       // Первый пересчёт (c0 -> c1) идёт с n = 1
+    p.sum_w = 0;
+    p.rest = 0;
+    p.cmin_q8 = (uint32_t)(((uint64_t)STEP_RMT_TICK_HZ << STEP_PLANNER_Q) / max_hz);
+
+    uint32_t accel_need = step_planner_ramp_steps(max_hz, accel, jerk_steps);
+    uint32_t decel_need = step_planner_ramp_steps(max_hz, decel, jerk_steps);
+    if ((uint64_t)accel_need + decel_need <= total_steps) {
+        p.accel_steps = accel_need;
+        p.decel_steps = decel_need;
+    } else {
+        // Треугольник: делим путь обратно пропорционально ускорениям
+        p.accel_steps = (uint32_t)((uint64_t)total_steps * decel / ((uint64_t)accel + decel));
+        p.decel_steps = total_steps - p.accel_steps;
+    }
+
+    // Первый интервал: c0 = 0.676 * F * sqrt(2 / a1), a1 = a * w[1] / W
+    uint64_t w_full = jerk_steps == 0 ? 1 : jerk_steps;
+    uint64_t f = STEP_RMT_TICK_HZ;
+    uint64_t c0_ticks = step_isqrt64(2 * w_full * f * f / accel);
+    uint64_t c0_q8 = c0_ticks * STEP_PLANNER_C0_CORR_Q8;
+    uint64_t cmax_q8 = (uint64_t)STEP_MAX_INTERVAL_TICKS << STEP_PLANNER_Q;
+    if (c0_q8 > cmax_q8) c0_q8 = cmax_q8;
+    if (c0_q8 < p.cmin_q8) c0_q8 = p.cmin_q8;
+    p.c_q8 = (uint32_t)c0_q8;
+
+    if (total_steps == 0) p.phase = STEP_PHASE_DONE;
+    else if (p.accel_steps > 0) p.phase = STEP_PHASE_ACCEL;
+    else if (total_steps > p.decel_steps) p.phase = STEP_PHASE_CRUISE;
+    else p.phase = STEP_PHASE_DECEL;
+
+    // Совсем без разгона - стартуем с крейсерской скорости
+    if (p.accel_steps == 0 && p.decel_steps == 0) p.c_q8 = p.cmin_q8;
+    if (p.phase == STEP_PHASE_DECEL) {
+        p.n = p.decel_steps;
+        p.sum_w = step_planner_weight_sum(p.n, jerk_steps);
+    }
+}
+
+// Интервал следующего шага в тиках RMT; 0 - движение закончено. O(1): одно деление
+STEP_PLANNER_CONSTEXPR uint32_t step_planner_next(StepPlanner &p) {
+    if (p.phase == STEP_PHASE_DONE || p.index >= p.total_steps) {
+        p.phase = STEP_PHASE_DONE;
+        return 0;
+    }
+
+    uint32_t interval = (p.c_q8 + (1u << (STEP_PLANNER_Q - 1))) >> STEP_PLANNER_Q;
+    p.index++;
+    uint32_t decel_start = p.total_steps - p.decel_steps;
+
+    if (p.index >= decel_start) {
+        // Торможение: рампа торможения проходится от n = decel_steps до 1
+        if (p.phase != STEP_PHASE_DECEL) {
+            p.phase = STEP_PHASE_DECEL;
+            p.n = p.decel_steps;
+            p.sum_w = step_planner_weight_sum(p.n, p.jerk_steps);
+            p.rest = 0;
+        }
+        if (p.n >= 1 && p.index < p.total_steps) {
+            uint32_t w = step_planner_weight(p.n, p.jerk_steps);
+            if (p.jerk_steps == 0) {
+                uint32_t num = 2 * p.c_q8 + p.rest;
+                uint32_t den = 4 * p.n - 1;
+                p.c_q8 += num / den;
+                p.rest = num % den;
+            } else {
+                uint64_t num = 2ULL * p.c_q8 * w + p.rest;
+                uint64_t den = 4 * p.sum_w - w;
+                p.c_q8 += (uint32_t)(num / den);
+                p.rest = (uint32_t)(num % den);
+            }
+            p.sum_w -= w;
+            p.n--;
+        }
+    } else if (p.phase == STEP_PHASE_ACCEL) {
+        if (p.index >= p.accel_steps) {
+            p.phase = STEP_PHASE_CRUISE;
+            p.c_q8 = p.cmin_q8;
+        } else {
+            p.n++;
+            uint32_t w = step_planner_weight(p.n, p.jerk_steps);
+            p.sum_w += w;
+            if (p.jerk_steps == 0) {
+                uint32_t num = 2 * p.c_q8 + p.rest;
+                uint32_t den = 4 * p.n + 1;
+                p.c_q8 -= num / den;
+                p.rest = num % den;
+            } else {
+                uint64_t num = 2ULL * p.c_q8 * w + p.rest;
+                uint64_t den = 4 * p.sum_w + w;
+                p.c_q8 -= (uint32_t)(num / den);
+                p.rest = (uint32_t)(num % den);
+            }
+            if (p.c_q8 < p.cmin_q8) p.c_q8 = p.cmin_q8;
+        }
+    }
+    return interval;
+}
+
+// Адаптер для StepStream (step_stream.h)
+inline uint32_t step_planner_source(void *ctx) {
+    return step_planner_next(*(StepPlanner *)ctx);
+}
+
+// ===== ИДЕАЛЬНАЯ ТРАПЕЦИЯ (эталон для оценки ошибки профиля) =====
+
+// Время идеального трапецеидального/треугольного движения, мкс
+inline uint32_t step_planner_ideal_time_us(uint32_t total_steps, uint32_t max_hz, uint32_t accel, uint32_t decel) {
+    if (total_steps == 0 || max_hz == 0 || accel == 0 || decel == 0) return 0;
+    float v = (float)max_hz;
+    float s_acc = v * v / (2.0f * accel);
+    float s_dec = v * v / (2.0f * decel);
+    float t;
+    if (s_acc + s_dec <= total_steps) {
+        t = v / accel + v / decel + (total_steps - s_acc - s_dec) / v;
+    } else {
+        // Пиковая скорость треугольника: v² (1/2a + 1/2d) = s
+        float vp = sqrtf(2.0f * total_steps * accel * decel / (float)(accel + decel));
+        t = vp / accel + vp / decel;
+    }
+    return (uint32_t)(t * 1e6f);
+}
+
+// Суммарное время спланированного профиля, мкс (O(total) - для диагностики)
+inline uint32_t step_planner_total_time_us(StepPlanner p) {
+    uint64_t ticks = 0;
+    for (uint32_t t = step_planner_next(p); t != 0; t = step_planner_next(p)) ticks += t;
+    return (uint32_t)(ticks * 1000000ULL / STEP_RMT_TICK_HZ);
+}
+
+#if __cplusplus >= 201402L
+// Проверки при компиляции: первый интервал, крейсер и число шагов
+constexpr uint32_t step_planner_nth_interval(uint32_t total, uint32_t hz, uint32_t a, uint32_t d,
+                                             uint32_t jerk, uint32_t nth) {
+    StepPlanner p = {};
+    step_planner_init(p, total, hz, a, d, jerk);
+    uint32_t t = 0;
+    for (uint32_t i = 0; i <= nth; i++) t = step_planner_next(p);
+    return t;
+}
+constexpr uint32_t step_planner_count_steps(uint32_t total, uint32_t hz, uint32_t a, uint32_t d, uint32_t jerk) {
+    StepPlanner p = {};
+    step_planner_init(p, total, hz, a, d, jerk);
+    uint32_t count = 0;
+    while (step_planner_next(p) != 0) count++;
+    return count;
+}
+static_assert(step_planner_nth_interval(2000, 1000, 1000, 1000, 0, 1000) == 10000, "cruise interval must be F / vmax");
+static_assert(step_planner_count_steps(257, 5000, 2000, 3000, 0) == 257, "planner must emit exactly total steps");
+static_assert(step_planner_count_steps(300, 5000, 2000, 3000, 20) == 300, "S-curve must emit exactly total steps");
+#endif
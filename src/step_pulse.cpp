@@ -0,0 +1,114 @@
+#include "step_pulse.h"
+#include "pins.h"
+#include "tmc.h"
+#include <driver/rmt.h>
+
+static TaskHandle_t step_pulse_task_handle = nullptr;
+static volatile bool step_pulse_active = false;
+static volatile bool step_pulse_abort_requested = false;
+
+// Профиль текущего движения (пишет step_pulse_start, читает прерывание RMT - только пока не active)
+static StepPlanner step_planner;
+static StepStream step_stream;
+
+// Для rmt_write_sample: источник - поток step_stream, сами байты не читаются
+static const uint8_t step_sample = 0;
+static volatile uint32_t step_refills = 0;
+
+static StepPulseStats step_stats = {};
+
+// Транслятор RMT: драйвер вызывает его из прерывания порога, когда освободилась половина
+// памяти канала, и сразу дописывает результат - между блоками нет паузы на пробуждение задачи.
+// Неполный блок драйвер считает концом передачи, поэтому step_stream_fill отдаёт ровно wanted_num.
+// Единственный байт источника считаем прочитанным, когда поток кончился
+static void step_rmt_translate(const void *src, rmt_item32_t *dest, size_t src_size, size_t wanted_num,
+                               size_t *translated_size, size_t *item_num) {
+    uint16_t n = step_pulse_abort_requested ? 0 :
+                 step_stream_fill(step_stream, (uint32_t *)dest, (uint16_t)wanted_num);
+    step_refills++;
+    *item_num = n;
+    *translated_size = n < wanted_num ? src_size : 0;
+}
+
+static void step_pulse_task(void *arg) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        uint32_t start_ms = millis();
+        step_refills = 0;
+
+        // Первый блок кодируется здесь, остальные - в прерывании (step_rmt_translate)
+        rmt_write_sample(STEP_RMT_CHANNEL, &step_sample, 1, false);
+        rmt_wait_tx_done(STEP_RMT_CHANNEL, portMAX_DELAY);
+
+        if (step_pulse_abort_requested) step_stats.aborted++;
+
+        step_stats.last_steps = step_stream.steps_encoded;
+        step_stats.last_chunks = step_refills;
+        step_stats.last_duration_ms = millis() - start_ms;
+        step_pulse_abort_requested = false;
+        step_pulse_active = false;
+    }
+}
+
+bool init_step_pulse_engine() {
+    if (step_pulse_task_handle) return true;
+
+    rmt_config_t config = {};
+    config.rmt_mode = RMT_MODE_TX;
+    config.channel = STEP_RMT_CHANNEL;
+    config.gpio_num = STEP_PIN;
+    config.clk_div = STEP_RMT_CLK_DIV;
+    config.mem_block_num = STEP_RMT_MEM_BLOCKS;
+    config.tx_config.carrier_en = false;
+    config.tx_config.loop_en = false;
+    config.tx_config.idle_output_en = true;
+    config.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;
+
+    esp_err_t err = rmt_config(&config);
+    if (err == ESP_OK) err = rmt_driver_install(STEP_RMT_CHANNEL, 0, 0);
+    if (err == ESP_OK) err = rmt_translator_init(STEP_RMT_CHANNEL, step_rmt_translate);
+    if (err != ESP_OK) {
+        add_log("❌ RMT init failed for STEP pin: " + String(esp_err_to_name(err)));
+        return false;
+    }
+
+    xTaskCreatePinnedToCore(step_pulse_task, "step_pulse", STEP_PULSE_TASK_STACK, nullptr,
+                            STEP_PULSE_TASK_PRIORITY, &step_pulse_task_handle, STEP_PULSE_TASK_CORE);
+    add_log("✅ STEP/DIR pulse engine ready (RMT, up to " + String(STEP_PULSE_MAX_HZ) + " Hz)");
+    return true;
+}
+
+bool step_pulse_start(int32_t steps, uint32_t max_hz, uint32_t accel, uint32_t decel, uint32_t jerk_steps) {
+    if (!step_pulse_task_handle || step_pulse_active || steps == 0) return false;
+
+    if (max_hz > STEP_PULSE_MAX_HZ) max_hz = STEP_PULSE_MAX_HZ;
+    uint32_t abs_steps = steps < 0 ? (uint32_t)(-(int64_t)steps) : (uint32_t)steps;
+
+    // DIR выставляем заранее: setup time TMC5160 - 20 нс, до первого фронта STEP - микросекунды
+    digitalWrite(DIR_PIN, steps >= 0 ? HIGH : LOW);
+
+    step_planner_init(step_planner, abs_steps, max_hz, accel, decel, jerk_steps);
+    step_stream_begin(step_stream, step_planner_source, &step_planner);
+
+    step_stats.moves++;
+    step_stats.last_expected_ms = step_planner_ideal_time_us(abs_steps, max_hz, accel, decel) / 1000;
+    step_pulse_abort_requested = false;
+    step_pulse_active = true;
+    xTaskNotifyGive(step_pulse_task_handle);
+    return true;
+}
+
+bool step_pulse_busy() {
+    return step_pulse_active;
+}
+
+void step_pulse_abort() {
+    if (step_pulse_active) step_pulse_abort_requested = true;
+}
+
+StepPulseStats get_step_pulse_stats() {
+    StepPulseStats stats = step_stats;
+    stats.busy = step_pulse_active;
+    return stats;
+}
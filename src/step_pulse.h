@@ -0,0 +1,43 @@
+#pragma once
+#include <Arduino.h>
+#include "step_stream.h"
+#include "step_planner.h"
+
+// ============================================================================
+// АППАРАТНАЯ ГЕНЕРАЦИЯ STEP/DIR (RMT) - БЕЗ БЛОКИРОВКИ CPU
+// ============================================================================
+// Импульсы формирует периферия RMT. Профиль интервалов кодируется блоками (step_stream.h)
+// прямо в прерывании порога RMT: пока передаётся одна половина памяти канала, заполняется
+// другая. Задача step_pulse только запускает передачу и ждёт её окончания.
+
+#define STEP_RMT_CHANNEL RMT_CHANNEL_0
+#define STEP_RMT_CLK_DIV 8                  // 80 МГц / 8 = STEP_RMT_TICK_HZ
+#define STEP_RMT_MEM_BLOCKS 4               // 4 x 64 элемента; подкачка по 128 - запас >= 640 мкс на 200 кГц
+#define STEP_PULSE_MAX_HZ 200000            // Предел частоты шагов
+#define STEP_PULSE_DEFAULT_JERK_STEPS 0     // 0 - трапеция, >0 - S-кривая (см. step_planner.h)
+#define STEP_PULSE_TASK_CORE 1
+#define STEP_PULSE_TASK_PRIORITY 4          // Выше задачи движения - статистика и busy сразу по окончании
+#define STEP_PULSE_TASK_STACK 3072
+
+struct StepPulseStats {
+    bool busy;
+    uint32_t moves;             // Запущено движений
+    uint32_t aborted;
+    uint32_t last_steps;        // Шагов закодировано в последнем движении
+    uint32_t last_chunks;       // Заполнений памяти RMT (первое + подкачки в прерывании)
+    uint32_t last_expected_ms;  // Длительность идеальной трапеции с теми же параметрами
+    uint32_t last_duration_ms;  // Фактическая (от старта до окончания передачи)
+};
+
+// Установка канала RMT на STEP_PIN и запуск задачи подкачки
+bool init_step_pulse_engine();
+
+// Запустить движение (не блокирует): max_hz - шаги/с, accel/decel - шаги/с².
+// false - генератор занят или не инициализирован
+bool step_pulse_start(int32_t steps, uint32_t max_hz, uint32_t accel, uint32_t decel,
+                      uint32_t jerk_steps = STEP_PULSE_DEFAULT_JERK_STEPS);
+bool step_pulse_busy();
+// Прервать после текущего блока (для мгновенной остановки снимите EN)
+void step_pulse_abort();
+
+StepPulseStats get_step_pulse_stats();
@@ -0,0 +1,160 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================================
+// ПОТОК ИМПУЛЬСОВ STEP ДЛЯ RMT - ЧИСТАЯ ЛОГИКА (БЕЗ ЖЕЛЕЗА)
+// ============================================================================
+// Интервалы шагов (в тиках RMT) кодируются в 32-битные элементы RMT:
+//   биты 0..14 duration0, бит 15 level0, биты 16..30 duration1, бит 31 level1
+// (раскладка rmt_item32_t.val). Без Arduino/ESP-IDF зависимостей - тот же код
+// работает в step_pulse.cpp на чипе и в модели на хосте.
+
+#define STEP_RMT_TICK_HZ 10000000UL          // APB 80 МГц / 8 = 0.1 мкс на тик
+#define STEP_PULSE_HIGH_TICKS 20             // Ширина STEP = 2 мкс (TMC5160: мин. 100 нс)
+#define STEP_MIN_INTERVAL_TICKS (2 * STEP_PULSE_HIGH_TICKS)   // 250 кГц - предел кодирования
+#define STEP_MAX_INTERVAL_TICKS 1000000UL    // 100 мс (10 Гц) - медленнее не бывает
+#define STEP_RMT_MAX_DURATION 32767          // 15 бит на половину элемента
+
+// Максимум элементов на один шаг (самый длинный интервал): 1 + ceil(остаток / (2*MAX))
+#define STEP_MAX_ITEMS_PER_STEP (2 + (STEP_MAX_INTERVAL_TICKS / (2 * STEP_RMT_MAX_DURATION)))
+
+// Источник интервалов: интервал следующего шага в тиках RMT, 0 - шагов больше нет
+typedef uint32_t (*StepIntervalSource)(void *ctx);
+
+static inline uint32_t step_item(uint32_t d0, uint32_t l0, uint32_t d1, uint32_t l1) {
+    return (d0 & 0x7FFF) | (l0 << 15) | ((d1 & 0x7FFF) << 16) | (l1 << 31);
+}
+
+// Отрезать кусок низкого уровня <= MAX. Никогда не оставляет остаток 1 тик:
+// длительность 0 в элементе RMT - маркер конца передачи, её быть не должно.
+static inline uint32_t step_take_low(uint32_t *remaining) {
+    uint32_t take = *remaining > STEP_RMT_MAX_DURATION ? STEP_RMT_MAX_DURATION : *remaining;
+    if (*remaining - take == 1) take--;
+    *remaining -= take;
+    return take;
+}
+
+// Закодировать один шаг. Возвращает число элементов (<= STEP_MAX_ITEMS_PER_STEP)
+static inline uint8_t step_encode_interval(uint32_t interval_ticks, uint32_t *items) {
+    if (interval_ticks < STEP_MIN_INTERVAL_TICKS) interval_ticks = STEP_MIN_INTERVAL_TICKS;
+    if (interval_ticks > STEP_MAX_INTERVAL_TICKS) interval_ticks = STEP_MAX_INTERVAL_TICKS;
+
+    uint32_t low = interval_ticks - STEP_PULSE_HIGH_TICKS;
+    uint8_t n = 0;
+    items[n++] = step_item(STEP_PULSE_HIGH_TICKS, 1, step_take_low(&low), 0);
+
+    // Длинные паузы - продолжение низкого уровня (обе половины > 0)
+    while (low > 0) {
+        uint32_t d0 = step_take_low(&low);
+        uint32_t d1;
+        if (low == 0) {
+            // Весь остаток влез в первую половину - делим пополам (остаток >= 2)
+            d1 = d0 / 2;
+            d0 -= d1;
+        } else {
+            d1 = step_take_low(&low);
+        }
+        items[n++] = step_item(d0, 0, d1, 0);
+    }
+    return n;
+}
+
+// Поток: тянет интервалы из источника и заполняет блоки элементов для RMT.
+// Шаг, не влезший в блок целиком, остаётся в carry и уходит в начало следующего блока
+struct StepStream {
+    StepIntervalSource source;
+    void *ctx;
+    bool done;
+    uint32_t steps_encoded;
+    uint64_t ticks_encoded;
+    uint32_t carry[STEP_MAX_ITEMS_PER_STEP];
+    uint8_t carry_len;
+    uint8_t carry_pos;
+};
+
+static inline void step_stream_begin(StepStream &stream, StepIntervalSource source, void *ctx) {
+    stream.source = source;
+    stream.ctx = ctx;
+    stream.done = false;
+    stream.steps_encoded = 0;
+    stream.ticks_encoded = 0;
+    stream.carry_len = 0;
+    stream.carry_pos = 0;
+}
+
+// Заполнить блок ровно на capacity элементов (меньше - только в конце движения).
+// Возвращает число элементов, 0 - конец. Вызывается из прерывания порога RMT:
+// драйвер считает неполный блок концом передачи
+static inline uint16_t step_stream_fill(StepStream &stream, uint32_t *items, uint16_t capacity) {
+    uint16_t n = 0;
+    while (n < capacity) {
+        if (stream.carry_pos < stream.carry_len) {
+            items[n++] = stream.carry[stream.carry_pos++];
+            continue;
+        }
+        if (stream.done) break;
+
+        uint32_t interval = stream.source(stream.ctx);
+        if (interval == 0) {
+            stream.done = true;
+            break;
+        }
+        stream.carry_len = step_encode_interval(interval, stream.carry);
+        stream.carry_pos = 0;
+        stream.steps_encoded++;
+        stream.ticks_encoded += interval < STEP_MIN_INTERVAL_TICKS ? STEP_MIN_INTERVAL_TICKS :
+                                interval > STEP_MAX_INTERVAL_TICKS ? STEP_MAX_INTERVAL_TICKS : interval;
+    }
+    return n;
+}
+
+// ===== МОДЕЛЬ ВЫХОДА RMT (для проверки инвариантов на хосте) =====
+// Разбирает элементы так, как их выдал бы пин: считает импульсы (фронты 0→1),
+// длительности уровней и ищет запрещённые нулевые длительности.
+
+struct StepOutputModel {
+    uint32_t pulses;
+    uint64_t total_ticks;
+    uint32_t min_high_ticks;
+    uint32_t min_low_ticks;     // Минимальный низкий уровень между импульсами
+    uint32_t items;
+    uint32_t zero_durations;    // Должно быть 0
+    uint8_t level;
+    uint32_t run_ticks;         // Длительность текущего уровня
+};
+
+static inline void step_model_reset(StepOutputModel &m) {
+    m.pulses = 0;
+    m.total_ticks = 0;
+    m.min_high_ticks = UINT32_MAX;
+    m.min_low_ticks = UINT32_MAX;
+    m.items = 0;
+    m.zero_durations = 0;
+    m.level = 0;
+    m.run_ticks = 0;
+}
+
+static inline void step_model_half(StepOutputModel &m, uint32_t duration, uint8_t level) {
+    if (duration == 0) {
+        m.zero_durations++;
+        return;
+    }
+    if (level != m.level) {
+        // Закрываем предыдущий уровень
+        if (m.level == 1 && m.run_ticks < m.min_high_ticks) m.min_high_ticks = m.run_ticks;
+        if (m.level == 0 && m.pulses > 0 && m.run_ticks < m.min_low_ticks) m.min_low_ticks = m.run_ticks;
+        if (level == 1) m.pulses++;
+        m.level = level;
+        m.run_ticks = 0;
+    }
+    m.run_ticks += duration;
+    m.total_ticks += duration;
+}
+
+static inline void step_model_feed(StepOutputModel &m, const uint32_t *items, uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+        step_model_half(m, items[i] & 0x7FFF, (items[i] >> 15) & 1);
+        step_model_half(m, (items[i] >> 16) & 0x7FFF, items[i] >> 31);
+        m.items++;
+    }
+}
@@ -0,0 +1,296 @@
+#include "telemetry.h"
+#include "tmc.h"
+#include "motion_task.h"
+#include "move_events.h"
+#include "fault_monitor.h"
+#include "homing.h"
+#include "sequence.h"
+#include "hall_sensors.h"
+#include "solenoid.h"
+#include <ArduinoJson.h>
+
+// Рассылка подписчикам SSE (определены в web_server.cpp)
+extern size_t telemetry_client_count();
+extern void publish_telemetry_event(const char *event, const char *message, uint32_t id);
+extern void publish_log_events();
+
+static TaskHandle_t telemetry_task_handle = nullptr;
+static volatile bool telemetry_enabled = true;
+static volatile uint16_t telemetry_rate_hz = TELEMETRY_DEFAULT_RATE_HZ;
+static volatile TelemetryFormat telemetry_format = TELEMETRY_FORMAT_JSON;
+static volatile bool keyframe_requested = true;
+
+// Только задача телеметрии
+static TelemetrySample sent = {};
+static TelemetryFrame sent_frame = {};
+static uint16_t frame_seq = 0;
+static uint32_t message_id = 0;
+static uint32_t last_keyframe_ms = 0;
+static uint32_t window_start_ms = 0;
+static uint32_t window_messages = 0;
+static uint32_t window_bytes = 0;
+static uint32_t window_busy_us = 0;
+static uint64_t publish_total_us = 0;
+static uint64_t age_total_ms = 0;
+
+// Статистика - пишет задача телеметрии, читает AsyncTCP
+static portMUX_TYPE telemetry_mux = portMUX_INITIALIZER_UNLOCKED;
+static TelemetryStats stats = {};
+
+void telemetry_configure(bool enabled, uint16_t rate_hz, TelemetryFormat format) {
+    telemetry_rate_hz = constrain(rate_hz, (uint16_t)1, (uint16_t)TELEMETRY_MAX_RATE_HZ);
+    telemetry_format = format;
+    telemetry_enabled = enabled;
+    keyframe_requested = true;
+}
+
+const char* telemetry_format_name(TelemetryFormat format) {
+    return format == TELEMETRY_FORMAT_BINARY ? "binary" : "json";
+}
+
+bool telemetry_format_from_name(const String &name, TelemetryFormat &format) {
+    if (name == "json") format = TELEMETRY_FORMAT_JSON;
+    else if (name == "binary") format = TELEMETRY_FORMAT_BINARY;
+    else return false;
+    return true;
+}
+
+void telemetry_request_keyframe() {
+    keyframe_requested = true;
+}
+
+TelemetryStats get_telemetry_stats() {
+    portENTER_CRITICAL(&telemetry_mux);
+    TelemetryStats s = stats;
+    portEXIT_CRITICAL(&telemetry_mux);
+    s.enabled = telemetry_enabled;
+    s.rate_hz = telemetry_rate_hz;
+    s.format = telemetry_format;
+    s.clients = telemetry_client_count();
+    return s;
+}
+
+void reset_telemetry_stats() {
+    portENTER_CRITICAL(&telemetry_mux);
+    stats = {};
+    publish_total_us = 0;
+    age_total_ms = 0;
+    portEXIT_CRITICAL(&telemetry_mux);
+}
+
+// Снимок движения - только из кэша задачи движения: SPI на ядре 0 не трогаем,
+// вместо свежего чтения клиенту уходит возраст снимка
+static void telemetry_capture(TelemetrySample &s) {
+    MotionSnapshot snap = {};
+    if (tmc_initialized) snap = peek_motion_snapshot();
+
+    TMC5160_Reg::DRV_STATUS_Register drv = {0};
+    drv.value = snap.valid ? snap.drv_status : 0;
+    s.timestamp_ms = snap.valid ? snap.timestamp_ms : millis();
+    s.position_usteps = snap.xactual;
+    s.wraps = snap.wraps;
+    s.target_usteps = snap.xtarget;
+    s.vactual = snap.vactual;
+    s.sg_result = drv.sg_result;
+    s.cs_actual = drv.cs_actual;
+    s.initialized = tmc_initialized;
+    s.enabled = motor_enabled;
+    s.moving = tmc_initialized && (move_in_flight() || snap.vactual != 0);
+    s.stallguard = drv.stallGuard;
+}
+
+static uint8_t telemetry_solenoid_bits() {
+    String state = get_solenoid_state();
+    uint8_t bits = state == "A" ? 1 : (state == "B" ? 2 : 0);
+    if (is_solenoid_switching()) bits |= TSOL_SWITCHING;
+    if (is_solenoid_testing()) bits |= TSOL_TESTING;
+    if (is_solenoid_enabled()) bits |= TSOL_ENABLED;
+    return bits;
+}
+
+// Как и в JSON - только кэш задачи движения, возраст снимка = timestamp_ms - snapshot_ms
+static void telemetry_capture_frame(TelemetryFrame &f) {
+    MotionSnapshot snap = {};
+    if (tmc_initialized) snap = peek_motion_snapshot();
+
+    f.timestamp_ms = millis();
+    f.snapshot_ms = snap.valid ? snap.timestamp_ms : f.timestamp_ms;
+    f.xactual = snap.xactual;
+    f.wraps = snap.wraps;
+    f.xtarget = snap.xtarget;
+    f.vactual = snap.vactual;
+    f.drv_status = snap.valid ? snap.drv_status : 0;
+    f.spi_status = tmc_initialized ? motor.getLastSpiStatus() : 0;
+
+    f.flags = 0;
+    if (tmc_initialized) f.flags |= TFRAME_INITIALIZED;
+    if (motor_enabled) f.flags |= TFRAME_ENABLED;
+    if (tmc_initialized && (move_in_flight() || snap.vactual != 0)) f.flags |= TFRAME_MOVING;
+    if (get_fault_monitor_stats().latched) f.flags |= TFRAME_FAULT;
+    if (is_jog_active()) f.flags |= TFRAME_JOG;
+    if (is_sequence_active()) f.flags |= TFRAME_SEQUENCE;
+    if (is_homing_active()) f.flags |= TFRAME_HOMING;
+
+    f.hall = (read_hall_sensor_1() ? 1 : 0) | (read_hall_sensor_2() ? 2 : 0);
+    f.solenoid = telemetry_solenoid_bits();
+}
+
+void telemetry_read_frame(TelemetryFrame &frame) {
+    telemetry_capture_frame(frame);
+    frame.seq = frame_seq;
+}
+
+// Ключи - как в /api/status: клиент накладывает кадр на последний ответ статуса
+static void telemetry_fill_json(JsonObject obj, const TelemetrySample &s, uint16_t mask) {
+    if (mask & TELEM_INITIALIZED) obj["initialized"] = s.initialized;
+    if (mask & TELEM_ENABLED) obj["enabled"] = s.enabled;
+    if (mask & TELEM_MOVING) obj["is_moving"] = s.moving;
+    if (mask & TELEM_POSITION) {
+        obj["current_position"] = steps_from_usteps(s.position_usteps);
+        obj["position_usteps"] = s.position_usteps;
+        obj["position_wraps"] = s.wraps;
+        AngleUnits units;
+        if (get_angle_units(units)) obj["angle_deg"] = angle_from_usteps_deg(units, (int64_t)s.wraps * 4294967296LL + s.position_usteps);
+    }
+    if (mask & TELEM_TARGET) {
+        obj["target_position"] = steps_from_usteps(s.target_usteps);
+        obj["target_usteps"] = s.target_usteps;
+    }
+    if (mask & (TELEM_POSITION | TELEM_TARGET)) {
+        obj["steps_remaining"] = usteps_distance(s.target_usteps, s.position_usteps) / get_usteps_per_step();
+    }
+    if (mask & TELEM_SPEED) obj["current_speed"] = s.vactual;
+    if (mask & TELEM_CS_ACTUAL) obj["cs_actual"] = s.cs_actual;
+    if (mask & TELEM_SG_RESULT) obj["sg_result"] = s.sg_result;
+    if (mask & TELEM_STALLGUARD) obj["stallguard"] = s.stallguard;
+}
+
+static void telemetry_json_message(const TelemetrySample &s, uint16_t mask, bool keyframe, String &message) {
+    JsonDocument doc;
+    doc["t"] = s.timestamp_ms;
+    doc["a"] = millis() - s.timestamp_ms;
+    if (keyframe) doc["k"] = true;
+    telemetry_fill_json(doc.as<JsonObject>(), s, mask);
+    serializeJson(doc, message);
+}
+
+// Возвращает размер отправленного (0 - без изменений), snapshot_ms - время данных в кадре
+static size_t telemetry_publish_json(bool keyframe, uint32_t &snapshot_ms) {
+    TelemetrySample cur;
+    telemetry_capture(cur);
+    snapshot_ms = cur.timestamp_ms;
+    uint16_t mask = keyframe ? TELEM_ALL : telemetry_changed(sent, cur, TELEMETRY_SG_DEADBAND);
+    if (!mask) return 0;
+
+    String message;
+    telemetry_json_message(cur, mask, keyframe, message);
+    publish_telemetry_event("telemetry", message.c_str(), ++message_id);
+    telemetry_apply(sent, cur, mask);
+    return message.length();
+}
+
+static size_t telemetry_publish_binary(bool keyframe, uint32_t &snapshot_ms) {
+    TelemetryFrame cur;
+    telemetry_capture_frame(cur);
+    snapshot_ms = cur.snapshot_ms;
+    if (!keyframe && telemetry_frame_same_state(sent_frame, cur)) return 0;
+
+    cur.seq = ++frame_seq;
+    uint8_t frame[TELEMETRY_FRAME_SIZE];
+    char text[TELEMETRY_FRAME_BASE64_SIZE];
+    size_t len = telemetry_base64_encode(frame, telemetry_frame_encode(cur, frame), text);
+    publish_telemetry_event("telemetry_bin", text, ++message_id);
+    sent_frame = cur;
+    return len;
+}
+
+static void telemetry_publish() {
+    uint32_t start_us = micros();
+    uint32_t now = millis();
+
+    bool keyframe = keyframe_requested || now - last_keyframe_ms >= TELEMETRY_KEYFRAME_MS;
+    uint32_t snapshot_ms = now;
+    size_t bytes = telemetry_format == TELEMETRY_FORMAT_BINARY ? telemetry_publish_binary(keyframe, snapshot_ms)
+                                                                : telemetry_publish_json(keyframe, snapshot_ms);
+    bool sent_message = bytes > 0;
+    if (sent_message && keyframe) {
+        keyframe_requested = false;
+        last_keyframe_ms = now;
+    }
+
+    uint32_t publish_us = micros() - start_us;
+    uint32_t age_ms = millis() - snapshot_ms;
+    size_t clients = telemetry_client_count();
+    window_busy_us += publish_us;
+    if (sent_message) {
+        window_messages++;
+        window_bytes += bytes;
+    }
+
+    portENTER_CRITICAL(&telemetry_mux);
+    stats.samples++;
+    if (!sent_message) {
+        stats.unchanged++;
+    } else {
+        stats.messages++;
+        if (keyframe) stats.keyframes++;
+        stats.bytes += bytes;
+        stats.publish_last_us = publish_us;
+        if (publish_us > stats.publish_max_us) stats.publish_max_us = publish_us;
+        publish_total_us += publish_us;
+        stats.publish_avg_us = publish_total_us / stats.messages;
+        stats.per_client_us = clients ? stats.publish_avg_us / clients : 0;
+        stats.age_last_ms = age_ms;
+        if (age_ms > stats.age_max_ms) stats.age_max_ms = age_ms;
+        age_total_ms += age_ms;
+        stats.age_avg_ms = age_total_ms / stats.messages;
+    }
+    if (now - window_start_ms >= 1000) {
+        uint32_t window_ms = now - window_start_ms;
+        stats.messages_per_sec = (uint64_t)window_messages * 1000 / window_ms;
+        stats.bytes_per_sec = (uint64_t)window_bytes * 1000 / window_ms;
+        stats.cpu_permille = window_busy_us / window_ms;
+        window_start_ms = now;
+        window_messages = 0;
+        window_bytes = 0;
+        window_busy_us = 0;
+    }
+    portEXIT_CRITICAL(&telemetry_mux);
+}
+
+static void telemetry_task(void *arg) {
+    TickType_t last_wake = xTaskGetTickCount();
+    for (;;) {
+        uint32_t period_ms = 1000 / telemetry_rate_hz;
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(period_ms));
+
+        // Новые строки лога - тем же подписчикам, независимо от телеметрии
+        bool has_clients = telemetry_client_count() > 0;
+        if (has_clients) publish_log_events();
+
+        // Нет подписчиков - ни SPI, ни JSON; первый подключившийся получит ключевой кадр
+        if (!telemetry_enabled || !has_clients) {
+            keyframe_requested = true;
+            window_start_ms = millis();
+            window_messages = 0;
+            window_bytes = 0;
+            window_busy_us = 0;
+            portENTER_CRITICAL(&telemetry_mux);
+            stats.messages_per_sec = 0;
+            stats.bytes_per_sec = 0;
+            stats.cpu_permille = 0;
+            portEXIT_CRITICAL(&telemetry_mux);
+            continue;
+        }
+        telemetry_publish();
+    }
+}
+
+void init_telemetry() {
+    if (telemetry_task_handle) return;
+
+    window_start_ms = millis();
+    xTaskCreatePinnedToCore(telemetry_task, "telemetry", TELEMETRY_TASK_STACK, nullptr,
+                            TELEMETRY_TASK_PRIORITY, &telemetry_task_handle, TELEMETRY_TASK_CORE);
+    add_log("✅ Telemetry push started (" + String(telemetry_rate_hz) + " Hz, SSE /api/events)");
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <Arduino.h>
+#include "telemetry_sample.h"
+#include "telemetry_frame.h"
+
+// ============================================================================
+// PUSH-ТЕЛЕМЕТРИЯ (SSE /api/events, событие "telemetry")
+// ============================================================================
+// Единственный производитель - своя задача на PRO CPU: с заданной частотой берёт снимок
+// движения (задача движения обновляет его раз в MOTION_POLL_PERIOD_MS) и DRV_STATUS из
+// него же, рассылает всем подписчикам SSE только изменившиеся поля (telemetry_sample.h).
+// Ключевой кадр - новому клиенту и раз в TELEMETRY_KEYFRAME_MS. Без подписчиков - не
+// работает. Опрос /api/status остаётся запасным путём и для полей вне телеметрии.
+// Формат binary - событие "telemetry_bin": кадр telemetry_frame.h в base64, целиком (с
+// датчиками Холла и соленоидом), но только если состояние изменилось.
+// Та же задача отдаёт подписчикам новые строки лога (событие "log", web_server.cpp).
+
+#define TELEMETRY_DEFAULT_RATE_HZ 50
+#define TELEMETRY_MAX_RATE_HZ 100
+#define TELEMETRY_KEYFRAME_MS 5000
+#define TELEMETRY_SG_DEADBAND 8         // Изменения SG_RESULT меньше - шум, не отправляются
+#define TELEMETRY_TASK_CORE 0           // PRO CPU, рядом с AsyncTCP - не мешает задаче движения
+#define TELEMETRY_TASK_PRIORITY 1
+#define TELEMETRY_TASK_STACK 4096
+
+enum TelemetryFormat : uint8_t {
+    TELEMETRY_FORMAT_JSON = 0,      // "telemetry": изменившиеся поля с ключами /api/status
+    TELEMETRY_FORMAT_BINARY         // "telemetry_bin": кадр фиксированной раскладки в base64
+};
+
+struct TelemetryStats {
+    bool enabled;
+    uint16_t rate_hz;
+    TelemetryFormat format;
+    uint32_t clients;
+    uint32_t samples;               // Выборок при подписчиках
+    uint32_t messages;
+    uint32_t keyframes;
+    uint32_t unchanged;             // Выборок без изменений - ничего не отправлено
+    uint32_t bytes;
+    uint32_t messages_per_sec;      // За последнюю полную секунду
+    uint32_t bytes_per_sec;
+    uint32_t publish_last_us;       // Выборка + JSON + постановка в очереди клиентов
+    uint32_t publish_avg_us;
+    uint32_t publish_max_us;
+    uint32_t per_client_us;         // publish_avg_us на одного подписчика
+    uint32_t cpu_permille;          // Доля ядра на рассылку за последнюю секунду (‰)
+    uint32_t age_last_ms;           // Возраст снимка движения в момент отправки
+    uint32_t age_avg_ms;
+    uint32_t age_max_ms;
+};
+
+void init_telemetry();
+void telemetry_configure(bool enabled, uint16_t rate_hz, TelemetryFormat format);
+const char* telemetry_format_name(TelemetryFormat format);
+// false - неизвестное имя формата
+bool telemetry_format_from_name(const String &name, TelemetryFormat &format);
+// Новый подписчик SSE - следующая рассылка будет ключевым кадром
+void telemetry_request_keyframe();
+
+TelemetryStats get_telemetry_stats();
+void reset_telemetry_stats();
+
+// Текущее состояние двоичным кадром (GET /api/telemetry/frame)
+void telemetry_read_frame(TelemetryFrame &frame);
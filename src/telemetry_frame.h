@@ -0,0 +1,149 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// ДВОИЧНЫЙ КАДР ТЕЛЕМЕТРИИ (ЧИСТАЯ ЛОГИКА)
+// ============================================================================
+// Фиксированная раскладка, little-endian, без выравнивания - пишется и читается побайтно,
+// не зависит от упаковки структур. Полный статус движения, SPI_STATUS, DRV_STATUS, датчики
+// Холла и соленоид - 40 байт против ~700 байт JSON /api/status. Декодер в веб-интерфейсе
+// (decodeTelemetryFrame в index.html) читает те же смещения через DataView.
+//
+//  off  размер  поле
+//   0   1       magic 'T' (0x54)
+//   1   1       version (TELEMETRY_FRAME_VERSION)
+//   2   2       seq - номер кадра (u16, переполняется)
+//   4   4       timestamp_ms - millis() сборки кадра
+//   8   4       snapshot_ms - millis() снимка движения
+//  12   4       xactual (i32, микрошаги)
+//  16   4       wraps (i32, переходы XACTUAL через ±2^31)
+//  20   4       xtarget (i32, микрошаги)
+//  24   4       vactual (i32)
+//  28   4       drv_status (u32, DRV_STATUS целиком)
+//  32   1       spi_status (статус последней SPI-датаграммы)
+//  33   1       flags (TelemetryFrameFlag)
+//  34   1       hall (бит 0 - датчик 1, бит 1 - датчик 2: магнит обнаружен)
+//  35   1       solenoid (биты 0-1 позиция 0/A/B, TelemetrySolenoidBit)
+//  36   4       reserved (0) - добавки без смены версии, старый декодер их не читает
+//
+// Новое поле - в reserved; смена смысла или смещений - только с новой версией.
+
+#define TELEMETRY_FRAME_MAGIC 0x54
+#define TELEMETRY_FRAME_VERSION 1
+#define TELEMETRY_FRAME_SIZE 40
+#define TELEMETRY_FRAME_BASE64_SIZE (((TELEMETRY_FRAME_SIZE + 2) / 3) * 4 + 1)
+
+enum TelemetryFrameFlag : uint8_t {
+    TFRAME_INITIALIZED = 1 << 0,
+    TFRAME_ENABLED     = 1 << 1,
+    TFRAME_MOVING      = 1 << 2,
+    TFRAME_FAULT       = 1 << 3,     // Мотор отключён по ошибке драйвера (DIAG0)
+    TFRAME_JOG         = 1 << 4,
+    TFRAME_SEQUENCE    = 1 << 5,
+    TFRAME_HOMING      = 1 << 6
+};
+
+enum TelemetrySolenoidBit : uint8_t {
+    TSOL_POSITION_MASK = 0x03,       // 0 - неизвестно, 1 - A, 2 - B
+    TSOL_SWITCHING     = 1 << 2,
+    TSOL_TESTING       = 1 << 3,
+    TSOL_ENABLED       = 1 << 4
+};
+
+struct TelemetryFrame {
+    uint16_t seq;
+    uint32_t timestamp_ms;
+    uint32_t snapshot_ms;
+    int32_t xactual;
+    int32_t wraps;
+    int32_t xtarget;
+    int32_t vactual;
+    uint32_t drv_status;
+    uint8_t spi_status;
+    uint8_t flags;
+    uint8_t hall;
+    uint8_t solenoid;
+};
+
+inline void tframe_put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+inline void tframe_put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+inline uint16_t tframe_get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+inline uint32_t tframe_get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// out - не меньше TELEMETRY_FRAME_SIZE байт. Возвращает размер кадра
+inline size_t telemetry_frame_encode(const TelemetryFrame &f, uint8_t *out) {
+    out[0] = TELEMETRY_FRAME_MAGIC;
+    out[1] = TELEMETRY_FRAME_VERSION;
+    tframe_put_u16(out + 2, f.seq);
+    tframe_put_u32(out + 4, f.timestamp_ms);
+    tframe_put_u32(out + 8, f.snapshot_ms);
+    tframe_put_u32(out + 12, (uint32_t)f.xactual);
+    tframe_put_u32(out + 16, (uint32_t)f.wraps);
+    tframe_put_u32(out + 20, (uint32_t)f.xtarget);
+    tframe_put_u32(out + 24, (uint32_t)f.vactual);
+    tframe_put_u32(out + 28, f.drv_status);
+    out[32] = f.spi_status;
+    out[33] = f.flags;
+    out[34] = f.hall;
+    out[35] = f.solenoid;
+    tframe_put_u32(out + 36, 0);
+    return TELEMETRY_FRAME_SIZE;
+}
+
+// false - не кадр телеметрии (magic), неизвестная версия или короткий буфер
+inline bool telemetry_frame_decode(const uint8_t *in, size_t len, TelemetryFrame &f) {
+    if (len < TELEMETRY_FRAME_SIZE || in[0] != TELEMETRY_FRAME_MAGIC || in[1] != TELEMETRY_FRAME_VERSION) return false;
+    f.seq = tframe_get_u16(in + 2);
+    f.timestamp_ms = tframe_get_u32(in + 4);
+    f.snapshot_ms = tframe_get_u32(in + 8);
+    f.xactual = (int32_t)tframe_get_u32(in + 12);
+    f.wraps = (int32_t)tframe_get_u32(in + 16);
+    f.xtarget = (int32_t)tframe_get_u32(in + 20);
+    f.vactual = (int32_t)tframe_get_u32(in + 24);
+    f.drv_status = tframe_get_u32(in + 28);
+    f.spi_status = in[32];
+    f.flags = in[33];
+    f.hall = in[34];
+    f.solenoid = in[35];
+    return true;
+}
+
+// Кадр без seq и времени - для пропуска неизменившихся выборок
+inline bool telemetry_frame_same_state(const TelemetryFrame &a, const TelemetryFrame &b) {
+    return a.xactual == b.xactual && a.wraps == b.wraps && a.xtarget == b.xtarget && a.vactual == b.vactual &&
+           a.drv_status == b.drv_status && a.spi_status == b.spi_status && a.flags == b.flags &&
+           a.hall == b.hall && a.solenoid == b.solenoid;
+}
+
+// SSE передаёт только текст: кадр уходит в base64 (56 символов), браузер - atob()
+inline size_t telemetry_base64_encode(const uint8_t *in, size_t len, char *out) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t o = 0;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)in[i + 1] << 8;
+        if (i + 2 < len) v |= in[i + 2];
+        out[o++] = alphabet[(v >> 18) & 0x3F];
+        out[o++] = alphabet[(v >> 12) & 0x3F];
+        out[o++] = i + 1 < len ? alphabet[(v >> 6) & 0x3F] : '=';
+        out[o++] = i + 2 < len ? alphabet[v & 0x3F] : '=';
+    }
+    out[o] = '\0';
+    return o;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================================
+// ТЕЛЕМЕТРИЯ - ВЫБОРКА СОСТОЯНИЯ И ИЗМЕНИВШИЕСЯ ПОЛЯ (ЧИСТАЯ ЛОГИКА)
+// ============================================================================
+// Одна выборка на период рассылки. Клиентам уходят только поля, отличные от последней
+// ОТПРАВЛЕННОЙ выборки (маска TelemetryField), ключевой кадр - все поля. SG_RESULT шумит
+// на каждом полном шаге - его мелкие изменения (в пределах sg_deadband) не отправляются.
+
+enum TelemetryField : uint16_t {
+    TELEM_INITIALIZED = 1 << 0,
+    TELEM_ENABLED     = 1 << 1,
+    TELEM_MOVING      = 1 << 2,
+    TELEM_POSITION    = 1 << 3,     // XACTUAL и переходы через ±2^31
+    TELEM_TARGET      = 1 << 4,
+    TELEM_SPEED       = 1 << 5,
+    TELEM_CS_ACTUAL   = 1 << 6,
+    TELEM_SG_RESULT   = 1 << 7,
+    TELEM_STALLGUARD  = 1 << 8,
+    TELEM_ALL         = (1 << 9) - 1
+};
+
+struct TelemetrySample {
+    uint32_t timestamp_ms;          // millis() снимка движения
+    int32_t position_usteps;
+    int32_t wraps;
+    int32_t target_usteps;
+    int32_t vactual;
+    uint16_t sg_result;
+    uint8_t cs_actual;
+    bool initialized;
+    bool enabled;
+    bool moving;
+    bool stallguard;
+};
+
+inline uint16_t telemetry_changed(const TelemetrySample &sent, const TelemetrySample &cur, uint16_t sg_deadband) {
+    uint16_t mask = 0;
+    if (cur.initialized != sent.initialized) mask |= TELEM_INITIALIZED;
+    if (cur.enabled != sent.enabled) mask |= TELEM_ENABLED;
+    if (cur.moving != sent.moving) mask |= TELEM_MOVING;
+    if (cur.position_usteps != sent.position_usteps || cur.wraps != sent.wraps) mask |= TELEM_POSITION;
+    if (cur.target_usteps != sent.target_usteps) mask |= TELEM_TARGET;
+    if (cur.vactual != sent.vactual) mask |= TELEM_SPEED;
+    if (cur.cs_actual != sent.cs_actual) mask |= TELEM_CS_ACTUAL;
+    uint16_t sg_delta = cur.sg_result > sent.sg_result ? cur.sg_result - sent.sg_result : sent.sg_result - cur.sg_result;
+    if (sg_delta > sg_deadband) mask |= TELEM_SG_RESULT;
+    if (cur.stallguard != sent.stallguard) mask |= TELEM_STALLGUARD;
+    return mask;
+}
+
+// Отправленное состояние у клиента: изменившиеся поля из cur, остальные - прежние
+inline void telemetry_apply(TelemetrySample &sent, const TelemetrySample &cur, uint16_t mask) {
+    sent.timestamp_ms = cur.timestamp_ms;
+    if (mask & TELEM_INITIALIZED) sent.initialized = cur.initialized;
+    if (mask & TELEM_ENABLED) sent.enabled = cur.enabled;
+    if (mask & TELEM_MOVING) sent.moving = cur.moving;
+    if (mask & TELEM_POSITION) {
+        sent.position_usteps = cur.position_usteps;
+        sent.wraps = cur.wraps;
+    }
+    if (mask & TELEM_TARGET) sent.target_usteps = cur.target_usteps;
+    if (mask & TELEM_SPEED) sent.vactual = cur.vactual;
+    if (mask & TELEM_CS_ACTUAL) sent.cs_actual = cur.cs_actual;
+    if (mask & TELEM_SG_RESULT) sent.sg_result = cur.sg_result;
+    if (mask & TELEM_STALLGUARD) sent.stallguard = cur.stallguard;
+}
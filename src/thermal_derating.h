@@ -0,0 +1,122 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================================
+// ТЕПЛОВОЕ СНИЖЕНИЕ ТОКА (DERATING) - ПОЛИТИКА, ЧИСТАЯ ЛОГИКА
+// ============================================================================
+// Вход - флаги DRV_STATUS otpw/ot с фиксированным периодом опроса. Держится otpw дольше
+// persist_ms - ток (IRUN) снижается на step_percent, не чаще step_interval_ms и не ниже
+// min_percent. otpw нет дольше cool_ms - ток возвращается на шаг (каждый шаг ждёт cool_ms
+// заново) - гистерезис по времени, без дребезга на границе otpw.
+// ot (драйвер уже отключил мост) - сразу min_percent. Без Arduino - проверяется на хосте,
+// в т.ч. на модели нагрева (test/test_thermal_derating).
+
+#define DERATE_SAMPLE_PERIOD_MS 100
+#define DERATE_PERSIST_MS 500
+#define DERATE_COOL_MS 20000
+#define DERATE_STEP_INTERVAL_MS 10000
+#define DERATE_STEP_PERCENT 10
+#define DERATE_MIN_PERCENT 50
+
+struct DeratePolicy {
+    uint32_t persist_ms;
+    uint32_t cool_ms;
+    uint32_t step_interval_ms;
+    uint8_t step_percent;
+    uint8_t min_percent;
+};
+
+static inline DeratePolicy derate_default_policy() {
+    DeratePolicy p;
+    p.persist_ms = DERATE_PERSIST_MS;
+    p.cool_ms = DERATE_COOL_MS;
+    p.step_interval_ms = DERATE_STEP_INTERVAL_MS;
+    p.step_percent = DERATE_STEP_PERCENT;
+    p.min_percent = DERATE_MIN_PERCENT;
+    return p;
+}
+
+// Политика без противоречий: nullptr - корректна
+static inline const char* derate_policy_validate(const DeratePolicy &p) {
+    if (p.step_percent == 0 || p.step_percent > 50) return "step_percent must be 1..50";
+    if (p.min_percent < 10 || p.min_percent > 100) return "min_percent must be 10..100";
+    if (p.cool_ms < p.persist_ms) return "cool_ms must be >= persist_ms";
+    return nullptr;
+}
+
+enum DerateDecision : uint8_t {
+    DERATE_NONE = 0,
+    DERATE_STEP_DOWN,
+    DERATE_STEP_UP,
+};
+
+struct DerateState {
+    uint8_t percent;            // Доля тока настроек, 100 - без снижения
+    bool otpw;
+    uint32_t otpw_since_ms;     // Начало текущего otpw (или его отсутствия)
+    uint32_t clear_since_ms;
+    uint32_t last_change_ms;
+    uint32_t last_update_ms;
+    uint32_t steps_down;
+    uint32_t steps_up;
+    uint32_t reduced_ms;        // Всего времени на сниженном токе
+    uint32_t otpw_ms;           // Всего времени с otpw
+    uint32_t ot_events;
+    uint8_t min_reached;        // Наименьший процент
+};
+
+static inline void derate_reset(DerateState &s, uint32_t now_ms) {
+    s.percent = 100;
+    s.otpw = false;
+    s.otpw_since_ms = now_ms;
+    s.clear_since_ms = now_ms;
+    s.last_change_ms = now_ms;
+    s.last_update_ms = now_ms;
+    s.steps_down = 0;
+    s.steps_up = 0;
+    s.reduced_ms = 0;
+    s.otpw_ms = 0;
+    s.ot_events = 0;
+    s.min_reached = 100;
+}
+
+static inline DerateDecision derate_update(DerateState &s, const DeratePolicy &p, bool otpw, bool ot, uint32_t now_ms) {
+    uint32_t dt = now_ms - s.last_update_ms;
+    if (s.percent < 100) s.reduced_ms += dt;
+    if (s.otpw) s.otpw_ms += dt;
+    s.last_update_ms = now_ms;
+
+    if (otpw && !s.otpw) s.otpw_since_ms = now_ms;
+    if (!otpw && s.otpw) s.clear_since_ms = now_ms;
+    s.otpw = otpw;
+
+    DerateDecision d = DERATE_NONE;
+    if (ot) {
+        s.ot_events++;
+        if (s.percent > p.min_percent) {
+            s.percent = p.min_percent;
+            s.steps_down++;
+            s.last_change_ms = now_ms;
+            d = DERATE_STEP_DOWN;
+        }
+    } else if (otpw) {
+        if (s.percent > p.min_percent && now_ms - s.otpw_since_ms >= p.persist_ms &&
+            now_ms - s.last_change_ms >= p.step_interval_ms) {
+            s.percent = s.percent - p.step_percent > p.min_percent ? s.percent - p.step_percent : p.min_percent;
+            s.steps_down++;
+            s.last_change_ms = now_ms;
+            d = DERATE_STEP_DOWN;
+        }
+    } else if (s.percent < 100 && now_ms - s.clear_since_ms >= p.cool_ms && now_ms - s.last_change_ms >= p.cool_ms) {
+        s.percent = s.percent + p.step_percent < 100 ? s.percent + p.step_percent : 100;
+        s.steps_up++;
+        s.last_change_ms = now_ms;
+        d = DERATE_STEP_UP;
+    }
+    if (s.percent < s.min_reached) s.min_reached = s.percent;
+    return d;
+}
+
+static inline uint16_t derate_current(uint16_t current_mA, uint8_t percent) {
+    return (uint16_t)((uint32_t)current_mA * percent / 100);
+}
@@ -6,22 +6,70 @@
 #include "config.h"
 #include "api_types.h"
 #include "eeprom_manager.h"
+#include "tmc_spi.h"
+#include "step_pulse.h"
+#include "move_events.h"
+#include "homing.h"
+#include "fault_monitor.h"
+#include "health_monitor.h"
+#include "tmc_config_diff.h"
+#include "serial_log.h"
 
 // Глобальные переменные
-TMC5160_SPI *motor_ptr = nullptr;  // Указатель для динамического создания (extern в tmc.h)
+TMC5160_ShadowSPI *motor_ptr = nullptr;  // Указатель для динамического создания (extern в tmc.h)
 bool tmc_initialized = false;
 bool motor_enabled = false;
 volatile bool stallguard_triggered = false;  // Флаг срабатывания StallGuard
+uint32_t spi_status_reads_saved = 0;
+uint32_t driver_reset_count = 0;
+
+// Ток, заданный настройками/командой - в чип пишется с учётом теплового снижения
+static uint16_t requested_current_mA = 0;
+static float requested_hold_multiplier = 0.5f;
+
+// Режим скорости (RAMPMODE 1/2): целевая скорость в шагах/с со знаком
+static volatile bool jog_active = false;
+static volatile int32_t jog_target_speed = 0;
+
+// Последний снимок движения (обновляется read_motion_snapshot).
+// Пишется задачей движения и AsyncTCP - копирование под спинлоком.
+static MotionSnapshot last_motion_snapshot = {};
+static portMUX_TYPE motion_snapshot_mux = portMUX_INITIALIZER_UNLOCKED;
+// Переходы XACTUAL через ±2^31 - обновляется каждым снимком (под motion_snapshot_mux)
+static UstepsUnwrap position_unwrap = {};
+
+// Микрошагов на шаг по MRES, записанному в CHOPCONF: в этой шкале считают XACTUAL/XTARGET.
+// Пишет задача движения, читает и AsyncTCP (статус) - одно 32-битное слово
+static volatile uint32_t programmed_usteps_per_step = TMC_LIB_USTEPS_PER_STEP;
+
+// Дробный остаток угловых ходов - только задача движения. Сбрасывается при смене единиц
+// (настройки, режим) и при установке позиции
+static AngleUnits angle_units = {};
+static AngleCarry angle_carry = {};
+static bool angle_carry_valid = false;
+
+// Новая шкала микрошагов - остаток в старых единицах теряет смысл
+static void set_programmed_usteps_per_step(uint8_t mres) {
+    uint32_t per_step = usteps_per_step_from_mres(mres);
+    if (per_step == programmed_usteps_per_step) return;
+    programmed_usteps_per_step = per_step;
+    angle_carry_valid = false;
+}
 
-// Переменные для последовательности от центра
-bool center_sequence_active = false;
-unsigned long sequence_start_time = 0;
-int sequence_step = 0;
-const int sequence_delay = 2000;
-
-// Функция логирования
+// Регистры снимка - порядок соответствует полям MotionSnapshot
+static const uint8_t MOTION_SNAPSHOT_REGS[] = {
+    TMC5160_Reg::XACTUAL,
+    TMC5160_Reg::XTARGET,
+    TMC5160_Reg::VACTUAL,
+    TMC5160_Reg::RAMP_STAT,
+    TMC5160_Reg::DRV_STATUS,
+    TMC5160_Reg::GSTAT
+};
+static const uint8_t MOTION_SNAPSHOT_REG_COUNT = sizeof(MOTION_SNAPSHOT_REGS) / sizeof(MOTION_SNAPSHOT_REGS[0]);
+
+// Функция логирования: строка уходит в очередь, в Serial её выводит задача serial_log.cpp
 void add_log(String message) {
-    Serial.println(message);
+    serial_log_write(message.c_str(), message.length());
 }
 
 // ===== ФУНКЦИИ ВАЛИДАЦИИ =====
@@ -54,6 +102,21 @@ bool validate_acceleration(uint16_t accel) {
     return true;
 }
 
+// microsteps -> mres (CHOPCONF биты 24..27): 256=0, 128=1, 64=2, 32=3, 16=4, 8=5, 4=6, 2=7, 1=8
+static uint8_t microsteps_to_mres(uint16_t microsteps) {
+    uint8_t mres = 8; // по умолчанию FULLSTEP
+    if (microsteps == 256) mres = 0;
+    else if (microsteps == 128) mres = 1;
+    else if (microsteps == 64) mres = 2;
+    else if (microsteps == 32) mres = 3;
+    else if (microsteps == 16) mres = 4;
+    else if (microsteps == 8) mres = 5;
+    else if (microsteps == 4) mres = 6;
+    else if (microsteps == 2) mres = 7;
+    else if (microsteps == 1) mres = 8;
+    return mres;
+}
+
 // ===== РАСЧЁТ ТОКА TMC5160 (ПРАВИЛЬНАЯ ФОРМУЛА!) =====
 
 void calculate_current_settings(uint16_t current_mA, float hold_multiplier,
@@ -94,12 +157,15 @@ bool setup_tmc5160(uint16_t current_mA, float hold_multiplier, uint16_t microste
     digitalWrite(EN_PIN, HIGH);  // ВЫКЛЮЧЕН (активный LOW, значит HIGH = выключен)
     Serial.println("✅ EN pin configured (motor DISABLED)");
 
-    // 2. РАССЧИТЫВАЕМ irun, ihold, globalScaler из current_mA
+    // 2. РАССЧИТЫВАЕМ irun, ihold, globalScaler из current_mA (с учётом теплового снижения)
+    requested_current_mA = current_mA;
+    requested_hold_multiplier = hold_multiplier;
+    uint16_t effective_mA = derate_current(current_mA, get_derate_percent());
     uint8_t irun, ihold;
     uint16_t globalScaler;
-    calculate_current_settings(current_mA, hold_multiplier, &irun, &ihold, &globalScaler);
+    calculate_current_settings(effective_mA, hold_multiplier, &irun, &ihold, &globalScaler);
     Serial.print("✅ Current: ");
-    Serial.print(current_mA);
+    Serial.print(effective_mA);
     Serial.print("mA → irun=");
     Serial.print(irun);
     Serial.print(", ihold=");
@@ -122,26 +188,33 @@ bool setup_tmc5160(uint16_t current_mA, float hold_multiplier, uint16_t microste
 
     // 6. Создаём объект ПОСЛЕ SPI.begin() с 100kHz SPI
     if (motor_ptr == nullptr) {
-        motor_ptr = new TMC5160_SPI(CS_PIN, 12000000, SPISettings(100000, MSBFIRST, SPI_MODE3), SPI);
+        motor_ptr = new TMC5160_ShadowSPI(CS_PIN, TMC5160_FCLK, SPISettings(100000, MSBFIRST, SPI_MODE3), SPI);
         Serial.println("✅ motor object created (SPI 100kHz)");
     }
 
+    // Чип мог быть сброшен - тень заполняется заново при motor.begin()
+    motor.invalidateShadow();
+
     // 7. motor.begin()
     motor.begin(powerStageParams, motorParams, TMC5160::NORMAL_MOTOR_DIRECTION);
     Serial.println("✅ motor.begin() called");
 
+    // Частота SPI: сохранённая калибровка (с проверкой) или автонастройка при первом запуске
+    if (currentSettings.spi_clock_hz != 0) {
+        motor.setSpiClock(currentSettings.spi_clock_hz);
+        if (motor.probeLink(SPI_AUTOTUNE_PATTERNS, nullptr) != 0) {
+            add_log("⚠️ Stored SPI clock " + String(currentSettings.spi_clock_hz) + " Hz unstable, recalibrating");
+            calibrate_spi_clock();
+        }
+    } else {
+        calibrate_spi_clock();
+    }
+    Serial.print("✅ SPI clock: ");
+    Serial.print(motor.getSpiClock());
+    Serial.println(" Hz");
+
     // 8. УСТАНАВЛИВАЕМ МИКРОШАГИ ВРУЧНУЮ! (библиотека tommag не имеет API для этого)
-    // microsteps -> mres value: 256=0, 128=1, 64=2, 32=3, 16=4, 8=5, 4=6, 2=7, 1=8
-    uint8_t mres = 8; // по умолчанию FULLSTEP
-    if (microsteps == 256) mres = 0;
-    else if (microsteps == 128) mres = 1;
-    else if (microsteps == 64) mres = 2;
-    else if (microsteps == 32) mres = 3;
-    else if (microsteps == 16) mres = 4;
-    else if (microsteps == 8) mres = 5;
-    else if (microsteps == 4) mres = 6;
-    else if (microsteps == 2) mres = 7;
-    else if (microsteps == 1) mres = 8;
+    uint8_t mres = microsteps_to_mres(microsteps);
     
     // Читаем текущий CHOPCONF
     uint32_t chopconf = motor.readRegister(TMC5160_Reg::CHOPCONF);
@@ -149,28 +222,47 @@ bool setup_tmc5160(uint16_t current_mA, float hold_multiplier, uint16_t microste
     chopconf &= ~(0x0F << 24); // Очищаем биты mres
     chopconf |= (mres << 24);   // Устанавливаем новое значение
     motor.writeRegister(TMC5160_Reg::CHOPCONF, chopconf);
+    set_programmed_usteps_per_step(mres);
     Serial.print("✅ Microsteps set: ");
     Serial.print(microsteps);
     Serial.print(" (mres=");
     Serial.print(mres);
     Serial.println(")");
 
-    // 9. ramp definition
+    // 9. ramp definition - все шесть точек рампы одной группой
     motor.setRampMode(TMC5160::POSITIONING_MODE);
-    motor.setMaxSpeed(max_speed);
-    motor.setAcceleration(accel);
+    jog_active = false;
+    jog_target_speed = 0;
+    RampProfile ramp = get_ramp_profile(currentSettings);
+    ramp.vmax = max_speed;
+    ramp.amax = accel;
+    ramp.dmax = decel;
+    apply_ramp_profile(ramp);
     Serial.print("✅ Ramp: VMAX=");
     Serial.print(max_speed);
     Serial.print(", AMAX=");
-    Serial.println(accel);
+    Serial.print(accel);
+    Serial.print(", DMAX=");
+    Serial.println(decel);
 
     Serial.println("starting up");
 
     // 10. СБРАСЫВАЕМ ПОЗИЦИЮ В 0!
     motor.writeRegister(TMC5160_Reg::XACTUAL, 0);
     motor.writeRegister(TMC5160_Reg::XTARGET, 0);
+    portENTER_CRITICAL(&motion_snapshot_mux);
+    usteps_unwrap_reset(position_unwrap, 0);
+    portEXIT_CRITICAL(&motion_snapshot_mux);
+    angle_carry_valid = false;
+    homing_invalidate_origin();
     Serial.println("✅ Position reset to 0");
 
+    // Ошибки драйвера на DIAG0 - ловит diag0_isr() (fault_monitor.cpp)
+    fault_monitor_configure();
+
+    // Сбрасываем флаги GSTAT (reset после включения питания), чтобы run_motor() не принял их за сброс
+    motor.writeRegister(TMC5160_Reg::GSTAT, 0x07);
+
     // 11. delay(1000) для автонастройки
     delay(1000);
     Serial.println("✅ Calibration complete");
@@ -179,60 +271,469 @@ bool setup_tmc5160(uint16_t current_mA, float hold_multiplier, uint16_t microste
     return true;
 }
 
+// ===== ДИФФЕРЕНЦИАЛЬНОЕ ПРИМЕНЕНИЕ НАСТРОЕК =====
+// Без SPI.begin()/motor.begin()/delay и без сброса XACTUAL: образ регистров из настроек
+// сравнивается с тенью, пишутся только отличающиеся (tmc_config_diff.h)
+
+static ConfigApplyStats last_config_apply = {};
+
+static bool config_peek(uint8_t address, uint32_t *value, void *ctx) {
+    // Write-only без тени - с чипа читается 0, значение неизвестно
+    if (TMC5160_ShadowSPI::regPolicy(address) == REG_WRITE_ONLY && !motor.isShadowValid(address)) return false;
+    *value = motor.readRegister(address);
+    return true;
+}
+
+static void config_poke(uint8_t address, uint32_t value, void *ctx) {
+    motor.writeRegister(address, value);
+}
+
+// Порядок - как в setup_tmc5160: ток, микрошаги, StallGuard, рампа (VMAX последним)
+static void build_config_image(const MotorSettings &settings, TmcConfigImage &img) {
+    tmc_image_clear(img);
+
+    uint8_t irun, ihold;
+    uint16_t globalScaler;
+    calculate_current_settings(derate_current(settings.current_mA, get_derate_percent()), settings.hold_multiplier,
+                               &irun, &ihold, &globalScaler);
+    tmc_image_set(img, TMC5160_Reg::GLOBAL_SCALER, globalScaler);
+    tmc_image_set(img, TMC5160_Reg::IHOLD_IRUN, (ihold << 0) | (irun << 8) | (7 << 16));
+
+    tmc_image_set(img, TMC5160_Reg::CHOPCONF, (uint32_t)microsteps_to_mres(settings.microsteps) << 24, 0x0FUL << 24);
+
+    if (settings.stallguard_threshold != 0) {
+        tmc_image_set(img, TMC5160_Reg::COOLCONF, (uint32_t)(settings.stallguard_threshold & 0x7F) << 16, 0x7FUL << 16);
+        tmc_image_set(img, TMC5160_Reg::TCOOLTHRS, settings.stallguard_tcoolthrs & 0xFFFFF);
+        tmc_image_set(img, TMC5160_Reg::GCONF, (1UL << 7) | (1UL << 12), (1UL << 7) | (1UL << 12));
+    } else {
+        tmc_image_set(img, TMC5160_Reg::GCONF, 0, 1UL << 7);
+    }
+
+    RampRegisters regs;
+    ramp_profile_to_registers(get_ramp_profile(settings), TMC5160_FCLK, TMC_LIB_USTEPS_PER_STEP, regs);
+    tmc_image_set(img, TMC5160_Reg::VSTART, regs.vstart);
+    tmc_image_set(img, TMC5160_Reg::A1, regs.a1);
+    tmc_image_set(img, TMC5160_Reg::V1, regs.v1);
+    tmc_image_set(img, TMC5160_Reg::AMAX, regs.amax);
+    tmc_image_set(img, TMC5160_Reg::DMAX, regs.dmax);
+    tmc_image_set(img, TMC5160_Reg::D1, regs.d1);
+    tmc_image_set(img, TMC5160_Reg::VSTOP, regs.vstop);
+    tmc_image_set(img, TMC5160_Reg::VMAX, regs.vmax);
+}
+
+bool apply_settings_diff(const MotorSettings &settings) {
+    // Чип не инициализирован или сбросился (тень недостоверна) - только полная инициализация
+    if (!tmc_initialized || motor_ptr == nullptr) return false;
+    const char *error = ramp_profile_validate(get_ramp_profile(settings));
+    if (error) {
+        add_log("❌ Ramp profile rejected: " + String(error));
+        return false;
+    }
+
+    uint32_t start_us = micros();
+    motor.lockBus();
+    TMC5160_Reg::GSTAT_Register gstat = {0};
+    gstat.value = motor.readRegisterDirect(TMC5160_Reg::GSTAT);
+    if (gstat.reset) {
+        motor.unlockBus();
+        return false;
+    }
+
+    leave_jog_mode();
+    if (settings.spi_clock_hz != 0 && settings.spi_clock_hz != motor.getSpiClock()) {
+        motor.setSpiClock(settings.spi_clock_hz);
+    }
+
+    TmcConfigImage img;
+    build_config_image(settings, img);
+    TmcConfigDiff diff = tmc_config_apply(img, config_peek, config_poke, nullptr);
+    motor.unlockBus();
+
+    requested_current_mA = settings.current_mA;
+    requested_hold_multiplier = settings.hold_multiplier;
+    set_programmed_usteps_per_step(microsteps_to_mres(settings.microsteps));
+    fault_monitor_set_stall_routed(settings.stallguard_threshold != 0);
+
+    last_config_apply.differential = true;
+    last_config_apply.compared = diff.compared;
+    last_config_apply.written = diff.written;
+    last_config_apply.unknown = diff.unknown;
+    last_config_apply.duration_us = micros() - start_us;
+    last_config_apply.timestamp_ms = millis();
+
+    String regs;
+    for (uint8_t i = 0; i < diff.written; i++) {
+        if (i) regs += ",";
+        regs += TMC5160_ShadowSPI::regName(diff.written_addr[i]);
+    }
+    add_log("⚙️ Settings applied: " + String(diff.written) + "/" + String(diff.compared) + " registers written in " +
+            String(last_config_apply.duration_us) + " µs, position kept" + (diff.written ? " (" + regs + ")" : String("")));
+    return true;
+}
+
+void note_full_config_apply(uint32_t duration_us) {
+    last_config_apply.differential = false;
+    last_config_apply.compared = 0;
+    last_config_apply.written = 0;
+    last_config_apply.unknown = 0;
+    last_config_apply.duration_us = duration_us;
+    last_config_apply.timestamp_ms = millis();
+}
+
+ConfigApplyStats get_config_apply_stats() {
+    return last_config_apply;
+}
+
+// ===== ШЕСТИТОЧЕЧНАЯ РАМПА =====
+
+RampProfile get_ramp_profile(const MotorSettings &settings) {
+    RampProfile p;
+    p.vstart = settings.vstart;
+    p.a1 = settings.a1;
+    p.v1 = settings.v1;
+    p.amax = settings.acceleration;
+    p.vmax = settings.max_speed;
+    p.dmax = settings.deceleration;
+    p.d1 = settings.d1;
+    p.vstop = settings.vstop;
+    return p;
+}
+
+bool apply_ramp_profile(const RampProfile &profile) {
+    if (motor_ptr == nullptr) return false;
+
+    const char *error = ramp_profile_validate(profile);
+    if (error) {
+        add_log("❌ Ramp profile rejected: " + String(error));
+        return false;
+    }
+
+    RampRegisters regs;
+    ramp_profile_to_registers(profile, TMC5160_FCLK, TMC_LIB_USTEPS_PER_STEP, regs);
+
+    // Все восемь регистров - под одним захватом шины: опрос статуса из другой задачи
+    // не увидит полуприменённую рампу. VMAX последним - новая скорость стартует с новой рампой.
+    motor.lockBus();
+    motor.writeRegister(TMC5160_Reg::VSTART, regs.vstart);
+    motor.writeRegister(TMC5160_Reg::A1, regs.a1);
+    motor.writeRegister(TMC5160_Reg::V1, regs.v1);
+    motor.writeRegister(TMC5160_Reg::AMAX, regs.amax);
+    motor.writeRegister(TMC5160_Reg::DMAX, regs.dmax);
+    motor.writeRegister(TMC5160_Reg::D1, regs.d1);
+    motor.writeRegister(TMC5160_Reg::VSTOP, regs.vstop);
+    motor.writeRegister(TMC5160_Reg::VMAX, regs.vmax);
+    motor.unlockBus();
+    return true;
+}
+
+uint8_t load_motion_segment(const RampRegisters &regs, int32_t target) {
+    TmcConfigImage img;
+    tmc_image_clear(img);
+    tmc_image_set(img, TMC5160_Reg::VSTART, regs.vstart);
+    tmc_image_set(img, TMC5160_Reg::A1, regs.a1);
+    tmc_image_set(img, TMC5160_Reg::V1, regs.v1);
+    tmc_image_set(img, TMC5160_Reg::AMAX, regs.amax);
+    tmc_image_set(img, TMC5160_Reg::DMAX, regs.dmax);
+    tmc_image_set(img, TMC5160_Reg::D1, regs.d1);
+    tmc_image_set(img, TMC5160_Reg::VSTOP, regs.vstop);
+    tmc_image_set(img, TMC5160_Reg::VMAX, regs.vmax);
+    tmc_image_set(img, TMC5160_Reg::XTARGET, (uint32_t)target);
+
+    motor.lockBus();
+    TmcConfigDiff diff = tmc_config_apply(img, config_peek, config_poke, nullptr);
+    motor.unlockBus();
+    return diff.written;
+}
+
+// ===== РЕЖИМ СКОРОСТИ (JOG) =====
+// RAMPMODE 1/2: чип сам разгоняется/тормозит с AMAX до VMAX, смена скорости и
+// направления - просто запись VMAX/RAMPMODE без остановки рампы.
+
+bool set_jog_speed(int32_t speed) {
+    if (!tmc_initialized || !motor_enabled) return false;
+    if (currentSettings.control_mode != MODE_MOTION_CONTROLLER) return false;
+    if (speed == 0 && !jog_active) return true;
+
+    uint32_t abs_speed = speed < 0 ? (uint32_t)(-(int64_t)speed) : (uint32_t)speed;
+    if (abs_speed > MAX_SPEED_STEPS) abs_speed = MAX_SPEED_STEPS;
+    uint32_t vmax = ramp_speed_to_vmax(abs_speed, TMC5160_FCLK, TMC_LIB_USTEPS_PER_STEP);
+
+    motor.lockBus();
+    if (!jog_active) {
+        // В режиме скорости A1/V1/D1 не используются - разгон и торможение только AMAX
+        RampRegisters regs;
+        ramp_profile_to_registers(get_ramp_profile(currentSettings), TMC5160_FCLK, TMC_LIB_USTEPS_PER_STEP, regs);
+        motor.writeRegister(TMC5160_Reg::VSTART, regs.vstart);
+        motor.writeRegister(TMC5160_Reg::AMAX, regs.amax);
+    }
+    // VMAX раньше RAMPMODE: при смене направления чип тормозит и разгоняется уже к новой скорости
+    motor.writeRegister(TMC5160_Reg::VMAX, vmax);
+    if (speed != 0) motor.writeRegister(TMC5160_Reg::RAMPMODE, speed < 0 ? 2 : 1);
+    motor.unlockBus();
+
+    if (!jog_active) add_log("🎚️ Jog mode: " + String(speed) + " steps/s");
+    jog_target_speed = speed < 0 ? -(int32_t)abs_speed : (int32_t)abs_speed;
+    jog_active = true;
+    return true;
+}
+
+void leave_jog_mode() {
+    if (!jog_active) return;
+    jog_active = false;
+    jog_target_speed = 0;
+    if (!tmc_initialized) return;
+
+    // XTARGET = XACTUAL до возврата в позиционирование - иначе мотор поедет к старой цели
+    motor.lockBus();
+    uint32_t xactual = motor.readRegisterDirect(TMC5160_Reg::XACTUAL);
+    motor.writeRegister(TMC5160_Reg::XTARGET, xactual);
+    motor.writeRegister(TMC5160_Reg::RAMPMODE, 0);
+    apply_ramp_profile(get_ramp_profile(currentSettings));
+    motor.unlockBus();
+    add_log("🎚️ Jog mode off, positioning restored");
+}
+
+void update_jog() {
+    if (!jog_active || jog_target_speed != 0) return;
+
+    // Цель 0 и мотор остановился - возвращаемся в режим позиционирования
+    MotionSnapshot snap = get_motion_snapshot(JOG_SNAPSHOT_MAX_AGE_MS);
+    if (snap.valid && snap.vactual == 0) leave_jog_mode();
+}
+
+bool is_jog_active() {
+    return jog_active;
+}
+
+int32_t get_jog_target_speed() {
+    return jog_target_speed;
+}
+
+// ===== АВТОНАСТРОЙКА ЧАСТОТЫ SPI =====
+
+SpiClockProbeResult spi_calibration_results[SPI_AUTOTUNE_MAX_STEPS];
+uint8_t spi_calibration_count = 0;
+
+static uint16_t probe_tmc_link(uint32_t hz, uint16_t *checks, void *ctx) {
+    motor.setSpiClock(hz);
+    return motor.probeLink(SPI_AUTOTUNE_PATTERNS, checks);
+}
+
+uint32_t calibrate_spi_clock() {
+    if (motor_ptr == nullptr) return 0;
+
+    uint32_t chosen = spi_autotune_select(SPI_AUTOTUNE_STEPS_HZ, SPI_AUTOTUNE_MAX_STEPS, SPI_AUTOTUNE_MARGIN_STEPS,
+                                          probe_tmc_link, nullptr,
+                                          spi_calibration_results, &spi_calibration_count);
+
+    if (chosen == 0) {
+        motor.setSpiClock(SPI_CLOCK_SAFE_HZ);
+        add_log("❌ SPI calibration failed - no stable clock, staying at " + String(SPI_CLOCK_SAFE_HZ) + " Hz");
+        return 0;
+    }
+
+    motor.setSpiClock(chosen);
+    add_log("✅ SPI clock calibrated: " + String(chosen) + " Hz");
+
+    if (currentSettings.spi_clock_hz != chosen) {
+        MotorSettings updated = currentSettings;
+        updated.spi_clock_hz = chosen;
+        publish_settings(updated);
+        saveMotorSettings(updated);
+    }
+    return chosen;
+}
+
+uint8_t get_spi_calibration_results(const SpiClockProbeResult **results) {
+    *results = spi_calibration_results;
+    return spi_calibration_count;
+}
+
 // ===== ФУНКЦИЯ ДВИЖЕНИЯ =====
 
-void move_motor_steps(int32_t steps, MotorControlMode mode) {
+// Проверки перед любым движением
+static bool motion_ready() {
     if (!tmc_initialized) {
         add_log("❌ TMC5160 not initialized!");
-        return;
+        return false;
     }
 
     if (!motor_enabled) {
         add_log("❌ Motor is disabled!");
+        return false;
+    }
+
+    // Проверка ошибки драйвера по SPI_STATUS - без лишнего чтения GSTAT
+    if (driver_error_flagged()) {
+        add_log("⚠️ Driver error flag set (GSTAT.drv_err) - see /api/detailed_diagnostics");
+    }
+    return true;
+}
+
+// tommag motor.stop() обнуляет VSTART и VMAX (досрочная остановка рампы): ход без своих
+// VMAX/AMAX/DMAX после остановки стоял бы на месте. VMAX - из тени, без SPI
+static bool restore_ramp_after_stop() {
+    if (motor.readRegister(TMC5160_Reg::VMAX) != 0) return true;
+    LOG_INFOF("⚙️ Ramp restored from settings after stop");
+    return apply_ramp_profile(get_ramp_profile(currentSettings));
+}
+
+void move_motor_steps(int32_t steps, MotorControlMode mode) {
+    int32_t usteps;
+    if (!usteps_from_steps(steps, programmed_usteps_per_step, &usteps)) {
+        add_log("❌ Move too long: " + String(steps) + " steps");
         return;
     }
+    move_relative_usteps(usteps, mode);
+}
+
+bool move_relative_usteps(int32_t usteps, MotorControlMode mode) {
+    if (!motion_ready()) return false;
+    if (!usteps_move_valid(usteps)) {
+        add_log("❌ Move too long: " + String(usteps) + " µsteps");
+        return false;
+    }
+
+    // Относительное движение отменяет режим скорости
+    leave_jog_mode();
 
-    add_log("🚀 Moving: " + String(steps) + " steps (" + 
-            String(mode == MODE_MOTION_CONTROLLER ? "SPI" : "STEP/DIR") + ")");
+    LOG_INFOF("🚀 Moving: %ld µsteps (%s)", (long)usteps, mode == MODE_MOTION_CONTROLLER ? "SPI" : "STEP/DIR");
 
     if (mode == MODE_MOTION_CONTROLLER) {
-        // Motion Controller Mode (КАК В ПРИМЕРЕ!)
-        float current_pos = motor.getCurrentPosition();
-        float target_pos = current_pos + steps;
-        
-        motor.setTargetPosition(target_pos);  // КАК В ПРИМЕРЕ!
-        add_log("✅ SPI Motion: steps=" + String(steps) + ", target=" + String(target_pos));
+        if (!restore_ramp_after_stop()) return false;
+        // Цель = XACTUAL + ход по модулю 2^32: без float (точность 24 бита) и без UB на ±2^31
+        int32_t current = read_position_usteps();
+        int32_t target = usteps_add(current, usteps);
+        motor.writeRegister(TMC5160_Reg::XTARGET, (uint32_t)target);
+        move_events_begin(mode);
+        LOG_DEBUGF("✅ SPI Motion: usteps=%ld, target=%ld", (long)usteps, (long)target);
         
     } else {
-        // STEP/DIR Mode
-        bool forward = (steps >= 0);
-        int32_t abs_steps = abs(steps);
-        digitalWrite(DIR_PIN, forward ? HIGH : LOW);
-        
-        // Плавный разгон/торможение
-        uint32_t min_delay = 160;
-        uint32_t max_delay = 1000;
-        uint32_t accel_steps = 200;
-        uint32_t decel_steps = 200;
-        
-        for (int32_t i = 0; i < abs_steps; i++) {
-            uint32_t delay_us;
-            if (i < accel_steps) {
-                delay_us = max_delay - ((max_delay - min_delay) * i / accel_steps);
-            } else if (i > abs_steps - decel_steps) {
-                int32_t decel_i = abs_steps - i;
-                delay_us = max_delay - ((max_delay - min_delay) * decel_i / decel_steps);
-            } else {
-                delay_us = min_delay;
-            }
-            
-        digitalWrite(STEP_PIN, HIGH);
-            delayMicroseconds(delay_us);
-        digitalWrite(STEP_PIN, LOW);
-            delayMicroseconds(delay_us);
+        // STEP/DIR Mode: импульсы генерирует RMT в целых шагах, функция сразу возвращается
+        int32_t per_step = (int32_t)programmed_usteps_per_step;
+        int32_t steps = usteps / per_step;
+        if (usteps % per_step) {
+            LOG_WARNF("⚠️ STEP/DIR: fractional step dropped (%ld µsteps → %ld steps)", (long)usteps, (long)steps);
         }
-        add_log("✅ Completed: " + String(abs_steps) + " steps");
+        if (!step_pulse_start(steps, currentSettings.max_speed, currentSettings.acceleration, currentSettings.deceleration)) {
+            LOG_ERRORF("❌ STEP/DIR: pulse engine busy or not initialized");
+            return false;
+        }
+        move_events_begin(mode);
+        LOG_DEBUGF("✅ STEP/DIR: %ld steps queued to RMT, expected %lu ms", (long)steps,
+                   (unsigned long)get_step_pulse_stats().last_expected_ms);
+    }
+    return true;
+}
+
+bool move_absolute_usteps(int32_t target) {
+    if (!motion_ready()) return false;
+    if ((MotorControlMode)currentSettings.control_mode != MODE_MOTION_CONTROLLER) {
+        add_log("❌ Absolute moves need Motion Controller mode");
+        return false;
+    }
+
+    leave_jog_mode();
+    if (!restore_ramp_after_stop()) return false;
+
+    // Генератор рампы едет к XTARGET кратчайшим путём по модулю 2^32 - тот же путь и в логе
+    int32_t current = read_position_usteps();
+    motor.writeRegister(TMC5160_Reg::XTARGET, (uint32_t)target);
+    move_events_begin(MODE_MOTION_CONTROLLER);
+    LOG_INFOF("✅ SPI Motion: target=%ld (%ld µsteps)", (long)target, (long)usteps_diff(target, current));
+    return true;
+}
+
+int32_t read_position_usteps() {
+    if (!tmc_initialized) return 0;
+    return (int32_t)motor.readRegisterDirect(TMC5160_Reg::XACTUAL);
+}
+
+// RAMPMODE=3 (hold) на время записи, чтобы расхождение XACTUAL/XTARGET между записями
+// не запустило движение. Счётчик переходов через ±2^31 начинается заново
+void set_position_usteps(int32_t position) {
+    if (!tmc_initialized) return;
+    leave_jog_mode();
+    motor.lockBus();
+    motor.writeRegister(TMC5160_Reg::RAMPMODE, 3);
+    motor.writeRegister(TMC5160_Reg::XACTUAL, (uint32_t)position);
+    motor.writeRegister(TMC5160_Reg::XTARGET, (uint32_t)position);
+    motor.writeRegister(TMC5160_Reg::RAMPMODE, 0);
+    motor.unlockBus();
+
+    portENTER_CRITICAL(&motion_snapshot_mux);
+    usteps_unwrap_reset(position_unwrap, position);
+    portEXIT_CRITICAL(&motion_snapshot_mux);
+    angle_carry_valid = false;
+}
+
+int32_t steps_from_usteps(int32_t usteps) {
+    return usteps_to_steps(usteps, programmed_usteps_per_step);
+}
+
+uint32_t get_usteps_per_step() {
+    return programmed_usteps_per_step;
+}
+
+// ===== УГЛОВЫЕ ХОДЫ =====
+
+// STEP/DIR считает целые шаги - там остаток ведётся в шагах, иначе в микрошагах
+static bool angle_units_for(MotorControlMode mode, AngleUnits &units) {
+    uint32_t per_step = mode == MODE_MOTION_CONTROLLER ? programmed_usteps_per_step : 1;
+    if (!angle_units_make(currentSettings.steps_per_rev, per_step, currentSettings.gear_ratio, units)) {
+        add_log("❌ Invalid angle units: steps_per_rev=" + String(currentSettings.steps_per_rev) +
+                ", gear_ratio=" + String(currentSettings.gear_ratio, 4));
+        return false;
+    }
+    if (!angle_carry_valid || !angle_units_equal(units, angle_units)) {
+        angle_units = units;
+        angle_carry_reset(angle_units, angle_carry);
+        angle_carry_valid = true;
+    }
+    return true;
+}
+
+bool get_angle_units(AngleUnits &units) {
+    // Вызывается и из AsyncTCP (статус) - поля из одной версии настроек
+    MotorSettings settings = get_settings_snapshot();
+    return angle_units_make(settings.steps_per_rev, programmed_usteps_per_step, settings.gear_ratio, units);
+}
+
+bool move_angle_mdeg(int64_t mdeg, MotorControlMode mode) {
+    AngleUnits units;
+    if (!angle_units_for(mode, units)) return false;
+
+    // Остаток меняется только если ход действительно начнётся
+    AngleCarry carry = angle_carry;
+    int32_t amount;
+    if (!angle_move_relative(units, carry, mdeg, &amount)) {
+        add_log("❌ Angle move too long: " + String((double)mdeg / 1000.0, 3) + "°");
+        return false;
+    }
+    // STEP/DIR: остаток в шагах, ход в шагах помещается в int32, а в микрошагах - не обязательно
+    int32_t usteps = amount;
+    if (mode != MODE_MOTION_CONTROLLER && !usteps_from_steps(amount, programmed_usteps_per_step, &usteps)) {
+        add_log("❌ Angle move too long: " + String((double)mdeg / 1000.0, 3) + "°");
+        return false;
     }
+    if (!move_relative_usteps(usteps, mode)) return false;
+    angle_carry = carry;
+    return true;
+}
+
+bool move_to_angle_mdeg(int64_t mdeg) {
+    AngleUnits units;
+    if (!angle_units_for(MODE_MOTION_CONTROLLER, units)) return false;
+
+    AngleCarry carry = angle_carry;
+    int32_t target;
+    if (!angle_target_absolute(units, carry, mdeg, &target)) {
+        add_log("❌ Angle target out of range: " + String((double)mdeg / 1000.0, 3) + "°");
+        return false;
+    }
+    if (!move_absolute_usteps(target)) return false;
+    angle_carry = carry;
+    return true;
 }
 
 // ===== ENABLE/DISABLE =====
@@ -243,6 +744,9 @@ void enable_motor() {
         return;
     }
 
+    // После отключения по ошибке - только если она снята
+    if (!fault_monitor_rearm()) return;
+
     motor.enable();  // КАК В ПРИМЕРЕ!
     digitalWrite(EN_PIN, LOW);  // Активный LOW
     motor_enabled = true;
@@ -261,90 +765,19 @@ void disable_motor() {
 // ===== LOOP FUNCTIONS =====
 
 void run_motor() {
-    // Не используется в STEP/DIR режиме
-}
-
-void test_step_dir_mode() {
-    if (!tmc_initialized || !motor_enabled) {
-        add_log("❌ TMC5160 not ready for test!");
-        return;
-    }
-    
-    add_log("🧪 Testing STEP/DIR mode...");
-    
-    // Тест вперёд
-    add_log("🧪 Test: 100 steps FORWARD");
-    digitalWrite(DIR_PIN, HIGH);
-    delay(10);
-    
-    for (int i = 0; i < 100; i++) {
-        digitalWrite(STEP_PIN, HIGH);
-        delayMicroseconds(160);
-        digitalWrite(STEP_PIN, LOW);
-        delayMicroseconds(160);
-    }
-    
-    add_log("✅ Forward test complete");
-    delay(1000);
-    
-    // Тест назад
-    add_log("🧪 Test: 100 steps BACKWARD");
-    digitalWrite(DIR_PIN, LOW);
-    delay(10);
-    
-    for (int i = 0; i < 100; i++) {
-        digitalWrite(STEP_PIN, HIGH);
-        delayMicroseconds(160);
-        digitalWrite(STEP_PIN, LOW);
-        delayMicroseconds(160);
-    }
-    
-    add_log("✅ Backward test complete");
-    add_log("✅ STEP/DIR mode test passed!");
-}
-
-// ===== CENTER SEQUENCE =====
+    if (!tmc_initialized) return;
 
-void update_center_sequence() {
-    if (!center_sequence_active) return;
-    
-    unsigned long current_time = millis();
-    MotorControlMode mode = (MotorControlMode)currentSettings.control_mode;
-    
-    switch (sequence_step) {
-        case 0:
-            if (current_time - sequence_start_time >= sequence_delay) {
-                move_motor_steps(1000, mode);
-                sequence_step = 1;
-                sequence_start_time = current_time;
-                add_log("🎯 Center sequence: Step 1 - Right");
-            }
-            break;
-            
-        case 1:
-            if (current_time - sequence_start_time >= sequence_delay) {
-                move_motor_steps(-1000, mode);
-                sequence_step = 2;
-                sequence_start_time = current_time;
-                add_log("🎯 Center sequence: Step 2 - Left");
-            }
-            break;
-            
-        case 2:
-            if (current_time - sequence_start_time >= sequence_delay) {
-                move_motor_steps(1000, mode);
-                sequence_step = 3;
-                sequence_start_time = current_time;
-                add_log("🎯 Center sequence: Step 3 - Return to center");
-            }
-            break;
-            
-        case 3:
-            if (current_time - sequence_start_time >= sequence_delay) {
-                center_sequence_active = false;
-                add_log("✅ Center sequence completed");
-            }
-            break;
+    // Флаг сброса в SPI_STATUS последней датаграммы - бесплатно, без чтения регистров
+    uint8_t status;
+    if (motor.getSpiStatus(motor.getShadowMaxAge(), &status) && (status & SPI_STATUS_RESET_FLAG)) {
+        // Подтверждаем чтением GSTAT (байт мог остаться от датаграммы до очистки флагов)
+        TMC5160_Reg::GSTAT_Register gstat = {0};
+        gstat.value = motor.readRegisterDirect(TMC5160_Reg::GSTAT);
+        if (gstat.reset) {
+            driver_reset_count++;
+            motor.invalidateShadow();
+            add_log("⚠️ TMC5160 reset detected (VM power loss?) - registers at defaults, re-apply settings");
+        }
     }
 }
 
@@ -352,28 +785,89 @@ bool position_reached() {
     if (!tmc_initialized) return true;
     if (!motor_enabled) return true;  // Если мотор выключен, считаем что достигли цели
 
+    // Движение, запущенное move_motor_steps(), завершается событием (move_events.cpp)
+    if (move_in_flight()) return false;
+
+    // SPI_STATUS последней датаграммы: position_reached = XACTUAL == XTARGET, значит стоим
+    uint8_t status;
+    if (motor.getSpiStatus(motor.getShadowMaxAge(), &status) && (status & SPI_STATUS_POSITION_REACHED)) {
+        spi_status_reads_saved++;
+        return true;
+    }
+
     // Проверяем ТОЛЬКО скорость (не позицию, т.к. после stop() target не сбрасывается)
-    int32_t vactual = motor.getCurrentSpeed();
+    const MotionSnapshot &snap = get_motion_snapshot(motor.getShadowMaxAge());
 
     // Если скорость = 0, значит НЕ движется
-    return (abs(vactual) < 1);
+    return (abs(snap.vactual) < 1);
 }
 
-void start_center_sequence() {
-    if (!tmc_initialized || !motor_enabled) {
-        add_log("❌ Cannot start center sequence - motor not ready");
-        return;
+bool position_reached_cached(const MotionSnapshot &snap) {
+    if (!tmc_initialized || !motor_enabled) return true;
+    if (move_in_flight()) return false;
+
+    uint8_t status;
+    if (motor.getSpiStatus(motor.getShadowMaxAge(), &status) && (status & SPI_STATUS_POSITION_REACHED)) return true;
+    return abs(snap.vactual) < 1;
+}
+
+bool driver_error_flagged() {
+    if (!tmc_initialized) return false;
+
+    uint8_t status;
+    if (motor.getSpiStatus(motor.getShadowMaxAge(), &status)) {
+        spi_status_reads_saved++;
+        return (status & SPI_STATUS_DRIVER_ERROR) != 0;
     }
-    
-    center_sequence_active = true;
-    sequence_step = 0;
-    sequence_start_time = millis();
-    add_log("🎯 Center sequence started");
+
+    TMC5160_Reg::GSTAT_Register gstat = {0};
+    gstat.value = motor.readRegister(TMC5160_Reg::GSTAT);
+    return gstat.drv_err;
+}
+
+// ===== СНИМОК ДВИЖЕНИЯ =====
+
+bool read_motion_snapshot(MotionSnapshot &snap) {
+    if (!tmc_initialized) {
+        snap = {};
+        return false;
+    }
+
+    uint32_t values[MOTION_SNAPSHOT_REG_COUNT];
+    motor.readRegisterBurst(MOTION_SNAPSHOT_REGS, values, MOTION_SNAPSHOT_REG_COUNT);
+
+    snap.xactual = (int32_t)values[0];
+    snap.xtarget = (int32_t)values[1];
+    snap.vactual = usteps_vactual_from_register(values[2]);
+    snap.ramp_stat = values[3];
+    snap.drv_status = values[4];
+    snap.gstat = values[5];
+    snap.timestamp_ms = millis();
+    snap.valid = true;
+
+    portENTER_CRITICAL(&motion_snapshot_mux);
+    usteps_unwrap(position_unwrap, snap.xactual);
+    snap.wraps = position_unwrap.wraps;
+    last_motion_snapshot = snap;
+    portEXIT_CRITICAL(&motion_snapshot_mux);
+    return true;
 }
 
-void stop_center_sequence() {
-    center_sequence_active = false;
-    add_log("🛑 Center sequence stopped");
+MotionSnapshot peek_motion_snapshot() {
+    MotionSnapshot snap;
+    portENTER_CRITICAL(&motion_snapshot_mux);
+    snap = last_motion_snapshot;
+    portEXIT_CRITICAL(&motion_snapshot_mux);
+    return snap;
+}
+
+MotionSnapshot get_motion_snapshot(uint32_t max_age_ms) {
+    MotionSnapshot snap = peek_motion_snapshot();
+
+    if (!snap.valid || (millis() - snap.timestamp_ms) >= max_age_ms) {
+        read_motion_snapshot(snap);
+    }
+    return snap;
 }
 
 // ===== STATUS FUNCTIONS =====
@@ -390,7 +884,9 @@ String get_movement_status() {
 
 int32_t get_current_speed() {
     if (!tmc_initialized) return 0;
-    return (int32_t)motor.getCurrentSpeed();  // КАК В ПРИМЕРЕ!
+    // VACTUAL из снимка, целочисленно: микрошаги/с → шаги/с
+    const MotionSnapshot &snap = get_motion_snapshot(JOG_SNAPSHOT_MAX_AGE_MS);
+    return usteps_rate_from_vactual(snap.vactual, TMC5160_FCLK) / (int32_t)TMC_LIB_USTEPS_PER_STEP;
 }
 
 uint32_t get_driver_status() {
@@ -444,9 +940,11 @@ String get_detailed_diagnostics() {
     diag += "\n";
 
     // 4. Позиция и скорость
-    diag += "Position: " + String(motor.getCurrentPosition()) + " steps\n";
-    diag += "Target: " + String(motor.getTargetPosition()) + " steps\n";
-    diag += "Speed: " + String(motor.getCurrentSpeed()) + " steps/s\n";
+    MotionSnapshot snap = {};
+    read_motion_snapshot(snap);
+    diag += "Position: " + String(steps_from_usteps(snap.xactual)) + " steps (" + String(snap.xactual) + " µsteps)\n";
+    diag += "Target: " + String(steps_from_usteps(snap.xtarget)) + " steps (" + String(snap.xtarget) + " µsteps)\n";
+    diag += "Speed: " + String(usteps_rate_from_vactual(snap.vactual, TMC5160_FCLK)) + " µsteps/s\n";
     diag += "\n";
 
     // 5. Ток
@@ -468,10 +966,15 @@ void set_motor_current(uint16_t current_mA, float hold_multiplier) {
         return;
     }
 
-    // Пересчитываем irun/ihold
+    requested_current_mA = current_mA;
+    requested_hold_multiplier = hold_multiplier;
+
+    // Пересчитываем irun/ihold (драйвер перегрет - доля тока, см. health_monitor.h)
+    uint8_t percent = get_derate_percent();
+    uint16_t effective_mA = derate_current(current_mA, percent);
     uint8_t irun, ihold;
     uint16_t globalScaler;
-    calculate_current_settings(current_mA, hold_multiplier, &irun, &ihold, &globalScaler);
+    calculate_current_settings(effective_mA, hold_multiplier, &irun, &ihold, &globalScaler);
 
     // Записываем в регистры
     motor.writeRegister(TMC5160_Reg::GLOBAL_SCALER, globalScaler);
@@ -479,7 +982,16 @@ void set_motor_current(uint16_t current_mA, float hold_multiplier) {
     uint32_t ihold_irun = (ihold << 0) | (irun << 8) | (7 << 16);  // iholddelay=7
     motor.writeRegister(TMC5160_Reg::IHOLD_IRUN, ihold_irun);
 
-    add_log("🔧 Current updated: " + String(current_mA) + "mA (irun=" + String(irun) + ", ihold=" + String(ihold) + ")");
+    add_log("🔧 Current updated: " + String(effective_mA) + "mA (irun=" + String(irun) + ", ihold=" + String(ihold) + ")" +
+            (percent < 100 ? " - derated to " + String(percent) + "% of " + String(current_mA) + "mA" : String("")));
+}
+
+void reapply_motor_current() {
+    set_motor_current(requested_current_mA, requested_hold_multiplier);
+}
+
+uint16_t get_requested_motor_current() {
+    return requested_current_mA;
 }
 
 uint16_t get_motor_current() {
@@ -524,28 +1036,23 @@ String get_current_diagnostics() {
 // STALLGUARD ФУНКЦИИ
 // ============================================================================
 
-// Прерывание при срабатывании StallGuard
-void IRAM_ATTR stallguard_isr() {
-    stallguard_triggered = true;
-}
-
 // Настройка StallGuard
-void setup_stallguard(int8_t threshold) {
+void setup_stallguard(int8_t threshold, uint32_t tcoolthrs) {
     if (!tmc_initialized) {
         add_log("❌ Cannot setup StallGuard - TMC not initialized");
         return;
     }
     
     if (threshold == 0) {
-        // Выключаем StallGuard
-        detachInterrupt(digitalPinToInterrupt(DIAG_PIN));
+        // Выключаем StallGuard на DIAG0 - прерывание остаётся для ошибок драйвера
+        motor.lockBus();
+        motor.writeRegister(TMC5160_Reg::GCONF, motor.readRegister(TMC5160_Reg::GCONF) & ~(1UL << 7));
+        motor.unlockBus();
+        fault_monitor_set_stall_routed(false);
         add_log("🔇 StallGuard disabled");
         return;
     }
     
-    // Настраиваем DIAG пин как вход с подтяжкой вниз
-    pinMode(DIAG_PIN, INPUT_PULLDOWN);
-    
     // Настраиваем StallGuard через регистры
     // COOLCONF: настройка StallGuard
     uint32_t coolconf = motor.readRegister(TMC5160_Reg::COOLCONF);
@@ -554,12 +1061,17 @@ void setup_stallguard(int8_t threshold) {
     motor.writeRegister(TMC5160_Reg::COOLCONF, coolconf);
     
     // TCOOLTHRS: порог скорости для StallGuard (работает только выше этой скорости)
-    motor.writeRegister(TMC5160_Reg::TCOOLTHRS, 0xFFFFF);  // Всегда активен
+    motor.writeRegister(TMC5160_Reg::TCOOLTHRS, tcoolthrs & 0xFFFFF);
+
+    // GCONF: stall на DIAG0 (diag0_stall, бит 7), push-pull активный HIGH (бит 12) - под RISING ниже
+    uint32_t gconf = motor.readRegister(TMC5160_Reg::GCONF);
+    gconf |= (1UL << 7) | (1UL << 12);
+    motor.writeRegister(TMC5160_Reg::GCONF, gconf);
     
-    // Настраиваем прерывание на DIAG пин
-    attachInterrupt(digitalPinToInterrupt(DIAG_PIN), stallguard_isr, RISING);
+    // Фронт DIAG0 теперь может быть stall - ошибку отличает задача ошибок по DRV_STATUS
+    fault_monitor_set_stall_routed(true);
     
-    add_log("✅ StallGuard enabled, threshold: " + String(threshold));
+    add_log("✅ StallGuard enabled, threshold: " + String(threshold) + ", TCOOLTHRS: " + String(tcoolthrs & 0xFFFFF));
 }
 
 // Проверка флага StallGuard
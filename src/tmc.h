@@ -5,21 +5,55 @@
 #include "pins.h"
 #include "config.h"
 #include "api_types.h"
+#include "tmc_spi.h"
+#include "ramp_profile.h"
+#include "usteps.h"
+#include "angle_units.h"
 
 // Глобальные переменные для TMC5160
-extern TMC5160_SPI *motor_ptr;  // Указатель на объект
+extern TMC5160_ShadowSPI *motor_ptr;  // Указатель на объект (SPI-слой с тенью регистров)
 extern bool tmc_initialized;
 extern bool motor_enabled;
-extern volatile bool stallguard_triggered;  // Флаг срабатывания StallGuard
+extern volatile bool stallguard_triggered;  // Фронт DIAG0 (stall или ошибка, см. fault_monitor.h)
+extern uint32_t spi_status_reads_saved;     // Сколько чтений регистров сэкономил SPI_STATUS
+extern uint32_t driver_reset_count;         // Сколько раз драйвер сбрасывался (GSTAT.reset)
 
 // Макрос для удобства обращения к motor
 #define motor (*motor_ptr)
 
+// Снимок состояния движения - читается одной конвейерной SPI-транзакцией (7 датаграмм на 6 регистров)
+struct MotionSnapshot {
+    int32_t xactual;        // Позиция (микрошаги)
+    int32_t xtarget;        // Цель (микрошаги)
+    int32_t vactual;        // Скорость (24 бита со знаком, уже расширена)
+    uint32_t ramp_stat;     // RAMP_STAT (флаги событий сбрасываются чтением!)
+    uint32_t drv_status;    // DRV_STATUS
+    uint32_t gstat;         // GSTAT (флаги сбрасываются чтением!)
+    uint32_t timestamp_ms;  // millis() момента чтения
+    int32_t wraps;          // Переходов XACTUAL через ±2^31 с последней установки позиции
+    bool valid;             // false - драйвер не инициализирован
+};
+
 // Основные функции
 void add_log(String message);
 bool setup_tmc5160(uint16_t current_mA, float hold_multiplier, uint16_t microsteps,
                    uint32_t max_speed, uint16_t accel, uint16_t decel);
 void move_motor_steps(int32_t steps, MotorControlMode mode);
+
+// Позиция в микрошагах TMC5160 (шаг = get_usteps_per_step()), int32 без float и с переходом
+// через ±2^31 (usteps.h). move_motor_steps() - обёртка над move_relative_usteps()
+bool move_relative_usteps(int32_t usteps, MotorControlMode mode);  // false - ход не начат
+bool move_absolute_usteps(int32_t target);          // Только MODE_MOTION_CONTROLLER
+int32_t read_position_usteps();                     // XACTUAL с чипа
+void set_position_usteps(int32_t position);         // XACTUAL = XTARGET = position, без движения
+int32_t steps_from_usteps(int32_t usteps);
+uint32_t get_usteps_per_step();                     // По MRES в CHOPCONF (256 >> mres)
+
+// Угол выходного вала (миллиградусы, angle_units.h): steps_per_rev · шкала шага · gear_ratio,
+// остаток дробных микрошагов переносится между ходами - повторные сегменты не накапливают ошибку
+bool move_angle_mdeg(int64_t mdeg, MotorControlMode mode);
+bool move_to_angle_mdeg(int64_t mdeg);              // От начала координат, только MODE_MOTION_CONTROLLER
+bool get_angle_units(AngleUnits &units);            // Для MODE_MOTION_CONTROLLER из currentSettings
 void enable_motor();
 void disable_motor();
 
@@ -30,12 +64,51 @@ bool validate_acceleration(uint16_t accel);
 
 // Функции для loop()
 void run_motor();
-void update_center_sequence();
 bool position_reached();
+// То же только по уже прочитанным данным (снимок + SPI_STATUS) - для AsyncTCP, без SPI
+bool position_reached_cached(const MotionSnapshot &snap);
+
+// Ошибка драйвера (GSTAT.drv_err) - по SPI_STATUS, без чтения регистров если байт свежий
+bool driver_error_flagged();
+
+// Снимок движения: read_* всегда читает с чипа, get_* отдаёт последний, если он моложе max_age_ms.
+// peek_* - последний как есть, без SPI: задача движения обновляет его каждые MOTION_POLL_PERIOD_MS
+bool read_motion_snapshot(MotionSnapshot &snap);
+MotionSnapshot get_motion_snapshot(uint32_t max_age_ms);
+MotionSnapshot peek_motion_snapshot();
+
+// Применение настроек без переинициализации: пишутся только регистры, отличные от тени
+// (ток, mres, StallGuard, рампа), позиция сохраняется. false - нужен полный setup_tmc5160
+struct ConfigApplyStats {
+    bool differential;      // false - последним был полный setup_tmc5160
+    uint8_t compared;
+    uint8_t written;
+    uint8_t unknown;        // Записано без известного значения (write-only без тени)
+    uint32_t duration_us;
+    uint32_t timestamp_ms;
+};
+bool apply_settings_diff(const MotorSettings &settings);
+void note_full_config_apply(uint32_t duration_us);
+ConfigApplyStats get_config_apply_stats();
+
+// Шеститочечная рампа: профиль из настроек и атомарная запись всех регистров рампы
+RampProfile get_ramp_profile(const MotorSettings &settings);
+bool apply_ramp_profile(const RampProfile &profile);
+// Сегмент очереди движения: регистры рампы, отличные от тени, и XTARGET последним - одной
+// группой под захватом шины. Возвращает число записанных регистров
+uint8_t load_motion_segment(const RampRegisters &regs, int32_t target);
+
+// Режим скорости (jog): RAMPMODE 1/2, скорость в шагах/с со знаком, меняется на лету.
+// Только MODE_MOTION_CONTROLLER. Цель 0 - плавная остановка, после неё update_jog()
+// возвращает режим позиционирования
+#define JOG_SNAPSHOT_MAX_AGE_MS 20
+bool set_jog_speed(int32_t speed);
+void leave_jog_mode();
+void update_jog();
+bool is_jog_active();
+int32_t get_jog_target_speed();
 
 // Дополнительные функции
-void start_center_sequence();
-void stop_center_sequence();
 String get_movement_status();
 int32_t get_current_speed();
 uint32_t get_driver_status();
@@ -43,13 +116,17 @@ String get_detailed_diagnostics();
 
 // Управление током (можно менять в реальном времени!)
 void set_motor_current(uint16_t current_mA, float hold_multiplier);
+// Ток последнего set_motor_current() заново - после смены теплового снижения
+void reapply_motor_current();
+uint16_t get_requested_motor_current();
 uint16_t get_motor_current();
 String get_current_diagnostics();
 
-// Тестовая функция
-void test_step_dir_mode();
+// Автонастройка частоты SPI (результат сохраняется в EEPROM вместе с настройками мотора)
+uint32_t calibrate_spi_clock();
+uint8_t get_spi_calibration_results(const SpiClockProbeResult **results);
 
 // StallGuard функции
-void setup_stallguard(int8_t threshold);
-void IRAM_ATTR stallguard_isr();
+// tcoolthrs - из настроек (свип SGT); хоминг держит StallGuard на любой скорости
+void setup_stallguard(int8_t threshold, uint32_t tcoolthrs = TCOOLTHRS_ALWAYS);
 bool is_stallguard_triggered();
@@ -0,0 +1,71 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================================
+// ДИФФЕРЕНЦИАЛЬНОЕ ПРИМЕНЕНИЕ КОНФИГУРАЦИИ TMC5160
+// ============================================================================
+// Желаемый образ регистров (адрес, значение, маска своих битов) сравнивается с текущим
+// (тень/чип через peek) - пишутся только отличающиеся регистры, в порядке образа.
+// Чистая логика: peek/poke - обратные вызовы, на хосте это мок-массив регистров.
+
+#define TMC_CONFIG_MAX_REGS 16
+
+struct TmcConfigEntry {
+    uint8_t address;
+    uint32_t value;
+    uint32_t mask;          // Биты, которые задаёт образ; остальные сохраняются как есть
+};
+
+struct TmcConfigImage {
+    uint8_t count;
+    TmcConfigEntry regs[TMC_CONFIG_MAX_REGS];
+};
+
+// Текущее значение регистра. false - неизвестно (WRITE_ONLY без тени) - регистр пишется
+typedef bool (*TmcRegPeek)(uint8_t address, uint32_t *value, void *ctx);
+typedef void (*TmcRegPoke)(uint8_t address, uint32_t value, void *ctx);
+
+struct TmcConfigDiff {
+    uint8_t compared;
+    uint8_t written;
+    uint8_t unknown;                            // Из записанных - без известного значения
+    uint8_t written_addr[TMC_CONFIG_MAX_REGS];
+};
+
+inline void tmc_image_clear(TmcConfigImage &img) {
+    img.count = 0;
+}
+
+// Поле регистра: повторный адрес объединяется с прежней записью (порядок - по первому)
+inline bool tmc_image_set(TmcConfigImage &img, uint8_t address, uint32_t value, uint32_t mask = 0xFFFFFFFF) {
+    for (uint8_t i = 0; i < img.count; i++) {
+        TmcConfigEntry &e = img.regs[i];
+        if (e.address != address) continue;
+        e.value = (e.value & ~mask) | (value & mask);
+        e.mask |= mask;
+        return true;
+    }
+    if (img.count >= TMC_CONFIG_MAX_REGS) return false;
+    img.regs[img.count].address = address;
+    img.regs[img.count].value = value & mask;
+    img.regs[img.count].mask = mask;
+    img.count++;
+    return true;
+}
+
+inline TmcConfigDiff tmc_config_apply(const TmcConfigImage &img, TmcRegPeek peek, TmcRegPoke poke, void *ctx) {
+    TmcConfigDiff d = {};
+    for (uint8_t i = 0; i < img.count; i++) {
+        const TmcConfigEntry &e = img.regs[i];
+        uint32_t current = 0;
+        bool known = peek(e.address, &current, ctx);
+        uint32_t desired = (current & ~e.mask) | (e.value & e.mask);
+        d.compared++;
+        if (known && desired == current) continue;
+
+        poke(e.address, desired, ctx);
+        if (!known) d.unknown++;
+        d.written_addr[d.written++] = e.address;
+    }
+    return d;
+}
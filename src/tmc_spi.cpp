@@ -0,0 +1,379 @@
+#include "tmc_spi.h"
+
+TMC5160_ShadowSPI::TMC5160_ShadowSPI(uint8_t chipSelectPin, uint32_t fclk, const SPISettings &spiSettings, SPIClass &spi)
+    : TMC5160_SPI(chipSelectPin, fclk, spiSettings, spi),
+      _bus_lock(xSemaphoreCreateRecursiveMutex()),
+      _cs_pin(chipSelectPin),
+      _spi_clock_hz(spiSettings._clock),
+      _spi_settings(spiSettings),
+      _spi_bus(&spi),
+      _datagram_count(0),
+      _ioin_errors(0),
+      _readback_errors(0),
+      _spi_status_seq(0),
+      _spi_status_ms(0),
+      _spi_status(0),
+      _max_age_ms(TMC_SHADOW_DEFAULT_MAX_AGE_MS) {
+    invalidateShadow();
+    resetShadowStats();
+}
+
+// Классификация регистров по даташиту TMC5160 (таблицы §6: R, W, RW, RC)
+TmcRegPolicy TMC5160_ShadowSPI::regPolicy(uint8_t address) {
+    switch (address) {
+        // RW регистры, которые меняем только мы
+        case TMC5160_Reg::GCONF:
+        case TMC5160_Reg::FACTORY_CONF:
+        case TMC5160_Reg::RAMPMODE:
+        case TMC5160_Reg::XTARGET:
+        case TMC5160_Reg::SW_MODE:
+        case TMC5160_Reg::ENCMODE:
+        case TMC5160_Reg::CHOPCONF:
+            return REG_CONFIG;
+
+        // Только запись - с чипа читается 0
+        case TMC5160_Reg::SLAVECONF:
+        case TMC5160_Reg::X_COMPARE:
+        case TMC5160_Reg::OTP_PROG:
+        case TMC5160_Reg::SHORT_CONF:
+        case TMC5160_Reg::DRV_CONF:
+        case TMC5160_Reg::GLOBAL_SCALER:
+        case TMC5160_Reg::IHOLD_IRUN:
+        case TMC5160_Reg::TPOWERDOWN:
+        case TMC5160_Reg::TPWMTHRS:
+        case TMC5160_Reg::TCOOLTHRS:
+        case TMC5160_Reg::THIGH:
+        case TMC5160_Reg::VSTART:
+        case TMC5160_Reg::A1:
+        case TMC5160_Reg::V1:
+        case TMC5160_Reg::AMAX:
+        case TMC5160_Reg::VMAX:
+        case TMC5160_Reg::DMAX:
+        case TMC5160_Reg::D1:
+        case TMC5160_Reg::VSTOP:
+        case TMC5160_Reg::TZEROWAIT:
+        case TMC5160_Reg::VDCMIN:
+        case TMC5160_Reg::ENC_CONST:
+        case TMC5160_Reg::ENC_DEVIATION:
+        case TMC5160_Reg::MSLUTSEL:
+        case TMC5160_Reg::MSLUTSTART:
+        case TMC5160_Reg::COOLCONF:
+        case TMC5160_Reg::DCCTRL:
+        case TMC5160_Reg::PWMCONF:
+            return REG_WRITE_ONLY;
+
+        // Только чтение (R) или сброс записью единицы (RWC) - записью значение не задаётся.
+        // По адресу IOIN запись идёт в OUTPUT, читается же состояние входов
+        case TMC5160_Reg::GSTAT:
+        case TMC5160_Reg::IFCNT:
+        case TMC5160_Reg::IO_INPUT_OUTPUT:
+        case TMC5160_Reg::OTP_READ:
+        case TMC5160_Reg::OFFSET_READ:
+        case TMC5160_Reg::TSTEP:
+        case TMC5160_Reg::VACTUAL:
+        case TMC5160_Reg::RAMP_STAT:
+        case TMC5160_Reg::XLATCH:
+        case TMC5160_Reg::ENC_STATUS:
+        case TMC5160_Reg::ENC_LATCH:
+        case TMC5160_Reg::MSCNT:
+        case TMC5160_Reg::MSCURACT:
+        case TMC5160_Reg::DRV_STATUS:
+        case TMC5160_Reg::PWM_SCALE:
+        case TMC5160_Reg::PWM_AUTO:
+        case TMC5160_Reg::LOST_STEPS:
+            return REG_STATUS;
+
+        default:
+            // MSLUT[0..7]
+            if (address >= TMC5160_Reg::MSLUT_0 && address < TMC5160_Reg::MSLUT_0 + 8) return REG_WRITE_ONLY;
+            // Остальное (XACTUAL, X_ENC...) пишем мы, но меняет и сам драйвер
+            return REG_VOLATILE;
+    }
+}
+
+const char* TMC5160_ShadowSPI::regName(uint8_t address) {
+    switch (address) {
+        case TMC5160_Reg::GCONF: return "GCONF";
+        case TMC5160_Reg::GSTAT: return "GSTAT";
+        case TMC5160_Reg::IO_INPUT_OUTPUT: return "IOIN";
+        case TMC5160_Reg::GLOBAL_SCALER: return "GLOBAL_SCALER";
+        case TMC5160_Reg::IHOLD_IRUN: return "IHOLD_IRUN";
+        case TMC5160_Reg::TCOOLTHRS: return "TCOOLTHRS";
+        case TMC5160_Reg::RAMPMODE: return "RAMPMODE";
+        case TMC5160_Reg::XACTUAL: return "XACTUAL";
+        case TMC5160_Reg::VACTUAL: return "VACTUAL";
+        case TMC5160_Reg::VSTART: return "VSTART";
+        case TMC5160_Reg::A1: return "A1";
+        case TMC5160_Reg::V1: return "V1";
+        case TMC5160_Reg::AMAX: return "AMAX";
+        case TMC5160_Reg::VMAX: return "VMAX";
+        case TMC5160_Reg::DMAX: return "DMAX";
+        case TMC5160_Reg::D1: return "D1";
+        case TMC5160_Reg::VSTOP: return "VSTOP";
+        case TMC5160_Reg::XTARGET: return "XTARGET";
+        case TMC5160_Reg::SW_MODE: return "SW_MODE";
+        case TMC5160_Reg::RAMP_STAT: return "RAMP_STAT";
+        case TMC5160_Reg::CHOPCONF: return "CHOPCONF";
+        case TMC5160_Reg::COOLCONF: return "COOLCONF";
+        case TMC5160_Reg::DRV_STATUS: return "DRV_STATUS";
+        case TMC5160_Reg::PWMCONF: return "PWMCONF";
+        default: return "REG";
+    }
+}
+
+void TMC5160_ShadowSPI::storeShadow(uint8_t address, uint32_t value, uint32_t now_ms) {
+    _value[address] = value;
+    _stamp_ms[address] = now_ms;
+    _valid[address] = true;
+}
+
+// ===== НИЗКИЙ УРОВЕНЬ: ДАТАГРАММЫ =====
+
+uint8_t TMC5160_ShadowSPI::transferDatagram(uint8_t address, uint32_t data, uint32_t *reply) {
+    digitalWrite(_cs_pin, LOW);
+    uint8_t status = _spi_bus->transfer(address);
+    uint32_t value = 0;
+    value |= (uint32_t)_spi_bus->transfer((data >> 24) & 0xFF) << 24;
+    value |= (uint32_t)_spi_bus->transfer((data >> 16) & 0xFF) << 16;
+    value |= (uint32_t)_spi_bus->transfer((data >> 8) & 0xFF) << 8;
+    value |= (uint32_t)_spi_bus->transfer(data & 0xFF);
+    digitalWrite(_cs_pin, HIGH);
+    _datagram_count++;
+    storeSpiStatus(status, millis());
+
+    if (reply) *reply = value;
+    return status;
+}
+
+uint32_t TMC5160_ShadowSPI::readRaw(uint8_t address) {
+    uint32_t value = 0;
+    _spi_bus->beginTransaction(_spi_settings);
+    transferDatagram(address, 0, nullptr);   // запрос
+    delayMicroseconds(1);                    // мин. время CSN high (2 tclk + 10ns)
+    transferDatagram(address, 0, &value);    // ответ на запрос
+    _spi_bus->endTransaction();
+
+    // Каждое чтение IOIN - бесплатная проверка канала по версии чипа
+    if (address == TMC5160_Reg::IO_INPUT_OUTPUT && (value >> 24) != TMC5160::IC_VERSION) {
+        _ioin_errors++;
+    }
+    return value;
+}
+
+void TMC5160_ShadowSPI::readRegisterBurst(const uint8_t *addresses, uint32_t *values, uint8_t count) {
+    if (count == 0) return;
+    BusLock lock(_bus_lock);
+
+    _spi_bus->beginTransaction(_spi_settings);
+    transferDatagram(addresses[0], 0, nullptr);
+    for (uint8_t i = 1; i < count; i++) {
+        delayMicroseconds(1);
+        transferDatagram(addresses[i], 0, &values[i - 1]);
+    }
+    // Последний ответ забираем безвредным адресом (IOIN не сбрасывается чтением, в отличие от GSTAT/RAMP_STAT)
+    delayMicroseconds(1);
+    transferDatagram(TMC5160_Reg::IO_INPUT_OUTPUT, 0, &values[count - 1]);
+    _spi_bus->endTransaction();
+
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < count; i++) {
+        if (addresses[i] < TMC_REG_COUNT && regPolicy(addresses[i]) != REG_WRITE_ONLY) {
+            _misses[addresses[i]]++;
+            storeShadow(addresses[i], values[i], now);
+        }
+    }
+}
+
+// ===== ЧАСТОТА SPI И ЦЕЛОСТНОСТЬ КАНАЛА =====
+
+void TMC5160_ShadowSPI::setSpiClock(uint32_t hz) {
+    BusLock lock(_bus_lock);
+    _spi_clock_hz = hz;
+    _spi_settings = SPISettings(hz, MSBFIRST, SPI_MODE3);
+}
+
+uint16_t TMC5160_ShadowSPI::probeLink(uint16_t patterns, uint16_t *checks) {
+    static const uint32_t PATTERNS[] = {
+        0xAAAAAAAA, 0x55555555, 0xFFFFFFFF, 0x00000000,
+        0x80000001, 0x7FFFFFFE, 0x12345678, 0xEDCBA987
+    };
+    const uint8_t pattern_count = sizeof(PATTERNS) / sizeof(PATTERNS[0]);
+
+    BusLock lock(_bus_lock);
+
+    uint16_t errors = 0;
+    uint16_t done = 0;
+
+    uint32_t saved_x_enc = readRaw(TMC5160_Reg::X_ENC);
+
+    for (uint16_t i = 0; i < patterns; i++) {
+        uint32_t pattern = PATTERNS[i % pattern_count] ^ (i / pattern_count);
+        writeRegister(TMC5160_Reg::X_ENC, pattern);
+        uint32_t readback = readRaw(TMC5160_Reg::X_ENC);
+        done++;
+        if (readback != pattern) {
+            errors++;
+            _readback_errors++;
+        }
+
+        uint32_t errors_before = _ioin_errors;
+        readRaw(TMC5160_Reg::IO_INPUT_OUTPUT);
+        done++;
+        if (_ioin_errors != errors_before) errors++;
+    }
+
+    writeRegister(TMC5160_Reg::X_ENC, saved_x_enc);
+
+    if (checks) *checks = done;
+    return errors;
+}
+
+uint32_t spi_autotune_select(const uint32_t *steps_hz, uint8_t count, uint8_t margin_steps,
+                             SpiLinkProbe probe, void *ctx,
+                             SpiClockProbeResult *results, uint8_t *probed_count) {
+    int last_stable = -1;
+    uint8_t probed = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint16_t checks = 0;
+        uint16_t errors = probe(steps_hz[i], &checks, ctx);
+        results[i].hz = steps_hz[i];
+        results[i].checks = checks;
+        results[i].errors = errors;
+        probed++;
+
+        if (errors > 0) break;  // Выше первой нестабильной ступени не идём
+        last_stable = i;
+    }
+
+    if (probed_count) *probed_count = probed;
+    if (last_stable < 0) return 0;
+
+    int chosen = last_stable - margin_steps;
+    if (chosen < 0) chosen = 0;
+    return steps_hz[chosen];
+}
+
+// ===== SPI_STATUS =====
+
+void TMC5160_ShadowSPI::storeSpiStatus(uint8_t status, uint32_t now_ms) {
+    uint32_t seq = _spi_status_seq.load(std::memory_order_relaxed);
+    _spi_status_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _spi_status.store(status, std::memory_order_relaxed);
+    _spi_status_ms.store(now_ms, std::memory_order_relaxed);
+    _spi_status_seq.store(seq + 2, std::memory_order_release);
+}
+
+void TMC5160_ShadowSPI::loadSpiStatus(uint8_t *status, uint32_t *stamp_ms, uint32_t *seq) const {
+    uint32_t before, after;
+    do {
+        before = _spi_status_seq.load(std::memory_order_acquire);
+        *status = _spi_status.load(std::memory_order_relaxed);
+        *stamp_ms = _spi_status_ms.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = _spi_status_seq.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    *seq = after;
+}
+
+uint8_t TMC5160_ShadowSPI::getLastSpiStatus() const {
+    uint8_t status;
+    uint32_t stamp_ms, seq;
+    loadSpiStatus(&status, &stamp_ms, &seq);
+    return status;
+}
+
+uint32_t TMC5160_ShadowSPI::getSpiStatusAgeMs() const {
+    uint8_t status;
+    uint32_t stamp_ms, seq;
+    loadSpiStatus(&status, &stamp_ms, &seq);
+    return millis() - stamp_ms;   // беззнаковая разность верна и через переполнение millis()
+}
+
+bool TMC5160_ShadowSPI::getSpiStatus(uint32_t max_age_ms, uint8_t *status) const {
+    uint8_t value;
+    uint32_t stamp_ms, seq;
+    loadSpiStatus(&value, &stamp_ms, &seq);
+    if (seq == 0) return false;
+    if (millis() - stamp_ms >= max_age_ms) return false;
+
+    *status = value;
+    return true;
+}
+
+// ===== ЧТЕНИЕ/ЗАПИСЬ ЧЕРЕЗ ТЕНЬ =====
+
+uint32_t TMC5160_ShadowSPI::readRegister(uint8_t address) {
+    BusLock lock(_bus_lock);
+    if (address >= TMC_REG_COUNT) return readRaw(address);
+
+    uint32_t now = millis();
+    TmcRegPolicy policy = regPolicy(address);
+
+    if (_valid[address]) {
+        bool live = policy == REG_VOLATILE || policy == REG_STATUS;
+        if (!live || (now - _stamp_ms[address]) < _max_age_ms) {
+            _hits[address]++;
+            return _value[address];
+        }
+    }
+
+    _misses[address]++;
+    uint32_t value = readRaw(address);
+
+    // Write-only регистр ещё не записывался - чип вернул 0, в тень не кладём
+    if (policy != REG_WRITE_ONLY) {
+        storeShadow(address, value, now);
+    }
+    return value;
+}
+
+uint8_t TMC5160_ShadowSPI::writeRegister(uint8_t address, uint32_t data) {
+    BusLock lock(_bus_lock);
+    _spi_bus->beginTransaction(_spi_settings);
+    uint8_t status = transferDatagram(address | TMC5160_Reg::WRITE_ACCESS, data, nullptr);
+    _spi_bus->endTransaction();
+
+    if (address < TMC_REG_COUNT) {
+        if (regPolicy(address) == REG_STATUS) _valid[address] = false;
+        else storeShadow(address, data, millis());
+    }
+    return status;
+}
+
+uint32_t TMC5160_ShadowSPI::readRegisterDirect(uint8_t address) {
+    BusLock lock(_bus_lock);
+    uint32_t value = readRaw(address);
+    if (address < TMC_REG_COUNT && regPolicy(address) != REG_WRITE_ONLY) {
+        storeShadow(address, value, millis());
+    }
+    return value;
+}
+
+void TMC5160_ShadowSPI::invalidateShadow() {
+    for (uint8_t i = 0; i < TMC_REG_COUNT; i++) {
+        _valid[i] = false;
+        _value[i] = 0;
+        _stamp_ms[i] = 0;
+    }
+}
+
+void TMC5160_ShadowSPI::resetShadowStats() {
+    for (uint8_t i = 0; i < TMC_REG_COUNT; i++) {
+        _hits[i] = 0;
+        _misses[i] = 0;
+    }
+}
+
+uint32_t TMC5160_ShadowSPI::getShadowTotalHits() const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < TMC_REG_COUNT; i++) total += _hits[i];
+    return total;
+}
+
+uint32_t TMC5160_ShadowSPI::getShadowTotalMisses() const {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < TMC_REG_COUNT; i++) total += _misses[i];
+    return total;
+}
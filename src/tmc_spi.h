@@ -0,0 +1,171 @@
+#pragma once
+#include <Arduino.h>
+#include <TMC5160.h>
+#include <SPI.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// ============================================================================
+// SPI-СЛОЙ TMC5160 С ТЕНЕВЫМИ КОПИЯМИ РЕГИСТРОВ
+// ============================================================================
+// Наследник TMC5160_SPI из библиотеки tommag: все вызовы библиотеки
+// (setMaxSpeed, setAcceleration, begin...) идут через readRegister/writeRegister,
+// поэтому тень всегда совпадает с тем, что реально записано в чип.
+
+// Количество адресов регистров TMC5160 (0x00..0x73)
+#define TMC_REG_COUNT 0x74
+
+// Макс. возраст кэша "живых" регистров по умолчанию (мс)
+#define TMC_SHADOW_DEFAULT_MAX_AGE_MS 50
+
+// Биты SPI_STATUS - первый байт ответа на КАЖДУЮ датаграмму (даташит §4.1.2)
+#define SPI_STATUS_RESET_FLAG        0x01  // GSTAT.reset
+#define SPI_STATUS_DRIVER_ERROR      0x02  // GSTAT.drv_err
+#define SPI_STATUS_SG2               0x04  // DRV_STATUS.stallGuard
+#define SPI_STATUS_STANDSTILL        0x08  // DRV_STATUS.stst
+#define SPI_STATUS_VELOCITY_REACHED  0x10  // RAMP_STAT.velocity_reached
+#define SPI_STATUS_POSITION_REACHED  0x20  // RAMP_STAT.position_reached
+#define SPI_STATUS_STOP_L            0x40  // RAMP_STAT.status_stop_l
+#define SPI_STATUS_STOP_R            0x80  // RAMP_STAT.status_stop_r
+
+// ===== АВТОНАСТРОЙКА ЧАСТОТЫ SPI =====
+#define SPI_CLOCK_SAFE_HZ 100000          // Проверенная стартовая частота (как было всегда)
+#define SPI_AUTOTUNE_MAX_STEPS 8
+#define SPI_AUTOTUNE_PATTERNS 8           // Шаблонов записи/чтения на каждую частоту
+#define SPI_AUTOTUNE_MARGIN_STEPS 1       // Запас: на столько ступеней ниже последней стабильной
+
+// Ступени частоты SPI для калибровки (по возрастанию)
+const uint32_t SPI_AUTOTUNE_STEPS_HZ[SPI_AUTOTUNE_MAX_STEPS] = {
+    100000, 250000, 500000, 1000000, 2000000, 4000000, 6000000, 8000000
+};
+
+// Результат проверки одной ступени
+struct SpiClockProbeResult {
+    uint32_t hz;
+    uint16_t checks;
+    uint16_t errors;
+};
+
+// Проверка связи на частоте hz: возвращает число ошибок (0 = стабильно)
+typedef uint16_t (*SpiLinkProbe)(uint32_t hz, uint16_t *checks, void *ctx);
+
+// Алгоритм выбора частоты - без обращения к железу (probe может быть моком с инжекцией ошибок).
+// Поднимается по ступеням до первой ошибки, берёт последнюю стабильную минус margin_steps.
+// Возвращает 0, если не прошла даже первая ступень. results - не менее count элементов.
+uint32_t spi_autotune_select(const uint32_t *steps_hz, uint8_t count, uint8_t margin_steps,
+                             SpiLinkProbe probe, void *ctx,
+                             SpiClockProbeResult *results, uint8_t *probed_count);
+
+// Политика кэширования регистра
+enum TmcRegPolicy : uint8_t {
+    REG_VOLATILE = 0,    // Меняется самим драйвером (XACTUAL, VACTUAL, DRV_STATUS...) - кэш с ограниченным возрастом
+    REG_CONFIG = 1,      // Чтение/запись, меняется только нами (GCONF, CHOPCONF, XTARGET...) - из RAM после первого доступа
+    REG_WRITE_ONLY = 2,  // Только запись (VMAX, AMAX, IHOLD_IRUN, COOLCONF...) - с чипа читается 0, отдаём из RAM
+    REG_STATUS = 3       // Только чтение или сброс записью 1 (GSTAT, RAMP_STAT, DRV_STATUS...) - как VOLATILE,
+                         // но записанное значение в тень не попадает: запись 0x07 в GSTAT флаги снимает, а не ставит
+};
+
+class TMC5160_ShadowSPI : public TMC5160_SPI {
+public:
+    TMC5160_ShadowSPI(uint8_t chipSelectPin, uint32_t fclk, const SPISettings &spiSettings, SPIClass &spi = SPI);
+
+    // Чтение через тень: CONFIG/WRITE_ONLY - из RAM, VOLATILE - из RAM если моложе max_age
+    uint32_t readRegister(uint8_t address) override;
+    // Запись в чип + обновление тени (REG_STATUS - тень сбрасывается, следующее чтение с чипа)
+    uint8_t writeRegister(uint8_t address, uint32_t data) override;
+
+    // Чтение мимо тени (всегда SPI), результат обновляет тень
+    uint32_t readRegisterDirect(uint8_t address);
+
+    // Конвейерное чтение N регистров за одну SPI-транзакцию: N+1 датаграмм вместо 2N.
+    // Ответ на каждую датаграмму содержит результат ПРЕДЫДУЩЕГО запроса чтения.
+    void readRegisterBurst(const uint8_t *addresses, uint32_t *values, uint8_t count);
+
+    // Счётчик 40-битных SPI датаграмм (для бенчмарков)
+    uint32_t getDatagramCount() const { return _datagram_count; }
+
+    // Последний SPI_STATUS (lock-free, пишется при каждой датаграмме).
+    // Возвращает false, если байт старше max_age_ms или ещё не было обмена.
+    bool getSpiStatus(uint32_t max_age_ms, uint8_t *status) const;
+    uint8_t getLastSpiStatus() const;
+    uint32_t getSpiStatusAgeMs() const;
+
+    // Частота SPI (меняется на лету, следующая транзакция идёт уже на новой частоте)
+    void setSpiClock(uint32_t hz);
+    uint32_t getSpiClock() const { return _spi_clock_hz; }
+
+    // Проверка целостности канала на текущей частоте: запись/чтение шаблонов в X_ENC
+    // (RW, без энкодера не используется) + проверка версии IOIN. Возвращает число ошибок.
+    uint16_t probeLink(uint16_t patterns, uint16_t *checks);
+
+    // Счётчики целостности канала
+    uint32_t getIoinErrors() const { return _ioin_errors; }
+    uint32_t getReadbackErrors() const { return _readback_errors; }
+
+    // Группа операций без вклинивания других задач (например, запись всей рампы).
+    // Мьютекс рекурсивный - внутри можно вызывать любые методы слоя.
+    void lockBus() { xSemaphoreTakeRecursive(_bus_lock, portMAX_DELAY); }
+    void unlockBus() { xSemaphoreGiveRecursive(_bus_lock); }
+
+    // Сбросить все теневые значения (после переинициализации/сброса чипа)
+    void invalidateShadow();
+    // Значение регистра уже в тени (записывалось или читалось после invalidateShadow)
+    bool isShadowValid(uint8_t address) const { return address < TMC_REG_COUNT && _valid[address]; }
+
+    // Макс. возраст кэша для VOLATILE регистров (0 = всегда читать с чипа)
+    void setShadowMaxAge(uint32_t max_age_ms) { _max_age_ms = max_age_ms; }
+    uint32_t getShadowMaxAge() const { return _max_age_ms; }
+
+    // Счётчики попаданий/промахов по регистрам
+    uint32_t getShadowHits(uint8_t address) const { return address < TMC_REG_COUNT ? _hits[address] : 0; }
+    uint32_t getShadowMisses(uint8_t address) const { return address < TMC_REG_COUNT ? _misses[address] : 0; }
+    uint32_t getShadowTotalHits() const;
+    uint32_t getShadowTotalMisses() const;
+    void resetShadowStats();
+
+    static TmcRegPolicy regPolicy(uint8_t address);
+    static const char* regName(uint8_t address);
+
+private:
+    // Рекурсивный мьютекс слоя: тень и датаграммы защищены при обращении из разных задач
+    // (задача движения, AsyncTCP, loop). Захват держится только на время одной операции.
+    class BusLock {
+    public:
+        explicit BusLock(SemaphoreHandle_t lock) : _lock(lock) { xSemaphoreTakeRecursive(_lock, portMAX_DELAY); }
+        ~BusLock() { xSemaphoreGiveRecursive(_lock); }
+    private:
+        SemaphoreHandle_t _lock;
+    };
+
+    void storeShadow(uint8_t address, uint32_t value, uint32_t now_ms);
+    // Одна 40-битная датаграмма (CS должен быть под транзакцией). Возвращает SPI_STATUS.
+    uint8_t transferDatagram(uint8_t address, uint32_t data, uint32_t *reply);
+    uint32_t readRaw(uint8_t address);
+
+    // Копии параметров шины (в TMC5160_SPI они private)
+    SemaphoreHandle_t _bus_lock;
+    uint8_t _cs_pin;
+    uint32_t _spi_clock_hz;
+    SPISettings _spi_settings;
+    SPIClass *_spi_bus;
+    uint32_t _datagram_count;
+    uint32_t _ioin_errors;       // IOIN вернул не ту версию (0x00/0xFF - обрыв/шум)
+    uint32_t _readback_errors;   // Записанное значение не совпало с прочитанным
+
+    // SPI_STATUS под seqlock: писатель один (датаграммы идут под _bus_lock), читатели без
+    // блокировок. Нечётный _spi_status_seq - запись в процессе, 0 - обмена ещё не было.
+    // Время хранится полными 32 битами millis() - возраст верен и после 4.66 ч аптайма.
+    void storeSpiStatus(uint8_t status, uint32_t now_ms);
+    void loadSpiStatus(uint8_t *status, uint32_t *stamp_ms, uint32_t *seq) const;
+    std::atomic<uint32_t> _spi_status_seq;
+    std::atomic<uint32_t> _spi_status_ms;
+    std::atomic<uint8_t> _spi_status;
+
+    uint32_t _value[TMC_REG_COUNT];
+    uint32_t _stamp_ms[TMC_REG_COUNT];
+    bool _valid[TMC_REG_COUNT];
+    uint32_t _hits[TMC_REG_COUNT];
+    uint32_t _misses[TMC_REG_COUNT];
+    uint32_t _max_age_ms;
+};
@@ -0,0 +1,89 @@
+#pragma once
+#include <stdint.h>
+
+// ============================================================================
+// ПОЗИЦИЯ В МИКРОШАГАХ - ЦЕЛЫЕ ЧИСЛА С ПЕРЕХОДОМ ЧЕРЕЗ ±2^31 (ЧИСТАЯ ЛОГИКА)
+// ============================================================================
+// XACTUAL/XTARGET - 32 бита со знаком. При 256 микрошагах на шаг и 10 об/с счётчик проходит
+// 2^31 примерно за 70 минут, дальше 2^31-1 → -2^31. Вся арифметика позиций - по модулю 2^32
+// через uint32_t (без UB переполнения int32): разность двух позиций верна, пока реальный путь
+// между ними меньше 2^31 микрошагов - так же считает и генератор рампы TMC5160.
+// Без Arduino - проверяется на хосте.
+
+// Наибольший относительный ход за одну команду (INT32_MIN - направление неоднозначно)
+#define USTEPS_MAX_MOVE 0x7FFFFFFFLL
+
+inline int32_t usteps_add(int32_t pos, int32_t delta) {
+    return (int32_t)((uint32_t)pos + (uint32_t)delta);
+}
+
+// Путь со знаком от from до to (кратчайший по модулю 2^32)
+inline int32_t usteps_diff(int32_t to, int32_t from) {
+    return (int32_t)((uint32_t)to - (uint32_t)from);
+}
+
+inline uint32_t usteps_distance(int32_t a, int32_t b) {
+    int32_t d = usteps_diff(a, b);
+    return d < 0 ? 0u - (uint32_t)d : (uint32_t)d;
+}
+
+inline bool usteps_move_valid(int64_t delta) {
+    return delta >= -USTEPS_MAX_MOVE && delta <= USTEPS_MAX_MOVE;
+}
+
+// CHOPCONF.MRES (0..8) → микрошагов на шаг: 0 = 256, 8 = полный шаг
+inline uint32_t usteps_per_step_from_mres(uint8_t mres) {
+    return mres > 8 ? 1u : 256u >> mres;
+}
+
+// Шаги → микрошаги. false - ход не помещается в одну команду
+inline bool usteps_from_steps(int64_t steps, uint32_t usteps_per_step, int32_t *out) {
+    if (!usteps_move_valid(steps)) return false;    // Иначе произведение переполнит int64
+    int64_t usteps = steps * (int64_t)usteps_per_step;
+    if (!usteps_move_valid(usteps)) return false;
+    *out = (int32_t)usteps;
+    return true;
+}
+
+// Микрошаги → целые шаги с округлением вниз (-1 мкшаг = шаг -1, как у позиции на оси)
+inline int32_t usteps_to_steps(int32_t usteps, uint32_t usteps_per_step) {
+    int64_t q = (int64_t)usteps / (int64_t)usteps_per_step;
+    if ((int64_t)usteps % (int64_t)usteps_per_step < 0) q--;
+    return (int32_t)q;
+}
+
+// VACTUAL с чипа - 24 бита со знаком: расширение по биту 23 (иначе -1 читается как 16777215)
+inline int32_t usteps_vactual_from_register(uint32_t raw) {
+    return (int32_t)(raw << 8) >> 8;
+}
+
+// VACTUAL (24 бита со знаком, уже расширен) → микрошаги/с: v = VACTUAL * fCLK / 2^24
+inline int32_t usteps_rate_from_vactual(int32_t vactual, uint32_t fclk) {
+    return (int32_t)((int64_t)vactual * fclk / 16777216LL);
+}
+
+// ===== РАЗВЁРТКА ДЛЯ МНОГОДНЕВНОГО ВРАЩЕНИЯ =====
+// Счётчик переходов через ±2^31: позиция 64 бита = wraps·2^32 + XACTUAL. Обновлять чаще,
+// чем мотор проходит 2^31 микрошагов (снимок движения - каждые 20 мс)
+
+struct UstepsUnwrap {
+    int32_t last;
+    int32_t wraps;
+    bool valid;
+};
+
+inline void usteps_unwrap_reset(UstepsUnwrap &u, int32_t pos) {
+    u.last = pos;
+    u.wraps = 0;
+    u.valid = true;
+}
+
+inline int64_t usteps_unwrap(UstepsUnwrap &u, int32_t pos) {
+    if (!u.valid) usteps_unwrap_reset(u, pos);
+    int32_t d = usteps_diff(pos, u.last);
+    // Шли вперёд, а число уменьшилось (или наоборот) - прошли границу
+    if (d > 0 && pos < u.last) u.wraps++;
+    else if (d < 0 && pos > u.last) u.wraps--;
+    u.last = pos;
+    return (int64_t)u.wraps * 4294967296LL + pos;
+}
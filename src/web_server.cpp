@@ -2,6 +2,7 @@
 #include <ESPAsyncWebServer.h>
 #include <LittleFS.h>
 #include <ArduinoJson.h>
+#include <errno.h>
 #include "web_server.h"
 #include "tmc.h"
 #include "eeprom_manager.h"
@@ -9,67 +10,359 @@
 #include "pins.h"
 #include "solenoid.h"
 #include "hall_sensors.h"
+#include "motion_task.h"
+#include "step_pulse.h"
+#include "move_events.h"
+#include "homing.h"
+#include "sg_tuning.h"
+#include "fault_monitor.h"
+#include "health_monitor.h"
+#include "move_queue.h"
+#include "sequence.h"
+#include "endurance.h"
+#include "telemetry.h"
+#include "log_ring.h"
+#include "serial_log.h"
 
 AsyncWebServer server(80);
 
-// Глобальный лог для системы
-String system_logs = "";
+// Push-события для клиентов (Server-Sent Events): move_done - завершение движения
+AsyncEventSource events("/api/events");
+
+// Глобальный лог для системы - кольцо двоичных записей (log_ring.h): запись без аллокаций,
+// текст собирается только при чтении. Записи пронумерованы: клиент помнит курсор и забирает
+// только новые строки (GET /api/logs?since=N). Пишут разные задачи - всё под log_mutex
+static LogRing log_ring;
+
+#define LOG_PUSH_PERIOD_MS 250          // Не чаще - строки лога пачкой в одном событии SSE
+#define SPI_BENCHMARK_TIMEOUT_MS 3000   // /api/spi_benchmark: 200 итераций на 100 кГц - около секунды
+
+// Трафик лога к клиентам: опрос (полный и по курсору) и push
+struct LogTrafficStats {
+    uint32_t start_ms;
+    uint32_t full_requests;
+    uint32_t cursor_requests;
+    uint32_t empty_responses;
+    uint32_t pushes;
+    uint32_t bytes;
+};
+static LogTrafficStats log_traffic = {};
+static portMUX_TYPE log_traffic_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Цена записи в лог на стороне вызывающего (классификация + копирование в кольцо)
+struct LogWriteStats {
+    uint32_t calls;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+};
+static LogWriteStats log_writes = {};
+
+static SemaphoreHandle_t log_mutex() {
+    static SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+    return mutex;
+}
 
-// Функция форматирования времени (миллисекунды в формат MM:SS.mmm)
-String format_time_ms(unsigned long ms) {
-    unsigned long seconds = ms / 1000;
-    unsigned long minutes = seconds / 60;
-    seconds = seconds % 60;
-    unsigned long milliseconds = ms % 1000;
-    
-    char buffer[16];
-    snprintf(buffer, sizeof(buffer), "%02lu:%02lu.%03lu", minutes, seconds, milliseconds);
-    return String(buffer);
-}
-
-// Функция замены смайликов на текстовые метки
-String replace_emojis(String message) {
-    message.replace("✅", "[OK]");
-    message.replace("❌", "[ERROR]");
-    message.replace("⚠️", "[WARN]");
-    message.replace("🚀", "[MOVE]");
-    message.replace("🔄", "[SWITCH]");
-    message.replace("🔧", "[CONFIG]");
-    message.replace("🔋", "[ENABLE]");
-    message.replace("🔌", "[DISABLE]");
-    message.replace("📊", "[INFO]");
-    message.replace("🎯", "[CENTER]");
-    message.replace("🚨", "[STOP]");
-    message.replace("💾", "[SAVE]");
-    message.replace("⚙️", "[SETTINGS]");
-    message.replace("⏹️", "[STOP]");
-    message.replace("🧪", "[TEST]");
-    message.replace("🛑", "[STOP]");
-    message.replace("⏱️", "[TIME]");
-    message.replace("🔢", "[CYCLES]");
-    message.replace("🧹", "[CLEAR]");
-    return message;
-}
-
-// Функция добавления в лог (объявлена в tmc.h)
+static void log_write(uint32_t start_us, LogLevel level, LogTag tag, LogMsgId id, const void *payload, size_t len) {
+    uint32_t now = millis();
+    xSemaphoreTake(log_mutex(), portMAX_DELAY);
+    log_ring_push(log_ring, now, level, tag, id, payload, len);
+    uint32_t us = micros() - start_us;
+    log_writes.calls++;
+    log_writes.last_us = us;
+    if (us > log_writes.max_us) log_writes.max_us = us;
+    log_writes.total_us += us;
+    xSemaphoreGive(log_mutex());
+}
+
+// Функция добавления в лог (объявлена в tmc.h). Ведущий смайлик / "[МЕТКА]" - в метку записи,
+// остальное копируется как есть (обрезка до LOG_PAYLOAD_MAX по границе символа)
 void add_log_to_web(String message) {
-    // Форматируем время и убираем смайлики
-    String formatted_time = format_time_ms(millis());
-    String clean_message = replace_emojis(message);
-    system_logs += "[" + formatted_time + "] " + clean_message + "\n";
-    
-    // Ограничиваем размер лога (обрезаем по строкам, а не по символам)
-    if (system_logs.length() > 10000) {
-        int cutPos = system_logs.indexOf('\n', 5000);
-        if (cutPos != -1) {
-            system_logs = system_logs.substring(cutPos + 1);
-        } else {
-            system_logs = system_logs.substring(5000);
-        }
+    uint32_t start_us = micros();
+    const char *text = message.c_str();
+    size_t len = message.length();
+    LogTag tag = log_classify(text, len);
+    log_write(start_us, log_tag_level(tag), tag, LOG_MSG_TEXT, text, log_utf8_clip(text, len, LOG_PAYLOAD_MAX));
+}
+
+// Сообщение с id и аргументами (log_ring.h) - без сборки строки у вызывающего
+void add_log_event(LogMsgId id, int32_t a0, int32_t a1, int32_t a2, int32_t a3) {
+    uint32_t start_us = micros();
+    int32_t args[LOG_EVENT_ARGS] = {a0, a1, a2, a3};
+    LogTag tag = log_event_tag(id);
+    log_write(start_us, log_tag_level(tag), tag, id, args, sizeof(args));
+}
+
+// Строки с номерами от since до конца (out - текст, next - курсор для следующего запроса).
+// Возвращает false, если часть строк после since уже вытеснена или лог очищен / прибор
+// перезагружен (since впереди) - тогда out с самой старой записи. Рендер - вне блокировки:
+// пишущая задача ждёт не дольше копирования одной записи
+static bool get_logs_since(uint32_t since, String &out, uint32_t &next) {
+    LogCursor cursor;
+    LogRecord rec;
+    char line[LOG_RENDER_MAX];
+
+    xSemaphoreTake(log_mutex(), portMAX_DELAY);
+    bool complete = log_ring_seek(log_ring, since, cursor);
+    uint32_t end = log_ring.next_seq;
+    xSemaphoreGive(log_mutex());
+
+    out.reserve((end - cursor.seq) * 64);
+    for (;;) {
+        xSemaphoreTake(log_mutex(), portMAX_DELAY);
+        bool ok = cursor.seq < end && log_ring_next(log_ring, cursor, rec);
+        xSemaphoreGive(log_mutex());
+        if (!ok) break;
+        out.concat(line, log_render(rec, line));
     }
+    // Запись вытеснена посреди чтения - следующий запрос начнётся с reset
+    next = cursor.seq;
+    return complete;
+}
+
+// counter - поле LogTrafficStats, которое увеличить (или nullptr)
+static void log_traffic_add(uint32_t LogTrafficStats::*counter, uint32_t bytes) {
+    uint32_t now = millis();
+    portENTER_CRITICAL(&log_traffic_mux);
+    if (log_traffic.start_ms == 0) log_traffic.start_ms = now;
+    if (counter) log_traffic.*counter += 1;
+    log_traffic.bytes += bytes;
+    portEXIT_CRITICAL(&log_traffic_mux);
 }
 
+// Задача телеметрии (telemetry.cpp) при подписчиках SSE: новые строки лога - событием "log"
+static uint32_t log_pushed_seq = 0;
+static uint32_t log_push_last_ms = 0;
+
+void publish_log_events() {
+    uint32_t now = millis();
+    if (log_ring.next_seq == log_pushed_seq || now - log_push_last_ms < LOG_PUSH_PERIOD_MS) return;
+    log_push_last_ms = now;
+
+    String lines;
+    uint32_t next;
+    bool complete = get_logs_since(log_pushed_seq, lines, next);
+    JsonDocument doc;
+    doc["from"] = log_pushed_seq;
+    doc["next"] = next;
+    if (!complete) doc["reset"] = true;
+    doc["lines"] = lines;
+    String message; serializeJson(doc, message);
+    events.send(message.c_str(), "log", next);
+    log_pushed_seq = next;
+    log_traffic_add(&LogTrafficStats::pushes, message.length() * events.count());
+}
+
+// Стоимость последнего опроса /api/status (SPI датаграммы и мкс)
+uint32_t status_poll_last_us = 0;
+uint32_t status_poll_last_datagrams = 0;
+
 // JSON ответ для статуса
+static void fillMoveEventJson(JsonObject obj, const MoveDoneEvent &event) {
+    obj["seq"] = event.seq;
+    obj["timestamp_ms"] = event.timestamp_ms;
+    obj["xactual"] = event.xactual;
+    obj["position"] = steps_from_usteps(event.xactual);
+    obj["duration_ms"] = event.duration_ms;
+    obj["mode"] = event.mode == MODE_STEP_DIR ? "step_dir" : "spi";
+    obj["aborted"] = event.aborted;
+    obj["stalled"] = event.stalled;
+}
+
+// Вызывается задачей движения при обнаружении завершения (move_events.cpp)
+void publish_move_event(const MoveDoneEvent &event) {
+    if (events.count() == 0) return;
+
+    JsonDocument doc;
+    fillMoveEventJson(doc.to<JsonObject>(), event);
+    String message; serializeJson(doc, message);
+    events.send(message.c_str(), "move_done", event.seq);
+}
+
+// Задача телеметрии (telemetry.cpp): подписчики SSE и рассылка кадра
+size_t telemetry_client_count() {
+    return events.count();
+}
+
+void publish_telemetry_event(const char *event, const char *message, uint32_t id) {
+    events.send(message, event, id);
+}
+
+static void fillFaultEntryJson(JsonObject obj, const FaultLogEntry &entry) {
+    char names[64];
+    driver_fault_describe(entry.flags, names, sizeof(names));
+    obj["seq"] = entry.seq;
+    obj["timestamp_ms"] = entry.timestamp_ms;
+    obj["flags"] = names;
+    obj["action"] = entry.action == FAULT_ACT_DISABLE ? "disable" : "warn";
+    obj["hard_disable"] = entry.hard_disable;
+    obj["drv_status"] = "0x" + String(entry.drv_status, HEX);
+    obj["gstat"] = "0x" + String(entry.gstat, HEX);
+    obj["latency_us"] = entry.latency_us;
+}
+
+// Вызывается задачей ошибок драйвера после фронта DIAG0 (fault_monitor.cpp)
+void publish_fault_event(const FaultLogEntry &entry) {
+    if (events.count() == 0) return;
+
+    JsonDocument doc;
+    fillFaultEntryJson(doc.to<JsonObject>(), entry);
+    String message; serializeJson(doc, message);
+    events.send(message.c_str(), "fault", entry.seq);
+}
+
+static void fillDeratePolicyJson(JsonObject obj, const DeratePolicy &p) {
+    obj["persist_ms"] = p.persist_ms;
+    obj["cool_ms"] = p.cool_ms;
+    obj["step_interval_ms"] = p.step_interval_ms;
+    obj["step_percent"] = p.step_percent;
+    obj["min_percent"] = p.min_percent;
+}
+
+// Политика снижения тока из формы (отсутствующие поля - из текущей)
+static DeratePolicy parseDeratePolicy(AsyncWebServerRequest *request) {
+    DeratePolicy p = get_derate_policy();
+    if (request->hasParam("persist_ms", true)) p.persist_ms = request->getParam("persist_ms", true)->value().toInt();
+    if (request->hasParam("cool_ms", true)) p.cool_ms = request->getParam("cool_ms", true)->value().toInt();
+    if (request->hasParam("step_interval_ms", true)) p.step_interval_ms = request->getParam("step_interval_ms", true)->value().toInt();
+    if (request->hasParam("step_percent", true)) p.step_percent = constrain(request->getParam("step_percent", true)->value().toInt(), 0, 100);
+    if (request->hasParam("min_percent", true)) p.min_percent = constrain(request->getParam("min_percent", true)->value().toInt(), 0, 100);
+    return p;
+}
+
+static void fillHomingConfigJson(JsonObject obj, const HomingConfig &c) {
+    static const char *const names[HOMING_PHASE_COUNT] = {"fast", "backoff", "slow"};
+    obj["direction"] = c.direction;
+    obj["backoff_steps"] = c.backoff_steps;
+    obj["timeout_ms"] = c.timeout_ms;
+    for (uint8_t i = 0; i < HOMING_PHASE_COUNT; i++) {
+        JsonObject phase = obj[names[i]].to<JsonObject>();
+        phase["speed"] = c.phases[i].speed;
+        phase["current"] = c.phases[i].current_mA;
+        if (i != HOMING_PHASE_BACKOFF) phase["sgt"] = c.phases[i].sgt;
+    }
+}
+
+static void fillSgTuneStatusJson(JsonObject obj, const SgTuneStatus &s) {
+    obj["running"] = s.running;
+    obj["done"] = s.done;
+    if (s.error) obj["error"] = s.error;
+    obj["preset_id"] = s.preset_id;
+    obj["band"] = s.band;
+    obj["sgt"] = s.sgt;
+    obj["samples_total"] = s.samples_total;
+    obj["sample_rate_hz"] = s.sample_rate_hz;
+    obj["duration_ms"] = s.duration_ms;
+    obj["recommended"] = s.recommended;
+    if (s.recommended) {
+        obj["sgt_recommended"] = s.sgt_recommended;
+        obj["tcoolthrs_recommended"] = s.tcoolthrs_recommended;
+    }
+}
+
+// Параметры свипа SGT из формы: preset_id, speeds (через запятую), sgt_min, sgt_max, sgt_step, samples.
+// Без speeds - 25/50/75/100% от max_speed текущих настроек
+static SgTuneRequest parseSgTuneRequest(AsyncWebServerRequest *request) {
+    SgTuneRequest r = {};
+    r.preset_id = request->hasParam("preset_id", true) ? request->getParam("preset_id", true)->value().toInt() : SG_TUNE_CUSTOM_PRESET;
+    r.sgt_min = request->hasParam("sgt_min", true) ? request->getParam("sgt_min", true)->value().toInt() : -8;
+    r.sgt_max = request->hasParam("sgt_max", true) ? request->getParam("sgt_max", true)->value().toInt() : 24;
+    r.sgt_step = request->hasParam("sgt_step", true) ? request->getParam("sgt_step", true)->value().toInt() : 4;
+    r.samples = request->hasParam("samples", true) ? request->getParam("samples", true)->value().toInt() : SG_TUNE_DEFAULT_SAMPLES;
+
+    if (request->hasParam("speeds", true)) {
+        String list = request->getParam("speeds", true)->value();
+        int start = 0;
+        while (start < (int)list.length() && r.bands < SG_MAX_BANDS) {
+            int comma = list.indexOf(',', start);
+            if (comma < 0) comma = list.length();
+            r.speeds[r.bands++] = list.substring(start, comma).toInt();
+            start = comma + 1;
+        }
+    } else {
+        for (uint8_t i = 0; i < 4; i++) r.speeds[r.bands++] = get_settings_snapshot().max_speed * (i + 1) / 4;
+    }
+    return r;
+}
+
+// Параметры хоминга из формы: <фаза>_speed/_current/_sgt, direction, backoff_steps, timeout_ms.
+// Отсутствующие - из текущей конфигурации
+static HomingConfig parseHomingConfig(AsyncWebServerRequest *request) {
+    static const char *const names[HOMING_PHASE_COUNT] = {"fast", "backoff", "slow"};
+    HomingConfig c = get_homing_config();
+    if (request->hasParam("direction", true)) c.direction = request->getParam("direction", true)->value().toInt();
+    if (request->hasParam("backoff_steps", true)) c.backoff_steps = request->getParam("backoff_steps", true)->value().toInt();
+    if (request->hasParam("timeout_ms", true)) c.timeout_ms = request->getParam("timeout_ms", true)->value().toInt();
+    for (uint8_t i = 0; i < HOMING_PHASE_COUNT; i++) {
+        String prefix = names[i];
+        if (request->hasParam(prefix + "_speed", true)) {
+            c.phases[i].speed = request->getParam(prefix + "_speed", true)->value().toInt();
+        }
+        if (request->hasParam(prefix + "_current", true)) {
+            c.phases[i].current_mA = request->getParam(prefix + "_current", true)->value().toInt();
+        }
+        if (request->hasParam(prefix + "_sgt", true)) {
+            c.phases[i].sgt = constrain(request->getParam(prefix + "_sgt", true)->value().toInt(), -64, 63);
+        }
+    }
+    return c;
+}
+
+// Целое 64 бита из формы: toInt() - 32 бита и молча даёт 0 на мусоре. false - не число,
+// лишние символы после числа или выход за int64 (ERANGE) - сужать до int32 такое нельзя
+static bool parseInt64Param(AsyncWebServerRequest *request, const char *name, int64_t &value) {
+    const String &text = request->getParam(name, true)->value();
+    char *end = nullptr;
+    errno = 0;
+    long long parsed = strtoll(text.c_str(), &end, 10);
+    if (errno == ERANGE || end == text.c_str() || *end != '\0') return false;
+    value = parsed;
+    return true;
+}
+
+// Параметры теста на ресурс из формы. nullptr - можно запускать, иначе ошибка
+static const char* parseEnduranceConfig(AsyncWebServerRequest *request, EnduranceConfig &c) {
+    c = endurance_default_config();
+    if (request->hasParam("pattern", true)) {
+        String pattern = request->getParam("pattern", true)->value();
+        if (pattern == "rotate") c.pattern = ENDURANCE_ROTATE;
+        else if (pattern != "back_and_forth") return "pattern must be back_and_forth or rotate";
+    }
+    if (request->hasParam("usteps", true) || request->hasParam("steps", true)) {
+        bool in_usteps = request->hasParam("usteps", true);
+        int64_t amount = 0;
+        if (!parseInt64Param(request, in_usteps ? "usteps" : "steps", amount)) return "distance must be an integer";
+        bool fits = in_usteps ? usteps_move_valid(amount) : usteps_from_steps(amount, get_usteps_per_step(), &c.distance_usteps);
+        if (!fits || amount == 0 || amount == INT32_MIN) return "distance must be non-zero and fit one move";
+        if (in_usteps) c.distance_usteps = (int32_t)amount;
+    }
+    if (request->hasParam("dwell_ms", true)) c.dwell_ms = request->getParam("dwell_ms", true)->value().toInt();
+    if (request->hasParam("max_cycles", true)) c.max_cycles = request->getParam("max_cycles", true)->value().toInt();
+    if (request->hasParam("max_time_sec", true)) c.max_time_ms = request->getParam("max_time_sec", true)->value().toInt() * 1000UL;
+    if (request->hasParam("tolerance_usteps", true)) c.tolerance_usteps = request->getParam("tolerance_usteps", true)->value().toInt();
+    if (request->hasParam("max_failures", true)) c.max_failures = constrain(request->getParam("max_failures", true)->value().toInt(), 0, 255);
+    if (request->hasParam("move_timeout_ms", true)) c.move_timeout_ms = request->getParam("move_timeout_ms", true)->value().toInt();
+    if (request->hasParam("max_speed", true)) c.max_speed = request->getParam("max_speed", true)->value().toInt();
+    if (request->hasParam("acceleration", true)) c.acceleration = request->getParam("acceleration", true)->value().toInt();
+    if (request->hasParam("deceleration", true)) c.deceleration = request->getParam("deceleration", true)->value().toInt();
+
+    if (c.move_timeout_ms == 0) return "move_timeout_ms must be positive";
+    if ((c.max_speed && !validate_speed(c.max_speed)) || c.acceleration > 0xFFFF || c.deceleration > 0xFFFF ||
+        (c.acceleration && !validate_acceleration(c.acceleration)) || (c.deceleration && !validate_acceleration(c.deceleration))) {
+        return "invalid speed/acceleration";
+    }
+    MoveSegment seg = {0, c.max_speed, c.acceleration, c.deceleration};
+    return ramp_profile_validate(move_segment_ramp(get_ramp_profile(get_settings_snapshot()), seg));
+}
+
+static void fillRunningStatsJson(JsonObject obj, const RunningStats &rs) {
+    obj["count"] = rs.count;
+    obj["mean"] = rs.mean;
+    obj["stddev"] = running_stats_stddev(rs);
+    obj["min"] = rs.min;
+    obj["max"] = rs.max;
+}
+
 String getStatusJson() {
     JsonDocument doc;
     doc["success"] = true;
@@ -77,35 +370,121 @@ String getStatusJson() {
     JsonObject data = doc["data"].to<JsonObject>();
     data["initialized"] = tmc_initialized;
     data["enabled"] = motor_enabled;
-    // Читаем регистры НАПРЯМУЮ для правильных значений (они В МИКРОШАГАХ!)
-    int32_t xactual_microsteps = tmc_initialized ? (int32_t)motor.readRegister(TMC5160_Reg::XACTUAL) : 0;
-    int32_t xtarget_microsteps = tmc_initialized ? (int32_t)motor.readRegister(TMC5160_Reg::XTARGET) : 0;
-    int32_t vactual = tmc_initialized ? (int32_t)motor.readRegister(TMC5160_Reg::VACTUAL) : 0;
+    // Снимок, который задача движения читает каждые MOTION_POLL_PERIOD_MS - из AsyncTCP без SPI
+    uint32_t poll_start_us = micros();
+    uint32_t poll_start_datagrams = tmc_initialized ? motor.getDatagramCount() : 0;
+    MotionSnapshot snap = peek_motion_snapshot();
     
-    // КОНВЕРТИРУЕМ МИКРОШАГИ → БАЗОВЫЕ ШАГИ (делим на microsteps)
-    uint16_t microsteps = currentSettings.microsteps > 0 ? currentSettings.microsteps : 16;
-    int32_t xactual = xactual_microsteps / microsteps;
-    int32_t xtarget = xtarget_microsteps / microsteps;
-    int32_t steps_remaining = abs(xtarget_microsteps - xactual_microsteps) / microsteps;
+    // МИКРОШАГИ → ШАГИ в шкале запрограммированных микрошагов (как ход /api/move), без float
+    int32_t xactual = steps_from_usteps(snap.xactual);
+    int32_t xtarget = steps_from_usteps(snap.xtarget);
+    int32_t vactual = snap.vactual;
+    uint32_t steps_remaining = usteps_distance(snap.xtarget, snap.xactual) / get_usteps_per_step();
     
     data["current_position"] = xactual;
     data["target_position"] = xtarget;
+    data["position_usteps"] = snap.xactual;
+    data["target_usteps"] = snap.xtarget;
+    data["position_wraps"] = snap.wraps;     // Переходы XACTUAL через ±2^31
+    // Угол выходного вала (steps_per_rev, gear_ratio) от начала координат
+    AngleUnits units;
+    if (get_angle_units(units)) data["angle_deg"] = angle_from_usteps_deg(units, (int64_t)snap.wraps * 4294967296LL + snap.xactual);
     data["current_speed"] = vactual;
     data["steps_remaining"] = steps_remaining;
-    data["is_moving"] = tmc_initialized ? !position_reached() : false;
+    data["is_moving"] = tmc_initialized ? !position_reached_cached(snap) : false;
+
+    // Последнее событие завершения - клиент видит номер и может ждать следующий
+    JsonObject move = data["move"].to<JsonObject>();
+    move["in_flight"] = move_in_flight();
+    move["last_seq"] = move_events_last_seq();
+    MoveDoneEvent last_event;
+    if (move_events_get_last(last_event)) {
+        fillMoveEventJson(move["last"].to<JsonObject>(), last_event);
+    }
+
+    // Хоминг: фаза и результат последнего
+    HomingStatus hs = get_homing_status();
+    JsonObject homing = data["homing"].to<JsonObject>();
+    homing["state"] = homing_state_name(hs.state);
+    homing["origin_valid"] = hs.origin_valid;
+
+    // Очередь сегментов: идёт ли и сколько ждёт
+    MoveQueueStatus mq = get_move_queue_status();
+    JsonObject queue = data["move_queue"].to<JsonObject>();
+    queue["active"] = mq.active;
+    queue["depth"] = mq.depth + (mq.next_ready ? 1 : 0);
+
+    // Программа движения: какая и где исполняется
+    SequenceStatus ss = get_sequence_status();
+    JsonObject sequence = data["sequence"].to<JsonObject>();
+    sequence["active"] = ss.active;
+    sequence["name"] = ss.name;
+    sequence["state"] = seq_state_name(ss.state);
+    sequence["pc"] = ss.pc;
+
+    // Тест на ресурс: идёт ли и сколько циклов
+    EnduranceStatus es = get_endurance_status();
+    JsonObject endurance = data["endurance"].to<JsonObject>();
+    endurance["active"] = es.running;
+    endurance["cycles"] = es.stats.cycles;
+    endurance["failed_cycles"] = es.stats.failed_cycles;
+
+    // Нагрев драйвера: otpw и доля тока после теплового снижения
+    HealthStatus hs_thermal = get_health_status();
+    JsonObject thermal = data["thermal"].to<JsonObject>();
+    thermal["otpw"] = hs_thermal.otpw;
+    thermal["derate_percent"] = hs_thermal.percent;
+    thermal["effective_mA"] = hs_thermal.effective_mA;
+    thermal["reduced_ms"] = hs_thermal.derate.reduced_ms;
+
+    // Отключение по ошибке драйвера (DIAG0): до повторного включения мотора
+    FaultMonitorStats fs = get_fault_monitor_stats();
+    JsonObject fault = data["fault"].to<JsonObject>();
+    fault["latched"] = fs.latched;
+    if (fs.latched) {
+        char names[64];
+        driver_fault_describe(fs.latched_flags, names, sizeof(names));
+        fault["flags"] = names;
+    }
+
+    // Режим скорости: цель и живая VACTUAL в шагах/с (VACTUAL из того же снимка)
+    JsonObject jog = data["jog"].to<JsonObject>();
+    jog["active"] = is_jog_active();
+    jog["target_speed"] = get_jog_target_speed();
+    jog["vactual_speed"] = ramp_vactual_to_speed(snap.vactual, TMC5160_FCLK, TMC_LIB_USTEPS_PER_STEP);
+    
+    // SPI_STATUS - пришёл вместе со снимком, отдельных чтений не нужно
+    if (tmc_initialized) {
+        uint8_t spi_status = motor.getLastSpiStatus();
+        JsonObject st = data["spi_status"].to<JsonObject>();
+        st["raw"] = spi_status;
+        st["driver_error"] = (spi_status & SPI_STATUS_DRIVER_ERROR) != 0;
+        st["reset"] = (spi_status & SPI_STATUS_RESET_FLAG) != 0;
+        st["stall"] = (spi_status & SPI_STATUS_SG2) != 0;
+        st["standstill"] = (spi_status & SPI_STATUS_STANDSTILL) != 0;
+        st["position_reached"] = (spi_status & SPI_STATUS_POSITION_REACHED) != 0;
+        st["velocity_reached"] = (spi_status & SPI_STATUS_VELOCITY_REACHED) != 0;
+    }
+    
+    if (tmc_initialized) {
+        status_poll_last_us = micros() - poll_start_us;
+        status_poll_last_datagrams = motor.getDatagramCount() - poll_start_datagrams;
+    }
     
-    // Настройки для frontend (из currentSettings)
+    // Настройки для frontend (копия currentSettings)
+    MotorSettings current = get_settings_snapshot();
     JsonObject settings = data["settings"].to<JsonObject>();
-    settings["steps_per_rev"] = currentSettings.steps_per_rev;
-    settings["max_speed"] = currentSettings.max_speed;
-    settings["acceleration"] = currentSettings.acceleration;
-    settings["deceleration"] = currentSettings.deceleration;
-    settings["current_mA"] = currentSettings.current_mA;
-    settings["hold_multiplier"] = currentSettings.hold_multiplier;
-    settings["microsteps"] = currentSettings.microsteps;
-    settings["gear_ratio"] = currentSettings.gear_ratio;  // Передаточное число!
+    settings["steps_per_rev"] = current.steps_per_rev;
+    settings["max_speed"] = current.max_speed;
+    settings["acceleration"] = current.acceleration;
+    settings["deceleration"] = current.deceleration;
+    settings["current_mA"] = current.current_mA;
+    settings["hold_multiplier"] = current.hold_multiplier;
+    settings["microsteps"] = current.microsteps;
+    settings["gear_ratio"] = current.gear_ratio;  // Передаточное число!
     settings["stealthchop"] = false;  // Всегда SpreadCycle для тестового стенда
-    settings["stallguard_threshold"] = currentSettings.stallguard_threshold;
+    settings["stallguard_threshold"] = current.stallguard_threshold;
+    settings["stallguard_tcoolthrs"] = current.stallguard_tcoolthrs;
     
     // Данные о соленоиде
     JsonObject solenoid = data["solenoid"].to<JsonObject>();
@@ -129,6 +508,161 @@ String getStatusJson() {
     return response;
 }
 
+// ===== ЧТЕНИЯ ДЛЯ ДИАГНОСТИКИ - В ЗАДАЧЕ ДВИЖЕНИЯ =====
+// Обработчики AsyncTCP не обращаются к SPI и к тени: функции ниже выполняет задача движения
+// (motion_call), результат - в static структурах, JSON собирается уже в обработчике
+
+// Счётчики тени регистров
+struct ShadowStatsCopy {
+    uint32_t max_age_ms;
+    uint32_t hits_total;
+    uint32_t misses_total;
+    uint32_t hits[TMC_REG_COUNT];
+    uint32_t misses[TMC_REG_COUNT];
+};
+
+static void copyShadowStats(ShadowStatsCopy &s) {
+    s.max_age_ms = motor.getShadowMaxAge();
+    s.hits_total = motor.getShadowTotalHits();
+    s.misses_total = motor.getShadowTotalMisses();
+    for (uint8_t addr = 0; addr < TMC_REG_COUNT; addr++) {
+        s.hits[addr] = motor.getShadowHits(addr);
+        s.misses[addr] = motor.getShadowMisses(addr);
+    }
+}
+
+// Регистры для /api/diagnostic (каждый читается ОДИН раз, повторные - из тени)
+struct DiagnosticRegisters {
+    bool communication_ok;
+    uint32_t ioin;
+    int32_t xactual;
+    int32_t xtarget;
+    int32_t vactual;
+    uint32_t gconf;
+    uint32_t gstat;
+    uint32_t vmax;
+    uint32_t amax;
+    uint32_t dmax;
+    uint32_t ramp_stat;
+    uint32_t chopconf;
+    uint32_t pwmconf;
+    uint32_t rampmode;
+    ShadowStatsCopy shadow;
+};
+
+static void readDiagnosticRegisters(void *ctx) {
+    DiagnosticRegisters &r = *(DiagnosticRegisters *)ctx;
+    r = {};
+    if (tmc_initialized) {
+        // Связь с драйвером - всегда по SPI, мимо тени
+        r.ioin = motor.readRegisterDirect(TMC5160_Reg::IO_INPUT_OUTPUT);
+        uint8_t version = (r.ioin >> 24) & 0xFF;
+        r.communication_ok = (version != 0xFF && version != 0 && r.ioin != 0xFFFFFFFF && r.ioin != 0x00000000);
+    }
+    if (r.communication_ok) {
+        r.xactual = (int32_t)motor.readRegister(TMC5160_Reg::XACTUAL);
+        r.xtarget = (int32_t)motor.readRegister(TMC5160_Reg::XTARGET);
+        r.vactual = usteps_vactual_from_register(motor.readRegister(TMC5160_Reg::VACTUAL));
+        r.gconf = motor.readRegister(TMC5160_Reg::GCONF);
+        r.gstat = motor.readRegister(TMC5160_Reg::GSTAT);
+        r.vmax = motor.readRegister(TMC5160_Reg::VMAX);
+        r.amax = motor.readRegister(TMC5160_Reg::AMAX);
+        r.dmax = motor.readRegister(TMC5160_Reg::DMAX);
+        r.ramp_stat = motor.readRegister(TMC5160_Reg::RAMP_STAT);
+        r.chopconf = motor.readRegister(TMC5160_Reg::CHOPCONF);
+        r.pwmconf = motor.readRegister(TMC5160_Reg::PWMCONF);
+        r.rampmode = motor.readRegister(TMC5160_Reg::RAMPMODE);
+    }
+    if (tmc_initialized) copyShadowStats(r.shadow);
+}
+
+static void readShadowStats(void *ctx) {
+    copyShadowStats(*(ShadowStatsCopy *)ctx);
+}
+
+// POST /api/register_cache: max_age_ms - результат (новый или текущий)
+struct RegisterCacheUpdate {
+    bool set_max_age;
+    bool reset;
+    uint32_t max_age_ms;
+};
+
+static void applyRegisterCacheUpdate(void *ctx) {
+    RegisterCacheUpdate &u = *(RegisterCacheUpdate *)ctx;
+    if (u.set_max_age) motor.setShadowMaxAge(u.max_age_ms);
+    if (u.reset) motor.resetShadowStats();
+    u.max_age_ms = motor.getShadowMaxAge();
+}
+
+// Бенчмарк опроса статуса: раздельные чтения (как раньше) против конвейерного снимка
+struct SpiBenchmark {
+    int iterations;
+    uint32_t legacy_us;
+    uint32_t legacy_datagrams;
+    uint32_t snapshot_us;
+    uint32_t snapshot_datagrams;
+};
+
+static void runSpiBenchmark(void *ctx) {
+    SpiBenchmark &b = *(SpiBenchmark *)ctx;
+
+    // Старый путь: XACTUAL, XTARGET, VACTUAL + VACTUAL в position_reached(), по 2 датаграммы на регистр
+    uint32_t d0 = motor.getDatagramCount();
+    uint32_t t0 = micros();
+    for (int i = 0; i < b.iterations; i++) {
+        motor.readRegisterDirect(TMC5160_Reg::XACTUAL);
+        motor.readRegisterDirect(TMC5160_Reg::XTARGET);
+        motor.readRegisterDirect(TMC5160_Reg::VACTUAL);
+        motor.readRegisterDirect(TMC5160_Reg::VACTUAL);
+    }
+    b.legacy_us = micros() - t0;
+    b.legacy_datagrams = motor.getDatagramCount() - d0;
+
+    // Новый путь: один снимок на 6 регистров
+    d0 = motor.getDatagramCount();
+    t0 = micros();
+    MotionSnapshot snap;
+    for (int i = 0; i < b.iterations; i++) {
+        read_motion_snapshot(snap);
+    }
+    b.snapshot_us = micros() - t0;
+    b.snapshot_datagrams = motor.getDatagramCount() - d0;
+}
+
+static void readDetailedDiagnostics(void *ctx) {
+    *(String *)ctx = get_detailed_diagnostics();
+}
+
+// POST /api/save_settings: EEPROM + currentSettings без переинициализации драйвера
+struct SettingsSave {
+    MotorSettings settings;
+    bool saved;
+};
+
+static void saveSettingsInMotionTask(void *ctx) {
+    SettingsSave &s = *(SettingsSave *)ctx;
+    s.saved = saveMotorSettings(s.settings);
+    if (s.saved) publish_settings(s.settings);
+}
+
+// Статистика тени регистров TMC5160 (только регистры, к которым были обращения)
+void fillRegisterCacheJson(JsonObject cache, const ShadowStatsCopy &s) {
+    cache["max_age_ms"] = s.max_age_ms;
+    cache["hits"] = s.hits_total;
+    cache["misses"] = s.misses_total;
+    
+    JsonArray regs = cache["registers"].to<JsonArray>();
+    for (uint8_t addr = 0; addr < TMC_REG_COUNT; addr++) {
+        if (s.hits[addr] == 0 && s.misses[addr] == 0) continue;
+        
+        JsonObject r = regs.add<JsonObject>();
+        r["addr"] = "0x" + String(addr, HEX);
+        r["name"] = TMC5160_ShadowSPI::regName(addr);
+        r["hits"] = s.hits[addr];
+        r["misses"] = s.misses[addr];
+    }
+}
+
 // JSON ответ для диагностики
 String getDiagnosticJson() {
     JsonDocument doc;
@@ -138,20 +672,33 @@ String getDiagnosticJson() {
     data["initialized"] = tmc_initialized;
     
     if (tmc_initialized) {
-        // Проверяем связь с драйвером
-        uint32_t ioin_value = motor.readRegister(TMC5160_Reg::IO_INPUT_OUTPUT);
+        // Регистры читает задача движения. Не дождались (она занята) - регистры "N/A"
+        static DiagnosticRegisters regs;
+        static const DiagnosticRegisters no_regs = {};
+        bool regs_read = motion_call(readDiagnosticRegisters, &regs);
+        if (!regs_read) data["registers_error"] = "Motion task busy, registers not read";
+        const DiagnosticRegisters &r = regs_read ? regs : no_regs;
+        bool communication_ok = r.communication_ok;
+        uint32_t ioin_value = r.ioin;
         uint8_t version = (ioin_value >> 24) & 0xFF;
-        bool communication_ok = (version != 0xFF && version != 0 && 
-                                ioin_value != 0xFFFFFFFF && ioin_value != 0x00000000);
-        
+        int32_t xactual = r.xactual;
+        int32_t xtarget = r.xtarget;
+        int32_t vactual = r.vactual;
+        uint32_t gconf = r.gconf;
+        uint32_t gstat = r.gstat;
+        uint32_t vmax = r.vmax;
+        uint32_t amax = r.amax;
+        uint32_t dmax = r.dmax;
+
         // Основная информация
         data["chip_version"] = communication_ok ? String(version) : "N/A";
-        data["current_position"] = communication_ok ? (int32_t)motor.readRegister(TMC5160_Reg::XACTUAL) : 0;
-        data["target_position"] = communication_ok ? (int32_t)motor.readRegister(TMC5160_Reg::XTARGET) : 0;
+        data["current_position"] = xactual;
+        data["target_position"] = xtarget;
         data["spi_communication"] = communication_ok;
         data["motor_enabled"] = motor_enabled;
-        data["microsteps"] = communication_ok ? currentSettings.microsteps : 0;
-        data["current_mA"] = communication_ok ? currentSettings.current_mA : 0;
+        MotorSettings current = get_settings_snapshot();
+        data["microsteps"] = communication_ok ? current.microsteps : 0;
+        data["current_mA"] = communication_ok ? current.current_mA : 0;
         
         // Анализ состояния (для фронтенда)
         JsonObject analysis = data["analysis"].to<JsonObject>();
@@ -163,14 +710,14 @@ String getDiagnosticJson() {
         // Регистры (для фронтенда)
         JsonObject registers = data["registers"].to<JsonObject>();
         if (communication_ok) {
-            registers["ioin"] = "0x" + String(motor.readRegister(TMC5160_Reg::IO_INPUT_OUTPUT), HEX);
-            registers["gconf"] = "0x" + String(motor.readRegister(TMC5160_Reg::GCONF), HEX);
-            registers["gstat"] = "0x" + String(motor.readRegister(TMC5160_Reg::GSTAT), HEX);
-            registers["xactual"] = String((int32_t)motor.readRegister(TMC5160_Reg::XACTUAL));
-            registers["xtarget"] = String((int32_t)motor.readRegister(TMC5160_Reg::XTARGET));
-            registers["vmax"] = String(motor.readRegister(TMC5160_Reg::VMAX));
-            registers["amax"] = String(motor.readRegister(TMC5160_Reg::AMAX));
-            registers["dmax"] = String(motor.readRegister(TMC5160_Reg::DMAX));
+            registers["ioin"] = "0x" + String(ioin_value, HEX);
+            registers["gconf"] = "0x" + String(gconf, HEX);
+            registers["gstat"] = "0x" + String(gstat, HEX);
+            registers["xactual"] = String(xactual);
+            registers["xtarget"] = String(xtarget);
+            registers["vmax"] = String(vmax);
+            registers["amax"] = String(amax);
+            registers["dmax"] = String(dmax);
         } else {
             registers["ioin"] = "N/A";
             registers["gconf"] = "N/A";
@@ -183,38 +730,128 @@ String getDiagnosticJson() {
         }
         
         // Дополнительная диагностика
-        data["vmax"] = communication_ok ? motor.readRegister(TMC5160_Reg::VMAX) : 0;
-        data["amax"] = communication_ok ? motor.readRegister(TMC5160_Reg::AMAX) : 0;
-        data["dmax"] = communication_ok ? motor.readRegister(TMC5160_Reg::DMAX) : 0;
-        data["vactual"] = communication_ok ? (int32_t)motor.getCurrentSpeed() : 0;
+        data["vmax"] = vmax;
+        data["amax"] = amax;
+        data["dmax"] = dmax;
+        data["vactual"] = vactual;
         
         // Статус драйвера
-        uint32_t gstat = communication_ok ? motor.readRegister(TMC5160_Reg::GSTAT) : 0;
         data["gstat"] = "0x" + String(gstat, HEX);
         data["gstat_reset"] = (gstat & 0x01) ? true : false;
         data["gstat_driver_error"] = (gstat & 0x02) ? true : false;
         
         // Статус движения
-        uint32_t ramp_stat = communication_ok ? motor.readRegister(TMC5160_Reg::RAMP_STAT) : 0;
+        uint32_t ramp_stat = r.ramp_stat;
         data["ramp_stat"] = "0x" + String(ramp_stat, HEX);
         data["position_reached"] = (ramp_stat & 0x80) ? true : false;
         data["velocity_reached"] = (ramp_stat & 0x40) ? true : false;
         
         // Настройки
-        uint32_t chopconf = communication_ok ? motor.readRegister(TMC5160_Reg::CHOPCONF) : 0;
+        uint32_t chopconf = r.chopconf;
         data["toff"] = communication_ok ? (chopconf & 0x0F) : 0;
         data["intpol"] = communication_ok ? ((chopconf >> 28) & 0x01) : false;
-        uint32_t gconf = communication_ok ? motor.readRegister(TMC5160_Reg::GCONF) : 0;
         data["en_pwm_mode"] = communication_ok ? (gconf & 0x04) : false;
-        uint32_t pwmconf = communication_ok ? motor.readRegister(TMC5160_Reg::PWMCONF) : 0;
+        uint32_t pwmconf = r.pwmconf;
         data["pwm_autoscale"] = communication_ok ? ((pwmconf >> 18) & 0x01) : false;
         
                // SPI метод и режим работы
-               data["spi_method"] = communication_ok ? "SPI Mode 3" : "N/A";
-               uint32_t rampmode = communication_ok ? motor.readRegister(TMC5160_Reg::RAMPMODE) : 0;
+               data["spi_method"] = communication_ok ? "SPI Mode 3 @ " + String(motor.getSpiClock()) + " Hz" : String("N/A");
+               uint32_t rampmode = r.rampmode;
                data["ramp_mode"] = rampmode;
                data["mode_description"] = communication_ok ? 
                    (rampmode == 0 ? "Motion Controller Mode" : "STEP/DIR Mode") : "N/A";
+
+        // Стоимость опроса статуса
+        JsonObject poll = data["status_poll"].to<JsonObject>();
+        poll["datagrams"] = status_poll_last_datagrams;
+        poll["us"] = status_poll_last_us;
+
+        // SPI_STATUS: последний байт статуса и сэкономленные чтения
+        JsonObject spi_status = data["spi_status"].to<JsonObject>();
+        spi_status["last"] = "0x" + String(motor.getLastSpiStatus(), HEX);
+        spi_status["age_ms"] = motor.getSpiStatusAgeMs();
+        spi_status["reads_saved"] = spi_status_reads_saved;
+        spi_status["driver_resets"] = driver_reset_count;
+
+        // Канал SPI: частота и счётчики целостности
+        JsonObject link = data["spi_link"].to<JsonObject>();
+        link["clock_hz"] = motor.getSpiClock();
+        link["ioin_errors"] = motor.getIoinErrors();
+        link["readback_errors"] = motor.getReadbackErrors();
+        const SpiClockProbeResult *cal_results;
+        uint8_t cal_count = get_spi_calibration_results(&cal_results);
+        JsonArray cal = link["calibration"].to<JsonArray>();
+        for (uint8_t i = 0; i < cal_count; i++) {
+            JsonObject step = cal.add<JsonObject>();
+            step["hz"] = cal_results[i].hz;
+            step["checks"] = cal_results[i].checks;
+            step["errors"] = cal_results[i].errors;
+        }
+
+        // Тень регистров: попадания/промахи
+        if (regs_read) {
+            JsonObject cache = data["register_cache"].to<JsonObject>();
+            fillRegisterCacheJson(cache, r.shadow);
+        }
+
+        // Задача движения: очередь команд и задержка до записи в SPI
+        MotionTaskStats mt = get_motion_task_stats();
+        JsonObject motion = data["motion_task"].to<JsonObject>();
+        motion["running"] = is_motion_task_running();
+        motion["queue_depth"] = mt.queue_depth;
+        motion["queue_depth_max"] = mt.queue_depth_max;
+        motion["queue_capacity"] = MOTION_QUEUE_SIZE;
+        motion["enqueued"] = mt.enqueued;
+        motion["dropped"] = mt.dropped;
+        motion["executed"] = mt.executed;
+        motion["latency_last_us"] = mt.latency_last_us;
+        motion["latency_max_us"] = mt.latency_max_us;
+        motion["latency_avg_us"] = mt.latency_avg_us;
+        motion["jog_requests"] = mt.jog_requests;
+        motion["jog_applied"] = mt.jog_applied;
+
+        // События завершения движения и мёртвое время между движениями
+        MoveEventStats me = get_move_event_stats();
+        JsonObject move_events_json = data["move_events"].to<JsonObject>();
+        move_events_json["started"] = me.started;
+        move_events_json["completed"] = me.completed;
+        move_events_json["polls"] = me.polls;
+        move_events_json["stalled"] = me.stalled;
+        move_events_json["sse_clients"] = events.count();
+        move_events_json["dead_time_last_ms"] = me.dead_time_last_ms;
+        move_events_json["dead_time_avg_ms"] = me.dead_time_avg_ms;
+        move_events_json["dead_time_max_ms"] = me.dead_time_max_ms;
+        move_events_json["dead_time_samples"] = me.dead_time_samples;
+
+        // Последнее применение настроек: дифференциальное (записано/сравнено) или полная инициализация
+        ConfigApplyStats ca = get_config_apply_stats();
+        JsonObject config_apply = data["config_apply"].to<JsonObject>();
+        config_apply["mode"] = ca.timestamp_ms == 0 ? "none" : (ca.differential ? "differential" : "full");
+        config_apply["compared"] = ca.compared;
+        config_apply["written"] = ca.written;
+        config_apply["unknown"] = ca.unknown;
+        config_apply["duration_us"] = ca.duration_us;
+
+        // Ошибки драйвера по DIAG0
+        FaultMonitorStats fs = get_fault_monitor_stats();
+        JsonObject fault_json = data["fault_monitor"].to<JsonObject>();
+        fault_json["latched"] = fs.latched;
+        fault_json["diag_edges"] = fs.diag_edges;
+        fault_json["faults"] = fs.faults;
+        fault_json["warnings"] = fs.warnings;
+        fault_json["isr_latency_max_us"] = fs.hard_latency_max_us;
+        fault_json["task_latency_max_us"] = fs.soft_latency_max_us;
+
+        // Генератор STEP/DIR (RMT)
+        StepPulseStats sp = get_step_pulse_stats();
+        JsonObject step_pulse = data["step_pulse"].to<JsonObject>();
+        step_pulse["busy"] = sp.busy;
+        step_pulse["moves"] = sp.moves;
+        step_pulse["aborted"] = sp.aborted;
+        step_pulse["last_steps"] = sp.last_steps;
+        step_pulse["last_chunks"] = sp.last_chunks;
+        step_pulse["last_expected_ms"] = sp.last_expected_ms;
+        step_pulse["last_duration_ms"] = sp.last_duration_ms;
         
         // Распиновка (из pins.h)
         JsonObject pins = data["pins"].to<JsonObject>();
@@ -242,6 +879,88 @@ String getDiagnosticJson() {
     return response;
 }
 
+// Шеститочечная рампа в JSON (для пресетов, оценки времени)
+static void fillRampJson(JsonObject obj, const RampProfile &p) {
+    obj["vstart"] = p.vstart;
+    obj["a1"] = p.a1;
+    obj["v1"] = p.v1;
+    obj["amax"] = p.amax;
+    obj["vmax"] = p.vmax;
+    obj["dmax"] = p.dmax;
+    obj["d1"] = p.d1;
+    obj["vstop"] = p.vstop;
+}
+
+// Профиль рампы пресета
+static RampProfile presetRampProfile(const MotorPreset &preset) {
+    RampProfile p;
+    p.vstart = preset.vstart;
+    p.a1 = preset.a1;
+    p.v1 = preset.v1;
+    p.amax = preset.acceleration;
+    p.vmax = preset.max_speed;
+    p.dmax = preset.deceleration;
+    p.d1 = preset.d1;
+    p.vstop = preset.vstop;
+    return p;
+}
+
+// Поставить команду в очередь задачи движения. При переполнении сам отвечает 503.
+// Необязательные max_speed/acceleration/deceleration хода: не заданы - рампа не меняется.
+// nullptr - параметры корректны (или их нет)
+static const char* parseMoveRamp(AsyncWebServerRequest *request, MotionCommand &cmd) {
+    if (!request->hasParam("max_speed", true)) return nullptr;
+    MotorSettings current = get_settings_snapshot();
+    cmd.max_speed = request->getParam("max_speed", true)->value().toInt();
+    cmd.acceleration = request->hasParam("acceleration", true) ?
+        request->getParam("acceleration", true)->value().toInt() : current.acceleration;
+    cmd.deceleration = request->hasParam("deceleration", true) ?
+        request->getParam("deceleration", true)->value().toInt() : current.deceleration;
+    if (!validate_speed(cmd.max_speed)) return "Invalid speed value";
+    if (!validate_acceleration(cmd.acceleration) || !validate_acceleration(cmd.deceleration)) {
+        return "Invalid acceleration/deceleration values";
+    }
+    RampProfile ramp = get_ramp_profile(current);
+    ramp.vmax = cmd.max_speed;
+    ramp.amax = cmd.acceleration;
+    ramp.dmax = cmd.deceleration;
+    return ramp_profile_validate(ramp);
+}
+
+// Программа с LittleFS (или встроенная) → байткод → проверка тока/рамп → ждёт MOTION_CMD_RUN_SEQUENCE.
+// nullptr - готова, иначе текст ошибки в error
+static const char* prepareSequence(const String &name, String &error) {
+    static SeqProgram program;      // Только задача AsyncTCP
+    String source;
+    if (!sequence_name_valid(name)) return "Invalid sequence name";
+    if (!sequence_load_source(name, source)) return "Sequence not found";
+
+    SeqCompileResult compiled = seq_compile(source.c_str(), get_usteps_per_step(), program);
+    if (compiled.error) {
+        error = "Line " + String(compiled.line) + ": " + compiled.error;
+        return error.c_str();
+    }
+    uint16_t op_index = 0;
+    const char *invalid = sequence_validate(program, &op_index);
+    if (invalid) {
+        error = "Op " + String(op_index) + ": " + invalid;
+        return error.c_str();
+    }
+    sequence_set_pending(name, program);
+    return nullptr;
+}
+
+static bool enqueue_motion_or_reject(AsyncWebServerRequest *request, const MotionCommand &cmd) {
+    if (motion_enqueue(cmd)) return true;
+
+    JsonDocument doc;
+    doc["success"] = false;
+    doc["message"] = "Motion queue full, try again";
+    String response; serializeJson(doc, response);
+    request->send(503, "application/json", response);
+    return false;
+}
+
 void init_web_server() {
     // Главная страница
     server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
@@ -255,7 +974,9 @@ void init_web_server() {
 
     // API: Включить мотор
     server.on("/api/enable", HTTP_POST, [](AsyncWebServerRequest *request) {
-        enable_motor();
+        MotionCommand cmd = {};
+        cmd.type = MOTION_CMD_ENABLE;
+        if (!enqueue_motion_or_reject(request, cmd)) return;
         add_log("🔋 Motor enabled via API");
         add_log_to_web("🔋 Motor enabled via API");
         
@@ -270,7 +991,9 @@ void init_web_server() {
 
     // API: Выключить мотор
     server.on("/api/disable", HTTP_POST, [](AsyncWebServerRequest *request) {
-        disable_motor();
+        MotionCommand cmd = {};
+        cmd.type = MOTION_CMD_DISABLE;
+        if (!enqueue_motion_or_reject(request, cmd)) return;
         add_log("🔌 Motor disabled via API");
         add_log_to_web("🔌 Motor disabled via API");
         
@@ -285,22 +1008,39 @@ void init_web_server() {
 
     // API: Движение по шагам (с валидацией и выбором режима)
     server.on("/api/move", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (request->hasParam("steps", true)) {
-            int32_t steps = request->getParam("steps", true)->value().toInt();
+        if (request->hasParam("steps", true) || request->hasParam("usteps", true)) {
+            // Ход в шагах или (точнее) в микрошагах - в очередь всегда идут микрошаги int32
+            int32_t usteps = 0;
+            bool in_usteps = request->hasParam("usteps", true);
+            int64_t amount = 0;
+            bool parsed = parseInt64Param(request, in_usteps ? "usteps" : "steps", amount);
+            bool fits = parsed && (in_usteps ? usteps_move_valid(amount) : usteps_from_steps(amount, get_usteps_per_step(), &usteps));
+            if (!fits) {
+                JsonDocument doc;
+                doc["success"] = false;
+                doc["message"] = parsed ? "Move too long: max " + String((long)USTEPS_MAX_MOVE) + " µsteps per command"
+                                        : String(in_usteps ? "usteps" : "steps") + " must be an integer";
+                String response; serializeJson(doc, response);
+                request->send(400, "application/json", response);
+                return;
+            }
+            if (in_usteps) usteps = (int32_t)amount;
+            String amount_text = in_usteps ? String(usteps) + " µsteps" : String((int32_t)amount) + " steps";
 
             // Считываем параметры из запроса
+            MotorSettings current = get_settings_snapshot();
             uint16_t driver_current = request->hasParam("driver_current", true) ?
-                request->getParam("driver_current", true)->value().toInt() : currentSettings.current_mA;
+                request->getParam("driver_current", true)->value().toInt() : current.current_mA;
             float hold_mult = request->hasParam("hold_multiplier", true) ?
-                request->getParam("hold_multiplier", true)->value().toFloat() : currentSettings.hold_multiplier;
+                request->getParam("hold_multiplier", true)->value().toFloat() : current.hold_multiplier;
             uint16_t microsteps = request->hasParam("driver_microsteps", true) ?
-                request->getParam("driver_microsteps", true)->value().toInt() : currentSettings.microsteps;
+                request->getParam("driver_microsteps", true)->value().toInt() : current.microsteps;
             uint32_t max_speed = request->hasParam("max_speed", true) ?
-                request->getParam("max_speed", true)->value().toInt() : currentSettings.max_speed;
+                request->getParam("max_speed", true)->value().toInt() : current.max_speed;
             uint16_t acceleration = request->hasParam("acceleration", true) ?
-                request->getParam("acceleration", true)->value().toInt() : currentSettings.acceleration;
+                request->getParam("acceleration", true)->value().toInt() : current.acceleration;
             uint16_t deceleration = request->hasParam("deceleration", true) ?
-                request->getParam("deceleration", true)->value().toInt() : currentSettings.deceleration;
+                request->getParam("deceleration", true)->value().toInt() : current.deceleration;
 
             // Валидация параметров
             if (!validate_current(driver_current)) {
@@ -328,6 +1068,21 @@ void init_web_server() {
                 return;
             }
 
+            // Вся рампа с новыми VMAX/AMAX/DMAX должна оставаться корректной (VSTART <= VMAX и т.д.)
+            RampProfile ramp = get_ramp_profile(current);
+            ramp.vmax = max_speed;
+            ramp.amax = acceleration;
+            ramp.dmax = deceleration;
+            const char *ramp_error = ramp_profile_validate(ramp);
+            if (ramp_error) {
+                JsonDocument doc;
+                doc["success"] = false;
+                doc["message"] = "Invalid ramp: " + String(ramp_error);
+                String response; serializeJson(doc, response);
+                request->send(400, "application/json", response);
+                return;
+            }
+
             // Проверяем что TMC инициализирован
             if (!tmc_initialized) {
                 JsonDocument doc;
@@ -348,22 +1103,25 @@ void init_web_server() {
                 return;
             }
 
-            // Обновляем скорость/ускорение для этого движения (БЕЗ переинициализации!)
-            motor.setMaxSpeed(max_speed);
-            motor.setAcceleration(acceleration);
-            add_log("⚙️ Speed/Accel updated: VMAX=" + String(max_speed) + ", AMAX=" + String(acceleration));
-
-            // Используем режим из currentSettings
-            MotorControlMode mode = (MotorControlMode)currentSettings.control_mode;
-            move_motor_steps(steps, mode);
+            // Скорость/ускорение для этого движения (БЕЗ переинициализации!) применит задача движения
+            MotionCommand cmd = {};
+            cmd.type = MOTION_CMD_MOVE;
+            cmd.usteps = usteps;
+            cmd.max_speed = max_speed;
+            cmd.acceleration = acceleration;
+            cmd.deceleration = deceleration;
+            if (!enqueue_motion_or_reject(request, cmd)) return;
+
+            // Используем режим из настроек
+            MotorControlMode mode = (MotorControlMode)current.control_mode;
             
-            add_log("🚀 Movement: " + String(steps) + " steps in " + 
+            add_log("🚀 Movement: " + amount_text + " in " + 
                     String(mode == MODE_MOTION_CONTROLLER ? "Motion Controller" : "STEP/DIR") + " mode");
-            add_log_to_web("🚀 Movement started: " + String(steps) + " steps");
+            add_log_to_web("🚀 Movement started: " + amount_text);
 
             JsonDocument doc;
             doc["success"] = true;
-            doc["message"] = "Movement started: " + String(steps) + " steps in " + 
+            doc["message"] = "Movement started: " + amount_text + " in " + 
                               String(mode == MODE_MOTION_CONTROLLER ? "Motion Controller" : "STEP/DIR") + " mode";
 
             String response;
@@ -372,7 +1130,7 @@ void init_web_server() {
         } else {
             JsonDocument doc;
             doc["success"] = false;
-            doc["message"] = "Missing steps parameter";
+            doc["message"] = "Missing steps or usteps parameter";
 
             String response;
             serializeJson(doc, response);
@@ -380,54 +1138,221 @@ void init_web_server() {
         }
     });
 
-    // API: Движение по углу (используем текущий режим)
+    // API: Поворот выходного вала на угол (угол со знаком или direction=backward), с переносом
+    // дробных микрошагов между ходами. max_speed/acceleration/deceleration - необязательны
     server.on("/api/move_angle", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (request->hasParam("angle", true) && request->hasParam("direction", true)) {
-            float angle = request->getParam("angle", true)->value().toFloat();
-            String direction = request->getParam("direction", true)->value();
+        JsonDocument doc;
+        MotionCommand cmd = {};
+        cmd.type = MOTION_CMD_MOVE_ANGLE;
+        const char *error = nullptr;
+        if (!request->hasParam("angle", true)) error = "Missing angle parameter";
+        else if (!angle_parse_mdeg(request->getParam("angle", true)->value().c_str(), &cmd.angle_mdeg)) error = "Invalid angle";
+        else if (!tmc_initialized || !motor_enabled) error = "Motor is not enabled. Please enable motor first.";
+        else error = parseMoveRamp(request, cmd);
+        if (error) {
+            doc["success"] = false;
+            doc["message"] = error;
+            String response; serializeJson(doc, response);
+            request->send(400, "application/json", response);
+            return;
+        }
+        if (request->hasParam("direction", true) && request->getParam("direction", true)->value() == "backward") {
+            cmd.angle_mdeg = -cmd.angle_mdeg;
+        }
+        if (!enqueue_motion_or_reject(request, cmd)) return;
+
+        String angle_text = String((double)cmd.angle_mdeg / 1000.0, 3) + "°";
+        add_log_to_web("🔄 Angle movement: " + angle_text);
+
+        doc["success"] = true;
+        doc["message"] = "Angle movement started: " + angle_text;
+        doc["angle_mdeg"] = cmd.angle_mdeg;
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Поворот к углу от начала координат (0° = позиция 0 после хоминга/сброса), режим SPI
+    server.on("/api/move_to_angle", HTTP_POST, [](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        MotionCommand cmd = {};
+        cmd.type = MOTION_CMD_MOVE_TO_ANGLE;
+        const char *error = nullptr;
+        if (!request->hasParam("angle", true)) error = "Missing angle parameter";
+        else if (!angle_parse_mdeg(request->getParam("angle", true)->value().c_str(), &cmd.angle_mdeg)) error = "Invalid angle";
+        else if (get_settings_snapshot().control_mode != MODE_MOTION_CONTROLLER) error = "Absolute moves need Motion Controller mode";
+        else if (!tmc_initialized || !motor_enabled) error = "Motor is not enabled. Please enable motor first.";
+        else error = parseMoveRamp(request, cmd);
+        if (error) {
+            doc["success"] = false;
+            doc["message"] = error;
+            String response; serializeJson(doc, response);
+            request->send(400, "application/json", response);
+            return;
+        }
+        if (!enqueue_motion_or_reject(request, cmd)) return;
 
-            // Используем steps_per_rev из currentSettings
-            int32_t steps = (angle / 360.0) * currentSettings.steps_per_rev;
+        String angle_text = String((double)cmd.angle_mdeg / 1000.0, 3) + "°";
+        add_log_to_web("🎯 Move to angle " + angle_text);
 
-            add_log("📊 Angle: " + String(angle) + "°");
-            add_log("📊 Steps per rev: " + String(currentSettings.steps_per_rev));
-            add_log("📊 Calculated steps: " + String(steps));
+        doc["success"] = true;
+        doc["message"] = "Moving to " + angle_text;
+        doc["angle_mdeg"] = cmd.angle_mdeg;
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
 
-            if (direction == "backward") steps = -steps;
+    // Подпути - до "/api/move_queue": обработчик пути ловит и "/api/move_queue/..."
+    server.on("/api/move_queue/reset_stats", HTTP_POST, [](AsyncWebServerRequest *request) {
+        reset_move_queue_stats();
 
-            // Используем текущий режим
-            MotorControlMode mode = (MotorControlMode)currentSettings.control_mode;
-            move_motor_steps(steps, mode);
-            
-            add_log("🔄 Angle movement: " + String(angle) + "° " + direction + " (" + String(steps) + " steps)");
-            add_log_to_web("🔄 Angle movement: " + String(angle) + "° " + direction);
+        JsonDocument doc;
+        doc["success"] = true;
+        doc["message"] = "Move queue stats reset";
 
-            JsonDocument doc;
-            doc["success"] = true;
-            doc["message"] = "Angle movement started: " + String(angle) + "° " + direction;
-            doc["steps"] = steps;
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
 
-            String response;
-            serializeJson(doc, response);
-            request->send(200, "application/json", response);
-        } else {
-            JsonDocument doc;
+    // API: Сегменты в очередь абсолютных целей - все или ни одного (формат - move_segments.h).
+    // units=steps - цели в шагах (по умолчанию микрошаги). Исполнение начнётся само
+    server.on("/api/move_queue", HTTP_POST, [](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        static MoveSegment segments[MOVE_QUEUE_SIZE];     // Только задача AsyncTCP
+        bool in_steps = request->hasParam("units", true) && request->getParam("units", true)->value() == "steps";
+        MoveSegmentsParse parsed = {0, 0, nullptr};
+        String error;
+        if (!request->hasParam("segments", true)) error = "Missing segments parameter";
+        else if (get_settings_snapshot().control_mode != MODE_MOTION_CONTROLLER) error = "Move queue needs Motion Controller mode";
+        else if (!tmc_initialized || !motor_enabled) error = "Motor is not enabled. Please enable motor first.";
+        else if (is_homing_active() || is_sg_tune_active()) error = "Homing or SGT sweep in progress";
+        else {
+            parsed = move_segments_parse(request->getParam("segments", true)->value().c_str(),
+                                         in_steps ? get_usteps_per_step() : 1, segments, MOVE_QUEUE_SIZE);
+            if (parsed.error) error = "Segment " + String(parsed.error_at) + ": " + parsed.error;
+        }
+        // Рампа каждого сегмента проверяется здесь - задача движения её уже не отвергает
+        RampProfile base = get_ramp_profile(get_settings_snapshot());
+        for (uint16_t i = 0; error.isEmpty() && i < parsed.count; i++) {
+            const MoveSegment &seg = segments[i];
+            if ((seg.vmax && !validate_speed(seg.vmax)) || seg.amax > 0xFFFF || seg.dmax > 0xFFFF ||
+                (seg.amax && !validate_acceleration(seg.amax)) || (seg.dmax && !validate_acceleration(seg.dmax))) {
+                error = "Segment " + String(i) + ": invalid speed/acceleration";
+                break;
+            }
+            const char *ramp_error = ramp_profile_validate(move_segment_ramp(base, seg));
+            if (ramp_error) error = "Segment " + String(i) + ": " + ramp_error;
+        }
+        if (!error.isEmpty()) {
             doc["success"] = false;
-            doc["message"] = "Missing angle or direction parameter";
+            doc["message"] = error;
+            String response; serializeJson(doc, response);
+            request->send(400, "application/json", response);
+            return;
+        }
+        if (!move_queue_push(segments, parsed.count)) {
+            doc["success"] = false;
+            doc["message"] = "Move queue full: " + String(move_queue_free()) + " free, " + String(parsed.count) + " requested";
+            String response; serializeJson(doc, response);
+            request->send(503, "application/json", response);
+            return;
+        }
 
-            String response;
-            serializeJson(doc, response);
+        doc["success"] = true;
+        doc["message"] = String(parsed.count) + " segments queued";
+        JsonObject data = doc["data"].to<JsonObject>();
+        data["accepted"] = parsed.count;
+        data["free"] = move_queue_free();
+        String response; serializeJson(doc, response);
+        request->send(202, "application/json", response);
+    });
+
+    // API: Состояние очереди сегментов и время подгрузки следующей цели
+    server.on("/api/move_queue", HTTP_GET, [](AsyncWebServerRequest *request) {
+        MoveQueueStatus mq = get_move_queue_status();
+        JsonDocument doc;
+        doc["success"] = true;
+        JsonObject data = doc["data"].to<JsonObject>();
+        data["active"] = mq.active;
+        data["depth"] = mq.depth;
+        data["capacity"] = mq.capacity;
+        data["next_ready"] = mq.next_ready;
+        data["current_target"] = mq.current_target;
+        data["enqueued"] = mq.enqueued;
+        data["executed"] = mq.executed;
+        data["completed"] = mq.completed;
+        data["aborted"] = mq.aborted;
+        data["rejected"] = mq.rejected;
+        if (mq.last_abort_reason) data["last_abort_reason"] = mq.last_abort_reason;
+        JsonObject handoff = data["handoff"].to<JsonObject>();
+        handoff["last_us"] = mq.handoff_last_us;
+        handoff["avg_us"] = mq.handoff_avg_us;
+        handoff["max_us"] = mq.handoff_max_us;
+        handoff["regs_written_last"] = mq.regs_written_last;
+        // Пауза между сегментами целиком (обнаружение + подгрузка) - мёртвое время событий движения
+        MoveEventStats ms = get_move_event_stats();
+        handoff["dead_time_last_ms"] = ms.dead_time_last_ms;
+        handoff["dead_time_avg_ms"] = ms.dead_time_avg_ms;
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Движение к абсолютной позиции (микрошаги или шаги), только режим Motion Controller
+    server.on("/api/move_to", HTTP_POST, [](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        bool in_usteps = request->hasParam("usteps", true);
+        int32_t target = 0;
+        int64_t amount = 0;
+        const char *error = nullptr;
+        if (!in_usteps && !request->hasParam("steps", true)) error = "Missing usteps or steps parameter";
+        else if (get_settings_snapshot().control_mode != MODE_MOTION_CONTROLLER) error = "Absolute moves need Motion Controller mode";
+        else if (!tmc_initialized || !motor_enabled) error = "Motor is not enabled. Please enable motor first.";
+        else if (!parseInt64Param(request, in_usteps ? "usteps" : "steps", amount)) error = "Target must be an integer";
+        // Позиция на оси 32 бита: цель должна поместиться в int32 микрошагов
+        else if (in_usteps ? (amount < INT32_MIN || amount > INT32_MAX)
+                           : !usteps_from_steps(amount, get_usteps_per_step(), &target))
+            error = "Target out of int32 µstep range";
+        else if (in_usteps) target = (int32_t)amount;
+        if (error) {
+            doc["success"] = false;
+            doc["message"] = error;
+            String response; serializeJson(doc, response);
             request->send(400, "application/json", response);
+            return;
         }
+
+        MotionCommand cmd = {};
+        cmd.type = MOTION_CMD_MOVE_TO;
+        cmd.usteps = target;
+        if (!enqueue_motion_or_reject(request, cmd)) return;
+        add_log_to_web("🎯 Move to " + String(target) + " µsteps");
+
+        doc["success"] = true;
+        doc["message"] = "Moving to " + String(target) + " µsteps";
+        doc["target_usteps"] = target;
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
     });
 
-    // API: Движение от центра
+    // API: Движение от центра - встроенная программа "center" (или её замена с LittleFS)
     server.on("/api/move_from_center", HTTP_POST, [](AsyncWebServerRequest *request) {
-        start_center_sequence(); // КРИТИЧЕСКОЕ ИСПРАВЛЕНИЕ!
+        JsonDocument doc;
+        String error;
+        const char *message = !tmc_initialized || !motor_enabled ? "Motor is not enabled. Please enable motor first."
+                            : prepareSequence(SEQUENCE_BUILTIN_CENTER, error);
+        if (message) {
+            doc["success"] = false;
+            doc["message"] = message;
+            String response; serializeJson(doc, response);
+            request->send(400, "application/json", response);
+            return;
+        }
+        MotionCommand cmd = {};
+        cmd.type = MOTION_CMD_RUN_SEQUENCE;
+        if (!enqueue_motion_or_reject(request, cmd)) return;
         add_log("🎯 Center sequence initiated");
         add_log_to_web("🎯 Center sequence initiated");
         
-        JsonDocument doc;
         doc["success"] = true;
         doc["message"] = "Center cycle initiated";
         
@@ -436,14 +1361,156 @@ void init_web_server() {
         request->send(200, "application/json", response);
     });
 
+    // Подпути - до "/api/sequence": обработчик пути ловит и "/api/sequence/..."
+    // API: Запустить программу движения (name) - компилируется здесь, исполняет задача движения
+    server.on("/api/sequence/run", HTTP_POST, [](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        String error;
+        String name = request->hasParam("name", true) ? request->getParam("name", true)->value() : String("");
+        const char *message = !request->hasParam("name", true) ? "Missing name parameter"
+                            : !tmc_initialized || !motor_enabled ? "Motor is not enabled. Please enable motor first."
+                            : prepareSequence(name, error);
+        if (message) {
+            doc["success"] = false;
+            doc["message"] = message;
+            String response; serializeJson(doc, response);
+            request->send(400, "application/json", response);
+            return;
+        }
+        MotionCommand cmd = {};
+        cmd.type = MOTION_CMD_RUN_SEQUENCE;
+        if (!enqueue_motion_or_reject(request, cmd)) return;
+        add_log_to_web("▶️ Sequence '" + name + "' queued");
+
+        doc["success"] = true;
+        doc["message"] = "Sequence '" + name + "' started";
+        String response; serializeJson(doc, response);
+        request->send(202, "application/json", response);
+    });
+
+    // API: Прервать программу (ход останавливается с DMAX, ток и рампа - из настроек)
+    server.on("/api/sequence/stop", HTTP_POST, [](AsyncWebServerRequest *request) {
+        MotionCommand cmd = {};
+        cmd.type = MOTION_CMD_STOP_SEQUENCE;
+        if (!enqueue_motion_or_reject(request, cmd)) return;
+
+        JsonDocument doc;
+        doc["success"] = true;
+        doc["message"] = "Sequence stopped";
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Удалить программу с LittleFS (встроенная "center" после этого - снова исходная)
+    server.on("/api/sequence/delete", HTTP_POST, [](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        String name = request->hasParam("name", true) ? request->getParam("name", true)->value() : String("");
+        if (!sequence_name_valid(name) || !sequence_remove(name)) {
+            doc["success"] = false;
+            doc["message"] = "Sequence not found";
+            String response; serializeJson(doc, response);
+            request->send(404, "application/json", response);
+            return;
+        }
+        doc["success"] = true;
+        doc["message"] = "Sequence '" + name + "' deleted";
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Имена программ на LittleFS и встроенных
+    server.on("/api/sequence/list", HTTP_GET, [](AsyncWebServerRequest *request) {
+        String names[SEQUENCE_LIST_MAX];
+        uint8_t count = sequence_list(names, SEQUENCE_LIST_MAX);
+
+        JsonDocument doc;
+        doc["success"] = true;
+        JsonArray data = doc["data"].to<JsonArray>();
+        for (uint8_t i = 0; i < count; i++) data.add(names[i]);
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Сохранить программу (name, program) - сначала компилируется, с ошибкой не сохраняется
+    server.on("/api/sequence", HTTP_POST, [](AsyncWebServerRequest *request) {
+        static SeqProgram program;      // Только задача AsyncTCP
+        JsonDocument doc;
+        String name = request->hasParam("name", true) ? request->getParam("name", true)->value() : String("");
+        String source = request->hasParam("program", true) ? request->getParam("program", true)->value() : String("");
+        String error;
+        if (!sequence_name_valid(name)) error = "Invalid sequence name (1-" + String(SEQUENCE_NAME_MAX) + " of a-z, 0-9, _, -)";
+        else if (!request->hasParam("program", true)) error = "Missing program parameter";
+        else if (source.length() > SEQUENCE_SOURCE_MAX) error = "Program too large";
+        else {
+            SeqCompileResult compiled = seq_compile(source.c_str(), get_usteps_per_step(), program);
+            if (compiled.error) error = "Line " + String(compiled.line) + ": " + compiled.error;
+        }
+        if (!error.isEmpty()) {
+            doc["success"] = false;
+            doc["message"] = error;
+            String response; serializeJson(doc, response);
+            request->send(400, "application/json", response);
+            return;
+        }
+        if (!sequence_save_source(name, source)) {
+            doc["success"] = false;
+            doc["message"] = "Cannot write " + sequence_path(name);
+            String response; serializeJson(doc, response);
+            request->send(500, "application/json", response);
+            return;
+        }
+
+        doc["success"] = true;
+        doc["message"] = "Sequence '" + name + "' saved";
+        JsonObject data = doc["data"].to<JsonObject>();
+        data["ops"] = program.ops;
+        data["program_bytes"] = seq_program_bytes(program);
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // После подпутей. API: Ход программы; с name - ещё её текст
+    server.on("/api/sequence", HTTP_GET, [](AsyncWebServerRequest *request) {
+        SequenceStatus ss = get_sequence_status();
+        JsonDocument doc;
+        doc["success"] = true;
+        JsonObject data = doc["data"].to<JsonObject>();
+        data["active"] = ss.active;
+        data["name"] = ss.name;
+        data["state"] = seq_state_name(ss.state);
+        data["pc"] = ss.pc;
+        data["code_words"] = ss.code_words;
+        data["ops_executed"] = ss.ops_executed;
+        data["actions"] = ss.actions;
+        data["runs"] = ss.runs;
+        data["elapsed_ms"] = ss.elapsed_ms;
+        if (ss.error) data["error"] = ss.error;
+
+        if (request->hasParam("name")) {
+            String name = request->getParam("name")->value();
+            String source;
+            if (!sequence_name_valid(name) || !sequence_load_source(name, source)) {
+                doc["success"] = false;
+                doc["message"] = "Sequence not found";
+                String response; serializeJson(doc, response);
+                request->send(404, "application/json", response);
+                return;
+            }
+            data["program"] = source;
+        }
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
     // API: Экстренная остановка
     server.on("/api/emergency_stop", HTTP_POST, [](AsyncWebServerRequest *request) {
+        // Силовой каскад снимаем сразу, без очереди и SPI; остановку рампы делает задача движения
         digitalWrite(EN_PIN, HIGH);
         motor_enabled = false;
         
-        if (tmc_initialized) {
-            motor.stop();  // КАК В ПРИМЕРЕ!
-        }
+        MotionCommand cmd = {};
+        cmd.type = MOTION_CMD_EMERGENCY_STOP;
+        motion_enqueue(cmd);
         
         add_log("🚨 EMERGENCY STOP activated!");
         add_log_to_web("🚨 EMERGENCY STOP activated!");
@@ -465,18 +1532,9 @@ void init_web_server() {
             if (preset_id >= 0 && preset_id < NEMA_PRESETS_COUNT) {
                 const MotorPreset& preset = NEMA_PRESETS[preset_id];
                 
-                bool success = setup_tmc5160(
-                    preset.current_mA,
-                    preset.hold_mult,
-                    preset.microsteps,
-                    preset.max_speed,
-                    preset.acceleration,
-                    preset.deceleration
-                );
-                
-                if (success) {
-                    // Сохраняем настройки в EEPROM и currentSettings
-                    MotorSettings newSettings;
+                {
+                    // Переинициализацию и сохранение в EEPROM выполнит задача движения (остальные поля - как были)
+                    MotorSettings newSettings = get_settings_snapshot();
                     newSettings.current_mA = preset.current_mA;
                     newSettings.hold_multiplier = preset.hold_mult;  // ✅ Добавлено!
                     newSettings.microsteps = preset.microsteps;
@@ -484,20 +1542,33 @@ void init_web_server() {
                     newSettings.acceleration = preset.acceleration;
                     newSettings.deceleration = preset.deceleration;
                     newSettings.steps_per_rev = preset.steps_per_rev;
+                    newSettings.vstart = preset.vstart;
+                    newSettings.a1 = preset.a1;
+                    newSettings.v1 = preset.v1;
+                    newSettings.d1 = preset.d1;
+                    newSettings.vstop = preset.vstop;
                     newSettings.control_mode = MODE_MOTION_CONTROLLER;
-                    
-                    if (saveMotorSettings(newSettings)) {
-                        currentSettings = newSettings;
-                        add_log("💾 Preset settings saved to EEPROM");
-                        add_log_to_web("💾 Preset settings saved to EEPROM");
+
+                    // Порог StallGuard, измеренный свипом для этого пресета (/api/sg_tune)
+                    int8_t tuned_sgt = 0;
+                    uint32_t tuned_tcoolthrs = 0;
+                    bool tuned = sg_tune_load_preset(preset_id, &tuned_sgt, &tuned_tcoolthrs);
+                    if (tuned) {
+                        newSettings.stallguard_threshold = tuned_sgt;
+                        newSettings.stallguard_tcoolthrs = tuned_tcoolthrs;
                     }
                     
+                    MotionCommand cmd = {};
+                    cmd.type = MOTION_CMD_APPLY_SETTINGS;
+                    cmd.settings = newSettings;
+                    if (!enqueue_motion_or_reject(request, cmd)) return;
+                    
                     add_log("⚙️ Preset applied: " + String(preset.name));
                     add_log_to_web("⚙️ Preset applied: " + String(preset.name));
                     
                     JsonDocument doc;
                     doc["success"] = true;
-                    doc["message"] = "Preset " + String(preset.name) + " applied and saved";
+                    doc["message"] = "Preset " + String(preset.name) + " queued for apply and save";
                     
                     JsonObject data = doc["data"].to<JsonObject>();
                     data["name"] = preset.name;
@@ -508,18 +1579,15 @@ void init_web_server() {
                     data["acceleration"] = preset.acceleration;
                     data["deceleration"] = preset.deceleration;
                     data["steps_per_rev"] = preset.steps_per_rev;
+                    fillRampJson(data["ramp"].to<JsonObject>(), presetRampProfile(preset));
+                    if (tuned) {
+                        data["sgt"] = tuned_sgt;
+                        data["tcoolthrs"] = tuned_tcoolthrs;
+                    }
                     
                     String response;
                     serializeJson(doc, response);
                     request->send(200, "application/json", response);
-                } else {
-                    JsonDocument doc;
-                    doc["success"] = false;
-                    doc["message"] = "Failed to apply preset";
-                    
-                    String response;
-                    serializeJson(doc, response);
-                    request->send(500, "application/json", response);
                 }
             } else {
                 JsonDocument doc;
@@ -557,19 +1625,225 @@ void init_web_server() {
             o["max_speed"] = p.max_speed;
             o["acceleration"] = p.acceleration;
             o["deceleration"] = p.deceleration;
+            fillRampJson(o["ramp"].to<JsonObject>(), presetRampProfile(p));
+            int8_t sgt = 0;
+            uint32_t tcoolthrs = 0;
+            if (sg_tune_load_preset(i, &sgt, &tcoolthrs)) {
+                o["sgt"] = sgt;
+                o["tcoolthrs"] = tcoolthrs;
+            }
+        }
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Диагностика
+    server.on("/api/diagnostic", HTTP_GET, [](AsyncWebServerRequest *request) {
+        request->send(200, "application/json", getDiagnosticJson());
+    });
+
+    // API: Тень регистров - статистика и макс. возраст кэша "живых" регистров
+    server.on("/api/register_cache", HTTP_GET, [](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        if (!tmc_initialized) {
+            doc["success"] = false;
+            doc["message"] = "TMC5160 not initialized";
+            String response; serializeJson(doc, response);
+            request->send(400, "application/json", response);
+            return;
+        }
+        static ShadowStatsCopy stats;
+        if (!motion_call(readShadowStats, &stats)) {
+            doc["success"] = false;
+            doc["message"] = "Motion task busy";
+            String response; serializeJson(doc, response);
+            request->send(503, "application/json", response);
+            return;
+        }
+        doc["success"] = true;
+        JsonObject data = doc["data"].to<JsonObject>();
+        fillRegisterCacheJson(data, stats);
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    server.on("/api/register_cache", HTTP_POST, [](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        if (!tmc_initialized) {
+            doc["success"] = false;
+            doc["message"] = "TMC5160 not initialized";
+            String response; serializeJson(doc, response);
+            request->send(400, "application/json", response);
+            return;
+        }
+        
+        // Тень меняет задача движения - параметры через static, как и для чтений
+        static RegisterCacheUpdate update;
+        if (motion_call_pending()) {
+            doc["success"] = false;
+            doc["message"] = "Motion task busy";
+            String response; serializeJson(doc, response);
+            request->send(503, "application/json", response);
+            return;
+        }
+        update = {};
+        if (request->hasParam("max_age_ms", true)) {
+            long max_age = request->getParam("max_age_ms", true)->value().toInt();
+            if (max_age < 0 || max_age > 10000) {
+                doc["success"] = false;
+                doc["message"] = "Invalid max_age_ms (0-10000)";
+                String response; serializeJson(doc, response);
+                request->send(400, "application/json", response);
+                return;
+            }
+            update.set_max_age = true;
+            update.max_age_ms = (uint32_t)max_age;
+        }
+        update.reset = request->hasParam("reset", true);
+        if (!motion_call(applyRegisterCacheUpdate, &update)) {
+            doc["success"] = false;
+            doc["message"] = "Motion task busy";
+            String response; serializeJson(doc, response);
+            request->send(503, "application/json", response);
+            return;
+        }
+        if (update.set_max_age) add_log("🔧 Register cache max age: " + String(update.max_age_ms) + " ms");
+        
+        doc["success"] = true;
+        doc["max_age_ms"] = update.max_age_ms;
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Бенчмарк опроса статуса - раздельные чтения (как раньше) против конвейерного снимка
+    server.on("/api/spi_benchmark", HTTP_GET, [](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        if (!tmc_initialized) {
+            doc["success"] = false;
+            doc["message"] = "TMC5160 not initialized";
+            String response; serializeJson(doc, response);
+            request->send(400, "application/json", response);
+            return;
+        }
+        
+        int iterations = request->hasParam("iterations") ? request->getParam("iterations")->value().toInt() : 20;
+        iterations = constrain(iterations, 1, 200);
+        
+        // Замер идёт в задаче движения
+        static SpiBenchmark bench;
+        if (motion_call_pending()) {
+            doc["success"] = false;
+            doc["message"] = "Motion task busy";
+            String response; serializeJson(doc, response);
+            request->send(503, "application/json", response);
+            return;
+        }
+        bench = {};
+        bench.iterations = iterations;
+        if (!motion_call(runSpiBenchmark, &bench, SPI_BENCHMARK_TIMEOUT_MS)) {
+            doc["success"] = false;
+            doc["message"] = "Motion task busy or benchmark timed out";
+            String response; serializeJson(doc, response);
+            request->send(503, "application/json", response);
+            return;
+        }
+        
+        doc["success"] = true;
+        JsonObject data = doc["data"].to<JsonObject>();
+        data["iterations"] = iterations;
+        data["legacy_datagrams_per_poll"] = (float)bench.legacy_datagrams / iterations;
+        data["legacy_us_per_poll"] = (float)bench.legacy_us / iterations;
+        data["snapshot_datagrams_per_poll"] = (float)bench.snapshot_datagrams / iterations;
+        data["snapshot_us_per_poll"] = (float)bench.snapshot_us / iterations;
+        
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Оценка времени движения для текущей рампы и всех пресетов (сравнение профилей)
+    server.on("/api/ramp_estimate", HTTP_GET, [](AsyncWebServerRequest *request) {
+        MotorSettings settings = get_settings_snapshot();
+        uint32_t distance = request->hasParam("distance") ? request->getParam("distance")->value().toInt() : settings.steps_per_rev;
+        
+        // Текущая рампа с необязательными переопределениями
+        RampProfile current = get_ramp_profile(settings);
+        if (request->hasParam("vstart")) current.vstart = request->getParam("vstart")->value().toInt();
+        if (request->hasParam("a1")) current.a1 = request->getParam("a1")->value().toInt();
+        if (request->hasParam("v1")) current.v1 = request->getParam("v1")->value().toInt();
+        if (request->hasParam("amax")) current.amax = request->getParam("amax")->value().toInt();
+        if (request->hasParam("vmax")) current.vmax = request->getParam("vmax")->value().toInt();
+        if (request->hasParam("dmax")) current.dmax = request->getParam("dmax")->value().toInt();
+        if (request->hasParam("d1")) current.d1 = request->getParam("d1")->value().toInt();
+        if (request->hasParam("vstop")) current.vstop = request->getParam("vstop")->value().toInt();
+        
+        JsonDocument doc;
+        const char *ramp_error = ramp_profile_validate(current);
+        if (ramp_error) {
+            doc["success"] = false;
+            doc["message"] = "Invalid ramp: " + String(ramp_error);
+            String response; serializeJson(doc, response);
+            request->send(400, "application/json", response);
+            return;
+        }
+        
+        doc["success"] = true;
+        JsonObject data = doc["data"].to<JsonObject>();
+        data["distance"] = distance;
+        JsonObject cur = data["current"].to<JsonObject>();
+        fillRampJson(cur["ramp"].to<JsonObject>(), current);
+        cur["time_ms"] = estimate_move_time_ms(current, distance);
+        
+        JsonArray presets = data["presets"].to<JsonArray>();
+        for (int i = 0; i < NEMA_PRESETS_COUNT; i++) {
+            RampProfile p = presetRampProfile(NEMA_PRESETS[i]);
+            JsonObject o = presets.add<JsonObject>();
+            o["id"] = i;
+            o["name"] = NEMA_PRESETS[i].name;
+            fillRampJson(o["ramp"].to<JsonObject>(), p);
+            o["time_ms"] = estimate_move_time_ms(p, distance);
+        }
+        
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Перекалибровать частоту SPI
+    server.on("/api/spi_calibrate", HTTP_POST, [](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        if (!tmc_initialized) {
+            doc["success"] = false;
+            doc["message"] = "TMC5160 not initialized";
+            String response; serializeJson(doc, response);
+            request->send(400, "application/json", response);
+            return;
+        }
+        if (!position_reached_cached(peek_motion_snapshot())) {
+            doc["success"] = false;
+            doc["message"] = "Motor is moving, stop it before SPI calibration";
+            String response; serializeJson(doc, response);
+            request->send(400, "application/json", response);
+            return;
         }
+        
+        // Калибровка занимает сотни мс - выполняет задача движения, результат в /api/diagnostic
+        MotionCommand cmd = {};
+        cmd.type = MOTION_CMD_CALIBRATE_SPI;
+        if (!enqueue_motion_or_reject(request, cmd)) return;
+        
+        doc["success"] = true;
+        doc["message"] = "SPI calibration queued";
+        doc["clock_hz"] = motor.getSpiClock();
         String response; serializeJson(doc, response);
-        request->send(200, "application/json", response);
-    });
-
-    // API: Диагностика
-    server.on("/api/diagnostic", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(200, "application/json", getDiagnosticJson());
+        request->send(202, "application/json", response);
     });
 
     // API: Подробная диагностика
     server.on("/api/detailed_diagnostics", HTTP_GET, [](AsyncWebServerRequest *request) {
-        String diagnostics = get_detailed_diagnostics();
+        static String diagnostics;
+        if (!motion_call(readDetailedDiagnostics, &diagnostics)) {
+            request->send(503, "text/plain", "Motion task busy");
+            return;
+        }
         request->send(200, "text/plain", diagnostics);
     });
 
@@ -589,9 +1863,13 @@ void init_web_server() {
         if (request->hasParam("amps", true)) {
             const float amps = request->getParam("amps", true)->value().toFloat();
             const uint16_t mA = (uint16_t)roundf(amps * 1000.0f);
-            const float hold = currentSettings.hold_multiplier;
+            const float hold = get_settings_snapshot().hold_multiplier;
 
-            set_motor_current(mA, hold);
+            MotionCommand cmd = {};
+            cmd.type = MOTION_CMD_SET_CURRENT;
+            cmd.current_mA = mA;
+            cmd.hold_multiplier = hold;
+            if (!enqueue_motion_or_reject(request, cmd)) return;
             add_log("🔧 Current set via API (amps): " + String(amps, 3) + "A");
             add_log_to_web("🔧 Current set via API (amps): " + String(amps, 3) + "A");
 
@@ -609,10 +1887,36 @@ void init_web_server() {
     });
 
     // API: Остановка движения
-    server.on("/api/stop", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (tmc_initialized) {
-            motor.stop();  // КАК В ПРИМЕРЕ!
+    // API: Режим скорости (jog). Слайдер шлёт 20+ запросов/с - без очереди, ответ короткий
+    server.on("/api/jog", HTTP_POST, [](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        int code = 200;
+        int64_t speed = 0;
+
+        if (!request->hasParam("speed", true) || !parseInt64Param(request, "speed", speed) ||
+            speed < -(int64_t)MAX_SPEED_STEPS || speed > (int64_t)MAX_SPEED_STEPS) {
+            code = 400;
+            doc["message"] = "Invalid speed (steps/s, |speed| <= " + String(MAX_SPEED_STEPS) + ")";
+        } else if (!tmc_initialized || !motor_enabled) {
+            code = 400;
+            doc["message"] = "Motor is not enabled. Please enable motor first.";
+        } else if (get_settings_snapshot().control_mode != MODE_MOTION_CONTROLLER) {
+            code = 400;
+            doc["message"] = "Jog requires SPI motion controller mode";
+        } else {
+            motion_request_jog((int32_t)speed);
+            doc["speed"] = (int32_t)speed;
         }
+        doc["success"] = (code == 200);
+
+        String response; serializeJson(doc, response);
+        request->send(code, "application/json", response);
+    });
+
+    server.on("/api/stop", HTTP_POST, [](AsyncWebServerRequest *request) {
+        MotionCommand cmd = {};
+        cmd.type = MOTION_CMD_STOP;
+        if (!enqueue_motion_or_reject(request, cmd)) return;
         add_log("⏹️ Movement stopped via API");
         add_log_to_web("⏹️ Movement stopped via API");
         
@@ -627,10 +1931,9 @@ void init_web_server() {
 
     // API: Сброс позиции
     server.on("/api/reset", HTTP_POST, [](AsyncWebServerRequest *request) {
-        if (tmc_initialized) {
-            motor.setCurrentPosition(0);  // КАК В ПРИМЕРЕ!
-            motor.setTargetPosition(0);
-        }
+        MotionCommand cmd = {};
+        cmd.type = MOTION_CMD_RESET_POSITION;
+        if (!enqueue_motion_or_reject(request, cmd)) return;
         add_log("🔄 Position reset via API");
         add_log_to_web("🔄 Position reset via API");
         
@@ -643,20 +1946,338 @@ void init_web_server() {
         request->send(200, "application/json", response);
     });
 
-    // API: Логи
-    server.on("/api/logs", HTTP_GET, [](AsyncWebServerRequest *request) {
+    // API: Журнал ошибок драйвера (DIAG0) и задержка "фронт → EN снят"
+    server.on("/api/faults", HTTP_GET, [](AsyncWebServerRequest *request) {
+        FaultMonitorStats fs = get_fault_monitor_stats();
         JsonDocument doc;
         doc["success"] = true;
-        doc["data"] = system_logs;
-        
+        JsonObject data = doc["data"].to<JsonObject>();
+        data["latched"] = fs.latched;
+        data["stall_routed"] = fs.stall_routed;
+        data["diag_edges"] = fs.diag_edges;
+        data["stall_edges"] = fs.stall_edges;
+        data["faults"] = fs.faults;
+        data["warnings"] = fs.warnings;
+
+        JsonObject latency = data["latency_us"].to<JsonObject>();
+        latency["isr_last"] = fs.hard_latency_last_us;
+        latency["isr_max"] = fs.hard_latency_max_us;
+        latency["task_last"] = fs.soft_latency_last_us;
+        latency["task_max"] = fs.soft_latency_max_us;
+
+        FaultLogEntry list[FAULT_LOG_SIZE];
+        uint8_t count = get_fault_log(list, FAULT_LOG_SIZE);
+        JsonArray arr = data["log"].to<JsonArray>();
+        for (uint8_t i = 0; i < count; i++) {
+            fillFaultEntryJson(arr.add<JsonObject>(), list[i]);
+        }
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Очистить журнал ошибок драйвера (отключение снимается только включением мотора)
+    server.on("/api/faults/clear", HTTP_POST, [](AsyncWebServerRequest *request) {
+        clear_fault_log();
+
+        JsonDocument doc;
+        doc["success"] = true;
+        doc["message"] = "Fault log cleared";
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Фоновый контроль драйвера - otpw/ot, CS_ACTUAL, тепловое снижение тока
+    server.on("/api/health", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HealthStatus hs = get_health_status();
+        JsonDocument doc;
+        doc["success"] = true;
+        JsonObject data = doc["data"].to<JsonObject>();
+        data["samples"] = hs.samples;
+        data["sample_period_ms"] = DERATE_SAMPLE_PERIOD_MS;
+        data["otpw"] = hs.otpw;
+        data["ot"] = hs.ot;
+        data["cs_actual"] = hs.cs_actual;
+        data["cs_min"] = hs.cs_min;
+        data["cs_max"] = hs.cs_max;
+
+        JsonObject derating = data["derating"].to<JsonObject>();
+        derating["enabled"] = hs.derating_enabled;
+        derating["percent"] = hs.percent;
+        derating["requested_mA"] = hs.requested_mA;
+        derating["effective_mA"] = hs.effective_mA;
+        derating["steps_down"] = hs.derate.steps_down;
+        derating["steps_up"] = hs.derate.steps_up;
+        derating["min_percent_reached"] = hs.derate.min_reached;
+        derating["reduced_ms"] = hs.derate.reduced_ms;
+        derating["otpw_ms"] = hs.derate.otpw_ms;
+        derating["ot_events"] = hs.derate.ot_events;
+        fillDeratePolicyJson(derating["policy"].to<JsonObject>(), get_derate_policy());
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Сбросить счётчики контроля драйвера (текущее снижение тока остаётся)
+    server.on("/api/health/reset", HTTP_POST, [](AsyncWebServerRequest *request) {
+        reset_health_stats();
+
+        JsonDocument doc;
+        doc["success"] = true;
+        doc["message"] = "Health stats reset";
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Политика теплового снижения тока (enabled, persist_ms, cool_ms, step_interval_ms, step_percent, min_percent)
+    server.on("/api/derating", HTTP_POST, [](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        DeratePolicy policy = parseDeratePolicy(request);
+        bool enabled = request->hasParam("enabled", true) ? request->getParam("enabled", true)->value() != "0"
+                                                          : get_health_status().derating_enabled;
+        const char *error = derate_policy_validate(policy);
+        if (error) {
+            doc["success"] = false;
+            doc["message"] = error;
+            String response; serializeJson(doc, response);
+            request->send(400, "application/json", response);
+            return;
+        }
+
+        set_derate_policy(policy, enabled);
+        add_log_to_web(String("🌡️ Thermal derating ") + (enabled ? "enabled" : "disabled"));
+
+        doc["success"] = true;
+        doc["message"] = "Derating policy updated";
+        JsonObject data = doc["data"].to<JsonObject>();
+        data["enabled"] = enabled;
+        fillDeratePolicyJson(data["policy"].to<JsonObject>(), policy);
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: События завершения движения (since - последний известный клиенту seq) и мёртвое время
+    server.on("/api/move_events", HTTP_GET, [](AsyncWebServerRequest *request) {
+        uint32_t since = request->hasParam("since") ? request->getParam("since")->value().toInt() : 0;
+
+        JsonDocument doc;
+        doc["success"] = true;
+        JsonObject data = doc["data"].to<JsonObject>();
+        data["last_seq"] = move_events_last_seq();
+        data["in_flight"] = move_in_flight();
+
+        MoveDoneEvent list[MOVE_EVENT_RING_SIZE];
+        uint8_t count = move_events_since(since, list, MOVE_EVENT_RING_SIZE);
+        JsonArray arr = data["events"].to<JsonArray>();
+        for (uint8_t i = 0; i < count; i++) {
+            fillMoveEventJson(arr.add<JsonObject>(), list[i]);
+        }
+
+        MoveEventStats me = get_move_event_stats();
+        data["stalled"] = me.stalled;
+        JsonObject dead = data["dead_time"].to<JsonObject>();
+        dead["last_ms"] = me.dead_time_last_ms;
+        dead["avg_ms"] = me.dead_time_avg_ms;
+        dead["max_ms"] = me.dead_time_max_ms;
+        dead["samples"] = me.dead_time_samples;
+
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Sensorless homing - быстрый подход, отъезд, медленный подход (параметры фаз необязательны)
+    server.on("/api/home", HTTP_POST, [](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        HomingConfig config = parseHomingConfig(request);
+        const char *error = homing_config_validate(config);
+        for (uint8_t i = 0; !error && i < HOMING_PHASE_COUNT; i++) {
+            if (!validate_current(config.phases[i].current_mA)) error = "phase current out of range";
+            else if (!validate_speed(config.phases[i].speed)) error = "phase speed out of range";
+        }
+        if (!error && (!tmc_initialized || !motor_enabled)) error = "Motor is not enabled. Please enable motor first.";
+        if (!error && get_settings_snapshot().control_mode != MODE_MOTION_CONTROLLER) error = "Homing requires SPI motion controller mode";
+        if (!error && !homing_configure(config)) error = "Homing already in progress";
+        if (error) {
+            doc["success"] = false;
+            doc["message"] = error;
+            String response; serializeJson(doc, response);
+            request->send(400, "application/json", response);
+            return;
+        }
+
+        MotionCommand cmd = {};
+        cmd.type = MOTION_CMD_HOME;
+        if (!enqueue_motion_or_reject(request, cmd)) return;
+
+        doc["success"] = true;
+        doc["message"] = "Homing queued, progress in /api/homing";
+        fillHomingConfigJson(doc["data"].to<JsonObject>(), config);
+        String response; serializeJson(doc, response);
+        request->send(202, "application/json", response);
+    });
+
+    // API: Состояние хоминга, время и повторяемость
+    server.on("/api/homing", HTTP_GET, [](AsyncWebServerRequest *request) {
+        HomingStatus hs = get_homing_status();
+        JsonDocument doc;
+        doc["success"] = true;
+        JsonObject data = doc["data"].to<JsonObject>();
+        data["state"] = homing_state_name(hs.state);
+        if (hs.error) data["error"] = hs.error;
+        data["runs"] = hs.runs;
+        data["successes"] = hs.successes;
+        data["failures"] = hs.failures;
+        data["last_duration_ms"] = hs.last_duration_ms;
+        data["fast_latch"] = hs.fast_latch;
+        data["slow_latch"] = hs.slow_latch;
+        data["origin_valid"] = hs.origin_valid;
+
+        JsonObject repeat = data["repeatability"].to<JsonObject>();
+        repeat["samples"] = hs.repeat.samples;
+        repeat["spread_usteps"] = homing_repeatability_spread(hs.repeat);
+        repeat["min_usteps"] = hs.repeat.min;
+        repeat["max_usteps"] = hs.repeat.max;
+        repeat["mean_usteps"] = hs.repeat.samples ? (float)hs.repeat.sum / hs.repeat.samples : 0.0f;
+
+        fillHomingConfigJson(data["config"].to<JsonObject>(), get_homing_config());
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Свип SGT по полосам скорости - SG_RESULT/CS_ACTUAL на полной частоте SPI, рекомендация SGT/TCOOLTHRS
+    server.on("/api/sg_tune", HTTP_POST, [](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        SgTuneRequest req = parseSgTuneRequest(request);
+        const char *error = nullptr;
+        if (req.preset_id < SG_TUNE_CUSTOM_PRESET || req.preset_id >= NEMA_PRESETS_COUNT) error = "Invalid preset ID";
+        else if (!tmc_initialized || !motor_enabled) error = "Motor is not enabled. Please enable motor first.";
+        else if (get_settings_snapshot().control_mode != MODE_MOTION_CONTROLLER) error = "SGT sweep requires SPI motion controller mode";
+        else if (is_homing_active()) error = "Homing in progress";
+        else sg_tune_configure(req, &error);
+        if (error) {
+            doc["success"] = false;
+            doc["message"] = error;
+            String response; serializeJson(doc, response);
+            request->send(400, "application/json", response);
+            return;
+        }
+
+        MotionCommand cmd = {};
+        cmd.type = MOTION_CMD_SG_TUNE;
+        if (!enqueue_motion_or_reject(request, cmd)) return;
+
+        doc["success"] = true;
+        doc["message"] = "SGT sweep queued, progress in /api/sg_tune";
+        JsonObject data = doc["data"].to<JsonObject>();
+        data["preset_id"] = req.preset_id;
+        JsonArray speeds = data["speeds"].to<JsonArray>();
+        for (uint8_t i = 0; i < req.bands; i++) speeds.add(req.speeds[i]);
+        data["sgt_min"] = req.sgt_min;
+        data["sgt_max"] = req.sgt_max;
+        data["sgt_step"] = req.sgt_step;
+        data["samples"] = req.samples;
+        String response; serializeJson(doc, response);
+        request->send(202, "application/json", response);
+    });
+
+    // API: Выборки последнего свипа (CSV) - для разбора на хосте той же логикой sg_stats.h.
+    // Отдаётся кусками прямо из кольца, без копии в RAM
+    server.on("/api/sg_tune/samples.csv", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (is_sg_tune_active()) {
+            JsonDocument doc;
+            doc["success"] = false;
+            doc["message"] = "SGT sweep in progress";
+            String response; serializeJson(doc, response);
+            request->send(409, "application/json", response);
+            return;
+        }
+
+        const SgBandResult *bands = nullptr;
+        uint8_t band_count = get_sg_tune_bands(&bands);
+        uint32_t row = 0;
+        bool header = false;
+        AsyncWebServerResponse *response = request->beginChunkedResponse("text/csv",
+            [bands, band_count, row, header](uint8_t *buffer, size_t max_len, size_t index) mutable -> size_t {
+                size_t len = 0;
+                if (!header) {
+                    len = snprintf((char *)buffer, max_len, "%s\n", SG_CSV_HEADER);
+                    header = true;
+                }
+                char line[64];
+                while (row < sg_ring_count()) {
+                    uint32_t s = sg_ring_get(row);
+                    SgCsvRow r;
+                    r.band = sg_sample_band(s);
+                    r.speed = r.band < band_count ? bands[r.band].speed : 0;
+                    r.tstep = r.band < band_count ? bands[r.band].tstep : 0;
+                    r.sgt = sg_sample_sgt(s);
+                    r.sg_result = sg_sample_result(s);
+                    r.cs_actual = sg_sample_cs(s);
+                    r.stst = sg_sample_stst(s);
+                    int n = sg_csv_format_row(line, sizeof(line), r);
+                    if (len + n > max_len) break;
+                    memcpy(buffer + len, line, n);
+                    len += n;
+                    row++;
+                }
+                return len;
+            });
+        response->addHeader("Content-Disposition", "attachment; filename=sg_samples.csv");
+        request->send(response);
+    });
+
+    // API: Сохранённый итог свипа для пресета (preset_id, -1 - без пресета)
+    server.on("/api/sg_tune/preset", HTTP_GET, [](AsyncWebServerRequest *request) {
+        int preset_id = request->hasParam("preset_id") ? request->getParam("preset_id")->value().toInt() : SG_TUNE_CUSTOM_PRESET;
+        String path = sg_tune_preset_path(preset_id);
+        if (!LittleFS.exists(path)) {
+            JsonDocument doc;
+            doc["success"] = false;
+            doc["message"] = "Preset has no SGT sweep results";
+            String response; serializeJson(doc, response);
+            request->send(404, "application/json", response);
+            return;
+        }
+        request->send(LittleFS, path, "application/json");
+    });
+
+    // После подпутей: обработчик "/api/sg_tune" ловит и "/api/sg_tune/..."
+    // API: Ход свипа SGT и результаты по полосам (точки свипа - после окончания)
+    server.on("/api/sg_tune", HTTP_GET, [](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        doc["success"] = true;
+        JsonObject data = doc["data"].to<JsonObject>();
+        fillSgTuneStatusJson(data, get_sg_tune_status());
+        if (!is_sg_tune_active()) sg_tune_results_json(data);
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Сбросить статистику мёртвого времени (перед замером)
+    server.on("/api/move_events/reset", HTTP_POST, [](AsyncWebServerRequest *request) {
+        reset_move_event_stats();
+
+        JsonDocument doc;
+        doc["success"] = true;
+        doc["message"] = "Move event stats reset";
+
         String response;
         serializeJson(doc, response);
         request->send(200, "application/json", response);
     });
 
-    // API: Очистить логи
+    // API: Очистить логи. Номера строк продолжаются: клиент с курсором до очистки получит reset
     server.on("/api/logs/clear", HTTP_POST, [](AsyncWebServerRequest *request) {
-        system_logs = "";
+        xSemaphoreTake(log_mutex(), portMAX_DELAY);
+        log_ring_clear(log_ring);
+        xSemaphoreGive(log_mutex());
         add_log("🧹 Logs cleared");
         add_log_to_web("🧹 Logs cleared");
         
@@ -675,11 +2296,156 @@ void init_web_server() {
         String filename = "logs_" + String(millis()) + ".txt";
         
         // Отправляем логи как plain text с заголовком для скачивания
-        AsyncWebServerResponse *response = request->beginResponse(200, "text/plain; charset=utf-8", system_logs);
+        String logs;
+        uint32_t next;
+        get_logs_since(0, logs, next);
+        AsyncWebServerResponse *response = request->beginResponse(200, "text/plain; charset=utf-8", logs);
         response->addHeader("Content-Disposition", "attachment; filename=\"" + filename + "\"");
         request->send(response);
     });
 
+    // API: Лог - трафик к клиентам (байт в минуту, запросы, пустые ответы), кольцо записей,
+    // цена записи у вызывающего и состояние кучи (фрагментация - доля свободного вне
+    // наибольшего блока)
+    server.on("/api/logs/stats", HTTP_GET, [](AsyncWebServerRequest *request) {
+        portENTER_CRITICAL(&log_traffic_mux);
+        LogTrafficStats st = log_traffic;
+        portEXIT_CRITICAL(&log_traffic_mux);
+        uint32_t elapsed_ms = st.start_ms ? millis() - st.start_ms : 0;
+
+        xSemaphoreTake(log_mutex(), portMAX_DELAY);
+        uint32_t first_seq = log_ring.first_seq;
+        uint32_t next_seq = log_ring.next_seq;
+        uint16_t records = log_ring.count;
+        uint16_t used = log_ring_bytes_used(log_ring);
+        uint32_t evicted = log_ring.evicted;
+        LogWriteStats ws = log_writes;
+        xSemaphoreGive(log_mutex());
+
+        JsonDocument doc;
+        doc["success"] = true;
+        JsonObject data = doc["data"].to<JsonObject>();
+        data["first_seq"] = first_seq;
+        data["next_seq"] = next_seq;
+        JsonObject ring = data["ring"].to<JsonObject>();
+        ring["records"] = records;
+        ring["bytes_used"] = used;
+        ring["capacity"] = LOG_RING_BYTES;
+        ring["evicted"] = evicted;
+        JsonObject write = data["write"].to<JsonObject>();
+        write["calls"] = ws.calls;
+        write["last_us"] = ws.last_us;
+        write["avg_us"] = ws.calls ? (float)ws.total_us / ws.calls : 0;
+        write["max_us"] = ws.max_us;
+        uint32_t free_heap = ESP.getFreeHeap();
+        uint32_t max_alloc = ESP.getMaxAllocHeap();
+        JsonObject heap = data["heap"].to<JsonObject>();
+        heap["free"] = free_heap;
+        heap["largest_block"] = max_alloc;
+        heap["min_free"] = ESP.getMinFreeHeap();
+        heap["fragmentation_percent"] = free_heap ? 100.0f * (free_heap - max_alloc) / free_heap : 0;
+        data["elapsed_ms"] = elapsed_ms;
+        data["full_requests"] = st.full_requests;
+        data["cursor_requests"] = st.cursor_requests;
+        data["empty_responses"] = st.empty_responses;
+        data["pushes"] = st.pushes;
+        data["bytes"] = st.bytes;
+        data["bytes_per_min"] = elapsed_ms ? (uint32_t)((uint64_t)st.bytes * 60000 / elapsed_ms) : 0;
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    server.on("/api/logs/reset_stats", HTTP_POST, [](AsyncWebServerRequest *request) {
+        portENTER_CRITICAL(&log_traffic_mux);
+        log_traffic = {};
+        portEXIT_CRITICAL(&log_traffic_mux);
+        xSemaphoreTake(log_mutex(), portMAX_DELAY);
+        log_writes = {};
+        xSemaphoreGive(log_mutex());
+
+        JsonDocument doc;
+        doc["success"] = true;
+        doc["message"] = "Log stats reset";
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Асинхронный лог в Serial - очередь, потери, стоимость add_log() для вызывающего
+    server.on("/api/serial_log/reset_stats", HTTP_POST, [](AsyncWebServerRequest *request) {
+        reset_serial_log_stats();
+
+        JsonDocument doc;
+        doc["success"] = true;
+        doc["message"] = "Serial log stats reset";
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    server.on("/api/serial_log", HTTP_GET, [](AsyncWebServerRequest *request) {
+        SerialLogStats ss = get_serial_log_stats();
+        JsonDocument doc;
+        doc["success"] = true;
+        JsonObject data = doc["data"].to<JsonObject>();
+        data["log_level"] = LOG_LEVEL;
+        data["written"] = ss.written;
+        data["dropped"] = ss.dropped;
+        data["truncated"] = ss.truncated;
+        data["queued"] = ss.queued;
+        data["max_queued"] = ss.max_queued;
+        data["capacity"] = SERIAL_LOG_QUEUE_SIZE;
+        data["line_max"] = SERIAL_LOG_LINE_MAX;
+        JsonObject producer = data["producer"].to<JsonObject>();
+        producer["last_us"] = ss.producer_last_us;
+        producer["avg_us"] = ss.producer_avg_us;
+        producer["max_us"] = ss.producer_max_us;
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Логи. Подпути /api/logs/... зарегистрированы выше - обработчик пути ловит и их.
+    // since=N - только строки начиная с N ("next" - курсор для следующего запроса); без
+    // since - весь буфер одной строкой, как раньше
+    server.on("/api/logs", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (!request->hasParam("since")) {
+            String logs;
+            uint32_t next;
+            get_logs_since(0, logs, next);
+            JsonDocument doc;
+            doc["success"] = true;
+            doc["data"] = logs;
+            
+            String response;
+            serializeJson(doc, response);
+            log_traffic_add(&LogTrafficStats::full_requests, response.length());
+            request->send(200, "application/json", response);
+            return;
+        }
+
+        uint32_t since = strtoul(request->getParam("since")->value().c_str(), nullptr, 10);
+        String lines;
+        uint32_t next;
+        bool complete = get_logs_since(since, lines, next);
+        // Ничего нового - короткий ответ без JsonDocument
+        if (complete && lines.length() == 0) {
+            String response = "{\"success\":true,\"data\":{\"next\":" + String(next) + ",\"lines\":\"\"}}";
+            log_traffic_add(&LogTrafficStats::empty_responses, response.length());
+            log_traffic_add(&LogTrafficStats::cursor_requests, 0);
+            request->send(200, "application/json", response);
+            return;
+        }
+
+        JsonDocument doc;
+        doc["success"] = true;
+        JsonObject data = doc["data"].to<JsonObject>();
+        data["next"] = next;
+        // Часть строк после since вытеснена, лог очищен или прибор перезапущен - с начала буфера
+        if (!complete) data["reset"] = true;
+        data["lines"] = lines;
+        String response; serializeJson(doc, response);
+        log_traffic_add(&LogTrafficStats::cursor_requests, response.length());
+        request->send(200, "application/json", response);
+    });
+
     // ❌ STEP/DIR тест удалён - используем только Motion Controller (SPI) режим
 
     // API: Сохранить настройки в EEPROM
@@ -688,7 +2454,7 @@ void init_web_server() {
             request->hasParam("max_speed", true) && request->hasParam("acceleration", true) &&
             request->hasParam("deceleration", true)) {
 
-            MotorSettings newSettings;
+            MotorSettings newSettings = get_settings_snapshot();
             newSettings.current_mA = request->getParam("current_mA", true)->value().toInt();
             newSettings.microsteps = request->getParam("microsteps", true)->value().toInt();
             newSettings.max_speed = request->getParam("max_speed", true)->value().toInt();
@@ -702,23 +2468,26 @@ void init_web_server() {
                 newSettings.steps_per_rev = 200 * newSettings.microsteps;
             }
             
-            // hold_multiplier опционально
+            // hold_multiplier опционально (по умолчанию - текущий)
             if (request->hasParam("hold_multiplier", true)) {
                 newSettings.hold_multiplier = request->getParam("hold_multiplier", true)->value().toFloat();
-            } else {
-                newSettings.hold_multiplier = currentSettings.hold_multiplier;
             }
             
-            // gear_ratio опционально
+            // gear_ratio опционально (по умолчанию - текущий)
             if (request->hasParam("gear_ratio", true)) {
                 newSettings.gear_ratio = request->getParam("gear_ratio", true)->value().toFloat();
-            } else {
-                newSettings.gear_ratio = currentSettings.gear_ratio;
             }
             
             // control_mode фиксирован (Motion Controller)
             newSettings.control_mode = MODE_MOTION_CONTROLLER;
 
+            // Шеститочечная рампа - опционально, по умолчанию как была
+            if (request->hasParam("vstart", true)) newSettings.vstart = request->getParam("vstart", true)->value().toInt();
+            if (request->hasParam("a1", true)) newSettings.a1 = request->getParam("a1", true)->value().toInt();
+            if (request->hasParam("v1", true)) newSettings.v1 = request->getParam("v1", true)->value().toInt();
+            if (request->hasParam("d1", true)) newSettings.d1 = request->getParam("d1", true)->value().toInt();
+            if (request->hasParam("vstop", true)) newSettings.vstop = request->getParam("vstop", true)->value().toInt();
+
             // Валидация
             if (!validate_current(newSettings.current_mA)) {
                 JsonDocument doc;
@@ -728,12 +2497,30 @@ void init_web_server() {
                 request->send(400, "application/json", response);
                 return;
             }
+            const char *ramp_error = ramp_profile_validate(get_ramp_profile(newSettings));
+            if (ramp_error) {
+                JsonDocument doc;
+                doc["success"] = false;
+                doc["message"] = "Invalid ramp: " + String(ramp_error);
+                String response; serializeJson(doc, response);
+                request->send(400, "application/json", response);
+                return;
+            }
 
-            // Сохраняем в EEPROM
-            if (saveMotorSettings(newSettings)) {
-                // Обновляем текущие настройки
-                currentSettings = newSettings;
-                
+            // Сохраняем в EEPROM и обновляем текущие настройки - в задаче движения,
+            // единственном писателе currentSettings
+            static SettingsSave save;
+            if (motion_call_pending()) {
+                JsonDocument doc;
+                doc["success"] = false;
+                doc["message"] = "Motion task busy";
+                String response; serializeJson(doc, response);
+                request->send(503, "application/json", response);
+                return;
+            }
+            save.settings = newSettings;
+            save.saved = false;
+            if (motion_call(saveSettingsInMotionTask, &save) && save.saved) {
                 add_log("💾 Settings saved: I=" + String(newSettings.current_mA) + "mA, µ=" + String(newSettings.microsteps) +
                         ", mode=" + String(newSettings.control_mode == MODE_MOTION_CONTROLLER ? "MC" : "SD"));
                 add_log_to_web("💾 Settings saved to EEPROM");
@@ -929,8 +2716,8 @@ void init_web_server() {
         
         // Проверяем, не движется ли мотор
         if (tmc_initialized && motor_enabled) {
-            int32_t vactual = (int32_t)motor.readRegister(TMC5160_Reg::VACTUAL);
-            if (abs(vactual) > 10) {
+            MotionSnapshot snap = peek_motion_snapshot();
+            if (abs(snap.vactual) > 10) {
                 JsonDocument doc;
                 doc["success"] = false;
                 doc["message"] = "Мотор движется, остановите перед тестом";
@@ -978,6 +2765,172 @@ void init_web_server() {
         request->send(200, "application/json", response);
     });
 
+    // Подпути - до "/api/endurance": обработчик пути ловит и "/api/endurance/..."
+    // API: Остановить тест мотора на ресурс (итог [STATS] - в лог)
+    server.on("/api/endurance/stop", HTTP_POST, [](AsyncWebServerRequest *request) {
+        MotionCommand cmd = {};
+        cmd.type = MOTION_CMD_STOP_ENDURANCE;
+        if (!enqueue_motion_or_reject(request, cmd)) return;
+
+        JsonDocument doc;
+        doc["success"] = true;
+        doc["message"] = "Endurance test stopped";
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Запустить тест мотора на ресурс - туда-обратно или вращение, N циклов или T секунд
+    server.on("/api/endurance", HTTP_POST, [](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        EnduranceConfig config;
+        const char *error = parseEnduranceConfig(request, config);
+        if (!error && (!tmc_initialized || !motor_enabled)) error = "Motor is not enabled. Please enable motor first.";
+        if (!error && get_settings_snapshot().control_mode != MODE_MOTION_CONTROLLER) error = "Endurance test needs Motion Controller mode";
+        if (!error && is_solenoid_testing()) error = "Solenoid test in progress";
+        if (!error && !endurance_configure(config)) error = "Endurance test already running";
+        if (error) {
+            doc["success"] = false;
+            doc["message"] = error;
+            String response; serializeJson(doc, response);
+            request->send(400, "application/json", response);
+            return;
+        }
+
+        MotionCommand cmd = {};
+        cmd.type = MOTION_CMD_ENDURANCE;
+        if (!enqueue_motion_or_reject(request, cmd)) return;
+
+        doc["success"] = true;
+        doc["message"] = "Endurance test queued, progress in /api/endurance";
+        String response; serializeJson(doc, response);
+        request->send(202, "application/json", response);
+    });
+
+    // API: Ход и статистика теста на ресурс (последнего, если уже остановлен)
+    server.on("/api/endurance", HTTP_GET, [](AsyncWebServerRequest *request) {
+        EnduranceStatus es = get_endurance_status();
+        JsonDocument doc;
+        doc["success"] = true;
+        JsonObject data = doc["data"].to<JsonObject>();
+        data["running"] = es.running;
+        if (es.stop_reason) data["stop_reason"] = es.stop_reason;
+        data["elapsed_ms"] = es.elapsed_ms;
+        data["reference_usteps"] = es.reference;
+
+        JsonObject config = data["config"].to<JsonObject>();
+        config["pattern"] = endurance_pattern_name(es.config.pattern);
+        config["distance_usteps"] = es.config.distance_usteps;
+        config["dwell_ms"] = es.config.dwell_ms;
+        config["max_cycles"] = es.config.max_cycles;
+        config["max_time_ms"] = es.config.max_time_ms;
+        config["tolerance_usteps"] = es.config.tolerance_usteps;
+        config["max_failures"] = es.config.max_failures;
+
+        const EnduranceStats &st = es.stats;
+        JsonObject stats = data["stats"].to<JsonObject>();
+        stats["cycles"] = st.cycles;
+        stats["failed_cycles"] = st.failed_cycles;
+        stats["consecutive_failures"] = st.consecutive_failures;
+        stats["stalls_total"] = st.stalls_total;
+        stats["stall_cycles"] = st.stall_cycles;
+        stats["max_abs_error_usteps"] = st.max_abs_error;
+        stats["peak_cs_max"] = st.peak_cs_max;
+        fillRunningStatsJson(stats["cycle_ms"].to<JsonObject>(), st.cycle_ms);
+        fillRunningStatsJson(stats["error_usteps"].to<JsonObject>(), st.error_usteps);
+        fillRunningStatsJson(stats["peak_cs"].to<JsonObject>(), st.peak_cs);
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // Подпути - до "/api/telemetry": обработчик пути ловит и "/api/telemetry/..."
+    server.on("/api/telemetry/reset_stats", HTTP_POST, [](AsyncWebServerRequest *request) {
+        reset_telemetry_stats();
+
+        JsonDocument doc;
+        doc["success"] = true;
+        doc["message"] = "Telemetry stats reset";
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Текущее состояние одним двоичным кадром (раскладка - telemetry_frame.h)
+    server.on("/api/telemetry/frame", HTTP_GET, [](AsyncWebServerRequest *request) {
+        TelemetryFrame frame;
+        telemetry_read_frame(frame);
+        uint8_t buf[TELEMETRY_FRAME_SIZE];
+        size_t len = telemetry_frame_encode(frame, buf);
+        request->send(request->beginResponse(200, "application/octet-stream", buf, len));
+    });
+
+    // API: Включить/выключить push-телеметрию, частота и формат (enabled, rate_hz, format=json|binary)
+    server.on("/api/telemetry", HTTP_POST, [](AsyncWebServerRequest *request) {
+        TelemetryStats ts = get_telemetry_stats();
+        bool enabled = request->hasParam("enabled", true) ? request->getParam("enabled", true)->value() == "true" : ts.enabled;
+        long rate_hz = request->hasParam("rate_hz", true) ? request->getParam("rate_hz", true)->value().toInt() : ts.rate_hz;
+        TelemetryFormat format = ts.format;
+        String error;
+        if (rate_hz < 1 || rate_hz > TELEMETRY_MAX_RATE_HZ) {
+            error = "rate_hz must be 1.." + String(TELEMETRY_MAX_RATE_HZ);
+        } else if (request->hasParam("format", true) && !telemetry_format_from_name(request->getParam("format", true)->value(), format)) {
+            error = "format must be json or binary";
+        }
+        JsonDocument doc;
+        if (error.length()) {
+            doc["success"] = false;
+            doc["message"] = error;
+            String response; serializeJson(doc, response);
+            request->send(400, "application/json", response);
+            return;
+        }
+        telemetry_configure(enabled, rate_hz, format);
+        add_log_to_web("📡 Telemetry " + String(enabled ? "on, " + String(rate_hz) + " Hz, " + telemetry_format_name(format) : "off"));
+
+        doc["success"] = true;
+        doc["message"] = enabled ? "Telemetry at " + String(rate_hz) + " Hz (" + telemetry_format_name(format) + ")" : String("Telemetry off");
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // API: Стоимость рассылки телеметрии - сообщений/с, мкс на клиента, возраст данных
+    server.on("/api/telemetry", HTTP_GET, [](AsyncWebServerRequest *request) {
+        TelemetryStats ts = get_telemetry_stats();
+        JsonDocument doc;
+        doc["success"] = true;
+        JsonObject data = doc["data"].to<JsonObject>();
+        data["enabled"] = ts.enabled;
+        data["rate_hz"] = ts.rate_hz;
+        data["format"] = telemetry_format_name(ts.format);
+        data["clients"] = ts.clients;
+        data["samples"] = ts.samples;
+        data["messages"] = ts.messages;
+        data["keyframes"] = ts.keyframes;
+        data["unchanged"] = ts.unchanged;
+        data["bytes"] = ts.bytes;
+        data["messages_per_sec"] = ts.messages_per_sec;
+        data["bytes_per_sec"] = ts.bytes_per_sec;
+        JsonObject cpu = data["cpu"].to<JsonObject>();
+        cpu["publish_last_us"] = ts.publish_last_us;
+        cpu["publish_avg_us"] = ts.publish_avg_us;
+        cpu["publish_max_us"] = ts.publish_max_us;
+        cpu["per_client_us"] = ts.per_client_us;
+        cpu["permille"] = ts.cpu_permille;
+        // Снимок движения → отправка: возраст данных в кадре (без сети)
+        JsonObject latency = data["latency"].to<JsonObject>();
+        latency["age_last_ms"] = ts.age_last_ms;
+        latency["age_avg_ms"] = ts.age_avg_ms;
+        latency["age_max_ms"] = ts.age_max_ms;
+        // Для сравнения - цена одного опроса /api/status
+        latency["status_poll_us"] = status_poll_last_us;
+        String response; serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // Push-события (EventSource в браузере). Новому подписчику - ключевой кадр телеметрии
+    events.onConnect([](AsyncEventSourceClient *client) {
+        telemetry_request_keyframe();
+    });
+    server.addHandler(&events);
+
     // Статические файлы из LittleFS
     server.serveStatic("/", LittleFS, "/");
 
@@ -0,0 +1,24 @@
+#pragma once
+// Мок Arduino для [env:native]: управляемое время и выводы (CS идёт в модель чипа)
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include "mock_tmc_chip.h"
+
+#define IRAM_ATTR
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define MSBFIRST 1
+
+// Время задаётся тестом: mock_millis = ...
+inline uint32_t mock_millis = 0;
+inline uint32_t millis() { return mock_millis; }
+inline uint32_t micros() { return mock_millis * 1000; }
+inline void delay(uint32_t ms) { mock_millis += ms; }
+inline void delayMicroseconds(uint32_t) {}
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t pin, uint8_t level) { mock_chip.pinWrite(pin, level); }
+inline int digitalRead(uint8_t) { return LOW; }
@@ -0,0 +1,27 @@
+#pragma once
+// Мок SPI для [env:native]: каждый байт уходит в модель TMC5160 (mock_tmc_chip.h)
+#include <Arduino.h>
+
+#define SPI_MODE0 0
+#define SPI_MODE3 3
+
+class SPISettings {
+public:
+    SPISettings() : _clock(1000000), _bitOrder(MSBFIRST), _dataMode(SPI_MODE0) {}
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode)
+        : _clock(clock), _bitOrder(bitOrder), _dataMode(dataMode) {}
+    uint32_t _clock;
+    uint8_t _bitOrder;
+    uint8_t _dataMode;
+};
+
+class SPIClass {
+public:
+    void begin(int8_t = -1, int8_t = -1, int8_t = -1, int8_t = -1) {}
+    void end() {}
+    void beginTransaction(SPISettings settings) { mock_chip.clock_hz = settings._clock; }
+    void endTransaction() {}
+    uint8_t transfer(uint8_t data) { return mock_chip.transfer(data); }
+};
+
+inline SPIClass SPI;
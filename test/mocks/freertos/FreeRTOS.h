@@ -0,0 +1,11 @@
+#pragma once
+// Мок FreeRTOS для [env:native]: тесты однопоточные, примитивы - заглушки
+#include <cstdint>
+
+typedef void *SemaphoreHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xffffffff
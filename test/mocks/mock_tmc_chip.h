@@ -0,0 +1,94 @@
+#pragma once
+// Модель TMC5160 на стороне SPI: 40-битные датаграммы, конвейерный ответ на чтение
+// (ответ приходит в СЛЕДУЮЩЕЙ датаграмме), GSTAT сбрасывается записью 1,
+// R-регистры запись игнорируют, W-регистры читаются как 0.
+// Инжекция ошибок: выше max_stable_hz каждый байт данных ответа искажается.
+#include <cstdint>
+#include <cstring>
+
+struct MockTmcChip {
+    static constexpr uint8_t REG_COUNT = 0x80;
+    static constexpr uint8_t IC_VERSION = 0x30;
+
+    uint32_t regs[REG_COUNT];
+    uint8_t status;              // SPI_STATUS - первый байт каждого ответа
+    uint32_t clock_hz;           // Частота текущей транзакции (из SPISettings)
+    uint32_t max_stable_hz;      // Выше - ответ искажается (0 = без инжекции)
+    uint8_t cs_pin;
+    uint32_t datagrams;          // Завершённых датаграмм
+    uint32_t writes;             // Из них записей
+
+    uint8_t _index;
+    uint8_t _in[5];
+    uint32_t _out;
+
+    void reset() {
+        memset(regs, 0, sizeof(regs));
+        regs[0x04] = (uint32_t)IC_VERSION << 24;   // IOIN.VERSION
+        status = 0;
+        clock_hz = 0;
+        max_stable_hz = 0;
+        cs_pin = 0xFF;
+        datagrams = 0;
+        writes = 0;
+        _index = 0;
+        _out = 0;
+    }
+
+    static bool readOnly(uint8_t a) {
+        switch (a) {
+            case 0x02: case 0x07: case 0x0C: case 0x12: case 0x22: case 0x35: case 0x36:
+            case 0x3B: case 0x3C: case 0x6A: case 0x6B: case 0x6F: case 0x71: case 0x72: case 0x73:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    static bool writeOnly(uint8_t a) {
+        if (a >= 0x60 && a <= 0x69) return true;   // MSLUT, MSLUTSEL, MSLUTSTART
+        switch (a) {
+            case 0x03: case 0x05: case 0x06: case 0x09: case 0x0A: case 0x0B:
+            case 0x10: case 0x11: case 0x13: case 0x14: case 0x15:
+            case 0x23: case 0x24: case 0x25: case 0x26: case 0x27: case 0x28: case 0x2A: case 0x2B: case 0x2C:
+            case 0x33: case 0x3A: case 0x3D: case 0x6D: case 0x6E: case 0x70:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    void pinWrite(uint8_t pin, uint8_t level) {
+        if (level == 0) {
+            cs_pin = pin;
+            _index = 0;     // CS вниз - начало датаграммы
+        }
+    }
+
+    uint8_t transfer(uint8_t in) {
+        uint8_t reply;
+        if (_index == 0) reply = status;
+        else reply = (_out >> (8 * (4 - _index))) & 0xFF;
+        if (_index > 0 && max_stable_hz && clock_hz > max_stable_hz) reply ^= 0x01;
+
+        if (_index < 5) _in[_index] = in;
+        if (++_index == 5) complete();
+        return reply;
+    }
+
+    void complete() {
+        uint8_t address = _in[0] & 0x7F;
+        uint32_t data = ((uint32_t)_in[1] << 24) | ((uint32_t)_in[2] << 16) | ((uint32_t)_in[3] << 8) | _in[4];
+        datagrams++;
+
+        if (_in[0] & 0x80) {
+            writes++;
+            if (address == 0x01) regs[address] &= ~data;      // GSTAT: W1C
+            else if (!readOnly(address)) regs[address] = data;
+        } else {
+            _out = writeOnly(address) ? 0 : regs[address];
+        }
+    }
+};
+
+inline MockTmcChip mock_chip;
@@ -0,0 +1,143 @@
+// Угол вала ↔ микрошаги (angle_units.h): дробь передаточного числа, перенос остатка
+// между ходами (и на 10^6 ходах), абсолютные цели и разбор десятичного угла
+#include <unity.h>
+#include "angle_units.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_ratio_to_fraction(void) {
+    int64_t num, den;
+    TEST_ASSERT_TRUE(angle_ratio_to_fraction(0.333333f, ANGLE_GEAR_MAX_DEN, &num, &den));
+    TEST_ASSERT_TRUE(num == 1 && den == 3);
+    TEST_ASSERT_TRUE(angle_ratio_to_fraction(2.5, ANGLE_GEAR_MAX_DEN, &num, &den));
+    TEST_ASSERT_TRUE(num == 5 && den == 2);
+    TEST_ASSERT_FALSE(angle_ratio_to_fraction(0, ANGLE_GEAR_MAX_DEN, &num, &den));
+    TEST_ASSERT_FALSE(angle_ratio_to_fraction(-1, ANGLE_GEAR_MAX_DEN, &num, &den));
+}
+
+// Шкала шага входит в единицы: 16 и 256 микрошагов - разные единицы
+static void test_units_follow_microstep_scale(void) {
+    AngleUnits u256, u16;
+    TEST_ASSERT_TRUE(angle_units_make(200, 256, 1.0f, u256));
+    TEST_ASSERT_TRUE(angle_units_make(200, 16, 1.0f, u16));
+    TEST_ASSERT_TRUE(u256.num == 51200 && u256.den == 1);
+    TEST_ASSERT_TRUE(u16.num == 3200 && u16.den == 1);
+    TEST_ASSERT_FALSE(angle_units_equal(u256, u16));
+    TEST_ASSERT_FALSE(angle_units_make(0, 16, 1.0f, u16));
+    TEST_ASSERT_FALSE(angle_units_make(200, 0, 1.0f, u16));
+}
+
+// 16 ходов по 22.5° на 16 микрошагах и редукторе 1/3 - ровно оборот, без накопления
+static void test_carry_sums_to_exact_revolution(void) {
+    AngleUnits u;
+    TEST_ASSERT_TRUE(angle_units_make(200, 16, 1.0f / 3.0f, u));
+    AngleCarry c;
+    angle_carry_reset(u, c);
+    int64_t total = 0;
+    for (int i = 0; i < 16 * 7; i++) {
+        int32_t usteps;
+        TEST_ASSERT_TRUE(angle_move_relative(u, c, 22500, &usteps));
+        total += usteps;
+        TEST_ASSERT_TRUE(c.rem >= 0 && c.rem < angle_scale(u));
+    }
+    // 7 оборотов · 3200/3 микрошага = 7466.67 - ближайший микрошаг
+    TEST_ASSERT_TRUE(total == 7467);
+    for (int i = 0; i < 16 * 7; i++) {
+        int32_t usteps;
+        TEST_ASSERT_TRUE(angle_move_relative(u, c, -22500, &usteps));
+        total += usteps;
+    }
+    TEST_ASSERT_TRUE(total == 0);
+}
+
+// Ход длиннее одной команды отвергается, остаток при этом не меняется
+static void test_too_long_move_rejected(void) {
+    AngleUnits u;
+    TEST_ASSERT_TRUE(angle_units_make(200, 256, 100.0f, u));
+    AngleCarry c;
+    angle_carry_reset(u, c);
+    int64_t rem = c.rem;
+    int32_t usteps;
+    TEST_ASSERT_FALSE(angle_move_relative(u, c, 1000000000LL, &usteps));
+    TEST_ASSERT_TRUE(c.rem == rem);
+}
+
+// Абсолютная цель - ближайший микрошаг; следующий относительный ход продолжает от точного угла
+static void test_absolute_target_then_relative(void) {
+    AngleUnits u;
+    TEST_ASSERT_TRUE(angle_units_make(200, 16, 1.0f / 3.0f, u));
+    AngleCarry c;
+    int32_t target, usteps;
+    TEST_ASSERT_TRUE(angle_target_absolute(u, c, 90000, &target));
+    TEST_ASSERT_EQUAL_INT32(267, target);        // 3200/3/4 = 266.67
+    TEST_ASSERT_TRUE(angle_move_relative(u, c, 270000, &usteps));
+    TEST_ASSERT_EQUAL_INT32(1067 - 267, usteps); // 360° = 1066.67
+    TEST_ASSERT_TRUE(angle_target_absolute(u, c, -90000, &target));
+    TEST_ASSERT_EQUAL_INT32(-267, target);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 270.0f, (float)angle_from_usteps_deg(u, 800));
+}
+
+// Свойство: 10^6 относительных ходов со случайными углами - сумма выданных микрошагов в точности
+// равна абсолютной цели суммарного угла, остаток всегда в [0, scale). Неудобные передаточные
+// числа и шкалы шага, включая STEP/DIR (шкала 1)
+static void test_million_moves_zero_accumulated_error(void) {
+    static const struct { uint32_t steps_per_rev; uint32_t per_step; float gear; } configs[] = {
+        {200, 256, 1.0f / 3.0f},
+        {200, 16, 7.0f / 13.0f},
+        {400, 1, 3.7f},
+        {200, 64, 0.1428571f},
+    };
+    for (auto &cfg : configs) {
+        AngleUnits u;
+        TEST_ASSERT_TRUE(angle_units_make(cfg.steps_per_rev, cfg.per_step, cfg.gear, u));
+        AngleCarry c;
+        angle_carry_reset(u, c);
+        const int64_t scale = angle_scale(u);
+
+        uint32_t rng = 12345;
+        int64_t mdeg_sum = 0, usteps_sum = 0;
+        for (uint32_t i = 0; i < 1000000; i++) {
+            rng = rng * 1664525u + 1013904223u;
+            int64_t mdeg = (int64_t)(rng >> 8) % 180001 - 90000;     // ±90.000°
+            int32_t usteps;
+            if (!angle_move_relative(u, c, mdeg, &usteps)) TEST_FAIL_MESSAGE("move rejected");
+            mdeg_sum += mdeg;
+            usteps_sum += usteps;
+            if (c.rem < 0 || c.rem >= scale) TEST_FAIL_MESSAGE("carry out of [0, scale)");
+        }
+        AngleCarry abs_carry;
+        int32_t target;
+        TEST_ASSERT_TRUE(angle_target_absolute(u, abs_carry, mdeg_sum, &target));
+        TEST_ASSERT_TRUE(usteps_sum == target);
+        TEST_ASSERT_TRUE(abs_carry.rem == c.rem);
+    }
+}
+
+static void test_parse_mdeg(void) {
+    int64_t mdeg;
+    TEST_ASSERT_TRUE(angle_parse_mdeg("-22.5", &mdeg));
+    TEST_ASSERT_TRUE(mdeg == -22500);
+    TEST_ASSERT_TRUE(angle_parse_mdeg(" 90 ", &mdeg));
+    TEST_ASSERT_TRUE(mdeg == 90000);
+    TEST_ASSERT_TRUE(angle_parse_mdeg("0.0625", &mdeg));
+    TEST_ASSERT_TRUE(mdeg == 63);                // 4-й знак округляется
+    TEST_ASSERT_TRUE(angle_parse_mdeg("+.5", &mdeg));
+    TEST_ASSERT_TRUE(mdeg == 500);
+    TEST_ASSERT_FALSE(angle_parse_mdeg("", &mdeg));
+    TEST_ASSERT_FALSE(angle_parse_mdeg("1.2.3", &mdeg));
+    TEST_ASSERT_FALSE(angle_parse_mdeg("12abc", &mdeg));
+    TEST_ASSERT_FALSE(angle_parse_mdeg(nullptr, &mdeg));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_ratio_to_fraction);
+    RUN_TEST(test_units_follow_microstep_scale);
+    RUN_TEST(test_carry_sums_to_exact_revolution);
+    RUN_TEST(test_too_long_move_rejected);
+    RUN_TEST(test_absolute_target_then_relative);
+    RUN_TEST(test_million_moves_zero_accumulated_error);
+    RUN_TEST(test_parse_mdeg);
+    return UNITY_END();
+}
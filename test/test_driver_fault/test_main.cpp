@@ -0,0 +1,66 @@
+// Разбор DRV_STATUS/GSTAT и решение по фронту DIAG0 (driver_fault.h)
+#include <unity.h>
+#include "driver_fault.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_decode_maps_every_bit(void) {
+    TEST_ASSERT_EQUAL_UINT16(0, driver_fault_decode(0, 0));
+    TEST_ASSERT_EQUAL_UINT16(FAULT_S2GA, driver_fault_decode(DRV_STATUS_S2GA, 0));
+    TEST_ASSERT_EQUAL_UINT16(FAULT_S2GB, driver_fault_decode(DRV_STATUS_S2GB, 0));
+    TEST_ASSERT_EQUAL_UINT16(FAULT_S2VSA, driver_fault_decode(DRV_STATUS_S2VSA, 0));
+    TEST_ASSERT_EQUAL_UINT16(FAULT_S2VSB, driver_fault_decode(DRV_STATUS_S2VSB, 0));
+    TEST_ASSERT_EQUAL_UINT16(FAULT_OT, driver_fault_decode(DRV_STATUS_OT, 0));
+    TEST_ASSERT_EQUAL_UINT16(FAULT_OTPW, driver_fault_decode(DRV_STATUS_OTPW, 0));
+    TEST_ASSERT_EQUAL_UINT16(FAULT_UV_CP, driver_fault_decode(0, GSTAT_UV_CP));
+    TEST_ASSERT_EQUAL_UINT16(FAULT_DRV_ERR, driver_fault_decode(0, GSTAT_DRV_ERR));
+    TEST_ASSERT_EQUAL_UINT16(FAULT_RESET, driver_fault_decode(0, GSTAT_RESET));
+
+    // Остальные биты DRV_STATUS (SG_RESULT, stallGuard, stst...) - не ошибки
+    TEST_ASSERT_EQUAL_UINT16(0, driver_fault_decode(0x810003FFUL, 0));
+}
+
+static void test_action(void) {
+    TEST_ASSERT_EQUAL_UINT8(FAULT_ACT_NONE, driver_fault_action(0, false));
+    TEST_ASSERT_EQUAL_UINT8(FAULT_ACT_WARN, driver_fault_action(FAULT_OTPW, false));
+    TEST_ASSERT_EQUAL_UINT8(FAULT_ACT_WARN, driver_fault_action(FAULT_RESET, false));
+    TEST_ASSERT_EQUAL_UINT8(FAULT_ACT_DISABLE, driver_fault_action(FAULT_S2GA | FAULT_OTPW, false));
+    TEST_ASSERT_EQUAL_UINT8(FAULT_ACT_DISABLE, driver_fault_action(FAULT_DRV_ERR, false));
+    // EN уже снят в ISR: даже без флагов остаётся отключение
+    TEST_ASSERT_EQUAL_UINT8(FAULT_ACT_DISABLE, driver_fault_action(0, true));
+    TEST_ASSERT_EQUAL_UINT8(FAULT_ACT_DISABLE, driver_fault_action(FAULT_OTPW, true));
+}
+
+static void test_cleared_ignores_warnings(void) {
+    TEST_ASSERT_TRUE(driver_fault_cleared(0, 0));
+    TEST_ASSERT_TRUE(driver_fault_cleared(DRV_STATUS_OTPW, GSTAT_RESET));
+    TEST_ASSERT_FALSE(driver_fault_cleared(DRV_STATUS_OT, 0));
+    TEST_ASSERT_FALSE(driver_fault_cleared(0, GSTAT_DRV_ERR));
+}
+
+static void test_describe(void) {
+    char buf[64];
+    TEST_ASSERT_EQUAL_INT(4, driver_fault_describe(0, buf, sizeof(buf)));
+    TEST_ASSERT_EQUAL_STRING("none", buf);
+
+    driver_fault_describe(FAULT_S2GA | FAULT_DRV_ERR, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL_STRING("s2ga,drv_err", buf);
+
+    // Не влезло - обрезка по целому имени, не "none"
+    char small[8];
+    driver_fault_describe(FAULT_S2GA | FAULT_S2VSB, small, sizeof(small));
+    TEST_ASSERT_EQUAL_STRING("s2ga", small);
+    char tiny[3];
+    TEST_ASSERT_EQUAL_INT(0, driver_fault_describe(FAULT_OT | FAULT_OTPW | FAULT_UV_CP, tiny, 2));
+    TEST_ASSERT_EQUAL_STRING("", tiny);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_decode_maps_every_bit);
+    RUN_TEST(test_action);
+    RUN_TEST(test_cleared_ignores_warnings);
+    RUN_TEST(test_describe);
+    return UNITY_END();
+}
@@ -0,0 +1,78 @@
+// Статистика теста на ресурс (endurance_stats.h): Уэлфорд против прямого расчёта,
+// устойчивость на большом смещении и учёт неудачных циклов
+#include <unity.h>
+#include "endurance_stats.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_running_stats_matches_two_pass(void) {
+    static const double xs[] = {2, 4, 4, 4, 5, 5, 7, 9};
+    RunningStats s;
+    running_stats_reset(s);
+    for (double x : xs) running_stats_add(s, x);
+    TEST_ASSERT_EQUAL_UINT32(8, s.count);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 5.0, s.mean);
+    // Сумма квадратов отклонений 32, выборочная дисперсия 32/7
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 32.0 / 7.0, running_stats_variance(s));
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 2.0, s.min);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 9.0, s.max);
+}
+
+static void test_single_sample_has_zero_variance(void) {
+    RunningStats s;
+    running_stats_reset(s);
+    TEST_ASSERT_FLOAT_WITHIN(1e-12, 0.0, running_stats_variance(s));
+    running_stats_add(s, -3);
+    TEST_ASSERT_FLOAT_WITHIN(1e-12, 0.0, running_stats_stddev(s));
+    TEST_ASSERT_FLOAT_WITHIN(1e-12, -3.0, s.min);
+    TEST_ASSERT_FLOAT_WITHIN(1e-12, -3.0, s.max);
+}
+
+// Миллион циклов около 10^9 с разбросом ±1: сумма квадратов потеряла бы всю точность
+static void test_stable_on_large_offset(void) {
+    RunningStats s;
+    running_stats_reset(s);
+    for (uint32_t i = 0; i < 1000000; i++) running_stats_add(s, 1.0e9 + (i & 1 ? 1.0 : -1.0));
+    TEST_ASSERT_TRUE(fabs(s.mean - 1.0e9) < 1e-6);     // Unity сравнивает во float - тут нужен double
+    TEST_ASSERT_FLOAT_WITHIN(1e-4, 1.0, running_stats_stddev(s));
+}
+
+// Неудача - StallGuard или ошибка больше допуска; серия сбрасывается удачным циклом
+static void test_endurance_failures(void) {
+    EnduranceStats s;
+    endurance_stats_reset(s);
+    TEST_ASSERT_FALSE(endurance_stats_add(s, {400, 3, 20, 0}, 4));
+    TEST_ASSERT_TRUE(endurance_stats_add(s, {410, -5, 25, 0}, 4));
+    TEST_ASSERT_TRUE(endurance_stats_add(s, {420, 0, 31, 2}, 4));
+    TEST_ASSERT_EQUAL_UINT32(2, s.consecutive_failures);
+    TEST_ASSERT_FALSE(endurance_stats_add(s, {430, -4, 18, 0}, 4));
+
+    TEST_ASSERT_EQUAL_UINT32(4, s.cycles);
+    TEST_ASSERT_EQUAL_UINT32(2, s.failed_cycles);
+    TEST_ASSERT_EQUAL_UINT32(0, s.consecutive_failures);
+    TEST_ASSERT_EQUAL_UINT32(2, s.stalls_total);
+    TEST_ASSERT_EQUAL_UINT32(1, s.stall_cycles);
+    TEST_ASSERT_EQUAL_UINT32(5, s.max_abs_error);
+    TEST_ASSERT_EQUAL_UINT8(31, s.peak_cs_max);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, 415.0, s.cycle_ms.mean);
+    TEST_ASSERT_FLOAT_WITHIN(1e-9, -1.5, s.error_usteps.mean);
+}
+
+// |INT32_MIN| не переполняется при пересчёте ошибки
+static void test_abs_error_of_int32_min(void) {
+    EnduranceStats s;
+    endurance_stats_reset(s);
+    TEST_ASSERT_TRUE(endurance_stats_add(s, {1, INT32_MIN, 0, 0}, 1000));
+    TEST_ASSERT_EQUAL_UINT32(0x80000000u, s.max_abs_error);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_running_stats_matches_two_pass);
+    RUN_TEST(test_single_sample_has_zero_variance);
+    RUN_TEST(test_stable_on_large_offset);
+    RUN_TEST(test_endurance_failures);
+    RUN_TEST(test_abs_error_of_int32_min);
+    return UNITY_END();
+}
@@ -0,0 +1,292 @@
+// Автомат sensorless homing (homing_machine.h): переходы фаз по входам и прогон
+// на модели мотора с жёстким упором и StallGuard
+#include <unity.h>
+#include "homing_machine.h"
+
+// ===== МОДЕЛЬ: МОТОР С ЖЁСТКИМ УПОРОМ И STALLGUARD =====
+// Шаг модели - 1 мс. XACTUAL (счётчик рампы) и ротор расходятся, когда ротор упёрся:
+// рампа продолжает считать, шаги теряются, пока StallGuard не сработает (detect_ms).
+// Остановка по StallGuard (sg_stop) мгновенная, как у чипа. Точка, где ротор стоит
+// в момент установки нуля, отличается от упора на упругий прогиб: compliance * скорость
+// плюс случайный разброс ±jitter - это и есть повторяемость в модели.
+
+struct HomingSimParams {
+    uint32_t usteps_per_step;
+    int32_t start_usteps;       // Начальная позиция ротора
+    int32_t wall_usteps;        // Упор
+    uint32_t accel;             // Шаги/с²
+    uint32_t detect_ms;         // Задержка StallGuard после касания
+    float compliance;           // Прогиб, микрошаги на (шаг/с)
+    uint32_t jitter_usteps;
+    uint32_t false_stall_ms;    // Ложная сработка во время разгона (0 - нет), должна игнорироваться
+    uint32_t seed;
+    uint32_t max_ms;            // Предел модели
+};
+
+struct HomingSimResult {
+    bool ok;
+    const char *error;
+    uint32_t duration_ms;
+    int32_t origin_error_usteps;    // Ротор относительно упора в момент установки нуля
+    int32_t lost_usteps;            // Потеряно на быстром подходе (до срабатывания)
+};
+
+static uint32_t homing_sim_rand(uint32_t &seed) {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+static HomingSimResult homing_simulate(const HomingConfig &config, const HomingSimParams &p) {
+    HomingSimResult result = {};
+    HomingMachine m = {};
+    uint32_t seed = p.seed;
+
+    const float us_per_step_ms = p.usteps_per_step / 1000.0f;        // (шаг/с) → микрошаги/мс
+    const float accel = p.accel * p.usteps_per_step / 1.0e6f;        // микрошаги/мс²
+    float x = (float)p.start_usteps;    // XACTUAL
+    float lost = 0;                     // x - ротор
+    float v = 0, v_target = 0;
+    bool moving_to_target = false;
+    float target = 0;
+    bool armed = false;
+    uint32_t contact_ms = 0;
+
+    HomingCommand cmd = homing_begin(m, config, 0);
+    for (uint32_t t = 0; t <= p.max_ms; t++) {
+        // Исполнение команды автомата
+        switch (cmd.action) {
+            case HOMING_ACT_APPROACH:
+                moving_to_target = false;
+                v_target = cmd.velocity * us_per_step_ms;
+                armed = false;
+                break;
+            case HOMING_ACT_ARM_STALL:
+                armed = true;
+                contact_ms = 0;
+                break;
+            case HOMING_ACT_MOVE:
+                moving_to_target = true;
+                target = x + (float)cmd.steps * p.usteps_per_step;
+                v_target = (target > x ? 1 : -1) * (float)config.phases[cmd.phase].speed * us_per_step_ms;
+                break;
+            case HOMING_ACT_SET_ORIGIN: {
+                float deflection = p.compliance * config.phases[HOMING_PHASE_SLOW].speed;
+                int32_t noise = p.jitter_usteps ?
+                    (int32_t)(homing_sim_rand(seed) % (2 * p.jitter_usteps + 1)) - (int32_t)p.jitter_usteps : 0;
+                result.origin_error_usteps = (int32_t)deflection + noise;
+                break;
+            }
+            case HOMING_ACT_ABORT:
+                v_target = 0;
+                v = 0;
+                break;
+            default:
+                break;
+        }
+        if (!homing_active(m)) break;
+
+        // Динамика рампы: разгон/торможение к v_target
+        if (v < v_target) v = (v + accel > v_target) ? v_target : v + accel;
+        else if (v > v_target) v = (v - accel < v_target) ? v_target : v - accel;
+        if (moving_to_target && ((v > 0 && x + v >= target) || (v < 0 && x + v <= target))) {
+            x = target;
+            v = v_target = 0;
+            moving_to_target = false;
+        } else {
+            x += v;
+        }
+
+        // Упор: ротор дальше не идёт, рампа теряет шаги
+        float rotor = x - lost;
+        bool beyond = config.direction < 0 ? rotor < p.wall_usteps : rotor > p.wall_usteps;
+        bool pushing = false;
+        if (beyond) {
+            lost += rotor - p.wall_usteps;
+            pushing = v != 0;
+        }
+        contact_ms = pushing ? contact_ms + 1 : 0;
+
+        bool stall = false;
+        if (armed && contact_ms >= p.detect_ms) {
+            stall = true;
+            armed = false;
+            v = v_target = 0;       // sg_stop: чип останавливает рампу сам
+            if (m.state == HOMING_FAST_APPROACH) result.lost_usteps = (int32_t)(lost < 0 ? -lost : lost);
+        }
+        if (p.false_stall_ms && t == p.false_stall_ms) stall = true;
+
+        HomingInputs in;
+        in.now_ms = t;
+        in.velocity_reached = v_target != 0 && v == v_target;
+        in.stall = stall;
+        in.move_done = !moving_to_target && v == 0;
+        in.xactual = (int32_t)x;
+        cmd = homing_update(m, in);
+    }
+
+    result.ok = m.state == HOMING_DONE;
+    result.error = m.state == HOMING_DONE ? nullptr : (m.error ? m.error : "simulation time limit");
+    result.duration_ms = m.duration_ms;
+    return result;
+}
+
+// Как homing_default_config() в homing.cpp
+static HomingConfig test_config() {
+    HomingConfig c = {};
+    c.phases[HOMING_PHASE_FAST] = {800, 600, 8};
+    c.phases[HOMING_PHASE_BACKOFF] = {400, 800, 0};
+    c.phases[HOMING_PHASE_SLOW] = {200, 500, 6};
+    c.direction = -1;
+    c.backoff_steps = 100;
+    c.timeout_ms = 20000;
+    return c;
+}
+
+static HomingSimParams test_params(uint32_t seed) {
+    HomingSimParams p = {};
+    p.usteps_per_step = 256;
+    p.start_usteps = 0;
+    p.wall_usteps = -2000 * 256;
+    p.accel = 2000;
+    p.detect_ms = 5;
+    p.compliance = 0.05f;
+    p.jitter_usteps = 8;
+    p.seed = seed;
+    p.max_ms = 3 * 20000;
+    return p;
+}
+
+static HomingInputs inputs(uint32_t now_ms, bool velocity_reached, bool stall, bool move_done, int32_t xactual) {
+    HomingInputs in = {now_ms, velocity_reached, stall, move_done, xactual};
+    return in;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_config_validate(void) {
+    HomingConfig c = test_config();
+    TEST_ASSERT_NULL(homing_config_validate(c));
+
+    c.direction = 0;
+    TEST_ASSERT_NOT_NULL(homing_config_validate(c));
+    c = test_config();
+    c.phases[HOMING_PHASE_SLOW].speed = 1000;   // Медленный подход быстрее быстрого
+    TEST_ASSERT_NOT_NULL(homing_config_validate(c));
+    c = test_config();
+    c.backoff_steps = 0;
+    TEST_ASSERT_NOT_NULL(homing_config_validate(c));
+    c = test_config();
+    c.timeout_ms = 0;
+    TEST_ASSERT_NOT_NULL(homing_config_validate(c));
+}
+
+// Полный проход по входам: сработка до набора скорости игнорируется, отъезд от упора,
+// начало координат - в точке медленного подхода
+static void test_phase_sequence(void) {
+    HomingMachine m = {};
+    HomingCommand cmd = homing_begin(m, test_config(), 0);
+    TEST_ASSERT_EQUAL_UINT8(HOMING_ACT_APPROACH, cmd.action);
+    TEST_ASSERT_EQUAL_INT32(-800, cmd.velocity);
+    TEST_ASSERT_TRUE(homing_active(m));
+
+    cmd = homing_update(m, inputs(10, false, true, false, -100));
+    TEST_ASSERT_EQUAL_UINT8(HOMING_ACT_NONE, cmd.action);
+    TEST_ASSERT_EQUAL_UINT8(HOMING_FAST_APPROACH, m.state);
+
+    cmd = homing_update(m, inputs(400, true, false, false, -20000));
+    TEST_ASSERT_EQUAL_UINT8(HOMING_ACT_ARM_STALL, cmd.action);
+
+    cmd = homing_update(m, inputs(900, true, true, false, -51000));
+    TEST_ASSERT_EQUAL_UINT8(HOMING_ACT_MOVE, cmd.action);
+    TEST_ASSERT_EQUAL_INT32(100, cmd.steps);
+    TEST_ASSERT_EQUAL_INT32(-51000, m.fast_latch);
+    TEST_ASSERT_EQUAL_UINT8(HOMING_BACKOFF, m.state);
+
+    cmd = homing_update(m, inputs(1000, false, false, true, -25400));
+    TEST_ASSERT_EQUAL_UINT8(HOMING_ACT_APPROACH, cmd.action);
+    TEST_ASSERT_EQUAL_INT32(-200, cmd.velocity);
+    TEST_ASSERT_EQUAL_UINT8(HOMING_SLOW_APPROACH, m.state);
+
+    homing_update(m, inputs(1100, true, false, false, -25500));
+    cmd = homing_update(m, inputs(1300, true, true, false, -51100));
+    TEST_ASSERT_EQUAL_UINT8(HOMING_ACT_SET_ORIGIN, cmd.action);
+    TEST_ASSERT_EQUAL_INT32(-51100, cmd.latch);
+    TEST_ASSERT_EQUAL_UINT8(HOMING_DONE, m.state);
+    TEST_ASSERT_EQUAL_UINT32(1300, m.duration_ms);
+    TEST_ASSERT_FALSE(homing_active(m));
+}
+
+static void test_phase_timeouts(void) {
+    HomingMachine m = {};
+    homing_begin(m, test_config(), 1000);
+    HomingCommand cmd = homing_update(m, inputs(1000 + 20000, false, false, false, 0));
+    TEST_ASSERT_EQUAL_UINT8(HOMING_ACT_ABORT, cmd.action);
+    TEST_ASSERT_EQUAL_UINT8(HOMING_FAILED, m.state);
+    TEST_ASSERT_NOT_NULL(m.error);
+
+    // Отъезд не закончился за timeout_ms
+    homing_begin(m, test_config(), 0);
+    homing_update(m, inputs(100, true, false, false, 0));
+    homing_update(m, inputs(200, true, true, false, -1000));
+    TEST_ASSERT_EQUAL_UINT8(HOMING_BACKOFF, m.state);
+    cmd = homing_update(m, inputs(200 + 20000, false, false, false, -1000));
+    TEST_ASSERT_EQUAL_UINT8(HOMING_ACT_ABORT, cmd.action);
+    TEST_ASSERT_EQUAL_UINT8(HOMING_FAILED, m.state);
+}
+
+static void test_simulated_homing_succeeds(void) {
+    HomingSimResult r = homing_simulate(test_config(), test_params(1));
+    TEST_ASSERT_TRUE(r.ok);
+    TEST_ASSERT_NULL(r.error);
+    TEST_ASSERT_TRUE(r.duration_ms > 0 && r.duration_ms < 3 * 20000);
+    TEST_ASSERT_TRUE(r.lost_usteps > 0);
+    // Прогиб 0.05 * 200 шагов/с = 10 микрошагов ± 8 разброса
+    TEST_ASSERT_INT_WITHIN(8, 10, r.origin_error_usteps);
+}
+
+// Ложная сработка во время разгона (StallGuard ещё не взведён) не должна закончить подход
+static void test_false_stall_during_acceleration_ignored(void) {
+    HomingSimParams p = test_params(2);
+    p.false_stall_ms = 3;
+    HomingSimResult with_false = homing_simulate(test_config(), p);
+    p.false_stall_ms = 0;
+    HomingSimResult clean = homing_simulate(test_config(), p);
+    TEST_ASSERT_TRUE(with_false.ok);
+    TEST_ASSERT_EQUAL_UINT32(clean.duration_ms, with_false.duration_ms);
+}
+
+// Упора нет (дальше, чем проходится за timeout_ms) - отказ по таймауту быстрого подхода
+static void test_no_wall_times_out(void) {
+    HomingSimParams p = test_params(3);
+    p.wall_usteps = -1000000000;
+    HomingSimResult r = homing_simulate(test_config(), p);
+    TEST_ASSERT_FALSE(r.ok);
+    TEST_ASSERT_EQUAL_STRING("fast approach: no stall before timeout", r.error);
+}
+
+// Разброс точки нуля по прогонам - в пределах модельного шума
+static void test_repeatability_spread(void) {
+    HomingRepeatability repeat;
+    homing_repeatability_reset(repeat);
+    for (uint32_t seed = 1; seed <= 20; seed++) {
+        HomingSimResult r = homing_simulate(test_config(), test_params(seed));
+        TEST_ASSERT_TRUE(r.ok);
+        homing_repeatability_add(repeat, r.origin_error_usteps);
+    }
+    TEST_ASSERT_EQUAL_UINT32(20, repeat.samples);
+    TEST_ASSERT_TRUE(homing_repeatability_spread(repeat) <= 2 * 8);
+    TEST_ASSERT_TRUE(homing_repeatability_spread(repeat) > 0);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_config_validate);
+    RUN_TEST(test_phase_sequence);
+    RUN_TEST(test_phase_timeouts);
+    RUN_TEST(test_simulated_homing_succeeds);
+    RUN_TEST(test_false_stall_during_acceleration_ignored);
+    RUN_TEST(test_no_wall_times_out);
+    RUN_TEST(test_repeatability_spread);
+    return UNITY_END();
+}
@@ -0,0 +1,199 @@
+// Кольцо лога (log_ring.h): вытеснение целыми записями с переходом на начало массива,
+// курсоры чтения, метки из смайликов, обрезка UTF-8 и рендер строки
+#include <unity.h>
+#include <string.h>
+#include "log_ring.h"
+
+static LogRing ring;
+
+// Нагрузка записи seq: номер и заполнитель переменной длины - по ней проверяется содержимое
+static size_t payload_for(uint32_t seq, char *out) {
+    size_t len = 4 + (seq * 37) % 200;
+    memcpy(out, &seq, 4);
+    for (size_t i = 4; i < len; i++) out[i] = (char)('a' + (seq + i) % 26);
+    return len;
+}
+
+static uint32_t push_numbered(uint32_t seq) {
+    char payload[LOG_PAYLOAD_MAX];
+    size_t len = payload_for(seq, payload);
+    return log_ring_push(ring, seq * 10, LOG_LEVEL_INFO, LOG_TAG_NONE, LOG_MSG_TEXT, payload, len);
+}
+
+// Все живые записи читаются по порядку и совпадают с тем, что писали
+static bool ring_consistent(void) {
+    LogCursor c;
+    LogRecord rec;
+    if (!log_ring_seek(ring, ring.first_seq, c)) return false;
+    uint32_t n = 0;
+    while (log_ring_next(ring, c, rec)) {
+        char expected[LOG_PAYLOAD_MAX];
+        size_t len = payload_for(rec.seq, expected);
+        if (rec.seq != ring.first_seq + n || rec.len != len || memcmp(rec.payload, expected, len) != 0) return false;
+        if (rec.timestamp_ms != rec.seq * 10) return false;
+        n++;
+    }
+    return n == ring.count && ring.first_seq + n == ring.next_seq && log_ring_bytes_used(ring) <= LOG_RING_BYTES;
+}
+
+void setUp(void) {
+    log_ring_init(ring);
+}
+void tearDown(void) {}
+
+static void test_push_and_read_back(void) {
+    for (uint32_t i = 0; i < 10; i++) TEST_ASSERT_EQUAL_UINT32(i, push_numbered(i));
+    TEST_ASSERT_EQUAL_UINT16(10, ring.count);
+    TEST_ASSERT_EQUAL_UINT32(0, ring.evicted);
+    TEST_ASSERT_TRUE(ring_consistent());
+}
+
+// Много оборотов кольца записями разной длины: вытесняются только целые старые записи
+static void test_wraps_and_evicts_whole_records(void) {
+    for (uint32_t i = 0; i < 5000; i++) {
+        push_numbered(i);
+        if (i % 97 == 0) TEST_ASSERT_TRUE(ring_consistent());
+    }
+    TEST_ASSERT_TRUE(ring_consistent());
+    TEST_ASSERT_EQUAL_UINT32(5000, ring.next_seq);
+    TEST_ASSERT_EQUAL_UINT32(ring.first_seq, ring.evicted);
+    TEST_ASSERT_TRUE(ring.evicted > 0);
+    // Кольцо заполнено почти целиком - не больше одной самой длинной записи пустует
+    TEST_ASSERT_TRUE(log_ring_bytes_used(ring) + LOG_RECORD_HEADER + LOG_PAYLOAD_MAX > LOG_RING_BYTES / 2);
+}
+
+// Курсор живой записи переживает новые записи; вытесненный - отказывает и встаёт на самую старую
+static void test_cursor_across_eviction(void) {
+    for (uint32_t i = 0; i < 20; i++) push_numbered(i);
+    LogCursor c;
+    LogRecord rec;
+    TEST_ASSERT_TRUE(log_ring_seek(ring, 15, c));
+    for (uint32_t i = 20; i < 25; i++) push_numbered(i);
+    TEST_ASSERT_TRUE(log_ring_next(ring, c, rec));
+    TEST_ASSERT_EQUAL_UINT32(15, rec.seq);
+
+    for (uint32_t i = 25; i < 2000; i++) push_numbered(i);
+    TEST_ASSERT_FALSE(log_ring_next(ring, c, rec));
+    TEST_ASSERT_FALSE(log_ring_seek(ring, 16, c));
+    TEST_ASSERT_EQUAL_UINT32(ring.first_seq, c.seq);
+    TEST_ASSERT_TRUE(log_ring_next(ring, c, rec));
+    TEST_ASSERT_EQUAL_UINT32(ring.first_seq, rec.seq);
+
+    // Курсор из будущего (лог очищен, прибор перезапущен) - тоже на самую старую
+    TEST_ASSERT_FALSE(log_ring_seek(ring, ring.next_seq + 5, c));
+    TEST_ASSERT_TRUE(log_ring_seek(ring, ring.next_seq, c));
+    TEST_ASSERT_FALSE(log_ring_next(ring, c, rec));
+}
+
+// Очистка - номера не начинаются заново
+static void test_clear_keeps_sequence(void) {
+    for (uint32_t i = 0; i < 5; i++) push_numbered(i);
+    log_ring_clear(ring);
+    TEST_ASSERT_EQUAL_UINT16(0, ring.count);
+    TEST_ASSERT_EQUAL_UINT16(0, log_ring_bytes_used(ring));
+    TEST_ASSERT_EQUAL_UINT32(5, push_numbered(5));
+    TEST_ASSERT_TRUE(ring_consistent());
+}
+
+static void test_long_payload_truncated(void) {
+    char big[400];
+    memset(big, 'x', sizeof(big));
+    log_ring_push(ring, 0, LOG_LEVEL_INFO, LOG_TAG_NONE, LOG_MSG_TEXT, big, sizeof(big));
+    LogCursor c;
+    LogRecord rec;
+    log_ring_seek(ring, 0, c);
+    TEST_ASSERT_TRUE(log_ring_next(ring, c, rec));
+    TEST_ASSERT_EQUAL_UINT8(LOG_PAYLOAD_MAX, rec.len);
+}
+
+static void test_classify_prefix(void) {
+    const char *text = "✅ Motor enabled";
+    size_t len = strlen(text);
+    TEST_ASSERT_EQUAL_UINT8(LOG_TAG_OK, log_classify(text, len));
+    TEST_ASSERT_EQUAL_STRING("Motor enabled", text);
+    TEST_ASSERT_EQUAL_UINT32(strlen("Motor enabled"), len);
+
+    text = "[WARN] hot";
+    len = strlen(text);
+    TEST_ASSERT_EQUAL_UINT8(LOG_TAG_WARN, log_classify(text, len));
+    TEST_ASSERT_EQUAL_STRING("hot", text);
+    TEST_ASSERT_EQUAL_UINT8(LOG_LEVEL_WARN, log_tag_level(LOG_TAG_WARN));
+    TEST_ASSERT_EQUAL_UINT8(LOG_LEVEL_ERROR, log_tag_level(LOG_TAG_STOP));
+
+    text = "plain [OK]";
+    len = strlen(text);
+    TEST_ASSERT_EQUAL_UINT8(LOG_TAG_NONE, log_classify(text, len));
+    TEST_ASSERT_EQUAL_STRING("plain [OK]", text);
+}
+
+// "ёж": 4 байта, граница после 2-го; обрезка посреди символа отступает назад
+static void test_utf8_clip(void) {
+    const char *s = "ёж";
+    TEST_ASSERT_EQUAL_UINT32(4, log_utf8_clip(s, 4, 10));
+    TEST_ASSERT_EQUAL_UINT32(2, log_utf8_clip(s, 4, 3));
+    TEST_ASSERT_EQUAL_UINT32(2, log_utf8_clip(s, 4, 2));
+    TEST_ASSERT_EQUAL_UINT32(0, log_utf8_clip(s, 4, 1));
+}
+
+// Уже обрезанный текст: оборванный в конце символ отбрасывается целиком, целые остаются
+static void test_utf8_trim(void) {
+    const char *s = "ёж";
+    TEST_ASSERT_EQUAL_UINT32(4, log_utf8_trim(s, 4));
+    TEST_ASSERT_EQUAL_UINT32(2, log_utf8_trim(s, 3));
+    TEST_ASSERT_EQUAL_UINT32(2, log_utf8_trim(s, 2));
+    TEST_ASSERT_EQUAL_UINT32(0, log_utf8_trim(s, 1));
+    const char *e = "a🚀";                          // 4-байтовый символ
+    TEST_ASSERT_EQUAL_UINT32(5, log_utf8_trim(e, 5));
+    for (size_t n = 1; n < 5; n++) TEST_ASSERT_EQUAL_UINT32(1, log_utf8_trim(e, n));
+    TEST_ASSERT_EQUAL_UINT32(0, log_utf8_trim(e, 0));
+}
+
+static void test_render_text_and_event(void) {
+    const char *msg = "Moving 🚀 now";
+    log_ring_push(ring, 61234, LOG_LEVEL_INFO, LOG_TAG_MOVE, LOG_MSG_TEXT, msg, strlen(msg));
+    int32_t args[LOG_EVENT_ARGS] = {1, 2, 150, 0};
+    log_ring_push(ring, 5, LOG_LEVEL_INFO, log_event_tag(LOG_MSG_SOLENOID_OK), LOG_MSG_SOLENOID_OK, args, sizeof(args));
+
+    LogCursor c;
+    LogRecord rec;
+    char out[LOG_RENDER_MAX];
+    log_ring_seek(ring, 0, c);
+    TEST_ASSERT_TRUE(log_ring_next(ring, c, rec));
+    log_render(rec, out);
+    TEST_ASSERT_EQUAL_STRING("[01:01.234] [MOVE] Moving [MOVE] now\n", out);
+    TEST_ASSERT_TRUE(log_ring_next(ring, c, rec));
+    log_render(rec, out);
+    TEST_ASSERT_EQUAL_STRING("[00:00.005] [OK] B (-90°) → H2 сработал за 150мс\n", out);
+}
+
+// Длинная строка со смайликами не выходит за LOG_RENDER_MAX
+static void test_render_bounded(void) {
+    char msg[LOG_PAYLOAD_MAX];
+    size_t o = 0;
+    while (o + 4 <= sizeof(msg)) { memcpy(msg + o, "🚀", 4); o += 4; }
+    log_ring_push(ring, 0, LOG_LEVEL_INFO, LOG_TAG_FAIL, LOG_MSG_TEXT, msg, o);
+    LogCursor c;
+    LogRecord rec;
+    char out[LOG_RENDER_MAX];
+    log_ring_seek(ring, 0, c);
+    TEST_ASSERT_TRUE(log_ring_next(ring, c, rec));
+    size_t len = log_render(rec, out);
+    TEST_ASSERT_TRUE(len < LOG_RENDER_MAX);
+    TEST_ASSERT_EQUAL_UINT32(len, strlen(out));
+    TEST_ASSERT_EQUAL_UINT8('\n', out[len - 1]);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_push_and_read_back);
+    RUN_TEST(test_wraps_and_evicts_whole_records);
+    RUN_TEST(test_cursor_across_eviction);
+    RUN_TEST(test_clear_keeps_sequence);
+    RUN_TEST(test_long_payload_truncated);
+    RUN_TEST(test_classify_prefix);
+    RUN_TEST(test_utf8_clip);
+    RUN_TEST(test_utf8_trim);
+    RUN_TEST(test_render_text_and_event);
+    RUN_TEST(test_render_bounded);
+    return UNITY_END();
+}
@@ -0,0 +1,169 @@
+// Lock-free очередь MPSC (mpsc_queue.h): FIFO и заполнение в одном потоке, затем несколько
+// производителей std::thread и один потребитель - ничего не теряется и не дублируется,
+// порядок каждого производителя сохраняется, при переполнении отказы посчитаны точно
+#include <unity.h>
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "mpsc_queue.h"
+
+struct Item {
+    uint32_t producer;
+    uint32_t seq;
+};
+
+#define PRODUCERS 4
+#define ITEMS_PER_PRODUCER 200000
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_fifo_and_full(void) {
+    MpscQueue<Item, 8> q;
+    Item out;
+    TEST_ASSERT_FALSE(q.pop(out));
+    for (uint32_t i = 0; i < 8; i++) TEST_ASSERT_TRUE(q.push({0, i}));
+    TEST_ASSERT_EQUAL_UINT16(8, q.size());
+    TEST_ASSERT_FALSE(q.push({0, 8}));          // Заполнена - сразу false
+
+    TEST_ASSERT_TRUE(q.pop(out));
+    TEST_ASSERT_EQUAL_UINT32(0, out.seq);
+    TEST_ASSERT_TRUE(q.push({0, 8}));           // Освободилась одна ячейка
+    for (uint32_t i = 1; i <= 8; i++) {
+        TEST_ASSERT_TRUE(q.pop(out));
+        TEST_ASSERT_EQUAL_UINT32(i, out.seq);
+    }
+    TEST_ASSERT_FALSE(q.pop(out));
+    TEST_ASSERT_EQUAL_UINT16(0, q.size());
+}
+
+// Индексы uint16_t переполняются много раз - порядок и ёмкость не меняются
+static void test_index_wraparound(void) {
+    MpscQueue<Item, 4> q;
+    Item out;
+    uint32_t next_in = 0, next_out = 0;
+    for (int round = 0; round < 300000; round++) {
+        int n = 1 + round % 4;
+        for (int i = 0; i < n; i++) TEST_ASSERT_TRUE(q.push({0, next_in++}));
+        if (n == 4) TEST_ASSERT_FALSE(q.push({0, 0xFFFFFFFF}));
+        for (int i = 0; i < n; i++) {
+            TEST_ASSERT_TRUE(q.pop(out));
+            TEST_ASSERT_EQUAL_UINT32(next_out++, out.seq);
+        }
+        TEST_ASSERT_FALSE(q.pop(out));
+    }
+    TEST_ASSERT_GREATER_THAN(65536 * 4, next_out);
+}
+
+// Производители повторяют push() до успеха: потребитель получает каждый элемент ровно
+// один раз и в порядке его производителя
+static void test_concurrent_no_loss_no_duplicates(void) {
+    static MpscQueue<Item, 32> q;
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([p]() {
+            for (uint32_t i = 0; i < ITEMS_PER_PRODUCER; i++) {
+                while (!q.push({p, i})) std::this_thread::yield();
+            }
+        });
+    }
+
+    uint32_t next[PRODUCERS] = {};
+    uint32_t received = 0, bad_producer = 0, out_of_order = 0;
+    while (received < PRODUCERS * ITEMS_PER_PRODUCER) {
+        if (!q.pop_with([&](const Item &item) {
+                if (item.producer >= PRODUCERS) {
+                    bad_producer++;
+                    return;
+                }
+                if (item.seq != next[item.producer]) out_of_order++;
+                next[item.producer] = item.seq + 1;
+            })) {
+            std::this_thread::yield();
+            continue;
+        }
+        received++;
+    }
+    for (auto &t : producers) t.join();
+
+    Item extra;
+    TEST_ASSERT_FALSE(q.pop(extra));            // Ничего лишнего
+    TEST_ASSERT_EQUAL_UINT32(0, bad_producer);
+    TEST_ASSERT_EQUAL_UINT32(0, out_of_order);  // Пропуск или повтор сбил бы номер
+    for (uint32_t p = 0; p < PRODUCERS; p++) TEST_ASSERT_EQUAL_UINT32(ITEMS_PER_PRODUCER, next[p]);
+}
+
+// Производители не ждут: отказ push() - потерянная строка. Принятые и отброшенные
+// элементы в сумме дают все попытки, и ни один не попал в оба множества
+static void test_concurrent_overflow_drop_count(void) {
+    static MpscQueue<Item, 8> q;
+    static std::vector<uint8_t> dropped_flags[PRODUCERS];
+    static std::vector<uint8_t> received_flags[PRODUCERS];
+    uint32_t dropped[PRODUCERS] = {};
+    std::atomic<uint32_t> producers_done{0};
+
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < PRODUCERS; p++) {
+        dropped_flags[p].assign(ITEMS_PER_PRODUCER, 0);
+        received_flags[p].assign(ITEMS_PER_PRODUCER, 0);
+        producers.emplace_back([p, &dropped, &producers_done]() {
+            for (uint32_t i = 0; i < ITEMS_PER_PRODUCER; i++) {
+                if (!q.push({p, i})) {
+                    dropped_flags[p][i] = 1;
+                    dropped[p]++;
+                }
+            }
+            producers_done.fetch_add(1);
+        });
+    }
+
+    // Потребитель медленнее производителей - очередь переполняется
+    uint32_t last[PRODUCERS];
+    bool seen[PRODUCERS] = {};
+    uint32_t received = 0, duplicates = 0, out_of_order = 0;
+    auto use = [&](const Item &item) {
+        if (received_flags[item.producer][item.seq]) duplicates++;
+        received_flags[item.producer][item.seq] = 1;
+        if (seen[item.producer] && item.seq <= last[item.producer]) out_of_order++;
+        seen[item.producer] = true;
+        last[item.producer] = item.seq;
+        received++;
+    };
+    for (;;) {
+        bool done = producers_done.load() == PRODUCERS;
+        if (!q.pop_with(use)) {
+            if (done) break;
+            std::this_thread::yield();
+        }
+        for (volatile int spin = 0; spin < 50; spin++) {
+        }
+    }
+    for (auto &t : producers) t.join();
+    while (q.pop_with(use)) {
+    }
+
+    uint32_t total_dropped = 0, both = 0, neither = 0;
+    for (uint32_t p = 0; p < PRODUCERS; p++) {
+        total_dropped += dropped[p];
+        for (uint32_t i = 0; i < ITEMS_PER_PRODUCER; i++) {
+            if (dropped_flags[p][i] && received_flags[p][i]) both++;
+            if (!dropped_flags[p][i] && !received_flags[p][i]) neither++;
+        }
+    }
+    TEST_ASSERT_GREATER_THAN(0, total_dropped);
+    TEST_ASSERT_EQUAL_UINT32(PRODUCERS * ITEMS_PER_PRODUCER, received + total_dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, duplicates);
+    TEST_ASSERT_EQUAL_UINT32(0, both);
+    TEST_ASSERT_EQUAL_UINT32(0, neither);
+    TEST_ASSERT_EQUAL_UINT32(0, out_of_order);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fifo_and_full);
+    RUN_TEST(test_index_wraparound);
+    RUN_TEST(test_concurrent_no_loss_no_duplicates);
+    RUN_TEST(test_concurrent_overflow_drop_count);
+    return UNITY_END();
+}
@@ -0,0 +1,123 @@
+// Шеститочечная рампа (ramp_profile.h): проверка профиля, пересчёт в регистры
+// и калькулятор времени движения
+#include <unity.h>
+#include "ramp_profile.h"
+
+#define FCLK 12000000UL     // Внутренний генератор TMC5160
+
+static RampProfile trapezoid(uint32_t vmax, uint32_t amax, uint32_t dmax) {
+    RampProfile p = {};
+    p.vmax = vmax;
+    p.amax = amax;
+    p.dmax = dmax;
+    return p;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_validate(void) {
+    RampProfile p = trapezoid(1000, 1000, 1000);
+    TEST_ASSERT_NULL(ramp_profile_validate(p));
+
+    p.vmax = 0;
+    TEST_ASSERT_NOT_NULL(ramp_profile_validate(p));
+    p = trapezoid(1000, 0, 1000);
+    TEST_ASSERT_NOT_NULL(ramp_profile_validate(p));
+
+    p = trapezoid(1000, 1000, 1000);
+    p.vstart = 10;
+    p.vstop = 5;
+    TEST_ASSERT_NOT_NULL(ramp_profile_validate(p));
+
+    p = trapezoid(1000, 1000, 1000);
+    p.v1 = 2000;
+    TEST_ASSERT_NOT_NULL(ramp_profile_validate(p));
+    p.v1 = 500;
+    TEST_ASSERT_NOT_NULL(ramp_profile_validate(p));     // v1 без a1/d1
+    p.a1 = 500;
+    p.d1 = 500;
+    TEST_ASSERT_NULL(ramp_profile_validate(p));
+}
+
+// v[Гц] = VMAX * fCLK / 2^24 на 256 микрошагах: 1000 шагов/с = 357914
+static void test_registers_scale_and_round_trip(void) {
+    RampRegisters r;
+    ramp_profile_to_registers(trapezoid(1000, 2000, 2000), FCLK, TMC_LIB_USTEPS_PER_STEP, r);
+    TEST_ASSERT_EQUAL_UINT32(357914, r.vmax);
+    TEST_ASSERT_EQUAL_UINT32(r.vmax, ramp_speed_to_vmax(1000, FCLK, TMC_LIB_USTEPS_PER_STEP));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1000.0f, ramp_vactual_to_speed((int32_t)r.vmax, FCLK, TMC_LIB_USTEPS_PER_STEP));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -1000.0f, ramp_vactual_to_speed(-(int32_t)r.vmax, FCLK, TMC_LIB_USTEPS_PER_STEP));
+
+    // a = AMAX * fCLK² / 2^41: 2000 шагов/с² на 256 микрошагах = 7818.75 -> 7819
+    TEST_ASSERT_EQUAL_UINT32(7819, r.amax);
+    TEST_ASSERT_EQUAL_UINT32(r.amax, r.dmax);
+}
+
+// Регистры не выходят за разрядность; VSTOP >= VSTART и не 0, D1/DMAX/AMAX не 0
+static void test_registers_clamp_and_positioning_limits(void) {
+    RampProfile p = trapezoid(1000000, 10000000, 1);
+    p.vstart = 100;
+    p.vstop = 0;
+    RampRegisters r;
+    ramp_profile_to_registers(p, FCLK, TMC_LIB_USTEPS_PER_STEP, r);
+    TEST_ASSERT_EQUAL_UINT32(RAMP_REG_VMAX_MAX, r.vmax);
+    TEST_ASSERT_EQUAL_UINT32(RAMP_REG_ACC_MAX, r.amax);
+    TEST_ASSERT_EQUAL_UINT32(r.vstart, r.vstop);
+    TEST_ASSERT_TRUE(r.dmax >= 1);
+    TEST_ASSERT_EQUAL_UINT32(1, r.d1);
+
+    ramp_profile_to_registers(trapezoid(1000, 1000, 1000), FCLK, TMC_LIB_USTEPS_PER_STEP, r);
+    TEST_ASSERT_EQUAL_UINT32(1, r.vstop);
+    TEST_ASSERT_EQUAL_UINT32(0, r.vstart);
+}
+
+// 1000 шагов/с, 1000 шагов/с²: по 500 шагов и 1 с на рампу + 9000 шагов крейсера
+static void test_time_trapezoid(void) {
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 11000.0f, estimate_move_time_ms(trapezoid(1000, 1000, 1000), 10000));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, estimate_move_time_ms(trapezoid(1000, 1000, 1000), 0));
+}
+
+// 500 шагов не хватает до VMAX: пик sqrt(500 * 1000) = 707 шагов/с, 2 * 0.707 с
+static void test_time_triangle(void) {
+    TEST_ASSERT_FLOAT_WITHIN(2.0f, 1414.2f, estimate_move_time_ms(trapezoid(1000, 1000, 1000), 500));
+}
+
+// A1 = 500 до V1 = 500 (1 с, 250 шагов), AMAX = 1000 до VMAX (0.5 с, 375 шагов), торможение зеркально
+static void test_time_six_point(void) {
+    RampProfile p = trapezoid(1000, 1000, 1000);
+    p.v1 = 500;
+    p.a1 = 500;
+    p.d1 = 500;
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 3000.0f + 8750.0f, estimate_move_time_ms(p, 10000));
+    // Более мягкий первый участок - движение дольше простой трапеции
+    TEST_ASSERT_TRUE(estimate_move_time_ms(p, 10000) > estimate_move_time_ms(trapezoid(1000, 1000, 1000), 10000));
+}
+
+// Время растёт с путём и на границе треугольник/трапеция не скачет
+static void test_time_monotonic_in_distance(void) {
+    RampProfile p = trapezoid(1000, 1000, 1000);
+    p.vstart = 50;
+    p.vstop = 100;
+    p.v1 = 400;
+    p.a1 = 300;
+    p.d1 = 300;
+    float prev = 0;
+    for (uint32_t d = 1; d <= 3000; d += 7) {
+        float t = estimate_move_time_ms(p, d);
+        TEST_ASSERT_TRUE(t >= prev - 0.5f);
+        prev = t;
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_validate);
+    RUN_TEST(test_registers_scale_and_round_trip);
+    RUN_TEST(test_registers_clamp_and_positioning_limits);
+    RUN_TEST(test_time_trapezoid);
+    RUN_TEST(test_time_triangle);
+    RUN_TEST(test_time_six_point);
+    RUN_TEST(test_time_monotonic_in_distance);
+    return UNITY_END();
+}
@@ -0,0 +1,182 @@
+// Программы движения (sequence_vm.h): компиляция текста в байткод, ошибки со строкой,
+// шаги в шкале микрошагов, интерпретатор (ходы, ожидания, циклы, таймауты) и его замер
+#include <unity.h>
+#include "sequence_vm.h"
+
+static SeqProgram program;
+
+// Прогон без железа: ходы завершаются мгновенно, ожидания истекают за один вызов, StallGuard
+// срабатывает на каждом. Программа перезапускается по окончании. Возвращает число операций
+static uint32_t seq_benchmark_run(const SeqProgram &p, uint32_t min_ops, uint32_t *actions) {
+    SeqVm vm;
+    seq_start(vm);
+    SeqInputs in = {0, true, 0};
+    uint32_t ops = 0, acts = 0;
+    while (ops + vm.ops_executed < min_ops) {
+        in.now_ms += 100000;
+        in.stall_count++;
+        SeqAction act = seq_step(vm, p, in);
+        if (act.type != SEQ_ACT_NONE) acts++;
+        if (vm.state != SEQ_RUNNING) {
+            if (vm.state == SEQ_FAILED) break;
+            ops += vm.ops_executed;
+            seq_start(vm);
+        }
+    }
+    if (actions) *actions = acts;
+    return ops + vm.ops_executed;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// move в шагах умножается на шкалу, move_us - как есть
+static void test_compile_scales_steps(void) {
+    SeqCompileResult r = seq_compile("move 1000\nmove_us 7\nmove_to -2", 16, program);
+    TEST_ASSERT_NULL(r.error);
+    TEST_ASSERT_EQUAL_UINT16(3, program.ops);
+    TEST_ASSERT_EQUAL_UINT32(SEQ_OP_MOVE, program.code[0]);
+    TEST_ASSERT_EQUAL_INT32(16000, (int32_t)program.code[1]);
+    TEST_ASSERT_EQUAL_INT32(7, (int32_t)program.code[3]);
+    TEST_ASSERT_EQUAL_UINT32(SEQ_OP_MOVE_TO, program.code[4]);
+    TEST_ASSERT_EQUAL_INT32(-32, (int32_t)program.code[5]);
+    TEST_ASSERT_EQUAL_UINT32(SEQ_OP_HALT, program.code[program.length - 1]);
+
+    // 10^7 шагов помещаются на 16 микрошагах и не помещаются на 256
+    TEST_ASSERT_NULL(seq_compile("move 10000000", 16, program).error);
+    TEST_ASSERT_NOT_NULL(seq_compile("move 10000000", 256, program).error);
+}
+
+static void test_compile_errors_report_line(void) {
+    static const struct { const char *src; uint16_t line; } cases[] = {
+        {"move 1\nfly 2", 2},
+        {"# комментарий\n\nwait x", 3},
+        {"loop 2\nmove 1", 1},              // loop without end
+        {"move 1\nend", 2},                 // end without loop
+        {"loop 3\nend", 2},                 // empty loop
+        {"loop 1\nloop 1\nloop 1\nloop 1\nloop 1", 5},
+        {"ramp", 1},
+        {"current 0", 1},
+    };
+    for (auto &c : cases) {
+        SeqCompileResult r = seq_compile(c.src, 256, program);
+        TEST_ASSERT_NOT_NULL(r.error);
+        TEST_ASSERT_EQUAL_UINT16(c.line, r.line);
+    }
+}
+
+// Ход - действие, wait_done ждёт завершения, wait - времени
+static void test_step_through_moves_and_waits(void) {
+    TEST_ASSERT_NULL(seq_compile("move 10\nwait_done\nwait 250\ncurrent 800\nramp 1000 2000", 1, program).error);
+    SeqVm vm;
+    seq_start(vm);
+    SeqInputs in = {1000, true, 0};
+
+    SeqAction a = seq_step(vm, program, in);
+    TEST_ASSERT_EQUAL_UINT8(SEQ_ACT_MOVE, a.type);
+    TEST_ASSERT_EQUAL_INT32(10, a.arg[0]);
+    in.move_done = false;
+    TEST_ASSERT_EQUAL_UINT8(SEQ_ACT_NONE, seq_step(vm, program, in).type);
+    TEST_ASSERT_EQUAL_UINT8(SEQ_OP_WAIT_DONE, vm.waiting);
+
+    in.move_done = true;
+    TEST_ASSERT_EQUAL_UINT8(SEQ_ACT_NONE, seq_step(vm, program, in).type);
+    TEST_ASSERT_EQUAL_UINT8(SEQ_OP_WAIT, vm.waiting);
+    in.now_ms += 249;
+    TEST_ASSERT_EQUAL_UINT8(SEQ_ACT_NONE, seq_step(vm, program, in).type);
+    in.now_ms += 1;
+    a = seq_step(vm, program, in);
+    TEST_ASSERT_EQUAL_UINT8(SEQ_ACT_CURRENT, a.type);
+    TEST_ASSERT_EQUAL_INT32(800, a.arg[0]);
+    a = seq_step(vm, program, in);
+    TEST_ASSERT_EQUAL_UINT8(SEQ_ACT_RAMP, a.type);
+    TEST_ASSERT_EQUAL_INT32(2000, a.arg[1]);
+    TEST_ASSERT_EQUAL_INT32(0, a.arg[2]);
+    seq_step(vm, program, in);
+    TEST_ASSERT_EQUAL_UINT8(SEQ_DONE, vm.state);
+}
+
+// Вложенные циклы: 3 · 2 хода внутреннего и 3 внешнего
+static void test_nested_loops(void) {
+    TEST_ASSERT_NULL(seq_compile("loop 3\n move 1\n loop 2\n  move_us 2\n end\nend", 1, program).error);
+    SeqVm vm;
+    seq_start(vm);
+    SeqInputs in = {0, true, 0};
+    int32_t sum = 0;
+    uint32_t moves = 0;
+    for (int i = 0; i < 100 && vm.state == SEQ_RUNNING; i++) {
+        SeqAction a = seq_step(vm, program, in);
+        if (a.type == SEQ_ACT_MOVE) { sum += a.arg[0]; moves++; }
+    }
+    TEST_ASSERT_EQUAL_UINT8(SEQ_DONE, vm.state);
+    TEST_ASSERT_EQUAL_UINT32(9, moves);
+    TEST_ASSERT_EQUAL_INT32(3 * 1 + 6 * 2, sum);
+}
+
+static void test_wait_timeouts_fail(void) {
+    TEST_ASSERT_NULL(seq_compile("move 1\nwait_done 500", 1, program).error);
+    SeqVm vm;
+    seq_start(vm);
+    SeqInputs in = {0, false, 0};
+    seq_step(vm, program, in);
+    seq_step(vm, program, in);
+    in.now_ms = 499;
+    seq_step(vm, program, in);
+    TEST_ASSERT_EQUAL_UINT8(SEQ_RUNNING, vm.state);
+    in.now_ms = 500;
+    seq_step(vm, program, in);
+    TEST_ASSERT_EQUAL_UINT8(SEQ_FAILED, vm.state);
+    TEST_ASSERT_EQUAL_STRING("wait_done timeout", vm.error);
+
+    // wait_stall завершается новым срабатыванием StallGuard
+    TEST_ASSERT_NULL(seq_compile("wait_stall\nmove 1", 1, program).error);
+    seq_start(vm);
+    in = {0, true, 5};
+    TEST_ASSERT_EQUAL_UINT8(SEQ_ACT_NONE, seq_step(vm, program, in).type);
+    in.now_ms = 100000;
+    TEST_ASSERT_EQUAL_UINT8(SEQ_ACT_NONE, seq_step(vm, program, in).type);
+    in.stall_count = 6;
+    TEST_ASSERT_EQUAL_UINT8(SEQ_ACT_MOVE, seq_step(vm, program, in).type);
+}
+
+// Испорченный байткод не выходит за программу
+static void test_bad_bytecode_fails_safely(void) {
+    TEST_ASSERT_NULL(seq_compile("move 1", 1, program).error);
+    program.code[0] = 200;
+    SeqVm vm;
+    seq_start(vm);
+    SeqInputs in = {0, true, 0};
+    seq_step(vm, program, in);
+    TEST_ASSERT_EQUAL_UINT8(SEQ_FAILED, vm.state);
+    TEST_ASSERT_EQUAL_STRING("bad opcode", vm.error);
+
+    // Бесконечный цикл без ходов не вешает seq_step(): не больше SEQ_MAX_OPS_PER_STEP за вызов
+    TEST_ASSERT_NULL(seq_compile("loop 0\nwait 0\nend", 1, program).error);
+    seq_start(vm);
+    seq_step(vm, program, in);
+    TEST_ASSERT_EQUAL_UINT8(SEQ_RUNNING, vm.state);
+    TEST_ASSERT_EQUAL_UINT32(SEQ_MAX_OPS_PER_STEP, vm.ops_executed);
+}
+
+// Замер: программа центрирования прокручивается целиком, число действий - по ходам
+static void test_benchmark_run(void) {
+    TEST_ASSERT_NULL(seq_compile("move 1000\nwait_done\nwait 250\nmove -1000\nwait_done\nwait 250", 256, program).error);
+    uint32_t actions = 0;
+    uint32_t ops = seq_benchmark_run(program, 70000, &actions);
+    TEST_ASSERT_TRUE(ops >= 70000);
+    // 7 операций на проход (с HALT), из них 2 хода
+    TEST_ASSERT_UINT32_WITHIN(2, ops * 2 / 7, actions);
+    TEST_ASSERT_TRUE(seq_program_bytes(program) < sizeof(SeqProgram));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_compile_scales_steps);
+    RUN_TEST(test_compile_errors_report_line);
+    RUN_TEST(test_step_through_moves_and_waits);
+    RUN_TEST(test_nested_loops);
+    RUN_TEST(test_wait_timeouts_fail);
+    RUN_TEST(test_bad_bytecode_fails_safely);
+    RUN_TEST(test_benchmark_run);
+    return UNITY_END();
+}
@@ -0,0 +1,257 @@
+#pragma once
+// Записанный свип SGT (/api/sg_tune/samples.csv): 2 полосы x 3 SGT x 40 выборок,
+// перед каждой точкой - 2 выборки в покое (stst = 1)
+static const char SAMPLES_CSV[] =
+    "band,speed,tstep,sgt,sg_result,cs_actual,stst\n"
+    "0,200,1200,-2,0,8,1\n"
+    "0,200,1200,-2,0,8,1\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,-2,0,16,0\n"
+    "0,200,1200,-2,30,18,0\n"
+    "0,200,1200,0,0,8,1\n"
+    "0,200,1200,0,0,8,1\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,0,300,16,0\n"
+    "0,200,1200,0,340,18,0\n"
+    "0,200,1200,2,0,8,1\n"
+    "0,200,1200,2,0,8,1\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "0,200,1200,2,500,16,0\n"
+    "0,200,1200,2,540,18,0\n"
+    "1,800,300,-2,0,8,1\n"
+    "1,800,300,-2,0,8,1\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,-2,0,16,0\n"
+    "1,800,300,-2,10,18,0\n"
+    "1,800,300,0,0,8,1\n"
+    "1,800,300,0,0,8,1\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,0,60,16,0\n"
+    "1,800,300,0,100,18,0\n"
+    "1,800,300,2,0,8,1\n"
+    "1,800,300,2,0,8,1\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n"
+    "1,800,300,2,400,16,0\n"
+    "1,800,300,2,440,18,0\n";
@@ -0,0 +1,148 @@
+// Статистика StallGuard (sg_stats.h) по записанному CSV свипа: разбор строк, среднее и
+// дисперсия точек, рекомендация SGT полосы и итог SGT/TCOOLTHRS
+#include <unity.h>
+#include <string.h>
+#include "sg_stats.h"
+#include "samples_csv.h"
+
+static SgBandResult bands[SG_MAX_BANDS];
+static uint8_t band_count;
+
+struct CsvRun {
+    uint32_t accepted;
+    uint32_t rejected;      // Заголовок, пустые и битые строки
+};
+
+// Построчно, как хостовый разбор файла /api/sg_tune/samples.csv
+static CsvRun run_csv(const char *text) {
+    CsvRun run = {0, 0};
+    char line[128];
+    while (*text) {
+        size_t n = strcspn(text, "\n");
+        if (n >= sizeof(line)) n = sizeof(line) - 1;
+        memcpy(line, text, n);
+        line[n] = '\0';
+        text += strcspn(text, "\n");
+        if (*text == '\n') text++;
+
+        SgCsvRow row;
+        if (sg_csv_parse_line(line, row) && sg_accumulate(bands, &band_count, row)) run.accepted++;
+        else run.rejected++;
+    }
+    for (uint8_t i = 0; i < band_count; i++) sg_band_recommend(bands[i]);
+    return run;
+}
+
+static const SgSweepPoint *point(uint8_t band, int8_t sgt) {
+    for (uint8_t i = 0; i < bands[band].points; i++) {
+        if (bands[band].sweep[i].sgt == sgt) return &bands[band].sweep[i];
+    }
+    return nullptr;
+}
+
+void setUp(void) {
+    band_count = 0;
+}
+void tearDown(void) {}
+
+// 300/340 через одну: среднее 320, выборочная дисперсия 40·20²/39, выборки в покое отдельно
+static void test_point_mean_and_variance(void) {
+    CsvRun run = run_csv(SAMPLES_CSV);
+    TEST_ASSERT_EQUAL_UINT32(2 * 3 * 42, run.accepted);
+    TEST_ASSERT_EQUAL_UINT32(1, run.rejected);          // Заголовок
+    TEST_ASSERT_EQUAL_UINT8(2, band_count);
+
+    const SgSweepPoint *p = point(0, 0);
+    TEST_ASSERT_NOT_NULL(p);
+    TEST_ASSERT_EQUAL_UINT32(40, p->stats.n);
+    TEST_ASSERT_EQUAL_UINT32(2, p->stats.standstill);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 320.0f, p->stats.mean);
+    TEST_ASSERT_FLOAT_WITHIN(1e-2f, 16000.0f / 39.0f, p->stats.m2 / (p->stats.n - 1));
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 17.0f, p->stats.cs_mean);
+    TEST_ASSERT_EQUAL_UINT16(300, p->stats.min);
+    TEST_ASSERT_EQUAL_UINT16(340, p->stats.max);
+}
+
+// Полоса 0: SGT -2 касается нуля, SGT 0 - наименьший безопасный.
+// Полоса 1: у SGT 0 пол шума 80 - 4σ ниже запаса, безопасен только SGT 2
+static void test_band_recommendation(void) {
+    run_csv(SAMPLES_CSV);
+    TEST_ASSERT_FALSE(sg_point_safe(point(0, -2)->stats));
+    TEST_ASSERT_TRUE(bands[0].usable);
+    TEST_ASSERT_EQUAL_INT8(0, bands[0].sgt_recommended);
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 320.0f - SG_NOISE_SIGMA * 20.255f, bands[0].floor);
+    TEST_ASSERT_EQUAL_UINT32(1200 + 1200 / SG_TCOOLTHRS_MARGIN_DIV, bands[0].tcoolthrs);
+
+    TEST_ASSERT_FALSE(sg_point_safe(point(1, 0)->stats));
+    TEST_ASSERT_TRUE(bands[1].usable);
+    TEST_ASSERT_EQUAL_INT8(2, bands[1].sgt_recommended);
+    TEST_ASSERT_EQUAL_UINT32(300 + 300 / SG_TCOOLTHRS_MARGIN_DIV, bands[1].tcoolthrs);
+}
+
+// SGT безопасный во всех полосах - наибольший; TCOOLTHRS - по самой медленной (наибольший TSTEP)
+static void test_tune_summary(void) {
+    run_csv(SAMPLES_CSV);
+    int8_t sgt = 0;
+    uint32_t tcoolthrs = 0;
+    TEST_ASSERT_TRUE(sg_tune_summary(bands, band_count, &sgt, &tcoolthrs));
+    TEST_ASSERT_EQUAL_INT8(2, sgt);
+    TEST_ASSERT_EQUAL_UINT32(1350, tcoolthrs);
+}
+
+// Битые строки отбрасываются и не портят статистику
+static void test_malformed_lines_rejected(void) {
+    static const char *bad[] = {
+        "", "band,speed,tstep,sgt,sg_result,cs_actual,stst", "0,200,1200,0,300,16",
+        "0,200,1200,0,1024,16,0", "0,200,1200,0,300,32,0", "0,200,1200,64,300,16,0",
+        "6,200,1200,0,300,16,0", "x,200,1200,0,300,16,0",
+    };
+    SgCsvRow row;
+    for (const char *line : bad) TEST_ASSERT_FALSE(sg_csv_parse_line(line, row));
+    TEST_ASSERT_TRUE(sg_csv_parse_line("5,3000,80,-64,1023,31,0\r", row));
+    TEST_ASSERT_EQUAL_INT8(-64, row.sgt);
+
+    CsvRun run = run_csv("0,200,1200,0,300,16,0\ngarbage\n0,200,1200,0,1024,16,0\n0,200,1200,0,340,18,0\n");
+    TEST_ASSERT_EQUAL_UINT32(2, run.accepted);
+    TEST_ASSERT_EQUAL_UINT32(2, run.rejected);
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 320.0f, point(0, 0)->stats.mean);
+    TEST_ASSERT_FALSE(bands[0].usable);                 // 2 выборки меньше SG_MIN_SAMPLES
+}
+
+// Пустой файл - ни одной полосы, рекомендации нет
+static void test_empty_input(void) {
+    CsvRun run = run_csv("");
+    TEST_ASSERT_EQUAL_UINT32(0, run.accepted);
+    TEST_ASSERT_EQUAL_UINT8(0, band_count);
+    int8_t sgt = 0;
+    uint32_t tcoolthrs = 0;
+    TEST_ASSERT_FALSE(sg_tune_summary(bands, band_count, &sgt, &tcoolthrs));
+
+    run = run_csv(SG_CSV_HEADER "\n");
+    TEST_ASSERT_EQUAL_UINT32(1, run.rejected);
+    TEST_ASSERT_EQUAL_UINT8(0, band_count);
+}
+
+// Формат записи читается обратно тем же разбором
+static void test_format_round_trip(void) {
+    SgCsvRow in = {3, 1500, 160, -7, 812, 21, false}, out;
+    char buf[96];
+    sg_csv_format_row(buf, sizeof(buf), in);
+    TEST_ASSERT_TRUE(sg_csv_parse_line(buf, out));
+    TEST_ASSERT_EQUAL_UINT8(in.band, out.band);
+    TEST_ASSERT_EQUAL_UINT32(in.tstep, out.tstep);
+    TEST_ASSERT_EQUAL_INT8(in.sgt, out.sgt);
+    TEST_ASSERT_EQUAL_UINT16(in.sg_result, out.sg_result);
+    TEST_ASSERT_EQUAL_UINT32(sg_sample_pack(812, 21, false, -7, 3), sg_sample_pack(out.sg_result, out.cs_actual, out.stst, out.sgt, out.band));
+    TEST_ASSERT_EQUAL_INT8(-7, sg_sample_sgt(sg_sample_pack(812, 21, false, -7, 3)));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_point_mean_and_variance);
+    RUN_TEST(test_band_recommendation);
+    RUN_TEST(test_tune_summary);
+    RUN_TEST(test_malformed_lines_rejected);
+    RUN_TEST(test_empty_input);
+    RUN_TEST(test_format_round_trip);
+    return UNITY_END();
+}
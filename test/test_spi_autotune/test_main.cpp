@@ -0,0 +1,114 @@
+// Автонастройка частоты SPI: выбор ступени и probeLink на модели чипа с инжекцией ошибок
+#include <unity.h>
+#include "tmc_spi.h"
+
+static TMC5160_ShadowSPI *tmc;
+
+void setUp(void) {
+    mock_chip.reset();
+    mock_millis = 1000;
+    tmc = new TMC5160_ShadowSPI(5, 12000000, SPISettings(SPI_CLOCK_SAFE_HZ, MSBFIRST, SPI_MODE3));
+}
+
+void tearDown(void) {
+    delete tmc;
+    tmc = nullptr;
+}
+
+// Как probe_tmc_link() в tmc.cpp, но на тестовом экземпляре
+static uint16_t probe_mock_link(uint32_t hz, uint16_t *checks, void *ctx) {
+    TMC5160_ShadowSPI *dev = (TMC5160_ShadowSPI *)ctx;
+    dev->setSpiClock(hz);
+    return dev->probeLink(SPI_AUTOTUNE_PATTERNS, checks);
+}
+
+static uint32_t autotune(SpiClockProbeResult *results, uint8_t *probed) {
+    return spi_autotune_select(SPI_AUTOTUNE_STEPS_HZ, SPI_AUTOTUNE_MAX_STEPS, SPI_AUTOTUNE_MARGIN_STEPS,
+                               probe_mock_link, tmc, results, probed);
+}
+
+// Чистый алгоритм: сбой с 4 МГц -> последняя стабильная 2 МГц, минус запас -> 1 МГц
+static uint16_t probe_fail_from_4mhz(uint32_t hz, uint16_t *checks, void *ctx) {
+    *checks = 10;
+    return hz >= SPI_AUTOTUNE_STEPS_HZ[5] ? 3 : 0;
+}
+
+static void test_select_stops_at_first_failure(void) {
+    SpiClockProbeResult results[SPI_AUTOTUNE_MAX_STEPS];
+    uint8_t probed = 0;
+    uint32_t hz = spi_autotune_select(SPI_AUTOTUNE_STEPS_HZ, SPI_AUTOTUNE_MAX_STEPS, 1,
+                                      probe_fail_from_4mhz, nullptr, results, &probed);
+    TEST_ASSERT_EQUAL_UINT32(SPI_AUTOTUNE_STEPS_HZ[3], hz);
+    TEST_ASSERT_EQUAL_UINT8(6, probed);   // выше первой нестабильной ступени не пробуем
+    TEST_ASSERT_EQUAL_UINT16(0, results[4].errors);
+    TEST_ASSERT_EQUAL_UINT16(3, results[5].errors);
+}
+
+static void test_select_margin_clamped_to_first_step(void) {
+    SpiClockProbeResult results[SPI_AUTOTUNE_MAX_STEPS];
+    uint8_t probed = 0;
+    uint32_t hz = spi_autotune_select(SPI_AUTOTUNE_STEPS_HZ, SPI_AUTOTUNE_MAX_STEPS, 3,
+                                      probe_fail_from_4mhz, nullptr, results, &probed);
+    TEST_ASSERT_EQUAL_UINT32(SPI_AUTOTUNE_STEPS_HZ[1], hz);
+
+    hz = spi_autotune_select(SPI_AUTOTUNE_STEPS_HZ, 2, 3, probe_fail_from_4mhz, nullptr, results, &probed);
+    TEST_ASSERT_EQUAL_UINT32(SPI_AUTOTUNE_STEPS_HZ[0], hz);
+}
+
+// Канал стабилен до 2 МГц включительно: выбирается 1 МГц, частота на шине - та, что пробовалась последней
+static void test_probe_link_with_fault_injection(void) {
+    mock_chip.max_stable_hz = 2000000;
+    SpiClockProbeResult results[SPI_AUTOTUNE_MAX_STEPS];
+    uint8_t probed = 0;
+
+    uint32_t hz = autotune(results, &probed);
+
+    TEST_ASSERT_EQUAL_UINT32(1000000, hz);
+    TEST_ASSERT_EQUAL_UINT8(6, probed);
+    for (uint8_t i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_UINT16(0, results[i].errors);
+        TEST_ASSERT_EQUAL_UINT16(SPI_AUTOTUNE_PATTERNS * 2, results[i].checks);
+    }
+    TEST_ASSERT_EQUAL_UINT32(4000000, results[5].hz);
+    TEST_ASSERT_GREATER_THAN(0, results[5].errors);
+    TEST_ASSERT_GREATER_THAN(0, tmc->getReadbackErrors());
+    TEST_ASSERT_GREATER_THAN(0, tmc->getIoinErrors());
+}
+
+static void test_probe_link_all_fail_returns_zero(void) {
+    mock_chip.max_stable_hz = 50000;   // ниже первой ступени
+    SpiClockProbeResult results[SPI_AUTOTUNE_MAX_STEPS];
+    uint8_t probed = 0;
+
+    TEST_ASSERT_EQUAL_UINT32(0, autotune(results, &probed));
+    TEST_ASSERT_EQUAL_UINT8(1, probed);
+}
+
+static void test_probe_link_all_stable_takes_margin(void) {
+    SpiClockProbeResult results[SPI_AUTOTUNE_MAX_STEPS];
+    uint8_t probed = 0;
+
+    uint32_t hz = autotune(results, &probed);
+    TEST_ASSERT_EQUAL_UINT32(SPI_AUTOTUNE_STEPS_HZ[SPI_AUTOTUNE_MAX_STEPS - 1 - SPI_AUTOTUNE_MARGIN_STEPS], hz);
+    TEST_ASSERT_EQUAL_UINT8(SPI_AUTOTUNE_MAX_STEPS, probed);
+}
+
+// probeLink возвращает X_ENC в исходное значение
+static void test_probe_link_restores_scratch_register(void) {
+    mock_chip.regs[TMC5160_Reg::X_ENC] = 0xCAFE;
+    uint16_t checks = 0;
+    TEST_ASSERT_EQUAL_UINT16(0, tmc->probeLink(SPI_AUTOTUNE_PATTERNS, &checks));
+    TEST_ASSERT_EQUAL_UINT16(SPI_AUTOTUNE_PATTERNS * 2, checks);
+    TEST_ASSERT_EQUAL_HEX32(0xCAFE, mock_chip.regs[TMC5160_Reg::X_ENC]);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_select_stops_at_first_failure);
+    RUN_TEST(test_select_margin_clamped_to_first_step);
+    RUN_TEST(test_probe_link_with_fault_injection);
+    RUN_TEST(test_probe_link_all_fail_returns_zero);
+    RUN_TEST(test_probe_link_all_stable_takes_margin);
+    RUN_TEST(test_probe_link_restores_scratch_register);
+    return UNITY_END();
+}
@@ -0,0 +1,127 @@
+// Планировщик интервалов STEP/DIR (step_planner.h): число шагов, форма профиля
+// и время против идеальной трапеции
+#include <unity.h>
+#include "step_planner.h"
+
+struct ProfileSummary {
+    uint32_t steps;
+    uint64_t ticks;
+    uint32_t first;
+    uint32_t last;
+    uint32_t min_interval;
+    uint32_t accel_rises;     // Интервал вырос на разгоне (не должно быть)
+    uint32_t decel_drops;     // Интервал упал на торможении (не должно быть)
+};
+
+static ProfileSummary run_planner(uint32_t total, uint32_t hz, uint32_t accel, uint32_t decel, uint32_t jerk) {
+    StepPlanner p = {};
+    step_planner_init(p, total, hz, accel, decel, jerk);
+    uint32_t decel_start = p.total_steps - p.decel_steps;
+
+    ProfileSummary s = {};
+    s.min_interval = UINT32_MAX;
+    uint32_t prev = 0;
+    for (uint32_t t = step_planner_next(p); t != 0; t = step_planner_next(p)) {
+        if (s.steps == 0) s.first = t;
+        if (prev != 0 && s.steps < p.accel_steps && t > prev) s.accel_rises++;
+        if (prev != 0 && s.steps > decel_start && t < prev) s.decel_drops++;
+        if (t < s.min_interval) s.min_interval = t;
+        s.ticks += t;
+        s.last = t;
+        prev = t;
+        s.steps++;
+    }
+    return s;
+}
+
+static float error_pct(const ProfileSummary &s, uint32_t total, uint32_t hz, uint32_t accel, uint32_t decel) {
+    float planned_us = s.ticks * 1e6f / STEP_RMT_TICK_HZ;
+    float ideal_us = step_planner_ideal_time_us(total, hz, accel, decel);
+    return (planned_us - ideal_us) * 100.0f / ideal_us;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_emits_exactly_total_steps(void) {
+    static const uint32_t totals[] = {1, 2, 3, 17, 1000, 12345, 200000};
+    static const uint32_t jerks[] = {0, 1, 50, STEP_PLANNER_MAX_JERK_STEPS + 1};
+    for (uint32_t total : totals) {
+        for (uint32_t jerk : jerks) {
+            TEST_ASSERT_EQUAL_UINT32(total, run_planner(total, 20000, 50000, 20000, jerk).steps);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, run_planner(0, 1000, 1000, 1000, 0).steps);
+}
+
+static void test_trapezoid_reaches_cruise_and_matches_ideal_time(void) {
+    ProfileSummary s = run_planner(20000, 5000, 10000, 10000, 0);
+    TEST_ASSERT_EQUAL_UINT32(STEP_RMT_TICK_HZ / 5000, s.min_interval);
+    TEST_ASSERT_EQUAL_UINT32(0, s.accel_rises);
+    TEST_ASSERT_EQUAL_UINT32(0, s.decel_drops);
+    TEST_ASSERT_TRUE(fabsf(error_pct(s, 20000, 5000, 10000, 10000)) < 2.0f);
+}
+
+// Путь короче двух рамп: пик ниже max_hz, время - как у идеального треугольника
+static void test_triangle_stays_below_max_speed(void) {
+    ProfileSummary s = run_planner(500, 50000, 10000, 10000, 0);
+    TEST_ASSERT_TRUE(s.min_interval > STEP_RMT_TICK_HZ / 50000);
+    TEST_ASSERT_EQUAL_UINT32(0, s.accel_rises);
+    TEST_ASSERT_EQUAL_UINT32(0, s.decel_drops);
+    TEST_ASSERT_TRUE(fabsf(error_pct(s, 500, 50000, 10000, 10000)) < 3.0f);
+}
+
+// Одинаковые рампы - профиль симметричен: первый и последний интервалы близки
+static void test_equal_ramps_are_symmetric(void) {
+    ProfileSummary s = run_planner(4000, 8000, 20000, 20000, 0);
+    uint32_t diff = s.first > s.last ? s.first - s.last : s.last - s.first;
+    TEST_ASSERT_TRUE(diff * 20 < s.first);
+}
+
+// S-кривая: ускорение нарастает, поэтому старт медленнее трапеции, а время больше
+static void test_s_curve_starts_softer(void) {
+    ProfileSummary trap = run_planner(20000, 5000, 10000, 10000, 0);
+    ProfileSummary scurve = run_planner(20000, 5000, 10000, 10000, 200);
+    TEST_ASSERT_TRUE(scurve.first > trap.first);
+    TEST_ASSERT_TRUE(scurve.ticks > trap.ticks);
+    TEST_ASSERT_EQUAL_UINT32(trap.min_interval, scurve.min_interval);
+    TEST_ASSERT_EQUAL_UINT32(0, scurve.accel_rises);
+    TEST_ASSERT_EQUAL_UINT32(0, scurve.decel_drops);
+}
+
+// Длинная медленная рампа: перенос остатка деления не даёт разгону застрять ниже цели
+static void test_long_ramp_reaches_target_speed(void) {
+    ProfileSummary s = run_planner(200000, 20000, 2500, 2500, 0);
+    TEST_ASSERT_EQUAL_UINT32(STEP_RMT_TICK_HZ / 20000, s.min_interval);
+    TEST_ASSERT_TRUE(fabsf(error_pct(s, 200000, 20000, 2500, 2500)) < 2.0f);
+}
+
+// Через StepStream: на пине ровно total импульсов и то же суммарное время
+static void test_planner_through_stream(void) {
+    StepPlanner p = {};
+    step_planner_init(p, 3000, 40000, 80000, 60000, 30);
+    StepStream stream;
+    step_stream_begin(stream, step_planner_source, &p);
+
+    StepOutputModel m;
+    step_model_reset(m);
+    uint32_t block[128];
+    for (uint16_t n = step_stream_fill(stream, block, 128); n > 0; n = step_stream_fill(stream, block, 128)) {
+        step_model_feed(m, block, n);
+    }
+    TEST_ASSERT_EQUAL_UINT32(3000, m.pulses);
+    TEST_ASSERT_EQUAL_UINT32(0, m.zero_durations);
+    TEST_ASSERT_TRUE(m.total_ticks == stream.ticks_encoded);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_emits_exactly_total_steps);
+    RUN_TEST(test_trapezoid_reaches_cruise_and_matches_ideal_time);
+    RUN_TEST(test_triangle_stays_below_max_speed);
+    RUN_TEST(test_equal_ramps_are_symmetric);
+    RUN_TEST(test_s_curve_starts_softer);
+    RUN_TEST(test_long_ramp_reaches_target_speed);
+    RUN_TEST(test_planner_through_stream);
+    return UNITY_END();
+}
@@ -0,0 +1,131 @@
+// Поток элементов RMT (step_stream.h): блоки ровно по запрошенному размеру, как их
+// забирает прерывание порога RMT, и модель выхода пина по склеенным блокам
+#include <unity.h>
+#include <vector>
+#include "step_stream.h"
+
+#define FIRST_BLOCK 256     // Первое заполнение - вся память канала (4 x 64)
+#define REFILL_BLOCK 128    // Подкачки - по половине
+
+// Источник: count интервалов, берутся по кругу из pattern
+struct PatternSource {
+    const uint32_t *pattern;
+    uint32_t pattern_len;
+    uint32_t count;
+    uint32_t next;
+};
+
+static uint32_t pattern_source(void *ctx) {
+    PatternSource &s = *(PatternSource *)ctx;
+    if (s.next >= s.count) return 0;
+    return s.pattern[s.next++ % s.pattern_len];
+}
+
+// Прогнать поток так, как это делает драйвер RMT: первый блок FIRST_BLOCK, дальше по REFILL_BLOCK
+// до первого неполного. short_blocks - неполных блоков до конца (должно быть 0)
+static std::vector<uint32_t> stream_like_rmt(PatternSource src, StepStream &stream, uint32_t &short_blocks) {
+    std::vector<uint32_t> out;
+    uint32_t block[FIRST_BLOCK];
+    step_stream_begin(stream, pattern_source, &src);
+    short_blocks = 0;
+
+    uint16_t wanted = FIRST_BLOCK;
+    for (;;) {
+        uint16_t n = step_stream_fill(stream, block, wanted);
+        out.insert(out.end(), block, block + n);
+        if (n < wanted) break;
+        wanted = REFILL_BLOCK;
+    }
+    // Неполный блок - конец передачи: после него поток обязан быть пуст
+    if (step_stream_fill(stream, block, REFILL_BLOCK) != 0) short_blocks++;
+    return out;
+}
+
+static StepOutputModel model_of(const std::vector<uint32_t> &items) {
+    StepOutputModel m;
+    step_model_reset(m);
+    step_model_feed(m, items.data(), (uint16_t)items.size());
+    return m;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_short_intervals_fill_whole_blocks(void) {
+    static const uint32_t fast[] = {100};
+    StepStream stream;
+    uint32_t short_blocks;
+    std::vector<uint32_t> items = stream_like_rmt({fast, 1, 1000, 0}, stream, short_blocks);
+
+    StepOutputModel m = model_of(items);
+    TEST_ASSERT_EQUAL_UINT32(0, short_blocks);
+    TEST_ASSERT_EQUAL_UINT32(1000, items.size());
+    TEST_ASSERT_EQUAL_UINT32(1000, m.pulses);
+    TEST_ASSERT_EQUAL_UINT32(0, m.zero_durations);
+    TEST_ASSERT_EQUAL_UINT32(1000, stream.steps_encoded);
+}
+
+// 100 мс на шаг - 16 элементов: шаги режутся границами блоков и продолжаются в следующем
+static void test_long_intervals_split_across_blocks(void) {
+    static const uint32_t slow[] = {STEP_MAX_INTERVAL_TICKS};
+    StepStream stream;
+    uint32_t short_blocks;
+    std::vector<uint32_t> items = stream_like_rmt({slow, 1, 50, 0}, stream, short_blocks);
+
+    uint32_t one_step[STEP_MAX_ITEMS_PER_STEP];
+    uint8_t per_step = step_encode_interval(STEP_MAX_INTERVAL_TICKS, one_step);
+
+    StepOutputModel m = model_of(items);
+    TEST_ASSERT_EQUAL_UINT8(16, per_step);
+    TEST_ASSERT_EQUAL_UINT32(0, short_blocks);
+    TEST_ASSERT_EQUAL_UINT32(50 * per_step, items.size());
+    TEST_ASSERT_EQUAL_UINT32(50, m.pulses);
+    TEST_ASSERT_EQUAL_UINT32(0, m.zero_durations);
+    TEST_ASSERT_EQUAL_UINT32(STEP_PULSE_HIGH_TICKS, m.min_high_ticks);
+    TEST_ASSERT_TRUE(m.total_ticks == 50ULL * STEP_MAX_INTERVAL_TICKS);
+}
+
+// Движение кончилось ровно на границе блока: следующее заполнение пустое (маркер конца)
+static void test_end_on_block_boundary(void) {
+    static const uint32_t fast[] = {100};
+    PatternSource src = {fast, 1, FIRST_BLOCK + REFILL_BLOCK, 0};
+    StepStream stream;
+    uint32_t block[FIRST_BLOCK];
+    step_stream_begin(stream, pattern_source, &src);
+
+    TEST_ASSERT_EQUAL_UINT16(FIRST_BLOCK, step_stream_fill(stream, block, FIRST_BLOCK));
+    TEST_ASSERT_EQUAL_UINT16(REFILL_BLOCK, step_stream_fill(stream, block, REFILL_BLOCK));
+    TEST_ASSERT_EQUAL_UINT16(0, step_stream_fill(stream, block, REFILL_BLOCK));
+    TEST_ASSERT_TRUE(stream.done);
+}
+
+// Нарезка на блоки не меняет выход: те же элементы, что и одним большим блоком
+static void test_slicing_does_not_change_output(void) {
+    static const uint32_t mixed[] = {10, 40, 65535, 65536, 65537, 131070, 500000, 999999, 2000000, 777};
+    StepStream sliced_stream;
+    uint32_t short_blocks;
+    std::vector<uint32_t> sliced = stream_like_rmt({mixed, 10, 300, 0}, sliced_stream, short_blocks);
+
+    PatternSource src = {mixed, 10, 300, 0};
+    StepStream whole_stream;
+    std::vector<uint32_t> whole(300 * STEP_MAX_ITEMS_PER_STEP);
+    step_stream_begin(whole_stream, pattern_source, &src);
+    whole.resize(step_stream_fill(whole_stream, whole.data(), (uint16_t)whole.size()));
+
+    StepOutputModel m = model_of(sliced);
+    TEST_ASSERT_EQUAL_UINT32(0, short_blocks);
+    TEST_ASSERT_TRUE(sliced == whole);
+    TEST_ASSERT_EQUAL_UINT32(300, m.pulses);
+    TEST_ASSERT_EQUAL_UINT32(0, m.zero_durations);
+    TEST_ASSERT_TRUE(m.min_low_ticks >= STEP_MIN_INTERVAL_TICKS - STEP_PULSE_HIGH_TICKS);
+    TEST_ASSERT_TRUE(m.total_ticks == sliced_stream.ticks_encoded);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_short_intervals_fill_whole_blocks);
+    RUN_TEST(test_long_intervals_split_across_blocks);
+    RUN_TEST(test_end_on_block_boundary);
+    RUN_TEST(test_slicing_does_not_change_output);
+    return UNITY_END();
+}
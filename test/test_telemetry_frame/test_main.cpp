@@ -0,0 +1,115 @@
+// Двоичный кадр телеметрии (telemetry_frame.h): смещения раскладки, кодирование/разбор,
+// отказ на чужих кадрах, сравнение состояния и base64 для SSE
+#include <unity.h>
+#include <string.h>
+#include "telemetry_frame.h"
+
+static TelemetryFrame sample_frame(void) {
+    TelemetryFrame f = {};
+    f.seq = 0xBEEF;
+    f.timestamp_ms = 0x01020304;
+    f.snapshot_ms = 0x01020300;
+    f.xactual = -2;
+    f.wraps = 1;
+    f.xtarget = INT32_MIN;
+    f.vactual = -8388608;
+    f.drv_status = 0x80000000u | 20;
+    f.spi_status = 0x0B;
+    f.flags = TFRAME_INITIALIZED | TFRAME_ENABLED | TFRAME_MOVING;
+    f.hall = 0x02;
+    f.solenoid = 1 | TSOL_ENABLED;
+    return f;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Смещения - те же, что читает decodeTelemetryFrame в index.html
+static void test_layout_offsets(void) {
+    uint8_t buf[TELEMETRY_FRAME_SIZE + 4];
+    memset(buf, 0xAA, sizeof(buf));
+    TEST_ASSERT_EQUAL_UINT32(TELEMETRY_FRAME_SIZE, telemetry_frame_encode(sample_frame(), buf));
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_FRAME_MAGIC, buf[0]);
+    TEST_ASSERT_EQUAL_UINT8(TELEMETRY_FRAME_VERSION, buf[1]);
+    TEST_ASSERT_EQUAL_UINT8(0xEF, buf[2]);          // little-endian
+    TEST_ASSERT_EQUAL_UINT8(0xBE, buf[3]);
+    TEST_ASSERT_EQUAL_UINT8(0x04, buf[4]);
+    TEST_ASSERT_EQUAL_UINT8(0xFE, buf[12]);          // xactual = -2
+    TEST_ASSERT_EQUAL_UINT8(0xFF, buf[15]);
+    TEST_ASSERT_EQUAL_UINT8(0x80, buf[23]);          // xtarget = INT32_MIN
+    TEST_ASSERT_EQUAL_UINT8(0x80, buf[31]);          // drv_status бит 31 (STST)
+    TEST_ASSERT_EQUAL_UINT8(0x0B, buf[32]);
+    TEST_ASSERT_EQUAL_UINT8(0x07, buf[33]);
+    TEST_ASSERT_EQUAL_UINT8(0x02, buf[34]);
+    TEST_ASSERT_EQUAL_UINT8(0x11, buf[35]);
+    for (int i = 36; i < TELEMETRY_FRAME_SIZE; i++) TEST_ASSERT_EQUAL_UINT8(0, buf[i]);
+    TEST_ASSERT_EQUAL_UINT8(0xAA, buf[TELEMETRY_FRAME_SIZE]);  // За кадр не пишет
+}
+
+static void test_round_trip(void) {
+    TelemetryFrame in = sample_frame(), out;
+    uint8_t buf[TELEMETRY_FRAME_SIZE];
+    telemetry_frame_encode(in, buf);
+    memset(&out, 0, sizeof(out));
+    TEST_ASSERT_TRUE(telemetry_frame_decode(buf, sizeof(buf), out));
+    TEST_ASSERT_EQUAL_UINT16(in.seq, out.seq);
+    TEST_ASSERT_EQUAL_UINT32(in.timestamp_ms, out.timestamp_ms);
+    TEST_ASSERT_EQUAL_UINT32(in.snapshot_ms, out.snapshot_ms);
+    TEST_ASSERT_EQUAL_INT32(in.vactual, out.vactual);
+    TEST_ASSERT_TRUE(telemetry_frame_same_state(in, out));
+}
+
+static void test_decode_rejects_foreign_frames(void) {
+    uint8_t buf[TELEMETRY_FRAME_SIZE];
+    TelemetryFrame f;
+    telemetry_frame_encode(sample_frame(), buf);
+    TEST_ASSERT_FALSE(telemetry_frame_decode(buf, TELEMETRY_FRAME_SIZE - 1, f));
+    buf[1] = TELEMETRY_FRAME_VERSION + 1;
+    TEST_ASSERT_FALSE(telemetry_frame_decode(buf, sizeof(buf), f));
+    buf[1] = TELEMETRY_FRAME_VERSION;
+    buf[0] = '{';
+    TEST_ASSERT_FALSE(telemetry_frame_decode(buf, sizeof(buf), f));
+}
+
+// seq и время не считаются изменением состояния, любое поле состояния - считается
+static void test_same_state_ignores_seq_and_time(void) {
+    TelemetryFrame a = sample_frame(), b = a;
+    b.seq++;
+    b.timestamp_ms += 20;
+    b.snapshot_ms += 20;
+    TEST_ASSERT_TRUE(telemetry_frame_same_state(a, b));
+    b.hall ^= 1;
+    TEST_ASSERT_FALSE(telemetry_frame_same_state(a, b));
+    b = a;
+    b.wraps++;
+    TEST_ASSERT_FALSE(telemetry_frame_same_state(a, b));
+}
+
+static void test_base64(void) {
+    char text[TELEMETRY_FRAME_BASE64_SIZE];
+    const uint8_t man[] = {'M', 'a', 'n'};
+    TEST_ASSERT_EQUAL_UINT32(4, telemetry_base64_encode(man, 3, text));
+    TEST_ASSERT_EQUAL_STRING("TWFu", text);
+    TEST_ASSERT_EQUAL_UINT32(4, telemetry_base64_encode(man, 2, text));
+    TEST_ASSERT_EQUAL_STRING("TWE=", text);
+    TEST_ASSERT_EQUAL_UINT32(4, telemetry_base64_encode(man, 1, text));
+    TEST_ASSERT_EQUAL_STRING("TQ==", text);
+
+    // Кадр целиком - 56 символов и завершающий ноль в буфер TELEMETRY_FRAME_BASE64_SIZE
+    uint8_t buf[TELEMETRY_FRAME_SIZE];
+    telemetry_frame_encode(sample_frame(), buf);
+    TEST_ASSERT_EQUAL_UINT32(TELEMETRY_FRAME_BASE64_SIZE - 1, telemetry_base64_encode(buf, sizeof(buf), text));
+    TEST_ASSERT_EQUAL_UINT32(56, strlen(text));
+    TEST_ASSERT_EQUAL_UINT8('V', text[0]);            // 'T' = 0x54 → "VA..."
+    TEST_ASSERT_EQUAL_UINT8('A', text[1]);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_layout_offsets);
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_decode_rejects_foreign_frames);
+    RUN_TEST(test_same_state_ignores_seq_and_time);
+    RUN_TEST(test_base64);
+    return UNITY_END();
+}
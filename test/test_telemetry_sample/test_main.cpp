@@ -0,0 +1,230 @@
+// Дельта-телеметрия (telemetry_sample.h): поток изменившихся полей, наложенный у клиента
+// на прежнее состояние, восстанавливает исходные выборки - в том числе при переходе
+// позиции через ±2^31, с мёртвой зоной SG_RESULT и после ключевого кадра (ресинхронизация)
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+#include "telemetry_sample.h"
+
+static uint32_t lcg_state;
+
+static uint32_t lcg_next(void) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return lcg_state >> 8;
+}
+
+// Сообщение в канале: неотправленных полей у клиента нет - на их месте мусор
+static TelemetrySample wire_message(const TelemetrySample &cur, uint16_t mask) {
+    TelemetrySample msg;
+    memset(&msg, 0xA5, sizeof(msg));
+    telemetry_apply(msg, cur, mask);
+    return msg;
+}
+
+static int64_t full_position(const TelemetrySample &s) {
+    return (int64_t)s.wraps * 4294967296LL + s.position_usteps;
+}
+
+// XACTUAL - знаковый 32-битный, wraps считает переходы через ±2^31
+static void set_position(TelemetrySample &s, int64_t pos) {
+    s.wraps = (int32_t)((pos + 2147483648LL) >> 32);
+    s.position_usteps = (int32_t)(pos - (int64_t)s.wraps * 4294967296LL);
+}
+
+static bool same_sample(const TelemetrySample &a, const TelemetrySample &b) {
+    return a.timestamp_ms == b.timestamp_ms && a.position_usteps == b.position_usteps &&
+           a.wraps == b.wraps && a.target_usteps == b.target_usteps && a.vactual == b.vactual &&
+           a.sg_result == b.sg_result && a.cs_actual == b.cs_actual &&
+           a.initialized == b.initialized && a.enabled == b.enabled &&
+           a.moving == b.moving && a.stallguard == b.stallguard;
+}
+
+static TelemetrySample start_sample(void) {
+    TelemetrySample s = {};
+    s.timestamp_ms = 1000;
+    s.initialized = true;
+    s.enabled = true;
+    s.cs_actual = 16;
+    s.sg_result = 300;
+    return s;
+}
+
+// Следующая выборка: позиция идёт со скоростью (с переносом в wraps), остальное меняется изредка
+static TelemetrySample next_sample(const TelemetrySample &prev) {
+    TelemetrySample s = prev;
+    s.timestamp_ms += 20;
+    if (lcg_next() % 16 == 0) s.vactual = (int32_t)(lcg_next() % 400001) - 200000;
+    if (lcg_next() % 32 == 0) s.target_usteps = (int32_t)(lcg_next() << 8);
+    set_position(s, full_position(prev) + (int64_t)s.vactual * 1000);
+    s.moving = s.vactual != 0;
+    if (lcg_next() % 8 == 0) s.cs_actual = lcg_next() % 32;
+    s.sg_result = (uint16_t)((s.sg_result + lcg_next() % 41 + 1004) % 1024);
+    if (lcg_next() % 64 == 0) s.stallguard = !s.stallguard;
+    if (lcg_next() % 512 == 0) s.enabled = !s.enabled;
+    return s;
+}
+
+void setUp(void) {
+    lcg_state = 12345;
+}
+void tearDown(void) {}
+
+static void test_unchanged_sample_sends_nothing(void) {
+    TelemetrySample s = start_sample();
+    TEST_ASSERT_EQUAL_UINT16(0, telemetry_changed(s, s, 0));
+    TelemetrySample later = s;
+    later.timestamp_ms += 20;
+    TEST_ASSERT_EQUAL_UINT16(0, telemetry_changed(s, later, 0));
+}
+
+// Без мёртвой зоны клиент после каждого сообщения совпадает с выборкой побайтно по полям
+static void test_delta_stream_rebuilds_every_sample(void) {
+    TelemetrySample cur = start_sample();
+    TelemetrySample sent = cur, client = cur;
+    int messages = 0;
+    for (int i = 0; i < 100000; i++) {
+        cur = next_sample(cur);
+        uint16_t mask = telemetry_changed(sent, cur, 0);
+        if (!mask) {
+            // Сообщение не ушло - значит у клиента уже всё так, кроме времени
+            TelemetrySample expect = client;
+            expect.timestamp_ms = cur.timestamp_ms;
+            TEST_ASSERT_TRUE(same_sample(expect, cur));
+            continue;
+        }
+        telemetry_apply(client, wire_message(cur, mask), mask);
+        telemetry_apply(sent, cur, mask);
+        messages++;
+        TEST_ASSERT_TRUE(same_sample(client, cur));
+        TEST_ASSERT_TRUE(same_sample(sent, cur));
+    }
+    TEST_ASSERT_GREATER_THAN(1000, messages);
+}
+
+// Переход XACTUAL через ±2^31: позиция и wraps уходят вместе, 64-битная позиция сходится
+static void test_position_wraparound(void) {
+    TelemetrySample cur = start_sample();
+    cur.position_usteps = INT32_MAX - 100;
+    TelemetrySample sent = cur, client = cur;
+
+    const int32_t step = 70;
+    int64_t expected = full_position(cur);
+    for (int i = 0; i < 5; i++) {
+        expected += step;
+        cur.timestamp_ms += 20;
+        set_position(cur, expected);
+        uint16_t mask = telemetry_changed(sent, cur, 0);
+        TEST_ASSERT_EQUAL_UINT16(TELEM_POSITION, mask);
+        telemetry_apply(client, wire_message(cur, mask), mask);
+        telemetry_apply(sent, cur, mask);
+        TEST_ASSERT_EQUAL_INT64(expected, full_position(client));
+    }
+    TEST_ASSERT_EQUAL_INT32(1, client.wraps);         // Уже за 2^31
+    TEST_ASSERT_TRUE(client.position_usteps < 0);
+
+    // Ровно один оборот 2^32 между выборками: XACTUAL тот же, отличается только wraps
+    cur.timestamp_ms += 20;
+    cur.wraps += 1;
+    uint16_t mask = telemetry_changed(sent, cur, 0);
+    TEST_ASSERT_EQUAL_UINT16(TELEM_POSITION, mask);
+    telemetry_apply(client, wire_message(cur, mask), mask);
+    TEST_ASSERT_EQUAL_INT64(expected + 4294967296LL, full_position(client));
+
+    // И в обратную сторону через INT32_MIN
+    telemetry_apply(sent, cur, mask);
+    expected = full_position(cur);
+    for (int i = 0; i < 5; i++) {
+        expected -= 3 * step;
+        cur.timestamp_ms += 20;
+        set_position(cur, expected);
+        mask = telemetry_changed(sent, cur, 0);
+        telemetry_apply(client, wire_message(cur, mask), mask);
+        telemetry_apply(sent, cur, mask);
+        TEST_ASSERT_EQUAL_INT64(expected, full_position(client));
+    }
+    TEST_ASSERT_TRUE(same_sample(client, cur));
+}
+
+// С мёртвой зоной SG_RESULT у клиента не дальше зоны от истины (отсчёт от ОТПРАВЛЕННОГО,
+// поэтому дрейф не копится), остальные поля - точно
+static void test_sg_deadband_bounded(void) {
+    const uint16_t deadband = 8;
+    TelemetrySample cur = start_sample();
+    TelemetrySample sent = cur, client = cur;
+    int sg_sent = 0;
+    for (int i = 0; i < 100000; i++) {
+        cur = next_sample(cur);
+        uint16_t mask = telemetry_changed(sent, cur, deadband);
+        if (mask & TELEM_SG_RESULT) sg_sent++;
+        telemetry_apply(client, wire_message(cur, mask), mask);
+        telemetry_apply(sent, cur, mask);
+        TEST_ASSERT_INT_WITHIN(deadband, cur.sg_result, client.sg_result);
+        TelemetrySample expect = cur;
+        expect.sg_result = client.sg_result;
+        TEST_ASSERT_TRUE(same_sample(client, expect));
+    }
+    TEST_ASSERT_GREATER_THAN(0, sg_sent);
+    TEST_ASSERT_LESS_THAN(100000, sg_sent);
+
+    // Изменение ровно на зону не отправляется, на зону + 1 - отправляется
+    TelemetrySample a = start_sample(), b = a;
+    b.sg_result = a.sg_result + deadband;
+    TEST_ASSERT_EQUAL_UINT16(0, telemetry_changed(a, b, deadband));
+    b.sg_result = a.sg_result - deadband - 1;
+    TEST_ASSERT_EQUAL_UINT16(TELEM_SG_RESULT, telemetry_changed(a, b, deadband));
+}
+
+// Клиент терял сообщения (или подключился только что) - ключевой кадр TELEM_ALL
+// восстанавливает всё состояние точно
+static void test_keyframe_resyncs_client(void) {
+    TelemetrySample cur = start_sample();
+    TelemetrySample sent = cur, client = cur;
+    for (int i = 0; i < 5000; i++) {
+        cur = next_sample(cur);
+        uint16_t mask = telemetry_changed(sent, cur, 0);
+        if (mask && i % 7 != 3) telemetry_apply(client, wire_message(cur, mask), mask);
+        telemetry_apply(sent, cur, mask);
+    }
+
+    // Потеряно сообщение с новой целью: следующие дельты её уже не несут
+    cur.timestamp_ms += 20;
+    cur.target_usteps += 256;
+    telemetry_apply(sent, cur, telemetry_changed(sent, cur, 0));
+    cur.timestamp_ms += 20;
+    set_position(cur, full_position(cur) + 1000);
+    uint16_t mask = telemetry_changed(sent, cur, 0);
+    TEST_ASSERT_EQUAL_UINT16(TELEM_POSITION, mask);
+    telemetry_apply(client, wire_message(cur, mask), mask);
+    telemetry_apply(sent, cur, mask);
+    TEST_ASSERT_TRUE(client.target_usteps != cur.target_usteps);
+
+    cur = next_sample(cur);
+    telemetry_apply(client, wire_message(cur, TELEM_ALL), TELEM_ALL);
+    telemetry_apply(sent, cur, TELEM_ALL);
+    TEST_ASSERT_TRUE(same_sample(client, cur));
+
+    // Новый клиент без какого-либо состояния
+    TelemetrySample fresh;
+    memset(&fresh, 0x5A, sizeof(fresh));
+    telemetry_apply(fresh, wire_message(cur, TELEM_ALL), TELEM_ALL);
+    TEST_ASSERT_TRUE(same_sample(fresh, cur));
+
+    // После ресинхронизации дельты снова точны
+    for (int i = 0; i < 1000; i++) {
+        cur = next_sample(cur);
+        mask = telemetry_changed(sent, cur, 0);
+        telemetry_apply(client, wire_message(cur, mask), mask);
+        telemetry_apply(sent, cur, mask);
+        TEST_ASSERT_TRUE(same_sample(client, cur));
+    }
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_unchanged_sample_sends_nothing);
+    RUN_TEST(test_delta_stream_rebuilds_every_sample);
+    RUN_TEST(test_position_wraparound);
+    RUN_TEST(test_sg_deadband_bounded);
+    RUN_TEST(test_keyframe_resyncs_client);
+    return UNITY_END();
+}
@@ -0,0 +1,210 @@
+// Политика теплового снижения тока (thermal_derating.h): шаги по otpw/ot, гистерезис
+// по времени и прогон на модели нагрева драйвера
+#include <unity.h>
+#include "thermal_derating.h"
+
+// ===== МОДЕЛЬ НАГРЕВА ДРАЙВЕРА =====
+// Температура драйвера первого порядка: T → ambient + rise_full·(I/I_full)², постоянная tau.
+// otpw выставляется на otpw_c и снимается ниже otpw_c - otpw_hyst_c, ot - на ot_c
+
+struct DerateSimParams {
+    float ambient_c;
+    float rise_full_c;          // Установившийся нагрев при 100% тока
+    float tau_s;
+    float otpw_c;
+    float otpw_hyst_c;
+    float ot_c;
+    uint32_t duration_s;
+};
+
+struct DerateSimResult {
+    bool ot_reached;
+    float max_temp_c;
+    float final_temp_c;
+    uint8_t final_percent;
+    uint8_t min_percent;
+    uint32_t steps_down;
+    uint32_t steps_up;
+    uint32_t otpw_ms;
+    uint32_t reduced_ms;
+    float avg_percent;          // Средний ток - мера сохранённой производительности
+};
+
+static DerateSimResult derate_simulate(const DeratePolicy &policy, const DerateSimParams &p) {
+    DerateSimResult r = {};
+    DerateState s;
+    derate_reset(s, 0);
+    float temp = p.ambient_c;
+    bool otpw = false;
+    double percent_sum = 0;
+    uint32_t steps = 0;
+    const float dt_s = DERATE_SAMPLE_PERIOD_MS / 1000.0f;
+
+    for (uint32_t t = DERATE_SAMPLE_PERIOD_MS; t <= p.duration_s * 1000; t += DERATE_SAMPLE_PERIOD_MS) {
+        float ratio = s.percent / 100.0f;
+        float target = p.ambient_c + p.rise_full_c * ratio * ratio;
+        temp += (target - temp) * dt_s / p.tau_s;
+        if (temp > r.max_temp_c) r.max_temp_c = temp;
+
+        if (temp >= p.otpw_c) otpw = true;
+        else if (temp < p.otpw_c - p.otpw_hyst_c) otpw = false;
+        bool ot = temp >= p.ot_c;
+        if (ot) r.ot_reached = true;
+
+        derate_update(s, policy, otpw, ot, t);
+        percent_sum += s.percent;
+        steps++;
+    }
+
+    r.final_temp_c = temp;
+    r.final_percent = s.percent;
+    r.min_percent = s.min_reached;
+    r.steps_down = s.steps_down;
+    r.steps_up = s.steps_up;
+    r.otpw_ms = s.otpw_ms;
+    r.reduced_ms = s.reduced_ms;
+    r.avg_percent = steps ? (float)(percent_sum / steps) : 100.0f;
+    return r;
+}
+
+// Нагрев 130 °C при полном токе: без снижения драйвер доходит до ot (150 °C)
+static DerateSimParams hot_driver() {
+    DerateSimParams p;
+    p.ambient_c = 25.0f;
+    p.rise_full_c = 130.0f;
+    p.tau_s = 60.0f;
+    p.otpw_c = 120.0f;
+    p.otpw_hyst_c = 10.0f;
+    p.ot_c = 150.0f;
+    p.duration_s = 1800;
+    return p;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_policy_validate(void) {
+    DeratePolicy p = derate_default_policy();
+    TEST_ASSERT_NULL(derate_policy_validate(p));
+    p.step_percent = 0;
+    TEST_ASSERT_NOT_NULL(derate_policy_validate(p));
+    p = derate_default_policy();
+    p.min_percent = 5;
+    TEST_ASSERT_NOT_NULL(derate_policy_validate(p));
+    p = derate_default_policy();
+    p.cool_ms = p.persist_ms - 1;
+    TEST_ASSERT_NOT_NULL(derate_policy_validate(p));
+}
+
+// otpw короче persist_ms - без снижения; дольше - шаг, следующий не раньше step_interval_ms
+static void test_step_down_after_persist_and_interval(void) {
+    DeratePolicy p = derate_default_policy();
+    DerateState s;
+    derate_reset(s, 0);
+    uint32_t t = DERATE_STEP_INTERVAL_MS;   // Последнее изменение - давно
+
+    TEST_ASSERT_EQUAL_UINT8(DERATE_NONE, derate_update(s, p, true, false, t));
+    TEST_ASSERT_EQUAL_UINT8(DERATE_NONE, derate_update(s, p, true, false, t + DERATE_PERSIST_MS - 100));
+    TEST_ASSERT_EQUAL_UINT8(DERATE_STEP_DOWN, derate_update(s, p, true, false, t + DERATE_PERSIST_MS));
+    TEST_ASSERT_EQUAL_UINT8(100 - DERATE_STEP_PERCENT, s.percent);
+
+    uint32_t changed = t + DERATE_PERSIST_MS;
+    TEST_ASSERT_EQUAL_UINT8(DERATE_NONE, derate_update(s, p, true, false, changed + DERATE_STEP_INTERVAL_MS - 100));
+    TEST_ASSERT_EQUAL_UINT8(DERATE_STEP_DOWN, derate_update(s, p, true, false, changed + DERATE_STEP_INTERVAL_MS));
+    TEST_ASSERT_EQUAL_UINT8(100 - 2 * DERATE_STEP_PERCENT, s.percent);
+    TEST_ASSERT_EQUAL_UINT32(2, s.steps_down);
+}
+
+// Дребезг otpw короче persist_ms каждый раз начинает отсчёт заново
+static void test_flickering_otpw_does_not_step(void) {
+    DeratePolicy p = derate_default_policy();
+    DerateState s;
+    derate_reset(s, 0);
+    for (uint32_t t = DERATE_STEP_INTERVAL_MS; t < DERATE_STEP_INTERVAL_MS + 10000; t += DERATE_SAMPLE_PERIOD_MS) {
+        bool otpw = (t / 400) % 2 == 0;     // 400 мс есть, 400 мс нет
+        TEST_ASSERT_EQUAL_UINT8(DERATE_NONE, derate_update(s, p, otpw, false, t));
+    }
+    TEST_ASSERT_EQUAL_UINT8(100, s.percent);
+}
+
+static void test_floor_and_overtemperature(void) {
+    DeratePolicy p = derate_default_policy();
+    DerateState s;
+    derate_reset(s, 0);
+    for (uint32_t t = 0; t <= 200000; t += DERATE_SAMPLE_PERIOD_MS) derate_update(s, p, true, false, t);
+    TEST_ASSERT_EQUAL_UINT8(DERATE_MIN_PERCENT, s.percent);
+    TEST_ASSERT_EQUAL_UINT8(DERATE_MIN_PERCENT, s.min_reached);
+
+    // ot - сразу минимум, без ожидания persist/interval
+    derate_reset(s, 0);
+    TEST_ASSERT_EQUAL_UINT8(DERATE_STEP_DOWN, derate_update(s, p, true, true, 100));
+    TEST_ASSERT_EQUAL_UINT8(DERATE_MIN_PERCENT, s.percent);
+    TEST_ASSERT_EQUAL_UINT32(1, s.ot_events);
+    TEST_ASSERT_EQUAL_UINT8(DERATE_NONE, derate_update(s, p, true, true, 200));
+}
+
+// Возврат - по шагу, каждый шаг ждёт cool_ms без otpw
+static void test_recovery_waits_cool_time_per_step(void) {
+    DeratePolicy p = derate_default_policy();
+    DerateState s;
+    derate_reset(s, 0);
+    derate_update(s, p, true, true, 100);                  // Сразу 50%
+    derate_update(s, p, false, false, 200);                 // otpw снят
+    TEST_ASSERT_EQUAL_UINT8(DERATE_NONE, derate_update(s, p, false, false, 200 + DERATE_COOL_MS - 100));
+    TEST_ASSERT_EQUAL_UINT8(DERATE_STEP_UP, derate_update(s, p, false, false, 200 + DERATE_COOL_MS));
+    TEST_ASSERT_EQUAL_UINT8(DERATE_MIN_PERCENT + DERATE_STEP_PERCENT, s.percent);
+    TEST_ASSERT_EQUAL_UINT8(DERATE_NONE, derate_update(s, p, false, false, 200 + 2 * DERATE_COOL_MS - 100));
+    TEST_ASSERT_EQUAL_UINT8(DERATE_STEP_UP, derate_update(s, p, false, false, 200 + 2 * DERATE_COOL_MS));
+
+    // До 100% и не выше
+    for (uint32_t t = 200 + 2 * DERATE_COOL_MS; t <= 200 + 10 * DERATE_COOL_MS; t += DERATE_SAMPLE_PERIOD_MS) {
+        derate_update(s, p, false, false, t);
+    }
+    TEST_ASSERT_EQUAL_UINT8(100, s.percent);
+    TEST_ASSERT_TRUE(s.reduced_ms > 0);
+}
+
+static void test_derate_current(void) {
+    TEST_ASSERT_EQUAL_UINT16(2000, derate_current(2000, 100));
+    TEST_ASSERT_EQUAL_UINT16(1000, derate_current(2000, 50));
+    TEST_ASSERT_EQUAL_UINT16(2998, derate_current(3332, 90));    // 2998.8 - округление вниз
+}
+
+// Политика по умолчанию удерживает модель ниже ot; без снижения (min 100%) ot достигается
+static void test_model_policy_prevents_overtemperature(void) {
+    DerateSimResult r = derate_simulate(derate_default_policy(), hot_driver());
+    TEST_ASSERT_FALSE(r.ot_reached);
+    TEST_ASSERT_TRUE(r.max_temp_c < 150.0f);
+    TEST_ASSERT_TRUE(r.steps_down > 0);
+    TEST_ASSERT_TRUE(r.min_percent < 100);
+    TEST_ASSERT_TRUE(r.avg_percent > DERATE_MIN_PERCENT);
+
+    DeratePolicy off = derate_default_policy();
+    off.min_percent = 100;
+    DerateSimResult hot = derate_simulate(off, hot_driver());
+    TEST_ASSERT_TRUE(hot.ot_reached);
+    TEST_ASSERT_EQUAL_UINT32(0, hot.steps_down);
+}
+
+// Холодный драйвер: otpw не бывает, ток не трогается
+static void test_model_cool_driver_untouched(void) {
+    DerateSimParams p = hot_driver();
+    p.rise_full_c = 60.0f;
+    DerateSimResult r = derate_simulate(derate_default_policy(), p);
+    TEST_ASSERT_EQUAL_UINT32(0, r.steps_down);
+    TEST_ASSERT_EQUAL_UINT8(100, r.final_percent);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 100.0f, r.avg_percent);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_policy_validate);
+    RUN_TEST(test_step_down_after_persist_and_interval);
+    RUN_TEST(test_flickering_otpw_does_not_step);
+    RUN_TEST(test_floor_and_overtemperature);
+    RUN_TEST(test_recovery_waits_cool_time_per_step);
+    RUN_TEST(test_derate_current);
+    RUN_TEST(test_model_policy_prevents_overtemperature);
+    RUN_TEST(test_model_cool_driver_untouched);
+    return UNITY_END();
+}
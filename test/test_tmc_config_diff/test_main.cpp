@@ -0,0 +1,115 @@
+// Дифференциальное применение конфигурации (tmc_config_diff.h) на мок-массиве регистров
+#include <unity.h>
+#include "tmc_config_diff.h"
+
+struct MockRegs {
+    uint32_t value[128];
+    bool known[128];
+    uint8_t pokes;
+    uint8_t poke_order[TMC_CONFIG_MAX_REGS];
+};
+
+static bool mock_peek(uint8_t address, uint32_t *value, void *ctx) {
+    MockRegs &m = *(MockRegs *)ctx;
+    if (!m.known[address]) return false;
+    *value = m.value[address];
+    return true;
+}
+
+static void mock_poke(uint8_t address, uint32_t value, void *ctx) {
+    MockRegs &m = *(MockRegs *)ctx;
+    m.value[address] = value;
+    m.known[address] = true;
+    m.poke_order[m.pokes++] = address;
+}
+
+static MockRegs regs;
+
+void setUp(void) {
+    regs = {};
+}
+void tearDown(void) {}
+
+static void test_equal_image_writes_nothing(void) {
+    regs.value[0x00] = 0x4;
+    regs.known[0x00] = true;
+    regs.value[0x6C] = 0x10410153;
+    regs.known[0x6C] = true;
+
+    TmcConfigImage img;
+    tmc_image_clear(img);
+    tmc_image_set(img, 0x00, 0x4);
+    tmc_image_set(img, 0x6C, 0x10410153);
+    TmcConfigDiff d = tmc_config_apply(img, mock_peek, mock_poke, &regs);
+    TEST_ASSERT_EQUAL_UINT8(2, d.compared);
+    TEST_ASSERT_EQUAL_UINT8(0, d.written);
+    TEST_ASSERT_EQUAL_UINT8(0, regs.pokes);
+}
+
+// Маска: меняются только свои биты, остальные берутся из текущего значения
+static void test_masked_field_keeps_other_bits(void) {
+    regs.value[0x6C] = 0x10410153;      // CHOPCONF, MRES = 0 (256 микрошагов)
+    regs.known[0x6C] = true;
+
+    TmcConfigImage img;
+    tmc_image_clear(img);
+    tmc_image_set(img, 0x6C, 4UL << 24, 0x0F000000UL);      // MRES = 4 (16 микрошагов)
+    TmcConfigDiff d = tmc_config_apply(img, mock_peek, mock_poke, &regs);
+    TEST_ASSERT_EQUAL_UINT8(1, d.written);
+    TEST_ASSERT_EQUAL_HEX32(0x14410153, regs.value[0x6C]);
+}
+
+// Повторный адрес - одна запись, поля объединены, порядок - по первому появлению
+static void test_repeated_address_merges(void) {
+    TmcConfigImage img;
+    tmc_image_clear(img);
+    tmc_image_set(img, 0x10, 0x1F, 0x1F);
+    tmc_image_set(img, 0x27, 1000);
+    tmc_image_set(img, 0x10, 0x0A00, 0x1F00);
+    TEST_ASSERT_EQUAL_UINT8(2, img.count);
+    TEST_ASSERT_EQUAL_HEX32(0x0A1F, img.regs[0].value);
+    TEST_ASSERT_EQUAL_HEX32(0x1F1F, img.regs[0].mask);
+
+    TmcConfigDiff d = tmc_config_apply(img, mock_peek, mock_poke, &regs);
+    TEST_ASSERT_EQUAL_UINT8(2, d.written);
+    TEST_ASSERT_EQUAL_UINT8(0x10, regs.poke_order[0]);
+    TEST_ASSERT_EQUAL_UINT8(0x27, regs.poke_order[1]);
+}
+
+// Значение неизвестно (WRITE_ONLY без тени) - регистр пишется всегда, даже если "совпал бы"
+static void test_unknown_register_is_written(void) {
+    TmcConfigImage img;
+    tmc_image_clear(img);
+    tmc_image_set(img, 0x23, 0);
+    tmc_image_set(img, 0x27, 5000);
+    TmcConfigDiff d = tmc_config_apply(img, mock_peek, mock_poke, &regs);
+    TEST_ASSERT_EQUAL_UINT8(2, d.written);
+    TEST_ASSERT_EQUAL_UINT8(2, d.unknown);
+    TEST_ASSERT_EQUAL_UINT8(0x23, d.written_addr[0]);
+    TEST_ASSERT_EQUAL_UINT8(0x27, d.written_addr[1]);
+
+    // Второе применение - всё уже известно и совпадает
+    d = tmc_config_apply(img, mock_peek, mock_poke, &regs);
+    TEST_ASSERT_EQUAL_UINT8(0, d.written);
+    TEST_ASSERT_EQUAL_UINT8(0, d.unknown);
+}
+
+static void test_image_capacity(void) {
+    TmcConfigImage img;
+    tmc_image_clear(img);
+    for (uint8_t i = 0; i < TMC_CONFIG_MAX_REGS; i++) TEST_ASSERT_TRUE(tmc_image_set(img, i, i));
+    TEST_ASSERT_FALSE(tmc_image_set(img, 0x70, 1));
+    // Существующий адрес при полном образе - по-прежнему можно
+    TEST_ASSERT_TRUE(tmc_image_set(img, 3, 0x30));
+    TEST_ASSERT_EQUAL_UINT8(TMC_CONFIG_MAX_REGS, img.count);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_equal_image_writes_nothing);
+    RUN_TEST(test_masked_field_keeps_other_bits);
+    RUN_TEST(test_repeated_address_merges);
+    RUN_TEST(test_unknown_register_is_written);
+    RUN_TEST(test_image_capacity);
+    return UNITY_END();
+}
@@ -0,0 +1,161 @@
+// Тень регистров TMC5160_ShadowSPI на модели чипа (test/mocks/mock_tmc_chip.h)
+#include <unity.h>
+#include "tmc_spi.h"
+#include "usteps.h"
+
+static const uint8_t CS_PIN = 5;
+
+static TMC5160_ShadowSPI *tmc;
+
+void setUp(void) {
+    mock_chip.reset();
+    mock_millis = 1000;
+    tmc = new TMC5160_ShadowSPI(CS_PIN, 12000000, SPISettings(SPI_CLOCK_SAFE_HZ, MSBFIRST, SPI_MODE3));
+}
+
+void tearDown(void) {
+    delete tmc;
+    tmc = nullptr;
+}
+
+static void test_policy_classification(void) {
+    TEST_ASSERT_EQUAL(REG_CONFIG, TMC5160_ShadowSPI::regPolicy(TMC5160_Reg::CHOPCONF));
+    TEST_ASSERT_EQUAL(REG_WRITE_ONLY, TMC5160_ShadowSPI::regPolicy(TMC5160_Reg::VMAX));
+    TEST_ASSERT_EQUAL(REG_WRITE_ONLY, TMC5160_ShadowSPI::regPolicy(TMC5160_Reg::MSLUT_0 + 7));
+    TEST_ASSERT_EQUAL(REG_VOLATILE, TMC5160_ShadowSPI::regPolicy(TMC5160_Reg::XACTUAL));
+    TEST_ASSERT_EQUAL(REG_STATUS, TMC5160_ShadowSPI::regPolicy(TMC5160_Reg::GSTAT));
+    TEST_ASSERT_EQUAL(REG_STATUS, TMC5160_ShadowSPI::regPolicy(TMC5160_Reg::DRV_STATUS));
+    TEST_ASSERT_EQUAL(REG_STATUS, TMC5160_ShadowSPI::regPolicy(TMC5160_Reg::VACTUAL));
+}
+
+// Запись 0x07 в GSTAT снимает флаги - в тени не должно остаться 0x07
+static void test_gstat_w1c_write_not_shadowed(void) {
+    mock_chip.regs[TMC5160_Reg::GSTAT] = 0x05;
+    TEST_ASSERT_EQUAL_HEX32(0x05, tmc->readRegister(TMC5160_Reg::GSTAT));
+
+    tmc->writeRegister(TMC5160_Reg::GSTAT, 0x07);
+    TEST_ASSERT_EQUAL_HEX32(0x00, mock_chip.regs[TMC5160_Reg::GSTAT]);
+    TEST_ASSERT_FALSE(tmc->isShadowValid(TMC5160_Reg::GSTAT));
+
+    uint32_t before = mock_chip.datagrams;
+    TEST_ASSERT_EQUAL_HEX32(0x00, tmc->readRegister(TMC5160_Reg::GSTAT));
+    TEST_ASSERT_EQUAL_UINT32(before + 2, mock_chip.datagrams);
+}
+
+// Запись в R-регистр чип игнорирует - тень тоже
+static void test_read_only_write_not_shadowed(void) {
+    mock_chip.regs[TMC5160_Reg::DRV_STATUS] = 0x80000000;
+    tmc->writeRegister(TMC5160_Reg::DRV_STATUS, 0x1234);
+    TEST_ASSERT_EQUAL_HEX32(0x80000000, tmc->readRegister(TMC5160_Reg::DRV_STATUS));
+}
+
+static void test_config_served_from_ram(void) {
+    tmc->writeRegister(TMC5160_Reg::CHOPCONF, 0x000100C3);
+    uint32_t before = mock_chip.datagrams;
+    TEST_ASSERT_EQUAL_HEX32(0x000100C3, tmc->readRegister(TMC5160_Reg::CHOPCONF));
+    TEST_ASSERT_EQUAL_UINT32(before, mock_chip.datagrams);
+    TEST_ASSERT_EQUAL_UINT32(1, tmc->getShadowHits(TMC5160_Reg::CHOPCONF));
+}
+
+// VMAX с чипа читается 0 - отдаём записанное
+static void test_write_only_served_from_ram(void) {
+    TEST_ASSERT_EQUAL_HEX32(0, tmc->readRegister(TMC5160_Reg::VMAX));
+    TEST_ASSERT_FALSE(tmc->isShadowValid(TMC5160_Reg::VMAX));
+
+    tmc->writeRegister(TMC5160_Reg::VMAX, 200000);
+    TEST_ASSERT_EQUAL_UINT32(200000, tmc->readRegister(TMC5160_Reg::VMAX));
+}
+
+static void test_volatile_expires_after_max_age(void) {
+    mock_chip.regs[TMC5160_Reg::XACTUAL] = 100;
+    TEST_ASSERT_EQUAL_UINT32(100, tmc->readRegister(TMC5160_Reg::XACTUAL));
+
+    mock_chip.regs[TMC5160_Reg::XACTUAL] = 200;
+    mock_millis += TMC_SHADOW_DEFAULT_MAX_AGE_MS - 1;
+    TEST_ASSERT_EQUAL_UINT32(100, tmc->readRegister(TMC5160_Reg::XACTUAL));
+
+    mock_millis += 1;
+    TEST_ASSERT_EQUAL_UINT32(200, tmc->readRegister(TMC5160_Reg::XACTUAL));
+}
+
+// N регистров за N+1 датаграмм, ответы сдвинуты на одну
+static void test_burst_pipelined(void) {
+    mock_chip.regs[TMC5160_Reg::XACTUAL] = 0x11111111;
+    mock_chip.regs[TMC5160_Reg::XTARGET] = 0x22222222;
+    mock_chip.regs[TMC5160_Reg::VACTUAL] = 0x00FFFFFF;
+
+    const uint8_t addresses[3] = {TMC5160_Reg::XACTUAL, TMC5160_Reg::XTARGET, TMC5160_Reg::VACTUAL};
+    uint32_t values[3] = {0, 0, 0};
+    tmc->readRegisterBurst(addresses, values, 3);
+
+    TEST_ASSERT_EQUAL_UINT32(4, mock_chip.datagrams);
+    TEST_ASSERT_EQUAL_HEX32(0x11111111, values[0]);
+    TEST_ASSERT_EQUAL_HEX32(0x22222222, values[1]);
+    TEST_ASSERT_EQUAL_HEX32(0x00FFFFFF, values[2]);
+}
+
+static void test_vactual_sign_extension(void) {
+    TEST_ASSERT_EQUAL_INT32(-1, usteps_vactual_from_register(0x00FFFFFF));
+    TEST_ASSERT_EQUAL_INT32(-8388608, usteps_vactual_from_register(0x00800000));
+    TEST_ASSERT_EQUAL_INT32(8388607, usteps_vactual_from_register(0x007FFFFF));
+    TEST_ASSERT_EQUAL_INT32(1000, usteps_vactual_from_register(1000));
+
+    mock_chip.regs[TMC5160_Reg::VACTUAL] = 0x00FFFC18;   // -1000
+    TEST_ASSERT_EQUAL_INT32(-1000, usteps_vactual_from_register(tmc->readRegister(TMC5160_Reg::VACTUAL)));
+}
+
+static void test_spi_status_from_every_datagram(void) {
+    uint8_t status = 0;
+    TEST_ASSERT_FALSE(tmc->getSpiStatus(100, &status));
+
+    mock_chip.status = SPI_STATUS_POSITION_REACHED | SPI_STATUS_STANDSTILL;
+    tmc->readRegister(TMC5160_Reg::XACTUAL);
+    TEST_ASSERT_TRUE(tmc->getSpiStatus(100, &status));
+    TEST_ASSERT_EQUAL_HEX8(SPI_STATUS_POSITION_REACHED | SPI_STATUS_STANDSTILL, status);
+}
+
+// Старый слот хранил millis() по модулю 2^24: после ~4.66 ч свежий статус выглядел старым
+static void test_spi_status_age_across_24bit_boundary(void) {
+    uint8_t status = 0;
+    mock_millis = (1UL << 24) - 5;
+    mock_chip.status = SPI_STATUS_STANDSTILL;
+    tmc->readRegisterDirect(TMC5160_Reg::XACTUAL);
+
+    mock_millis = (1UL << 24) + 10;
+    TEST_ASSERT_EQUAL_UINT32(15, tmc->getSpiStatusAgeMs());
+    TEST_ASSERT_TRUE(tmc->getSpiStatus(50, &status));
+    TEST_ASSERT_EQUAL_HEX8(SPI_STATUS_STANDSTILL, status);
+
+    // Статус, которому ровно 2^24 мс, - старый (24-битная разность давала 0)
+    mock_millis = (1UL << 24) - 5 + (1UL << 24);
+    TEST_ASSERT_EQUAL_UINT32(1UL << 24, tmc->getSpiStatusAgeMs());
+    TEST_ASSERT_FALSE(tmc->getSpiStatus(50, &status));
+}
+
+static void test_spi_status_age_across_millis_overflow(void) {
+    uint8_t status = 0;
+    mock_millis = 0xFFFFFFF0;
+    mock_chip.status = SPI_STATUS_RESET_FLAG;
+    tmc->readRegisterDirect(TMC5160_Reg::XACTUAL);
+
+    mock_millis = 0x00000010;
+    TEST_ASSERT_EQUAL_UINT32(0x20, tmc->getSpiStatusAgeMs());
+    TEST_ASSERT_TRUE(tmc->getSpiStatus(50, &status));
+    TEST_ASSERT_EQUAL_HEX8(SPI_STATUS_RESET_FLAG, tmc->getLastSpiStatus());
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_policy_classification);
+    RUN_TEST(test_gstat_w1c_write_not_shadowed);
+    RUN_TEST(test_read_only_write_not_shadowed);
+    RUN_TEST(test_config_served_from_ram);
+    RUN_TEST(test_write_only_served_from_ram);
+    RUN_TEST(test_volatile_expires_after_max_age);
+    RUN_TEST(test_burst_pipelined);
+    RUN_TEST(test_vactual_sign_extension);
+    RUN_TEST(test_spi_status_from_every_datagram);
+    RUN_TEST(test_spi_status_age_across_24bit_boundary);
+    RUN_TEST(test_spi_status_age_across_millis_overflow);
+    return UNITY_END();
+}
@@ -0,0 +1,96 @@
+// Позиция в микрошагах (usteps.h): арифметика по модулю 2^32, шаги ↔ микрошаги
+// в шкале MRES, VACTUAL со знаком и развёртка переходов через ±2^31
+#include <unity.h>
+#include "usteps.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void test_add_and_diff_wrap(void) {
+    TEST_ASSERT_EQUAL_INT32(INT32_MIN, usteps_add(INT32_MAX, 1));
+    TEST_ASSERT_EQUAL_INT32(INT32_MAX, usteps_add(INT32_MIN, -1));
+    // Через границу путь короткий и со знаком
+    TEST_ASSERT_EQUAL_INT32(10, usteps_diff(INT32_MIN + 4, INT32_MAX - 5));
+    TEST_ASSERT_EQUAL_INT32(-10, usteps_diff(INT32_MAX - 5, INT32_MIN + 4));
+    TEST_ASSERT_EQUAL_UINT32(10, usteps_distance(INT32_MIN + 4, INT32_MAX - 5));
+    TEST_ASSERT_EQUAL_UINT32(10, usteps_distance(INT32_MAX - 5, INT32_MIN + 4));
+    TEST_ASSERT_EQUAL_UINT32(0x80000000u, usteps_distance(INT32_MIN, 0));
+}
+
+static void test_move_valid(void) {
+    TEST_ASSERT_TRUE(usteps_move_valid(USTEPS_MAX_MOVE));
+    TEST_ASSERT_TRUE(usteps_move_valid(-USTEPS_MAX_MOVE));
+    TEST_ASSERT_FALSE(usteps_move_valid(INT32_MIN));
+    TEST_ASSERT_FALSE(usteps_move_valid(USTEPS_MAX_MOVE + 1));
+}
+
+// MRES 0..8 → 256..1; вне диапазона - полный шаг, как microsteps_to_mres по умолчанию
+static void test_usteps_per_step_from_mres(void) {
+    TEST_ASSERT_EQUAL_UINT32(256, usteps_per_step_from_mres(0));
+    TEST_ASSERT_EQUAL_UINT32(16, usteps_per_step_from_mres(4));
+    TEST_ASSERT_EQUAL_UINT32(1, usteps_per_step_from_mres(8));
+    TEST_ASSERT_EQUAL_UINT32(1, usteps_per_step_from_mres(15));
+}
+
+// Одни и те же шаги в разных шкалах; предел хода зависит от шкалы
+static void test_steps_round_trip_in_programmed_scale(void) {
+    static const uint32_t scales[] = {256, 16, 1};
+    for (uint32_t per_step : scales) {
+        int32_t usteps = 0;
+        TEST_ASSERT_TRUE(usteps_from_steps(-1000, per_step, &usteps));
+        TEST_ASSERT_EQUAL_INT32(-1000 * (int32_t)per_step, usteps);
+        TEST_ASSERT_EQUAL_INT32(-1000, usteps_to_steps(usteps, per_step));
+    }
+
+    int32_t usteps = 0;
+    TEST_ASSERT_FALSE(usteps_from_steps(10000000, 256, &usteps));
+    TEST_ASSERT_TRUE(usteps_from_steps(10000000, 16, &usteps));
+    TEST_ASSERT_EQUAL_INT32(160000000, usteps);
+    // Огромный ход не переполняет int64 при умножении
+    TEST_ASSERT_FALSE(usteps_from_steps(INT64_MAX / 2, 256, &usteps));
+}
+
+// Округление вниз: -1 мкшаг лежит в шаге -1
+static void test_to_steps_floors(void) {
+    TEST_ASSERT_EQUAL_INT32(0, usteps_to_steps(255, 256));
+    TEST_ASSERT_EQUAL_INT32(-1, usteps_to_steps(-1, 256));
+    TEST_ASSERT_EQUAL_INT32(-1, usteps_to_steps(-16, 16));
+    TEST_ASSERT_EQUAL_INT32(-2, usteps_to_steps(-17, 16));
+    TEST_ASSERT_EQUAL_INT32(INT32_MIN, usteps_to_steps(INT32_MIN, 1));
+}
+
+static void test_vactual_sign_extension(void) {
+    TEST_ASSERT_EQUAL_INT32(-1, usteps_vactual_from_register(0xFFFFFF));
+    TEST_ASSERT_EQUAL_INT32(-8388608, usteps_vactual_from_register(0x800000));
+    TEST_ASSERT_EQUAL_INT32(8388607, usteps_vactual_from_register(0x7FFFFF));
+    // 2^24 / fCLK: VACTUAL = 2^24 при 12 МГц - 12e6 мкшагов/с
+    TEST_ASSERT_EQUAL_INT32(12000000, usteps_rate_from_vactual(16777216, 12000000));
+    TEST_ASSERT_EQUAL_INT32(-12000000, usteps_rate_from_vactual(-16777216, 12000000));
+}
+
+// Вперёд через 2^31-1 → -2^31 и обратно: 64-битная позиция непрерывна
+static void test_unwrap_across_boundary(void) {
+    UstepsUnwrap u = {};
+    TEST_ASSERT_TRUE(usteps_unwrap(u, INT32_MAX - 100) == (int64_t)INT32_MAX - 100);
+    TEST_ASSERT_TRUE(usteps_unwrap(u, usteps_add(INT32_MAX, 100)) == (int64_t)INT32_MAX + 100);
+    TEST_ASSERT_EQUAL_INT32(1, u.wraps);
+    TEST_ASSERT_TRUE(usteps_unwrap(u, INT32_MAX - 50) == (int64_t)INT32_MAX - 50);
+    TEST_ASSERT_EQUAL_INT32(0, u.wraps);
+    TEST_ASSERT_TRUE(usteps_unwrap(u, INT32_MAX - 9) == (int64_t)INT32_MAX - 9);
+
+    usteps_unwrap_reset(u, 5);
+    TEST_ASSERT_EQUAL_INT32(0, u.wraps);
+    TEST_ASSERT_TRUE(usteps_unwrap(u, -5) == -5);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_add_and_diff_wrap);
+    RUN_TEST(test_move_valid);
+    RUN_TEST(test_usteps_per_step_from_mres);
+    RUN_TEST(test_steps_round_trip_in_programmed_scale);
+    RUN_TEST(test_to_steps_floors);
+    RUN_TEST(test_vactual_sign_extension);
+    RUN_TEST(test_unwrap_across_boundary);
+    return UNITY_END();
+}